@@ -575,8 +575,18 @@ int main ( int argc, char **argv )
 		return 1;
 	}
 
+	// Headless render (export) needs a session to begin with;
+	// the synthetic session benchmark builds its very own...
+	const bool bBench = (options.iBenchCycles > 0);
+	const bool bRender = !bBench && !options.sRenderFile.isEmpty();
+	if (bRender && options.sSessionFile.isEmpty()) {
+		options.print_usage(app.arguments().at(0));
+		app.quit();
+		return 1;
+	}
+
 	// Have another instance running?
-	if (app.setup()) {
+	if (!bRender && !bBench && app.setup()) {
 		app.quit();
 		return 2;
 	}
@@ -635,6 +645,21 @@ int main ( int argc, char **argv )
 	// Construct, setup and show the main form (a pseudo-singleton).
 	qtractorMainForm w;
 	w.setup(&options);
+
+	// Headless render (export) and quit...
+	if (bRender) {
+		const bool bResult = w.renderSession();
+		app.quit();
+		return (bResult ? 0 : 3);
+	}
+
+	// Headless synthetic session benchmark and quit...
+	if (bBench) {
+		const bool bResult = w.benchSession();
+		app.quit();
+		return (bResult ? 0 : 3);
+	}
+
 	w.show();
 
 	// Settle this one as application main widget...
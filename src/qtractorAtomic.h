@@ -1,7 +1,7 @@
 // qtractorAtomic.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2015, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -41,9 +41,13 @@ typedef QAtomicInt qtractorAtomic;
 #if QT_VERSION >= 0x050000
 #define ATOMIC_GET(a)	((a)->load())
 #define ATOMIC_SET(a,v)	((a)->store(v))
+#define ATOMIC_GET_ACQUIRE(a)	((a)->loadAcquire())
+#define ATOMIC_SET_RELEASE(a,v)	((a)->storeRelease(v))
 #else
 #define ATOMIC_GET(a)	((int) *(a))
 #define ATOMIC_SET(a,v)	(*(a) = (v))
+#define ATOMIC_GET_ACQUIRE(a)	ATOMIC_GET(a)
+#define ATOMIC_SET_RELEASE(a,v)	((a)->fetchAndStoreRelease(v))
 #endif
 
 static inline int ATOMIC_CAS ( qtractorAtomic *pVal,
@@ -131,6 +135,8 @@ typedef struct { volatile int value; } qtractorAtomic;
 
 #define ATOMIC_GET(a)	((a)->value)
 #define ATOMIC_SET(a,v)	((a)->value = (v))
+#define ATOMIC_GET_ACQUIRE(a)	ATOMIC_GET(a)
+#define ATOMIC_SET_RELEASE(a,v)	ATOMIC_SET(a,v)
 
 static inline int ATOMIC_CAS ( qtractorAtomic *pVal,
 	int iOldValue, int iNewValue )
@@ -21,22 +21,465 @@
 
 #include "qtractorAbout.h"
 #include "qtractorAudioBuffer.h"
+#include "qtractorAudioKernel.h"
 #include "qtractorAudioPeak.h"
+#include "qtractorAudioCache.h"
 
 #include "qtractorTimeStretcher.h"
 
 #include "qtractorSession.h"
 #include "qtractorAudioEngine.h"
 
+#include <QList>
+#include <QFileInfo>
+
 
 // Glitch, click, pop-free ramp length (in frames).
 #define QTRACTOR_RAMP_LENGTH	32
 
 
+//----------------------------------------------------------------------
+// class qtractorAudioBufferPool -- Ring-cache shared worker pool.
+//
+
+class qtractorAudioBufferPool
+{
+public:
+
+	// Constructor.
+	qtractorAudioBufferPool();
+
+	// Destructor.
+	~qtractorAudioBufferPool();
+
+	// Pool member threads (de)registration.
+	void addThread(qtractorAudioBufferThread *pSyncThread);
+	void removeThread(qtractorAudioBufferThread *pSyncThread);
+
+	// Wake up all workers (RT-safe).
+	void wake();
+
+	// Wake up all workers (non RT-safe).
+	void wakeAll();
+
+	// Worker executive, while given run-state holds.
+	void work(volatile bool *pbRunState);
+
+	// Bypass executive (non-concurrent).
+	void process();
+
+	// Member thread ring-queue resize.
+	void resize(qtractorAudioBufferThread *pSyncThread, unsigned int iSyncSize);
+
+	// Scheduling statistics.
+	void stats(qtractorAudioBufferThread::SyncStats& stats);
+	void resetStats();
+
+protected:
+
+	// Pending item descriptor.
+	struct SyncItem
+	{
+		qtractorAudioBuffer       *buffer;
+		qtractorAudioBufferThread *thread;
+		unsigned long              serial;
+	};
+
+	// Pending set helpers (mutex locked).
+	void collect();
+	bool isBusy(qtractorAudioBuffer *pAudioBuffer) const;
+	bool pick(SyncItem& item);
+	void done(const SyncItem& item);
+
+	// Helper workers (re)start (mutex locked).
+	void checkWorkers(unsigned int iSyncSize);
+
+private:
+
+	// Pool member threads (request ring-queues).
+	QList<qtractorAudioBufferThread *> m_threads;
+
+	// Global pending set, in arrival order.
+	QList<SyncItem> m_pending;
+	unsigned long   m_iSerial;
+
+	// Buffers currently being serviced.
+	QList<SyncItem> m_busy;
+
+	// Helper worker threads.
+	QList<qtractorAudioBufferWorker *> m_workers;
+
+	// Scheduling statistics.
+	qtractorAudioBufferThread::SyncStats m_stats;
+	unsigned long m_iStatsSamples;
+
+	// Thread synchronization objects.
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioBufferWorker -- Ring-cache helper worker thread.
+//
+
+class qtractorAudioBufferWorker : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioBufferWorker(qtractorAudioBufferPool *pSyncPool)
+		: QThread(), m_pSyncPool(pSyncPool), m_bRunState(true) {}
+
+	// Run state accessor.
+	void setRunState(bool bRunState)
+		{ m_bRunState = bRunState; }
+
+protected:
+
+	// The main thread executive.
+	void run() { m_pSyncPool->work(&m_bRunState); }
+
+private:
+
+	// Instance variables.
+	qtractorAudioBufferPool *m_pSyncPool;
+
+	volatile bool m_bRunState;
+};
+
+
+// Constructor.
+qtractorAudioBufferPool::qtractorAudioBufferPool (void)
+{
+	m_iSerial = 0;
+
+	resetStats();
+}
+
+
+// Destructor.
+qtractorAudioBufferPool::~qtractorAudioBufferPool (void)
+{
+	// Stop and reclaim all helper workers...
+	QListIterator<qtractorAudioBufferWorker *> iter(m_workers);
+	while (iter.hasNext())
+		iter.next()->setRunState(false);
+
+	iter.toFront();
+	while (iter.hasNext()) {
+		qtractorAudioBufferWorker *pWorker = iter.next();
+		while (!pWorker->wait(100))
+			wakeAll();
+	}
+
+	qDeleteAll(m_workers);
+	m_workers.clear();
+}
+
+
+// Pool member threads (de)registration.
+void qtractorAudioBufferPool::addThread (
+	qtractorAudioBufferThread *pSyncThread )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_threads.append(pSyncThread);
+}
+
+
+void qtractorAudioBufferPool::removeThread (
+	qtractorAudioBufferThread *pSyncThread )
+{
+	QMutexLocker locker(&m_mutex);
+
+	// Drop whatever is still pending...
+	QMutableListIterator<SyncItem> iter(m_pending);
+	while (iter.hasNext()) {
+		if (iter.next().thread == pSyncThread)
+			iter.remove();
+	}
+
+	// Wait for the ones still being serviced elsewhere...
+	for (;;) {
+		bool bBusy = false;
+		QListIterator<SyncItem> iter2(m_busy);
+		while (!bBusy && iter2.hasNext())
+			bBusy = (iter2.next().thread == pSyncThread);
+		if (!bBusy)
+			break;
+		m_cond.wait(&m_mutex);
+	}
+
+	m_threads.removeAll(pSyncThread);
+}
+
+
+// Wake up all workers (RT-safe).
+void qtractorAudioBufferPool::wake (void)
+{
+	if (m_mutex.tryLock()) {
+		m_cond.wakeAll();
+		m_mutex.unlock();
+	}
+#ifdef CONFIG_DEBUG_0
+	else qDebug("qtractorAudioBufferPool[%p]::wake(): tryLock() failed.", this);
+#endif
+}
+
+
+// Wake up all workers (non RT-safe).
+void qtractorAudioBufferPool::wakeAll (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_cond.wakeAll();
+}
+
+
+// Worker executive, while given run-state holds.
+void qtractorAudioBufferPool::work ( volatile bool *pbRunState )
+{
+	m_mutex.lock();
+
+	while (*pbRunState) {
+		// Do whatever we must, then wait for more...
+		SyncItem item;
+		if (pick(item)) {
+			m_mutex.unlock();
+			item.buffer->sync();
+			m_mutex.lock();
+			done(item);
+		} else {
+			// Wait for sync...
+			m_cond.wait(&m_mutex);
+		}
+	}
+
+	m_mutex.unlock();
+}
+
+
+// Bypass executive (non-concurrent).
+void qtractorAudioBufferPool::process (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	for (;;) {
+		SyncItem item;
+		if (pick(item)) {
+			item.buffer->sync();
+			done(item);
+		}
+		else
+		if (!m_pending.isEmpty() || !m_busy.isEmpty()) {
+			// Wait for workers to finish what's in hand...
+			m_cond.wait(&m_mutex);
+		}
+		else break;
+	}
+}
+
+
+// Drain all member ring-queues into the pending set (mutex locked).
+void qtractorAudioBufferPool::collect (void)
+{
+	QListIterator<qtractorAudioBufferThread *> iter(m_threads);
+	while (iter.hasNext()) {
+		qtractorAudioBufferThread *pSyncThread = iter.next();
+		unsigned int r = pSyncThread->m_iSyncRead;
+		unsigned int w = pSyncThread->m_iSyncWrite;
+		while (r != w) {
+			qtractorAudioBuffer *pAudioBuffer = pSyncThread->m_ppSyncItems[r];
+			QListIterator<SyncItem> iter2(m_pending);
+			while (iter2.hasNext()) {
+				if (iter2.next().buffer == pAudioBuffer) {
+					pAudioBuffer = NULL;
+					break;
+				}
+			}
+			if (pAudioBuffer) {
+				SyncItem item;
+				item.buffer = pAudioBuffer;
+				item.thread = pSyncThread;
+				item.serial = m_iSerial;
+				m_pending.append(item);
+			}
+			++r &= pSyncThread->m_iSyncMask;
+			w = pSyncThread->m_iSyncWrite;
+		}
+		pSyncThread->m_iSyncRead = r;
+	}
+
+	const unsigned int iPending = m_pending.count();
+	if (m_stats.pending < iPending)
+		m_stats.pending = iPending;
+}
+
+
+// Whether a buffer is being serviced already (mutex locked).
+bool qtractorAudioBufferPool::isBusy ( qtractorAudioBuffer *pAudioBuffer ) const
+{
+	QListIterator<SyncItem> iter(m_busy);
+	while (iter.hasNext()) {
+		if (iter.next().buffer == pAudioBuffer)
+			return true;
+	}
+
+	return false;
+}
+
+
+// Pick the next pending buffer to service (mutex locked).
+bool qtractorAudioBufferPool::pick ( SyncItem& item )
+{
+	collect();
+
+	const int iPending = m_pending.count();
+
+	int iPick = -1;
+	unsigned int iPickDeadline = 0;
+	bool bOverdue = false;
+
+	// Pending set is in arrival order, the oldest first...
+	for (int i = 0; i < iPending; ++i) {
+		const SyncItem& next = m_pending.at(i);
+		// Never the same buffer on two workers...
+		if (isBusy(next.buffer))
+			continue;
+		// Earliest deadline first...
+		const unsigned int iDeadline = next.buffer->syncDeadline();
+		if (iPick < 0 || iDeadline < iPickDeadline) {
+			iPick = i;
+			iPickDeadline = iDeadline;
+		}
+		// ...unless it has been left waiting for too long.
+		if (m_iSerial - next.serial > (unsigned long) (iPending << 1)) {
+			iPick = i;
+			iPickDeadline = iDeadline;
+			bOverdue = true;
+			break;
+		}
+	}
+
+	if (iPick < 0)
+		return false;
+
+	item = m_pending.takeAt(iPick);
+	m_busy.append(item);
+	++m_iSerial;
+
+	// Scheduling statistics...
+	++m_stats.picks;
+	if (bOverdue)
+		++m_stats.overdue;
+	if (item.buffer->updateSyncStats(iPickDeadline)) {
+		if (m_iStatsSamples++ == 0 || m_stats.headroom > iPickDeadline)
+			m_stats.headroom = iPickDeadline;
+		if (iPickDeadline < 1)
+			++m_stats.underruns;
+	}
+
+	return true;
+}
+
+
+// Buffer service done (mutex locked).
+void qtractorAudioBufferPool::done ( const SyncItem& item )
+{
+	// Beware: buffer might be already gone (closed)...
+	const int iBusy = m_busy.count();
+	for (int i = 0; i < iBusy; ++i) {
+		if (m_busy.at(i).buffer == item.buffer) {
+			m_busy.removeAt(i);
+			break;
+		}
+	}
+
+	m_cond.wakeAll();
+}
+
+
+// Member thread ring-queue resize.
+void qtractorAudioBufferPool::resize (
+	qtractorAudioBufferThread *pSyncThread, unsigned int iSyncSize )
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (iSyncSize > (pSyncThread->m_iSyncSize - 4)) {
+		unsigned int iNewSyncSize = (pSyncThread->m_iSyncSize << 1);
+		while (iNewSyncSize < iSyncSize)
+			iNewSyncSize <<= 1;
+		qtractorAudioBuffer **ppNewSyncItems
+			= new qtractorAudioBuffer * [iNewSyncSize];
+		qtractorAudioBuffer **ppOldSyncItems = pSyncThread->m_ppSyncItems;
+		::memcpy(ppNewSyncItems, ppOldSyncItems,
+			pSyncThread->m_iSyncSize * sizeof(qtractorAudioBuffer *));
+		pSyncThread->m_iSyncSize = iNewSyncSize;
+		pSyncThread->m_iSyncMask = (iNewSyncSize - 1);
+		pSyncThread->m_ppSyncItems = ppNewSyncItems;
+		delete [] ppOldSyncItems;
+	}
+
+	checkWorkers(iSyncSize);
+}
+
+
+// Helper workers (re)start (mutex locked).
+void qtractorAudioBufferPool::checkWorkers ( unsigned int iSyncSize )
+{
+	// Member threads are workers already; helpers are
+	// only added as needed, up to the global maximum...
+	unsigned int iWorkers = qtractorAudioBufferThread::syncWorkers();
+	if (iWorkers > iSyncSize)
+		iWorkers = iSyncSize;
+	iWorkers = (iWorkers > (unsigned int) m_threads.count()
+		? iWorkers - m_threads.count() : 0);
+
+	while (iWorkers > (unsigned int) m_workers.count()) {
+		qtractorAudioBufferWorker *pWorker = new qtractorAudioBufferWorker(this);
+		pWorker->start(QThread::HighPriority);
+		m_workers.append(pWorker);
+	}
+}
+
+
+// Scheduling statistics.
+void qtractorAudioBufferPool::stats (
+	qtractorAudioBufferThread::SyncStats& stats )
+{
+	QMutexLocker locker(&m_mutex);
+
+	stats = m_stats;
+	stats.workers = m_threads.count() + m_workers.count();
+}
+
+
+void qtractorAudioBufferPool::resetStats (void)
+{
+	m_stats.picks     = 0;
+	m_stats.overdue   = 0;
+	m_stats.headroom  = 0;
+	m_stats.underruns = 0;
+	m_stats.pending   = 0;
+	m_stats.workers   = 0;
+
+	m_iStatsSamples = 0;
+}
+
+
 //----------------------------------------------------------------------
 // class qtractorAudioBufferThread -- Ring-cache manager thread.
 //
 
+// Shared worker pool (ref'counted).
+qtractorAudioBufferPool *qtractorAudioBufferThread::g_pSyncPool = NULL;
+unsigned int qtractorAudioBufferThread::g_iSyncPoolRefCount = 0;
+
+// Maximum number of workers in pool (global option).
+unsigned short qtractorAudioBufferThread::g_iSyncWorkers = 4;
+
+
 // Constructor.
 qtractorAudioBufferThread::qtractorAudioBufferThread (
 	unsigned int iSyncSize ) : QThread()
@@ -50,6 +493,11 @@ qtractorAudioBufferThread::qtractorAudioBufferThread (
 	m_iSyncWrite  = 0;
 
 	m_bRunState = false;
+
+	if (++g_iSyncPoolRefCount == 1 && g_pSyncPool == NULL)
+		g_pSyncPool = new qtractorAudioBufferPool();
+
+	g_pSyncPool->addThread(this);
 }
 
 // Destructor.
@@ -61,15 +509,23 @@ qtractorAudioBufferThread::~qtractorAudioBufferThread (void)
 		sync();
 	} while (!wait(100));
 
+	g_pSyncPool->removeThread(this);
+
+	if (--g_iSyncPoolRefCount == 0 && g_pSyncPool != NULL) {
+		delete g_pSyncPool;
+		g_pSyncPool = NULL;
+	}
+
 	delete [] m_ppSyncItems;
 }
 
 // Run state accessor.
 void qtractorAudioBufferThread::setRunState ( bool bRunState )
 {
-	QMutexLocker locker(&m_mutex);
-
 	m_bRunState = bRunState;
+
+	if (!m_bRunState)
+		g_pSyncPool->wakeAll();
 }
 
 bool qtractorAudioBufferThread::runState (void) const
@@ -109,22 +565,14 @@ void qtractorAudioBufferThread::sync ( qtractorAudioBuffer *pAudioBuffer )
 		}
 	}
 
-	if (m_mutex.tryLock()) {
-		m_cond.wakeAll();
-		m_mutex.unlock();
-	}
-#ifdef CONFIG_DEBUG_0
-	else qDebug("qtractorAudioBufferThread[%p]::sync(): tryLock() failed.", this);
-#endif
+	g_pSyncPool->wake();
 }
 
 
 // Bypass executive wait condition (non RT-safe).
 void qtractorAudioBufferThread::syncExport (void)
 {
-	QMutexLocker locker(&m_mutex);
-
-	process();
+	g_pSyncPool->process();
 }
 
 
@@ -135,18 +583,10 @@ void qtractorAudioBufferThread::run (void)
 	qDebug("qtractorAudioBufferThread[%p]::run(): started.", this);
 #endif
 
-	m_mutex.lock();
-
 	m_bRunState = true;
 
-	while (m_bRunState) {
-		// Do whatever we must, then wait for more...
-		process();
-		// Wait for sync...
-		m_cond.wait(&m_mutex);
-	}
-
-	m_mutex.unlock();
+	// Do our own share of the pool work...
+	g_pSyncPool->work(&m_bRunState);
 
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorAudioBufferThread[%p]::run(): stopped.", this);
@@ -154,40 +594,38 @@ void qtractorAudioBufferThread::run (void)
 }
 
 
-// Thread run executive.
-void qtractorAudioBufferThread::process (void)
+// Conditional resize check.
+void qtractorAudioBufferThread::checkSyncSize ( unsigned int iSyncSize )
 {
-	unsigned int r = m_iSyncRead;
-	unsigned int w = m_iSyncWrite;
+	g_pSyncPool->resize(this, iSyncSize);
+}
 
-	while (r != w) {
-		m_ppSyncItems[r]->sync();
-		++r &= m_iSyncMask;
-		w = m_iSyncWrite;
-	}
 
-	m_iSyncRead = r;
+// Maximum number of workers in pool (global option).
+void qtractorAudioBufferThread::setSyncWorkers ( unsigned short iSyncWorkers )
+{
+	g_iSyncWorkers = (iSyncWorkers > 0 ? iSyncWorkers : 1);
 }
 
+unsigned short qtractorAudioBufferThread::syncWorkers (void)
+{
+	return g_iSyncWorkers;
+}
 
-// Conditional resize check.
-void qtractorAudioBufferThread::checkSyncSize ( unsigned int iSyncSize )
+
+// Scheduling statistics, for the whole pool (non RT-safe).
+void qtractorAudioBufferThread::syncStats ( SyncStats& stats )
 {
-	if (iSyncSize > (m_iSyncSize - 4)) {
-		QMutexLocker locker(&m_mutex);
-		unsigned int iNewSyncSize = (m_iSyncSize << 1);
-		while (iNewSyncSize < iSyncSize)
-			iNewSyncSize <<= 1;
-		qtractorAudioBuffer **ppNewSyncItems
-			= new qtractorAudioBuffer * [iNewSyncSize];
-		qtractorAudioBuffer **ppOldSyncItems = m_ppSyncItems;
-		::memcpy(ppNewSyncItems, ppOldSyncItems,
-			m_iSyncSize * sizeof(qtractorAudioBuffer *));
-		m_iSyncSize = iNewSyncSize;
-		m_iSyncMask = (iNewSyncSize - 1);
-		m_ppSyncItems = ppNewSyncItems;
-		delete [] ppOldSyncItems;
-	}
+	if (g_pSyncPool)
+		g_pSyncPool->stats(stats);
+	else
+		::memset(&stats, 0, sizeof(SyncStats));
+}
+
+void qtractorAudioBufferThread::resetSyncStats (void)
+{
+	if (g_pSyncPool)
+		g_pSyncPool->resetStats();
 }
 
 
@@ -230,6 +668,8 @@ qtractorAudioBuffer::qtractorAudioBuffer (
 	m_ppFrames       = NULL;
 	m_ppBuffer       = NULL;
 
+	m_ppRingFrames   = NULL;
+
 	m_bTimeStretch   = false;
 	m_fTimeStretch   = 1.0f;
 
@@ -237,6 +677,7 @@ qtractorAudioBuffer::qtractorAudioBuffer (
 	m_fPitchShift    = 1.0f;
 
 	m_pTimeStretcher = NULL;
+	m_bStretchCache  = false;
 
 	m_fNextGain      = 0.0f;
 	m_iRampGain      = 1;
@@ -251,6 +692,9 @@ qtractorAudioBuffer::qtractorAudioBuffer (
 #endif
 
 	m_pPeakFile      = NULL;
+
+	m_iSyncHeadroom  = 0;
+	m_iSyncUnderruns = 0;
 }
 
 // Default destructor.
@@ -311,14 +755,50 @@ bool qtractorAudioBuffer::open ( const QString& sFilename, int iMode )
 
 	const unsigned int iSampleRate = pSession->sampleRate();
 
+	// Time-stretch engine flags, whether needed...
+	unsigned int iStretchFlags = qtractorTimeStretcher::None;
+	if (m_bTimeStretch || m_bPitchShift) {
+		if (g_bWsolaTimeStretch)
+			iStretchFlags |= qtractorTimeStretcher::WsolaTimeStretch;
+		if (g_bWsolaQuickSeek)
+			iStretchFlags |= qtractorTimeStretcher::WsolaQuickSeek;
+		if (g_bWsolaFftSeek)
+			iStretchFlags |= qtractorTimeStretcher::WsolaFftSeek;
+	}
+
+	// Decoded-PCM or pre-rendered time-stretch cache,
+	// if readily available, otherwise stretch on the fly,
+	// until it gets ready and we're reopened (switch-over)...
+	QString sFilePath = sFilename;
+	qtractorAudioCacheFactory *pCacheFactory = pSession->audioCacheFactory();
+	if (pCacheFactory && (iMode & qtractorAudioFile::Read)) {
+		const QString& sCachePath = pCacheFactory->cachePath(
+			sFilename, iSampleRate,
+			(m_bTimeStretch ? m_fTimeStretch : 1.0f),
+			(m_bPitchShift  ? m_fPitchShift  : 1.0f), iStretchFlags);
+		if (!sCachePath.isEmpty()) {
+			if (QFileInfo(sCachePath).exists()) {
+				sFilePath = sCachePath;
+				m_bStretchCache = (m_bTimeStretch || m_bPitchShift);
+			} else {
+				m_sCachePending = sCachePath;
+			}
+		}
+	}
+
 	// Get proper file type class...
-	m_pFile = qtractorAudioFileFactory::createAudioFile(
-		sFilename, m_iChannels, iSampleRate);
+	if (sFilePath != sFilename) {
+		m_pFile = qtractorAudioFileFactory::createAudioFile(
+			qtractorAudioFileFactory::SndFile, m_iChannels, iSampleRate);
+	} else {
+		m_pFile = qtractorAudioFileFactory::createAudioFile(
+			sFilename, m_iChannels, iSampleRate);
+	}
 	if (m_pFile == NULL)
 		return false;
 
 	// Go open it...
-	if (!m_pFile->open(sFilename, iMode)) {
+	if (!m_pFile->open(sFilePath, iMode)) {
 		delete m_pFile;
 		m_pFile = NULL;
 		return false;
@@ -369,6 +849,8 @@ bool qtractorAudioBuffer::open ( const QString& sFilename, int iMode )
 	m_iThreshold  = (m_pRingBuffer->bufferSize() >> 2);
 	m_iBufferSize = (m_iThreshold >> 2);
 
+	resetSyncStats();
+
 #ifdef CONFIG_LIBSAMPLERATE
 	if (m_bResample && m_fResampleRatio < 1.0f) {
 		iBufferSize = (unsigned int) framesOut(m_iBufferSize);
@@ -384,15 +866,14 @@ bool qtractorAudioBuffer::open ( const QString& sFilename, int iMode )
 	for (i = 0; i < iBuffers; ++i)
 		m_ppFrames[i] = new float [m_iBufferSize];
 
+	// Zero-copy ring-buffer reads (memory-mapped)...
+	if (m_pFile->isMapped())
+		m_ppRingFrames = new float * [iBuffers];
+
 	// Allocate time-stretch engine whether needed...
-	if (m_bTimeStretch || m_bPitchShift) {
-		unsigned int iFlags = qtractorTimeStretcher::None;
-		if (g_bWsolaTimeStretch)
-			iFlags |= qtractorTimeStretcher::WsolaTimeStretch;
-		if (g_bWsolaQuickSeek)
-			iFlags |= qtractorTimeStretcher::WsolaQuickSeek;
+	if ((m_bTimeStretch || m_bPitchShift) && !m_bStretchCache) {
 		m_pTimeStretcher = new qtractorTimeStretcher(iBuffers, iSampleRate,
-			m_fTimeStretch, m_fPitchShift, iFlags, m_iBufferSize);
+			m_fTimeStretch, m_fPitchShift, iStretchFlags, m_iBufferSize);
 	}
 
 #ifdef CONFIG_LIBSAMPLERATE
@@ -435,6 +916,11 @@ void qtractorAudioBuffer::close (void)
 	if (m_pFile == NULL)
 		return;
 
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorAudioBuffer[%p]::close() headroom=%u underruns=%u",
+		this, m_iSyncHeadroom, m_iSyncUnderruns);
+#endif
+
 	// Wait for regular file close...
 	if (m_pSyncThread) {
 		setSyncFlag(CloseSync);
@@ -447,7 +933,7 @@ void qtractorAudioBuffer::close (void)
 	if (m_pFile->mode() & qtractorAudioFile::Write) {
 		// Close on-the-fly peak file, if applicable...
 		if (m_pPeakFile) {
-			m_pPeakFile->closeWrite();
+			m_pPeakFile->closeWrite(true);
 			m_pPeakFile = NULL;
 		}
 	}
@@ -458,6 +944,10 @@ void qtractorAudioBuffer::close (void)
 		m_pTimeStretcher = NULL;
 	}
 
+	m_bStretchCache = false;
+
+	m_sCachePending.clear();
+
 	// Release internal I/O buffers.
 	if (m_ppBuffer && m_pRingBuffer) {
 		const unsigned short iBuffers = m_pRingBuffer->channels();
@@ -505,6 +995,13 @@ void qtractorAudioBuffer::close (void)
 }
 
 
+// Cache file path still pending, while reading from source.
+const QString& qtractorAudioBuffer::cachePending (void) const
+{
+	return m_sCachePending;
+}
+
+
 // Buffer data read.
 int qtractorAudioBuffer::read ( float **ppFrames, unsigned int iFrames,
 	unsigned int iOffset )
@@ -608,7 +1105,7 @@ int qtractorAudioBuffer::write ( float **ppFrames, unsigned int iFrames,
 		if (nwrite > 0) {
 			const unsigned int w = m_pRingBuffer->writeIndex();
 			const unsigned int bs = m_pRingBuffer->bufferSize();
-			unsigned int n, n1, n2;
+			unsigned int n1, n2;
 			if (w + nwrite > bs) {
 				n1 = (bs - w);
 				n2 = (w + nwrite) & m_pRingBuffer->bufferMask();
@@ -620,26 +1117,23 @@ int qtractorAudioBuffer::write ( float **ppFrames, unsigned int iFrames,
 			float **ppBuffer = m_pRingBuffer->buffer();
 			if (iChannels > iBuffers) {
 				for (i = 0, j = 0; i < iBuffers; ++i, ++j) {
-					for (n = 0; n < n1; ++n)
-						ppBuffer[j][n + w] = ppFrames[i][n] + iOffset;
-					for (n = 0; n < n2; ++n)
-						ppBuffer[j][n] = ppFrames[i][n + n1] + iOffset;
+					const float *pFrames = ppFrames[i] + iOffset;
+					::memcpy(ppBuffer[j] + w, pFrames, n1 * sizeof(float));
+					::memcpy(ppBuffer[j], pFrames + n1, n2 * sizeof(float));
 				}
 				for (j = 0; i < iChannels; ++i) {
-					for (n = 0; n < n1; ++n)
-						ppBuffer[j][n + w] += ppFrames[i][n] + iOffset;
-					for (n = 0; n < n2; ++n)
-						ppBuffer[j][n] += ppFrames[i][n + n1] + iOffset;
+					const float *pFrames = ppFrames[i] + iOffset;
+					qtractorAudioKernel::add(ppBuffer[j] + w, pFrames, n1);
+					qtractorAudioKernel::add(ppBuffer[j], pFrames + n1, n2);
 					if (++j >= iBuffers)
 						j = 0;
 				}
 			} else { // (iChannels < iBuffers)
 				i = 0;
 				for (j = 0; j < iBuffers; ++j) {
-					for (n = 0; n < n1; ++n)
-						ppBuffer[j][n + w] = ppFrames[i][n] + iOffset;
-					for (n = 0; n < n2; ++n)
-						ppBuffer[j][n] = ppFrames[i][n + n1] + iOffset;
+					const float *pFrames = ppFrames[i] + iOffset;
+					::memcpy(ppBuffer[j] + w, pFrames, n1 * sizeof(float));
+					::memcpy(ppBuffer[j], pFrames + n1, n2 * sizeof(float));
 					if (++i >= iChannels)
 						i = 0;
 				}
@@ -661,7 +1155,8 @@ int qtractorAudioBuffer::write ( float **ppFrames, unsigned int iFrames,
 
 // Special kind of super-read/channel-mix.
 int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
-	unsigned short iChannels, unsigned int iOffset, float fGain )
+	unsigned short iChannels, unsigned int iOffset, float fGain,
+	const float *pGains )
 {
 	if (m_pRingBuffer == NULL)
 		return -1;
@@ -703,7 +1198,8 @@ int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
 			const unsigned int ri = m_pRingBuffer->readIndex();
 			while (ri < le && ri + iFrames >= le && nread > 0) {
 				m_iRampGain = -1;
-				nread = readMixFrames(ppFrames, le - ri, iChannels, iOffset, fGain);
+				nread = readMixFrames(ppFrames, le - ri,
+					iChannels, iOffset, fGain, pGains);
 				iFrames -= nread;
 				iOffset += nread;
 				ro = m_iOffset + ls;
@@ -714,7 +1210,8 @@ int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
 			le += m_iOffset;
 			while (le >= ro && ro + iFrames >= le && nread > 0) {
 				m_iRampGain = -1;
-				nread = readMixFrames(ppFrames, le - ro, iChannels, iOffset, fGain);
+				nread = readMixFrames(ppFrames, le - ro,
+					iChannels, iOffset, fGain, pGains);
 				iFrames -= nread;
 				iOffset += nread;
 				ro = ls;
@@ -728,7 +1225,7 @@ int qtractorAudioBuffer::readMix ( float **ppFrames, unsigned int iFrames,
 		m_iRampGain = -1;
 
 	// Mix the (remaining) data around...
-	nread = readMixFrames(ppFrames, iFrames, iChannels, iOffset, fGain);
+	nread = readMixFrames(ppFrames, iFrames, iChannels, iOffset, fGain, pGains);
 	m_iReadOffset = (ro + nread);
 	if (m_iReadOffset >= re) {
 		// Force out-of-sync...
@@ -964,6 +1461,68 @@ void qtractorAudioBuffer::syncExport (void)
 }
 
 
+// Sync deadline: frames left before ring-buffer under/overrun.
+unsigned int qtractorAudioBuffer::syncDeadline (void) const
+{
+	if (m_pFile == NULL || m_pRingBuffer == NULL)
+		return 0;
+
+	if (!isSyncFlag(InitSync) || isSyncFlag(CloseSync)
+		|| ATOMIC_GET(&m_seekPending))
+		return 0;
+
+	if (m_pFile->mode() & qtractorAudioFile::Write)
+		return m_pRingBuffer->writable();
+
+	if (m_bIntegral)
+		return m_pRingBuffer->bufferSize();
+
+	return m_pRingBuffer->readable();
+}
+
+
+// Sync headroom statistics (steady-state only).
+bool qtractorAudioBuffer::updateSyncStats ( unsigned int iDeadline )
+{
+	if (m_pFile == NULL || m_pRingBuffer == NULL || m_bIntegral)
+		return false;
+
+	if (!isSyncFlag(InitSync) || isSyncFlag(CloseSync)
+		|| ATOMIC_GET(&m_seekPending))
+		return false;
+
+	// Running dry on the logical end-of-clip is no underrun...
+	if ((m_pFile->mode() & qtractorAudioFile::Read)
+		&& m_iWriteOffset >= m_iOffset + m_iLength)
+		return false;
+
+	if (m_iSyncHeadroom > iDeadline)
+		m_iSyncHeadroom = iDeadline;
+	if (iDeadline < 1)
+		++m_iSyncUnderruns;
+
+	return true;
+}
+
+
+void qtractorAudioBuffer::resetSyncStats (void)
+{
+	m_iSyncHeadroom  = (m_pRingBuffer ? m_pRingBuffer->bufferSize() : 0);
+	m_iSyncUnderruns = 0;
+}
+
+
+unsigned int qtractorAudioBuffer::syncHeadroom (void) const
+{
+	return m_iSyncHeadroom;
+}
+
+unsigned int qtractorAudioBuffer::syncUnderruns (void) const
+{
+	return m_iSyncUnderruns;
+}
+
+
 // Read-mode sync executive.
 void qtractorAudioBuffer::readSync (void)
 {
@@ -1038,6 +1597,10 @@ void qtractorAudioBuffer::readSync (void)
 					m_iWriteOffset = offset;
 			}
 		}
+		else {
+			// No room left, yet (not end-of-file)...
+			nahead = 0;
+		}
 	}
 }
 
@@ -1177,6 +1740,51 @@ int qtractorAudioBuffer::flushFrames ( float **ppFrames, unsigned int iFrames )
 }
 
 
+// Zero-copy (memory-mapped) file read straight into the ring-buffer;
+// return 0 when there's no room left, -1 on end-of-file.
+int qtractorAudioBuffer::readDirect ( unsigned int iFrames )
+{
+	const unsigned int ws = m_pRingBuffer->writable();
+	if (iFrames > ws)
+		iFrames = ws;
+	if (iFrames < 1)
+		return 0;
+
+	const unsigned short iBuffers = m_pRingBuffer->channels();
+	const unsigned int w  = m_pRingBuffer->writeIndex();
+	const unsigned int bs = m_pRingBuffer->bufferSize();
+
+	unsigned int n1, n2;
+	if (w + iFrames > bs) {
+		n1 = (bs - w);
+		n2 = iFrames - n1;
+	} else {
+		n1 = iFrames;
+		n2 = 0;
+	}
+
+	unsigned short i;
+	float **ppBuffer = m_pRingBuffer->buffer();
+
+	for (i = 0; i < iBuffers; ++i)
+		m_ppRingFrames[i] = ppBuffer[i] + w;
+	int nread = m_pFile->read(m_ppRingFrames, n1);
+	if (nread == int(n1) && n2 > 0) {
+		const int nread2 = m_pFile->read(ppBuffer, n2);
+		if (nread2 > 0)
+			nread += nread2;
+	}
+
+	if (nread < 1)
+		return -1;
+
+	// Just publish what was read (no index override)...
+	m_pRingBuffer->commitWrite(nread);
+
+	return nread;
+}
+
+
 // I/O buffer read process; return -1 on end-of-file.
 int qtractorAudioBuffer::readBuffer ( unsigned int iFrames )
 {
@@ -1233,11 +1841,18 @@ int qtractorAudioBuffer::readBuffer ( unsigned int iFrames )
 	} else {
 #endif   // CONFIG_LIBSAMPLERATE
 
-		nread = m_pFile->read(m_ppFrames, iFrames);
-		if (nread > 0)
-			nread = writeFrames(m_ppFrames, nread);
-		else
-			nread = flushFrames(m_ppFrames, iFrames); // Maybe EoF!
+		if (m_ppRingFrames && m_pTimeStretcher == NULL) {
+			// Zero-copy: no room left is not end-of-file...
+			nread = readDirect(iFrames);
+			if (nread < 0)
+				nread = flushFrames(m_ppFrames, iFrames); // Maybe EoF!
+		} else {
+			nread = m_pFile->read(m_ppFrames, iFrames);
+			if (nread > 0)
+				nread = writeFrames(m_ppFrames, nread);
+			else
+				nread = flushFrames(m_ppFrames, iFrames); // Maybe EoF!
+		}
 
 #ifdef CONFIG_LIBSAMPLERATE
 	}
@@ -1268,7 +1883,7 @@ int qtractorAudioBuffer::writeBuffer ( unsigned int iFrames )
 // Special kind of super-read/channel-mix buffer helper.
 int qtractorAudioBuffer::readMixFrames (
 	float **ppFrames, unsigned int iFrames, unsigned short iChannels,
-	unsigned int iOffset, float fGain )
+	unsigned int iOffset, float fGain, const float *pGains )
 {
 	if (iFrames == 0)
 		return 0;
@@ -1279,23 +1894,18 @@ int qtractorAudioBuffer::readMixFrames (
 
 	const unsigned short iBuffers = m_pRingBuffer->channels();
 
-	unsigned short i, j; int n;
-	float fGainIter, fGainStep;
-	float *pFrames, *pBuffer;
+	unsigned short i, j;
 
 	// HACK: Case of clip ramp in/out-set in this run...
 	if (m_iRampGain) {
 		const unsigned int nramp
 			= (nread < QTRACTOR_RAMP_LENGTH ? nread : QTRACTOR_RAMP_LENGTH);
-		const int n0 = (m_iRampGain < 0 ? nread - nramp : nramp);
-		const int n1 = (m_iRampGain < 0 ? n0 : 0);
-		const int n2 = (m_iRampGain < 0 ? nread : n0);
-		fGainStep = float(m_iRampGain) / float(nramp);
+		const int n1 = (m_iRampGain < 0 ? nread - nramp : 0);
+		const float fGain0 = (m_iRampGain < 0 ? 1.0f : 0.0f);
+		const float fGain1 = fGain0 + float(m_iRampGain);
 		for (i = 0; i < iBuffers; ++i) {
-			fGainIter = (m_iRampGain < 0 ? 1.0f : 0.0f);
-			pBuffer = m_ppBuffer[i] + n1;
-			for (n = n1; n < n2; ++n, fGainIter += fGainStep)
-				*pBuffer++ *= fGainIter;
+			qtractorAudioKernel::gain_ramp(
+				m_ppBuffer[i] + n1, nramp, fGain0, fGain1);
 		}
 		m_iRampGain = (m_iRampGain < 0 ? 1 : 0);
 	//	fPrevGain = fGain;
@@ -1304,25 +1914,34 @@ int qtractorAudioBuffer::readMixFrames (
 	// Reset running gain...
 	const float fPrevGain = m_fNextGain;
 	m_fNextGain = fGain;
-	fGainStep = (m_fNextGain - fPrevGain) / float(nread);
+
+	// Per-frame gain envelope, if any...
+	if (pGains) {
+		pGains += iOffset;
+		m_fNextGain = pGains[nread - 1];
+	}
 
 	if (iChannels == iBuffers) {
 		for (i = 0; i < iBuffers; ++i) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[i];
-			fGainIter = fPrevGain;
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep)
-				*pFrames++ += fGainIter * *pBuffer++;
+			if (pGains) {
+				qtractorAudioKernel::add_env(ppFrames[i] + iOffset,
+					m_ppBuffer[i], pGains, nread);
+			} else {
+				qtractorAudioKernel::add_ramp(ppFrames[i] + iOffset,
+					m_ppBuffer[i], nread, fPrevGain, m_fNextGain);
+			}
 		}
 	}
 	else if (iChannels > iBuffers) {
 		j = 0;
 		for (i = 0; i < iChannels; ++i) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[j];
-			fGainIter = fPrevGain;
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep)
-				*pFrames++ += fGainIter * *pBuffer++;
+			if (pGains) {
+				qtractorAudioKernel::add_env(ppFrames[i] + iOffset,
+					m_ppBuffer[j], pGains, nread);
+			} else {
+				qtractorAudioKernel::add_ramp(ppFrames[i] + iOffset,
+					m_ppBuffer[j], nread, fPrevGain, m_fNextGain);
+			}
 			if (++j >= iBuffers)
 				j = 0;
 		}
@@ -1330,11 +1949,13 @@ int qtractorAudioBuffer::readMixFrames (
 	else { // (iChannels < iBuffers)
 		i = 0;
 		for (j = 0; j < iBuffers; ++j) {
-			pFrames = ppFrames[i] + iOffset;
-			pBuffer = m_ppBuffer[j];
-			fGainIter = fPrevGain;
-			for (n = 0; n < nread; ++n, fGainIter += fGainStep)
-				*pFrames++ += fGainIter * *pBuffer++;
+			if (pGains) {
+				qtractorAudioKernel::add_env(ppFrames[i] + iOffset,
+					m_ppBuffer[j], pGains, nread);
+			} else {
+				qtractorAudioKernel::add_ramp(ppFrames[i] + iOffset,
+					m_ppBuffer[j], nread, fPrevGain, m_fNextGain);
+			}
 			if (++i >= iChannels)
 				i = 0;
 		}
@@ -1386,6 +2007,11 @@ void qtractorAudioBuffer::deleteIOBuffers (void)
 		delete [] m_ppFrames;
 		m_ppFrames = NULL;
 	}
+
+	if (m_ppRingFrames) {
+		delete [] m_ppRingFrames;
+		m_ppRingFrames = NULL;
+	}
 }
 
 
@@ -1419,7 +2045,7 @@ unsigned long qtractorAudioBuffer::framesIn ( unsigned long iFrames ) const
 		iFrames = (unsigned long) (float(iFrames) * m_fResampleRatio);
 #endif
 
-	if (m_bTimeStretch)
+	if (m_bTimeStretch && !m_bStretchCache)
 		iFrames = (unsigned long) (float(iFrames) * m_fTimeStretch);
 
 	return iFrames;
@@ -1432,7 +2058,7 @@ unsigned long qtractorAudioBuffer::framesOut ( unsigned long iFrames ) const
 		iFrames = (unsigned long) (float(iFrames) / m_fResampleRatio);
 #endif
 
-	if (m_bTimeStretch)
+	if (m_bTimeStretch && !m_bStretchCache)
 		iFrames = (unsigned long) (float(iFrames) / m_fTimeStretch);
 
 	return iFrames;
@@ -1577,6 +2203,7 @@ int qtractorAudioBuffer::resampleType (void)
 // WSOLA time-stretch modes (global options).
 bool qtractorAudioBuffer::g_bWsolaTimeStretch = true;
 bool qtractorAudioBuffer::g_bWsolaQuickSeek   = false;
+bool qtractorAudioBuffer::g_bWsolaFftSeek     = false;
 
 void qtractorAudioBuffer::setWsolaTimeStretch ( bool bWsolaTimeStretch )
 {
@@ -1600,4 +2227,15 @@ bool qtractorAudioBuffer::isWsolaQuickSeek (void)
 }
 
 
+void qtractorAudioBuffer::setWsolaFftSeek ( bool bWsolaFftSeek )
+{
+	g_bWsolaFftSeek = bWsolaFftSeek;
+}
+
+bool qtractorAudioBuffer::isWsolaFftSeek (void)
+{
+	return g_bWsolaFftSeek;
+}
+
+
 // end of qtractorAudioBuffer.cpp
@@ -45,6 +45,18 @@ class qtractorTimeStretcher;
 //----------------------------------------------------------------------
 // class qtractorAudioBufferThread -- Ring-cache manager thread.
 //
+// Sync requests are posted (RT-safe) into a lock-free queue, one
+// per thread, all of them drained into one global pending set (sans
+// duplicates) serviced by a single shared pool of workers: all these
+// threads plus some helper threads, as needed to reach the global
+// maximum. Each worker picks the pending buffer with the earliest
+// deadline (ie. the least frames left before its ring-buffer would
+// under/overrun) that is not being serviced by another worker, while
+// buffers left waiting for too long are picked first anyway.
+//
+
+class qtractorAudioBufferPool;
+class qtractorAudioBufferWorker;
 
 class qtractorAudioBufferThread : public QThread
 {
@@ -69,14 +81,35 @@ public:
 	// Conditional resize check.
 	void checkSyncSize(unsigned int iSyncSize);
 
+	// Maximum number of workers in pool (global option).
+	static void setSyncWorkers(unsigned short iSyncWorkers);
+	static unsigned short syncWorkers();
+
+	// Scheduling statistics, for the whole pool.
+	struct SyncStats
+	{
+		unsigned long  picks;      // buffers serviced
+		unsigned long  overdue;    // picked out of deadline order
+		unsigned int   headroom;   // least deadline seen (frames)
+		unsigned int   underruns;  // nil deadline occurrences
+		unsigned int   pending;    // most pending at once
+		unsigned short workers;    // current pool size
+	};
+
+	// Scheduling statistics accessors (non RT-safe).
+	static void syncStats(SyncStats& stats);
+	static void resetSyncStats();
+
 protected:
 
-	// The main thread executives.
+	// The main thread executive.
 	void run();
-	void process();
 
 private:
 
+	// The pool drains our own queue.
+	friend class qtractorAudioBufferPool;
+
 	// Instance variables.
 	unsigned int          m_iSyncSize;
 	unsigned int          m_iSyncMask;
@@ -88,9 +121,12 @@ private:
 	// Whether the thread is logically running.
 	volatile bool m_bRunState;
 
-	// Thread synchronization objects.
-	QMutex m_mutex;
-	QWaitCondition m_cond;
+	// Shared worker pool (ref'counted).
+	static qtractorAudioBufferPool *g_pSyncPool;
+	static unsigned int g_iSyncPoolRefCount;
+
+	// Maximum number of workers in pool.
+	static unsigned short g_iSyncWorkers;
 };
 
 
@@ -126,15 +162,21 @@ public:
 	bool open(const QString& sFilename, int iMode = qtractorAudioFile::Read);
 	void close();
 
+	// Cache file path still pending, while reading from source.
+	const QString& cachePending() const;
+
 	// Buffer data read/write.
 	int read(float **ppFrames, unsigned int iFrames,
 		unsigned int iOffset = 0);
 	int write(float **ppFrames, unsigned int iFrames,
 		unsigned short iChannels = 0, unsigned int iOffset = 0);
 
-	// Special kind of super-read/channel-mix.
+	// Special kind of super-read/channel-mix; an optional
+	// per-frame gain envelope (eg. clip fades) takes over
+	// the gain ramp, indexed by the same frame offset.
 	int readMix(float **ppFrames, unsigned int iFrames,
-		unsigned short iChannels, unsigned int iOffset, float fGain);
+		unsigned short iChannels, unsigned int iOffset, float fGain,
+		const float *pGains = NULL);
 
 	// Buffer data seek.
 	bool seek(unsigned long iFrame);
@@ -187,6 +229,20 @@ public:
 	// Export-mode sync executive.
 	void syncExport();
 
+	// Sync deadline: frames left before the ring-buffer
+	// runs dry (playback) or full (recording); zero when
+	// initial, seek or close sync is pending.
+	unsigned int syncDeadline() const;
+
+	// Sync headroom statistics: least deadline ever seen
+	// and number of times it was found to be nil (returns
+	// whether it was a steady-state sample, ie. accounted).
+	bool updateSyncStats(unsigned int iDeadline);
+	void resetSyncStats();
+
+	unsigned int syncHeadroom() const;
+	unsigned int syncUnderruns() const;
+
 	// Internal peak descriptor accessors.
 	void setPeakFile(qtractorAudioPeakFile *pPeakFile);
 	qtractorAudioPeakFile *peakFile() const;
@@ -202,6 +258,9 @@ public:
 	static void setWsolaQuickSeek(bool bWsolaQuickSeek);
 	static bool isWsolaQuickSeek();
 
+	static void setWsolaFftSeek(bool bWsolaFftSeek);
+	static bool isWsolaFftSeek();
+
 protected:
 
 	// Read-sync mode methods (playback).
@@ -217,13 +276,18 @@ protected:
 	int writeFrames(float **ppFrames, unsigned int iFrames);
 	int flushFrames(float **ppFrames, unsigned int iFrames);
 
+	// Zero-copy (memory-mapped) file read into the ring-buffer
+	// (0 when there's no room left, -1 on end-of-file).
+	int readDirect(unsigned int iFrames);
+
 	// Buffer process methods.
 	int readBuffer  (unsigned int iFrames);
 	int writeBuffer (unsigned int iFrames);
 
 	// Special kind of super-read/channel-mix buffer helper.
 	int readMixFrames(float **ppFrames, unsigned int iFrames,
-		unsigned short iChannels, unsigned int iOffset, float fGain);
+		unsigned short iChannels, unsigned int iOffset, float fGain,
+		const float *pGains);
 
 	// I/O buffer release.
 	void deleteIOBuffers();
@@ -266,6 +330,8 @@ private:
 	float        **m_ppFrames;
 	float        **m_ppBuffer;
 
+	float        **m_ppRingFrames;
+
 	bool           m_bTimeStretch;
 	float          m_fTimeStretch;
 
@@ -274,6 +340,12 @@ private:
 
 	qtractorTimeStretcher *m_pTimeStretcher;
 
+	// Whether reading from a pre-rendered time-stretch cache.
+	bool           m_bStretchCache;
+
+	// Cache file path still pending (not ready yet).
+	QString        m_sCachePending;
+
 	float          m_fNextGain;
 	int            m_iRampGain;
 
@@ -288,12 +360,17 @@ private:
 
 	qtractorAudioPeakFile *m_pPeakFile;
 
+	// Sync headroom statistics.
+	unsigned int   m_iSyncHeadroom;
+	unsigned int   m_iSyncUnderruns;
+
 	// Sample-rate converter type global option.
 	static int     g_iResampleType;
 
 	// Time-stretch mode global options.
 	static bool    g_bWsolaTimeStretch;
 	static bool    g_bWsolaQuickSeek;
+	static bool    g_bWsolaFftSeek;
 };
 
 
@@ -0,0 +1,714 @@
+// qtractorAudioCache.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioCache.h"
+#include "qtractorAudioFile.h"
+#include "qtractorAudioBuffer.h"
+#include "qtractorAudioKernel.h"
+#include "qtractorTimeStretcher.h"
+
+#include "qtractorSession.h"
+
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+
+#include <QThread>
+#include <QWaitCondition>
+
+#include <QDateTime>
+
+#include <string.h>
+
+// libsndfile API.
+#include <sndfile.h>
+
+#ifdef CONFIG_LIBSAMPLERATE
+// libsamplerate API
+#include <samplerate.h>
+#endif
+
+
+// Transcoder buffer size in frames per channel.
+static const unsigned int c_iCacheFrames = (16 * 1024);
+
+// Default cache filename extension.
+static const QString c_sCacheFileExt = ".pcm";
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCacheWriter -- Cache file output helper.
+//
+
+class qtractorAudioCacheWriter
+{
+public:
+
+	// Constructor.
+	qtractorAudioCacheWriter(SNDFILE *pSndFile, unsigned short iChannels,
+		unsigned int iBufferSize, qtractorTimeStretcher *pTimeStretcher);
+
+	// Destructor.
+	~qtractorAudioCacheWriter();
+
+	// Write frames (through the time-stretcher, if any);
+	// no more than buffer-size frames at a time, please.
+	bool write(float **ppFrames, unsigned int iFrames);
+
+	// Flush any frames left in the time-stretcher, if any.
+	bool flush();
+
+protected:
+
+	// Drain all time-stretcher available output.
+	bool drain();
+
+	// Actual interleaved file output.
+	bool writef(float **ppFrames, unsigned int iFrames);
+
+private:
+
+	// Instance variables.
+	SNDFILE *m_pSndFile;
+
+	unsigned short m_iChannels;
+	unsigned int   m_iBufferSize;
+
+	float  *m_pBuffer;
+	float **m_ppFrames;
+
+	qtractorTimeStretcher *m_pTimeStretcher;
+};
+
+
+// Constructor.
+qtractorAudioCacheWriter::qtractorAudioCacheWriter ( SNDFILE *pSndFile,
+	unsigned short iChannels, unsigned int iBufferSize,
+	qtractorTimeStretcher *pTimeStretcher )
+	: m_pSndFile(pSndFile), m_iChannels(iChannels),
+		m_iBufferSize(iBufferSize), m_ppFrames(NULL),
+		m_pTimeStretcher(pTimeStretcher)
+{
+	m_pBuffer = new float [m_iChannels * m_iBufferSize];
+
+	if (m_pTimeStretcher) {
+		m_ppFrames = new float * [m_iChannels];
+		for (unsigned short i = 0; i < m_iChannels; ++i)
+			m_ppFrames[i] = new float [m_iBufferSize];
+	}
+}
+
+
+// Destructor.
+qtractorAudioCacheWriter::~qtractorAudioCacheWriter (void)
+{
+	if (m_ppFrames) {
+		for (unsigned short i = 0; i < m_iChannels; ++i)
+			delete [] m_ppFrames[i];
+		delete [] m_ppFrames;
+	}
+
+	delete [] m_pBuffer;
+}
+
+
+// Write frames (through the time-stretcher, if any).
+bool qtractorAudioCacheWriter::write ( float **ppFrames, unsigned int iFrames )
+{
+	if (m_pTimeStretcher == NULL)
+		return writef(ppFrames, iFrames);
+
+	m_pTimeStretcher->process(ppFrames, iFrames);
+
+	return drain();
+}
+
+
+// Flush any frames left in the time-stretcher, if any.
+bool qtractorAudioCacheWriter::flush (void)
+{
+	if (m_pTimeStretcher == NULL)
+		return true;
+
+	m_pTimeStretcher->flush();
+
+	return drain();
+}
+
+
+// Drain all time-stretcher available output.
+bool qtractorAudioCacheWriter::drain (void)
+{
+	unsigned int nahead = m_pTimeStretcher->available();
+	while (nahead > 0) {
+		if (nahead > m_iBufferSize)
+			nahead = m_iBufferSize;
+		nahead = m_pTimeStretcher->retrieve(m_ppFrames, nahead);
+		if (nahead > 0 && !writef(m_ppFrames, nahead))
+			return false;
+		nahead = m_pTimeStretcher->available();
+	}
+
+	return true;
+}
+
+
+// Actual interleaved file output.
+bool qtractorAudioCacheWriter::writef ( float **ppFrames, unsigned int iFrames )
+{
+	qtractorAudioKernel::interleave(m_pBuffer, ppFrames, m_iChannels, iFrames);
+
+	return (::sf_writef_float(m_pSndFile, m_pBuffer, iFrames) == sf_count_t(iFrames));
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCacheThread -- Decoded-PCM cache transcoder thread.
+//
+
+class qtractorAudioCacheThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioCacheThread(qtractorAudioCacheFactory *pCacheFactory);
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+	// Transcode request (non-RT).
+	void request(const QString& sFilename,
+		const QString& sCachePath, unsigned int iSampleRate,
+		float fTimeStretch, float fPitchShift, unsigned int iStretchFlags);
+
+	// Cancel all pending and current requests.
+	void clear();
+
+protected:
+
+	// Transcode request item.
+	struct Request
+	{
+		QString filename;
+		QString cachePath;
+		unsigned int sampleRate;
+		float timeStretch;
+		float pitchShift;
+		unsigned int stretchFlags;
+	};
+
+	// The main thread executive.
+	void run();
+
+	// Actual transcoding executive.
+	bool transcode(const Request& req);
+
+private:
+
+	// The cache factory owner.
+	qtractorAudioCacheFactory *m_pCacheFactory;
+
+	QList<Request> m_requests;
+
+	// Whether the thread is logically running.
+	volatile bool m_bRunState;
+
+	// Whether current transcoding is cancelled.
+	volatile bool m_bCancel;
+
+	// Thread synchronization objects.
+	QMutex m_mutex;
+	QWaitCondition m_cond;
+
+	// Current transcoding lock.
+	QMutex m_busy;
+};
+
+
+// Constructor.
+qtractorAudioCacheThread::qtractorAudioCacheThread (
+	qtractorAudioCacheFactory *pCacheFactory )
+	: QThread(), m_pCacheFactory(pCacheFactory),
+		m_bRunState(false), m_bCancel(false)
+{
+}
+
+
+// Run state accessor.
+void qtractorAudioCacheThread::setRunState ( bool bRunState )
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_bRunState = bRunState;
+
+	if (!m_bRunState) {
+		m_bCancel = true;
+		m_cond.wakeAll();
+	}
+}
+
+bool qtractorAudioCacheThread::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Transcode request (non-RT).
+void qtractorAudioCacheThread::request ( const QString& sFilename,
+	const QString& sCachePath, unsigned int iSampleRate,
+	float fTimeStretch, float fPitchShift, unsigned int iStretchFlags )
+{
+	QMutexLocker locker(&m_mutex);
+
+	QListIterator<Request> iter(m_requests);
+	while (iter.hasNext()) {
+		if (iter.next().cachePath == sCachePath)
+			return;
+	}
+
+	Request req;
+	req.filename     = sFilename;
+	req.cachePath    = sCachePath;
+	req.sampleRate   = iSampleRate;
+	req.timeStretch  = fTimeStretch;
+	req.pitchShift   = fPitchShift;
+	req.stretchFlags = iStretchFlags;
+	m_requests.append(req);
+
+	m_cond.wakeAll();
+}
+
+
+// Cancel all pending and current requests.
+void qtractorAudioCacheThread::clear (void)
+{
+	m_mutex.lock();
+	m_requests.clear();
+	m_bCancel = true;
+	m_mutex.unlock();
+
+	// Wait for the current one to give up...
+	m_busy.lock();
+	m_bCancel = false;
+	m_busy.unlock();
+}
+
+
+// The main thread executive.
+void qtractorAudioCacheThread::run (void)
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioCacheThread[%p]::run(): started...", this);
+#endif
+
+	m_mutex.lock();
+
+	m_bRunState = true;
+
+	while (m_bRunState) {
+		// Do whatever we must, then wait for more...
+		if (m_requests.isEmpty()) {
+			m_cond.wait(&m_mutex);
+			continue;
+		}
+		// Take the next one in line...
+		const Request req = m_requests.takeFirst();
+		m_busy.lock();
+		m_bCancel = false;
+		m_mutex.unlock();
+		// Skip if it's been already done...
+		if (!QFileInfo(req.cachePath).exists() && transcode(req))
+			m_pCacheFactory->notifyCacheEvent(req.cachePath);
+		m_busy.unlock();
+		m_mutex.lock();
+	}
+
+	m_mutex.unlock();
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioCacheThread[%p]::run(): stopped.", this);
+#endif
+}
+
+
+// Actual transcoding executive.
+bool qtractorAudioCacheThread::transcode ( const Request& req )
+{
+	const QString& sFilename = req.filename;
+	const QString& sCachePath = req.cachePath;
+
+	qtractorAudioFile *pFile
+		= qtractorAudioFileFactory::createAudioFile(sFilename);
+	if (pFile == NULL)
+		return false;
+
+	if (!pFile->open(sFilename)) {
+		delete pFile;
+		return false;
+	}
+
+	const unsigned short iChannels = pFile->channels();
+	unsigned int iSampleRateOut = pFile->sampleRate();
+	if (iChannels < 1 || iSampleRateOut < 1) {
+		delete pFile;
+		return false;
+	}
+
+	// Convert to target sample-rate, whether possible...
+	unsigned int iBufferSize = c_iCacheFrames;
+#ifdef CONFIG_LIBSAMPLERATE
+	SRC_STATE **ppSrcState = NULL;
+	float fResampleRatio = 1.0f;
+	const unsigned int iSampleRate = req.sampleRate;
+	if (iSampleRate > 0 && iSampleRate != iSampleRateOut) {
+		fResampleRatio = float(iSampleRate) / float(iSampleRateOut);
+		iSampleRateOut = iSampleRate;
+		iBufferSize = (unsigned int) (fResampleRatio * c_iCacheFrames) + 64;
+		const int iResampleType = qtractorAudioBuffer::resampleType();
+		ppSrcState = new SRC_STATE * [iChannels];
+		for (unsigned short i = 0; i < iChannels; ++i) {
+			int err = 0;
+			ppSrcState[i] = src_new(iResampleType, 1, &err);
+		}
+	}
+#endif
+
+	// Time-stretch and/or pitch-shift, whether asked...
+	qtractorTimeStretcher *pTimeStretcher = NULL;
+	if (req.timeStretch != 1.0f || req.pitchShift != 1.0f) {
+		pTimeStretcher = new qtractorTimeStretcher(iChannels,
+			iSampleRateOut, req.timeStretch, req.pitchShift,
+			req.stretchFlags, iBufferSize);
+	}
+
+	// Go open the (temporary) output file...
+	const QString sTempPath = sCachePath + ".tmp";
+
+	SF_INFO sfinfo;
+	::memset(&sfinfo, 0, sizeof(sfinfo));
+	sfinfo.channels   = iChannels;
+	sfinfo.samplerate = iSampleRateOut;
+	sfinfo.format     = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+	const QByteArray aTempPath = sTempPath.toUtf8();
+	SNDFILE *pSndFile = ::sf_open(aTempPath.constData(), SFM_WRITE, &sfinfo);
+
+	// Allocate the working buffers...
+	unsigned short i;
+	float **ppFrames = new float * [iChannels];
+	float **ppOutFrames = new float * [iChannels];
+	for (i = 0; i < iChannels; ++i) {
+		ppFrames[i] = new float [c_iCacheFrames];
+		ppOutFrames[i] = new float [iBufferSize];
+	}
+
+	qtractorAudioCacheWriter writer(pSndFile,
+		iChannels, iBufferSize, pTimeStretcher);
+
+	bool bResult = (pSndFile != NULL);
+
+	while (bResult && m_bRunState && !m_bCancel) {
+		const int nread = pFile->read(ppFrames, c_iCacheFrames);
+		// Decode/read error? Discard the whole lot...
+		if (nread < 0) {
+			bResult = false;
+			break;
+		}
+	#ifdef CONFIG_LIBSAMPLERATE
+		if (ppSrcState) {
+			int nused = 0;
+			int nfeed = 0;
+			int ngen  = 0;
+			do {
+				SRC_DATA src_data;
+				for (i = 0; i < iChannels; ++i) {
+					src_data.data_in       = ppFrames[i] + nused;
+					src_data.data_out      = ppOutFrames[i];
+					src_data.input_frames  = nread - nused;
+					src_data.output_frames = iBufferSize;
+					src_data.end_of_input  = (nread < 1);
+					src_data.src_ratio     = fResampleRatio;
+					src_data.input_frames_used = 0;
+					src_data.output_frames_gen = 0;
+					if (src_process(ppSrcState[i], &src_data)) {
+						bResult = false;
+						break;
+					}
+				}
+				if (!bResult)
+					break;
+				nfeed  = src_data.input_frames_used;
+				nused += nfeed;
+				ngen   = src_data.output_frames_gen;
+				if (ngen > 0 && !writer.write(ppOutFrames, ngen))
+					bResult = false;
+			} while (bResult && (ngen > 0 || (nfeed > 0 && nused < nread)));
+		}
+		else
+	#endif
+		if (nread > 0 && !writer.write(ppFrames, nread))
+			bResult = false;
+		// End-of-file?
+		if (nread < 1) {
+			if (bResult && !writer.flush())
+				bResult = false;
+			break;
+		}
+	}
+
+	if (m_bCancel || !m_bRunState)
+		bResult = false;
+
+	// Cleanup...
+	for (i = 0; i < iChannels; ++i) {
+		delete [] ppOutFrames[i];
+		delete [] ppFrames[i];
+	}
+	delete [] ppOutFrames;
+	delete [] ppFrames;
+
+	if (pTimeStretcher)
+		delete pTimeStretcher;
+
+#ifdef CONFIG_LIBSAMPLERATE
+	if (ppSrcState) {
+		for (i = 0; i < iChannels; ++i) {
+			if (ppSrcState[i])
+				src_delete(ppSrcState[i]);
+		}
+		delete [] ppSrcState;
+	}
+#endif
+
+	if (pSndFile)
+		::sf_close(pSndFile);
+
+	pFile->close();
+	delete pFile;
+
+	// Commit or discard...
+	if (bResult)
+		bResult = QFile::rename(sTempPath, sCachePath);
+	if (!bResult)
+		QFile::remove(sTempPath);
+
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorAudioCacheThread[%p]::transcode(\"%s\") %s.", this,
+		sCachePath.toUtf8().constData(), bResult ? "done" : "failed");
+#endif
+
+	return bResult;
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCacheFactory -- Decoded-PCM cache file factory.
+//
+
+// Global enabled options.
+bool qtractorAudioCacheFactory::g_bEnabled = true;
+bool qtractorAudioCacheFactory::g_bStretchEnabled = true;
+
+// Singleton instance pointer.
+qtractorAudioCacheFactory *qtractorAudioCacheFactory::g_pCacheFactory = NULL;
+
+// Singleton instance accessor (static).
+qtractorAudioCacheFactory *qtractorAudioCacheFactory::getInstance (void)
+{
+	return g_pCacheFactory;
+}
+
+
+// Constructor.
+qtractorAudioCacheFactory::qtractorAudioCacheFactory ( QObject *pParent )
+	: QObject(pParent), m_bAutoRemove(false), m_pCacheThread(NULL)
+{
+	// Pseudo-singleton reference setup.
+	g_pCacheFactory = this;
+}
+
+
+// Default destructor.
+qtractorAudioCacheFactory::~qtractorAudioCacheFactory (void)
+{
+	if (m_pCacheThread) {
+		if (m_pCacheThread->isRunning()) do {
+			m_pCacheThread->setRunState(false);
+		} while (!m_pCacheThread->wait(100));
+		delete m_pCacheThread;
+		m_pCacheThread = NULL;
+	}
+
+	cleanup();
+
+	// Pseudo-singleton reference shut-down.
+	g_pCacheFactory = NULL;
+}
+
+
+// Cache file path for a given source file, whether applicable;
+// request its creation, if not readily available.
+QString qtractorAudioCacheFactory::cachePath (
+	const QString& sFilename, unsigned int iSampleRate,
+	float fTimeStretch, float fPitchShift, unsigned int iStretchFlags )
+{
+	if (fTimeStretch != 1.0f || fPitchShift != 1.0f) {
+		if (!g_bStretchEnabled)
+			return QString();
+	}
+	else
+	if (!g_bEnabled || !isCacheable(sFilename))
+		return QString();
+
+	QMutexLocker locker(&m_mutex);
+
+	const QString& sCachePath = cacheName(sFilename,
+		iSampleRate, fTimeStretch, fPitchShift, iStretchFlags);
+	m_caches.insert(sCachePath, sFilename);
+
+	if (QFileInfo(sCachePath).exists())
+		return sCachePath;
+
+	if (m_pCacheThread == NULL) {
+		m_pCacheThread = new qtractorAudioCacheThread(this);
+		m_pCacheThread->start(QThread::LowPriority);
+	}
+
+	m_pCacheThread->request(sFilename, sCachePath,
+		iSampleRate, fTimeStretch, fPitchShift, iStretchFlags);
+
+	return sCachePath;
+}
+
+
+// Cache ready event notifier.
+void qtractorAudioCacheFactory::notifyCacheEvent ( const QString& sCachePath )
+{
+	emit cacheEvent(sCachePath);
+}
+
+
+// Auto-delete property.
+void qtractorAudioCacheFactory::setAutoRemove ( bool bAutoRemove )
+{
+	m_bAutoRemove = bAutoRemove;
+}
+
+bool qtractorAudioCacheFactory::isAutoRemove (void) const
+{
+	return m_bAutoRemove;
+}
+
+
+// Cleanup method.
+void qtractorAudioCacheFactory::cleanup (void)
+{
+	QMutexLocker locker(&m_mutex);
+
+	if (m_pCacheThread)
+		m_pCacheThread->clear();
+
+	// Remove all current cache files, if asked...
+	if (m_bAutoRemove) {
+		CacheFiles::ConstIterator iter = m_caches.constBegin();
+		const CacheFiles::ConstIterator& iter_end = m_caches.constEnd();
+		for ( ; iter != iter_end; ++iter)
+			QFile::remove(iter.key());
+	}
+
+	m_caches.clear();
+}
+
+
+// Cache file path standard.
+QString qtractorAudioCacheFactory::cacheName (
+	const QString& sFilename, unsigned int iSampleRate,
+	float fTimeStretch, float fPitchShift, unsigned int iStretchFlags )
+{
+	QDir dir;
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession)
+		dir.setPath(pSession->sessionDir());
+
+	const QFileInfo fileInfo(sFilename);
+	const QString& sCacheFilePrefix
+		= QFileInfo(dir, fileInfo.fileName()).filePath();
+	QString sCacheName = fileInfo.absoluteFilePath()
+		+ '_' + QString::number(fileInfo.lastModified().toTime_t())
+		+ '_' + QString::number(iSampleRate);
+	if (fTimeStretch != 1.0f || fPitchShift != 1.0f) {
+		sCacheName += '_' + QString::number(fTimeStretch, 'g', 9)
+			+ '_' + QString::number(fPitchShift, 'g', 9)
+			+ '_' + QString::number(iStretchFlags);
+	}
+	const QFileInfo cacheInfo(sCacheFilePrefix + '_'
+		+ QString::number(qHash(sCacheName), 16)
+		+ c_sCacheFileExt);
+
+	return cacheInfo.absoluteFilePath();
+}
+
+
+// Whether a given source file is worth caching at all.
+bool qtractorAudioCacheFactory::isCacheable ( const QString& sFilename )
+{
+	const QString& sExt = QFileInfo(sFilename).suffix().toLower();
+
+	bool bCacheable = false;
+
+	QListIterator<qtractorAudioFileFactory::FileFormat *>
+		iter(qtractorAudioFileFactory::formats());
+	while (iter.hasNext()) {
+		const qtractorAudioFileFactory::FileFormat *pFormat = iter.next();
+		if (pFormat->ext == sExt)
+			bCacheable = (pFormat->type != qtractorAudioFileFactory::SndFile);
+	}
+
+	return bCacheable;
+}
+
+
+// Global enabled options.
+void qtractorAudioCacheFactory::setEnabled ( bool bEnabled )
+{
+	g_bEnabled = bEnabled;
+}
+
+bool qtractorAudioCacheFactory::isEnabled (void)
+{
+	return g_bEnabled;
+}
+
+
+void qtractorAudioCacheFactory::setStretchEnabled ( bool bStretchEnabled )
+{
+	g_bStretchEnabled = bStretchEnabled;
+}
+
+bool qtractorAudioCacheFactory::isStretchEnabled (void)
+{
+	return g_bStretchEnabled;
+}
+
+
+// end of qtractorAudioCache.cpp
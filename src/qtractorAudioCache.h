@@ -0,0 +1,135 @@
+// qtractorAudioCache.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioCache_h
+#define __qtractorAudioCache_h
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+#include <QMutex>
+
+
+// Forward declarations.
+class qtractorAudioCacheThread;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioCacheFactory -- Decoded-PCM cache file factory.
+//
+// Compressed audio sources (eg. MP3, Ogg Vorbis) are transcoded, once
+// and in the background, into plain 32bit float WAV files, converted
+// to the current session sample-rate, whenever possible, and placed
+// beside the peak files. Cache files are keyed by source file path,
+// modification time and sample-rate, so that playback and seeking
+// can be served from the cache instead of decoding on the fly.
+//
+// Time-stretched and/or pitch-shifted clips get their whole source
+// pre-rendered likewise, through the very same time-stretcher engine
+// as used on live playback, additionally keyed by time-stretch ratio,
+// pitch-shift ratio and stretcher algorithm flags.
+//
+// Whenever a cache file gets ready, a notification is signaled, so
+// that buffers still reading from the source can switch over to it.
+//
+
+class qtractorAudioCacheFactory : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	// Constructor.
+	qtractorAudioCacheFactory(QObject *pParent = NULL);
+	// Default destructor.
+	~qtractorAudioCacheFactory();
+
+	// Cache file path for a given source file, whether applicable,
+	// otherwise an empty string; its creation is requested in the
+	// background, if not readily available (ie. still missing).
+	QString cachePath(const QString& sFilename, unsigned int iSampleRate,
+		float fTimeStretch = 1.0f, float fPitchShift = 1.0f,
+		unsigned int iStretchFlags = 0);
+
+	// Cache ready event notification.
+	void notifyCacheEvent(const QString& sCachePath);
+
+	// Auto-delete property.
+	void setAutoRemove(bool bAutoRemove);
+	bool isAutoRemove() const;
+
+	// Cleanup method.
+	void cleanup();
+
+	// Cache file path standard.
+	static QString cacheName(const QString& sFilename,
+		unsigned int iSampleRate, float fTimeStretch = 1.0f,
+		float fPitchShift = 1.0f, unsigned int iStretchFlags = 0);
+
+	// Whether a given source file is worth caching at all.
+	static bool isCacheable(const QString& sFilename);
+
+	// Global enabled options (decoded and time-stretched).
+	static void setEnabled(bool bEnabled);
+	static bool isEnabled();
+
+	static void setStretchEnabled(bool bStretchEnabled);
+	static bool isStretchEnabled();
+
+	// Singleton instance accessor.
+	static qtractorAudioCacheFactory *getInstance();
+
+signals:
+
+	// Cache ready signal.
+	void cacheEvent(const QString& sCachePath);
+
+private:
+
+	// Factory mutex.
+	QMutex m_mutex;
+
+	// The list of cache files in use (path to source).
+	typedef QHash<QString, QString> CacheFiles;
+
+	CacheFiles m_caches;
+
+	// Auto-delete property.
+	bool m_bAutoRemove;
+
+	// The transcoder thread.
+	qtractorAudioCacheThread *m_pCacheThread;
+
+	// Global enabled options.
+	static bool g_bEnabled;
+	static bool g_bStretchEnabled;
+
+	// The pseudo-singleton instance.
+	static qtractorAudioCacheFactory *g_pCacheFactory;
+};
+
+
+#endif  // __qtractorAudioCache_h
+
+
+// end of qtractorAudioCache.h
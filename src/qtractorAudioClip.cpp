@@ -1,7 +1,7 @@
 // qtractorAudioClip.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -23,11 +23,13 @@
 #include "qtractorAudioClip.h"
 #include "qtractorAudioEngine.h"
 #include "qtractorAudioPeak.h"
+#include "qtractorAudioKernel.h"
 
 #include "qtractorDocument.h"
 
 #include "qtractorSession.h"
 #include "qtractorFileList.h"
+#include "qtractorXrunTrace.h"
 
 #include <QFileInfo>
 #include <QPainter>
@@ -133,6 +135,9 @@ qtractorAudioClip::qtractorAudioClip ( qtractorTrack *pTrack )
 	m_fPitchShift  = 1.0f;
 
 	m_iOverlap = 0;
+
+	m_pGains = NULL;
+	m_iGains = 0;
 }
 
 // Copy constructor.
@@ -148,6 +153,9 @@ qtractorAudioClip::qtractorAudioClip ( const qtractorAudioClip& clip )
 
 	m_iOverlap = clip.overlap();
 
+	m_pGains = NULL;
+	m_iGains = 0;
+
 	setFilename(clip.filename());
 	setClipGain(clip.clipGain());
 	setClipName(clip.clipName());
@@ -165,6 +173,9 @@ qtractorAudioClip::~qtractorAudioClip (void)
 
 	if (m_pPeak)
 		delete m_pPeak;
+
+	if (m_pGains)
+		delete [] m_pGains;
 }
 
 
@@ -256,6 +267,11 @@ bool qtractorAudioClip::openAudioFile ( const QString& sFilename, int iMode )
 	if (bWrite && iChannels < 1)
 		return false;
 
+	// Fades gain envelope buffer, one period at least...
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	if (pAudioEngine)
+		setBufferSize(pAudioEngine->bufferSize());
+
 	// Save old property (need for peak file ignition)...
 	const bool bFilenameChanged = (sFilename != filename());
 
@@ -294,6 +310,9 @@ bool qtractorAudioClip::openAudioFile ( const QString& sFilename, int iMode )
 							delete m_pPeak;
 						m_pPeak = pPeakFactory->createPeak(
 							sFilename, pBuff->timeStretch());
+						// Get it (re)created in background...
+						if (!bWrite)
+							pPeakFactory->sync(m_pPeak->peakFile(), false);
 					}
 				}
 				// Clip name should be clear about it all.
@@ -336,6 +355,8 @@ bool qtractorAudioClip::openAudioFile ( const QString& sFilename, int iMode )
 				sFilename, pBuff->timeStretch());
 			if (bWrite)
 				pBuff->setPeakFile(m_pPeak->peakFile());
+			else // Get it (re)created in background...
+				pPeakFactory->sync(m_pPeak->peakFile(), false);
 		}
 	}
 
@@ -563,6 +584,35 @@ void qtractorAudioClip::open (void)
 }
 
 
+// Fades gain envelope buffer (re)allocation (not RT-safe).
+void qtractorAudioClip::setBufferSize ( unsigned int iBufferSize )
+{
+	if (m_iGains >= iBufferSize)
+		return;
+
+	if (m_pGains)
+		delete [] m_pGains;
+
+	m_pGains = new float [iBufferSize];
+	m_iGains = iBufferSize;
+}
+
+
+// Sample-accurate fades gain envelope (RT-safe);
+// NULL if there's no fade in range (or no room).
+const float *qtractorAudioClip::fadeGains ( unsigned int iOffset,
+	unsigned long iClipOffset, unsigned int iFrames )
+{
+	if (m_pGains == NULL || iOffset + iFrames > m_iGains)
+		return NULL;
+
+	if (!gains(m_pGains + iOffset, iClipOffset, iFrames))
+		return NULL;
+
+	return m_pGains;
+}
+
+
 // Audio clip special process cycle executive.
 void qtractorAudioClip::process (
 	unsigned long iFrameStart, unsigned long iFrameEnd )
@@ -576,6 +626,9 @@ void qtractorAudioClip::process (
 	if (pAudioBus == NULL)
 		return;
 
+	// Either the output bus or a private graph node buffer...
+	float **ppBuffer = track()->audioBuffer();
+
 	// Get the next bunch from the clip...
 	const unsigned long iClipStart = clipStart();
 	if (iClipStart > iFrameEnd)
@@ -588,25 +641,41 @@ void qtractorAudioClip::process (
 	const unsigned long iOffset
 		= (iFrameEnd < iClipEnd ? iFrameEnd : iClipEnd) - iClipStart;
 
+	// Ring-buffer fill level, for the record...
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+	if (pXrunTrace) pXrunTrace->addItem(qtractorXrunTrace::Buffer,
+		this, pBuff->syncDeadline());
+
+	int nread = 0;
+
 	if (iClipStart > iFrameStart) {
 		if (pBuff->inSync(0, iOffset)) {
-			pBuff->readMix(
-				pAudioBus->buffer(),
-				iOffset,
+			const unsigned int iFrames = iOffset;
+			nread = pBuff->readMix(
+				ppBuffer,
+				iFrames,
 				pAudioBus->channels(),
 				iClipStart - iFrameStart,
-				gain(iOffset));
+				gain(iOffset),
+				fadeGains(iClipStart - iFrameStart, 0, iFrames));
 		}
 	} else {
 		if (pBuff->inSync(iFrameStart - iClipStart, iOffset)) {
-			pBuff->readMix(
-				pAudioBus->buffer(),
-				(iFrameEnd < iClipEnd ? iFrameEnd : iClipEnd) - iFrameStart,
+			const unsigned int iFrames
+				= (iFrameEnd < iClipEnd ? iFrameEnd : iClipEnd) - iFrameStart;
+			nread = pBuff->readMix(
+				ppBuffer,
+				iFrames,
 				pAudioBus->channels(),
 				0,
-				gain(iOffset));
+				gain(iOffset),
+				fadeGains(0, iFrameStart - iClipStart, iFrames));
 		}
 	}
+
+	// Track buffer is not silent anymore...
+	if (nread > 0)
+		track()->setAudioSilent(false);
 }
 
 
@@ -827,11 +896,8 @@ bool qtractorAudioClip::clipExport ( ClipExport pfnClipExport, void *pvArg,
 			const int nread = pBuff->read(ppFrames, iFrames);
 			if (nread < 1)
 				break;
-			for (i = 0; i < iChannels; ++i) {
-				float *pFrames = ppFrames[i];
-				for (int n = 0; n < nread; ++n)
-					*pFrames++ *= fGain;
-			}
+			for (i = 0; i < iChannels; ++i)
+				qtractorAudioKernel::gain(ppFrames[i], nread, fGain);
 			(*pfnClipExport)(ppFrames, nread, pvArg);
 			iFrameStart += nread;
 		}
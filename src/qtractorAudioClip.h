@@ -1,7 +1,7 @@
 // qtractorAudioClip.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -83,6 +83,9 @@ public:
 	// Clip close-commit (record specific)
 	void close();
 
+	// Fades gain envelope buffer (re)allocation (not RT-safe).
+	void setBufferSize(unsigned int iBufferSize);
+
 	// Audio clip special process cycle executive.
 	void process(unsigned long iFrameStart, unsigned long iFrameEnd);
 
@@ -195,6 +198,11 @@ protected:
 	// Alternating overlap test.
 	bool isOverlap(unsigned int iOverlapSize) const;
 
+	// Sample-accurate fades gain envelope (RT-safe);
+	// NULL if there's no fade in range (or no room).
+	const float *fadeGains(unsigned int iOffset,
+		unsigned long iClipOffset, unsigned int iFrames);
+
 private:
 
 	// Instance variables.
@@ -206,6 +214,10 @@ private:
 	// Alternate overlap tag.
 	unsigned int m_iOverlap;
 
+	// Fades gain envelope buffer (one period).
+	float        *m_pGains;
+	unsigned int  m_iGains;
+
 	// Most interesting key/data (ref-counted?)...
 	Key  *m_pKey;
 	Data *m_pData;
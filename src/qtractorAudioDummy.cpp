@@ -0,0 +1,152 @@
+// qtractorAudioDummy.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioDummy.h"
+#include "qtractorAudioEngine.h"
+
+#include <time.h>
+#include <errno.h>
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioDummyDriver -- Null/dummy audio driver (no JACK).
+//
+
+// Constructor.
+qtractorAudioDummyDriver::qtractorAudioDummyDriver (
+	qtractorAudioEngine *pAudioEngine, unsigned int iSampleRate,
+	unsigned int iBufferSize, bool bRealTime ) : QThread()
+{
+	m_pAudioEngine = pAudioEngine;
+
+	m_iSampleRate = iSampleRate;
+	m_iBufferSize = iBufferSize;
+
+	m_bRealTime = bRealTime;
+	m_bRunState = false;
+
+	m_iFrameTime = 0;
+	m_iXruns = 0;
+}
+
+
+// Nominal sample-rate and buffer size accessors.
+unsigned int qtractorAudioDummyDriver::sampleRate (void) const
+{
+	return m_iSampleRate;
+}
+
+unsigned int qtractorAudioDummyDriver::bufferSize (void) const
+{
+	return m_iBufferSize;
+}
+
+
+// Real-time (clock paced) mode accessor.
+bool qtractorAudioDummyDriver::isRealTime (void) const
+{
+	return m_bRealTime;
+}
+
+
+// Run state accessor.
+void qtractorAudioDummyDriver::setRunState ( bool bRunState )
+{
+	m_bRunState = bRunState;
+}
+
+bool qtractorAudioDummyDriver::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Absolute number of frames elapsed since driver start.
+unsigned long qtractorAudioDummyDriver::frameTime (void) const
+{
+	return m_iFrameTime;
+}
+
+
+// Number of cycles that missed their deadline (real-time only).
+unsigned long qtractorAudioDummyDriver::xruns (void) const
+{
+	return m_iXruns;
+}
+
+
+// Thread run executive.
+void qtractorAudioDummyDriver::run (void)
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioDummyDriver[%p]::run(): started.", this);
+#endif
+
+	// Nominal cycle period (nanoseconds).
+	long iPeriod = 0;
+	if (m_bRealTime && m_iSampleRate > 0) {
+		iPeriod = long((1000000000ULL * m_iBufferSize) / m_iSampleRate);
+		if (iPeriod >= 1000000000L)
+			iPeriod  = 999999999L;
+	}
+
+	struct timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	m_bRunState = true;
+
+	while (m_bRunState) {
+		// Do the real thing...
+		m_pAudioEngine->process(m_iBufferSize);
+		m_iFrameTime += m_iBufferSize;
+		// As fast as possible?
+		if (iPeriod < 1)
+			continue;
+		// Next cycle deadline...
+		ts.tv_nsec += iPeriod;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_nsec -= 1000000000L;
+			++ts.tv_sec;
+		}
+		// Missed it already? restart from now...
+		struct timespec now;
+		::clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > ts.tv_sec
+			|| (now.tv_sec == ts.tv_sec && now.tv_nsec > ts.tv_nsec)) {
+			++m_iXruns;
+			m_pAudioEngine->notifyXrunEvent();
+			ts = now;
+			continue;
+		}
+		// Wait for it...
+		while (::clock_nanosleep(CLOCK_MONOTONIC,
+			TIMER_ABSTIME, &ts, NULL) == EINTR && m_bRunState)
+			;
+	}
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioDummyDriver[%p]::run(): stopped.", this);
+#endif
+}
+
+
+// end of qtractorAudioDummy.cpp
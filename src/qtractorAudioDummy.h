@@ -0,0 +1,94 @@
+// qtractorAudioDummy.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioDummy_h
+#define __qtractorAudioDummy_h
+
+#include <QThread>
+
+
+// Forward declarations.
+class qtractorAudioEngine;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioDummyDriver -- Null/dummy audio driver (no JACK).
+//
+// Drives the audio engine process cycle from its own thread, either
+// paced by the monotonic clock at the nominal sample-rate (real-time)
+// or just as fast as possible. All audio buses are then left without
+// any JACK ports, processing on their own private buffers instead.
+//
+
+class qtractorAudioDummyDriver : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioDummyDriver(qtractorAudioEngine *pAudioEngine,
+		unsigned int iSampleRate, unsigned int iBufferSize,
+		bool bRealTime = true);
+
+	// Nominal sample-rate and buffer size accessors.
+	unsigned int sampleRate() const;
+	unsigned int bufferSize() const;
+
+	// Real-time (clock paced) mode accessor.
+	bool isRealTime() const;
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+	// Absolute number of frames elapsed since driver start.
+	unsigned long frameTime() const;
+
+	// Number of cycles that missed their deadline (real-time only).
+	unsigned long xruns() const;
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+private:
+
+	// Instance variables.
+	qtractorAudioEngine *m_pAudioEngine;
+
+	unsigned int m_iSampleRate;
+	unsigned int m_iBufferSize;
+
+	bool m_bRealTime;
+
+	// Whether the thread is logically running.
+	volatile bool m_bRunState;
+
+	// Running frame time and missed deadlines.
+	volatile unsigned long m_iFrameTime;
+	volatile unsigned long m_iXruns;
+};
+
+
+#endif  // __qtractorAudioDummy_h
+
+
+// end of qtractorAudioDummy.h
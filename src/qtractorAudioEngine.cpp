@@ -24,6 +24,9 @@
 #include "qtractorAudioMonitor.h"
 #include "qtractorAudioBuffer.h"
 #include "qtractorAudioClip.h"
+#include "qtractorAudioGraph.h"
+#include "qtractorAudioDummy.h"
+#include "qtractorAudioKernel.h"
 
 #include "qtractorSession.h"
 
@@ -31,12 +34,15 @@
 
 #include "qtractorMonitor.h"
 #include "qtractorSessionCursor.h"
+#include "qtractorSessionSnapshot.h"
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiManager.h"
 #include "qtractorPlugin.h"
 #include "qtractorClip.h"
 
 #include "qtractorCurveFile.h"
+#include "qtractorRenderStats.h"
+#include "qtractorXrunTrace.h"
 
 #include "qtractorMainForm.h"
 
@@ -56,81 +62,19 @@
 
 #include <QApplication>
 #include <QProgressBar>
+#include <QTime>
 #include <QDomDocument>
 
-#if defined(__SSE__)
-
-#include <xmmintrin.h>
-
-// SSE detection.
-static inline bool sse_enabled (void)
-{
-#if defined(__GNUC__)
-	unsigned int eax, ebx, ecx, edx;
-#if defined(__x86_64__) || (!defined(PIC) && !defined(__PIC__))
-	__asm__ __volatile__ (
-		"cpuid\n\t" \
-		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#else
-	__asm__ __volatile__ (
-		"push %%ebx\n\t" \
-		"cpuid\n\t" \
-		"movl %%ebx,%1\n\t" \
-		"pop %%ebx\n\t" \
-		: "=a" (eax), "=r" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#endif
-	return (edx & (1 << 25));
-#else
-	return false;
-#endif
-}
-
-
-// SSE enabled mix-down processor version.
-static inline void sse_buffer_add (
-	float **ppBuffer, float **ppFrames, unsigned int iFrames,
-	unsigned short iBuffers, unsigned short iChannels, unsigned int iOffset )
-{
-	unsigned short j = 0;
-
-	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[j] + iOffset;
-		float *pFrames = ppFrames[i] + iOffset;
-		unsigned int nframes = iFrames;
-		for (; (long(pBuffer) & 15) && (nframes > 0); --nframes)
-			*pBuffer++ += *pFrames++;
-		for (; nframes >= 4; nframes -= 4) {
-			_mm_store_ps(pBuffer,
-				_mm_add_ps(
-					_mm_loadu_ps(pBuffer),
-					_mm_loadu_ps(pFrames)));
-			pFrames += 4;
-			pBuffer += 4;
-		}
-		for (; nframes > 0; --nframes)
-			*pBuffer++ += *pFrames++;
-		if (++j >= iBuffers)
-			j = 0;
-	}
-}
-
-#endif
-
-
-// Standard mix-down processor version.
-static inline void std_buffer_add (
+// Mix-down processor (multi-channel).
+static inline void buffer_add (
 	float **ppBuffer, float **ppFrames, unsigned int iFrames,
 	unsigned short iBuffers, unsigned short iChannels, unsigned int iOffset )
 {
 	unsigned short j = 0;
 
 	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[j] + iOffset;
-		float *pFrames = ppFrames[i] + iOffset;
-		for (unsigned int n = 0; n < iFrames; ++n)
-			*pBuffer++ += *pFrames++;
+		qtractorAudioKernel::add(
+			ppBuffer[j] + iOffset, ppFrames[i] + iOffset, iFrames);
 		if (++j >= iBuffers)
 			j = 0;
 	}
@@ -156,13 +100,6 @@ public:
 
 		for (unsigned short i = 0; i < m_iChannels; ++i)
 			m_ppBuffer[i] = new float [iBufferSize];
-
-	#if defined(__SSE__)
-		if (sse_enabled())
-			m_pfnBufferAdd = sse_buffer_add;
-		else
-	#endif
-		m_pfnBufferAdd = std_buffer_add;
 	}
 
 	// Destructor.
@@ -195,10 +132,23 @@ public:
 	void process_add (qtractorAudioBus *pAudioBus,
 		unsigned int nframes, unsigned int offset = 0)
 	{
-		(*m_pfnBufferAdd)(m_ppBuffer, pAudioBus->out(),
+		buffer_add(m_ppBuffer, pAudioBus->out(),
 			nframes, m_iChannels, pAudioBus->channels(), offset);
 	}
 
+	// Incremental mix-down buffer (from offset work buffers).
+	void process_add (float **ppFrames, unsigned short iChannels,
+		unsigned int nframes, unsigned int offset = 0)
+	{
+		unsigned short j = 0;
+		for (unsigned short i = 0; i < iChannels; ++i) {
+			qtractorAudioKernel::add(
+				m_ppBuffer[j] + offset, ppFrames[i], nframes);
+			if (++j >= m_iChannels)
+				j = 0;
+		}
+	}
+
 private:
 
 	unsigned short m_iChannels;
@@ -206,10 +156,6 @@ private:
 
 	// Mix-down buffer.
 	float **m_ppBuffer;
-
-	// Mix-down buffer processor.
-	void (*m_pfnBufferAdd)(float **, float **, unsigned int,
-		unsigned short, unsigned short, unsigned int);
 };
 
 
@@ -398,6 +344,13 @@ qtractorAudioEngine::qtractorAudioEngine ( qtractorSession *pSession )
 {
 	m_pJackClient = NULL;
 
+	// Null/dummy audio driver (no JACK).
+	m_pDummyDriver     = NULL;
+	m_bDummyDriver     = false;
+	m_iDummySampleRate = 48000;
+	m_iDummyBufferSize = 1024;
+	m_bDummyRealTime   = true;
+
 	m_iSampleRate = 44100;	// A sensible default, always.
 	m_iBufferSize = 0;
 
@@ -411,11 +364,24 @@ qtractorAudioEngine::qtractorAudioEngine ( qtractorSession *pSession )
 	// Common audio buffer sync thread.
 	m_pSyncThread = NULL;
 
+	// Sample-accurate automation frame resolution.
+	m_iAutomationFrames = 64;
+
+	// Silent plugin-chain tail hold time.
+	m_iPluginIdleTime = 2000;
+
+	// Parallel process graph.
+	m_iGraphThreads = 0;
+	m_pGraph = NULL;
+
 	// Audio-export (in)active state.
 	m_bExporting   = false;
+	m_bOfflineExport = true;
+	m_bOffline     = false;
 	m_pExportFile  = NULL;
 	m_pExportBuses = NULL;
 	m_pExportBuffer = NULL;
+	m_pExportTrack = NULL;
 	m_iExportStart = 0;
 	m_iExportEnd   = 0;
 	m_bExportDone  = true;
@@ -467,6 +433,11 @@ void qtractorAudioEngine::notifyShutEvent (void)
 
 void qtractorAudioEngine::notifyXrunEvent (void)
 {
+	// Keep the trace of what happened...
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+	if (pXrunTrace)
+		pXrunTrace->freeze();
+
 	m_proxy.notifyXrunEvent();
 }
 
@@ -543,39 +514,52 @@ bool qtractorAudioEngine::init (void)
 	if (pSession == NULL)
 		return false;
 
-	// Try open a new client...
-	const QByteArray aClientName = pSession->clientName().toUtf8();
-	int opts = JackNullOption;
-#ifdef CONFIG_XUNIQUE
-	opts |= JackUseExactName;
-#endif
-#ifdef CONFIG_JACK_SESSION
-	if (!m_sSessionId.isEmpty()) {
-		opts |= JackSessionID;
-		const QByteArray aSessionId = m_sSessionId.toLocal8Bit();
+	// Null/dummy audio driver (no JACK)?
+	if (m_bDummyDriver) {
+		// Sample-rate and buffer size are just nominal...
+		m_iSampleRate = m_iDummySampleRate;
+		m_iBufferSize = m_iDummyBufferSize;
+		if (m_iSampleRate < 1)
+			m_iSampleRate = 48000;
+		if (m_iBufferSize < 1)
+			m_iBufferSize = 1024;
+		m_pDummyDriver = new qtractorAudioDummyDriver(this,
+			m_iSampleRate, m_iBufferSize, m_bDummyRealTime);
+	} else {
+		// Try open a new client...
+		const QByteArray aClientName = pSession->clientName().toUtf8();
+		int opts = JackNullOption;
+	#ifdef CONFIG_XUNIQUE
+		opts |= JackUseExactName;
+	#endif
+	#ifdef CONFIG_JACK_SESSION
+		if (!m_sSessionId.isEmpty()) {
+			opts |= JackSessionID;
+			const QByteArray aSessionId = m_sSessionId.toLocal8Bit();
+			m_pJackClient = jack_client_open(
+				aClientName.constData(),
+				jack_options_t(opts), NULL,
+				aSessionId.constData());
+			// Reset JACK session UUID.
+			m_sSessionId.clear();
+		}
+		else
+	#endif
 		m_pJackClient = jack_client_open(
 			aClientName.constData(),
-			jack_options_t(opts), NULL,
-			aSessionId.constData());
-		// Reset JACK session UUID.
-		m_sSessionId.clear();
-	}
-	else
-#endif
-	m_pJackClient = jack_client_open(
-		aClientName.constData(),
-		jack_options_t(opts), NULL);
+			jack_options_t(opts), NULL);
 
-	if (m_pJackClient == NULL)
-		return false;
+		if (m_pJackClient == NULL)
+			return false;
 
-	// ATTN: First thing to remember is initial sample-rate and buffer size.
-	m_iSampleRate = jack_get_sample_rate(m_pJackClient);
-	m_iBufferSize = jack_get_buffer_size(m_pJackClient);
+		// ATTN: First thing to remember is initial sample-rate and buffer size.
+		m_iSampleRate = jack_get_sample_rate(m_pJackClient);
+		m_iBufferSize = jack_get_buffer_size(m_pJackClient);
 
-	// ATTN: Second is setting proper session client name.
-	pSession->setClientName(
-		QString::fromUtf8(jack_get_client_name(m_pJackClient)));
+		// ATTN: Second is setting proper session client name.
+		pSession->setClientName(
+			QString::fromUtf8(jack_get_client_name(m_pJackClient)));
+	}
 
 	// ATTN: Third is setting session sample rate.
 	pSession->setSampleRate(m_iSampleRate);
@@ -584,6 +568,16 @@ bool qtractorAudioEngine::init (void)
 	m_pSyncThread = new qtractorAudioBufferThread();
 	m_pSyncThread->start(QThread::HighPriority);
 
+	// Our parallel process graph worker threads...
+	int iGraphThreads = m_iGraphThreads;
+	if (iGraphThreads < 1)
+		iGraphThreads = QThread::idealThreadCount();
+	if (--iGraphThreads > 0) {
+		const int iPriority = (m_pJackClient && jack_is_realtime(m_pJackClient)
+			? jack_client_real_time_priority(m_pJackClient) : 0);
+		m_pGraph = new qtractorAudioGraph(this, iGraphThreads, iPriority);
+	}
+
 	return true;
 }
 
@@ -610,6 +604,14 @@ bool qtractorAudioEngine::activate (void)
 		pMidiManager = pMidiManager->next();
 	}
 
+	// Null/dummy audio driver (no JACK) is just started...
+	if (m_pDummyDriver) {
+		resetAllMonitors();
+		updateGraph();
+		m_pDummyDriver->start(QThread::TimeCriticalPriority);
+		return true;
+	}
+
 	// Ensure (not) freewheeling state...
 	jack_set_freewheel(m_pJackClient, 0);
 
@@ -659,6 +661,9 @@ bool qtractorAudioEngine::activate (void)
 	// Reset all dependable monitoring...
 	resetAllMonitors();
 
+	// Parallel process graph node buffers...
+	updateGraph();
+
 	// Time to activate ourselves...
 	jack_activate(m_pJackClient);
 
@@ -704,7 +709,7 @@ bool qtractorAudioEngine::start (void)
 	resetMetro();
 
 	// Start transport rolling...
-	if (m_transportMode & qtractorBus::Output)
+	if (m_pJackClient && (m_transportMode & qtractorBus::Output))
 		jack_transport_start(m_pJackClient);
 
 	// We're now ready and running...
@@ -718,7 +723,7 @@ void qtractorAudioEngine::stop (void)
 	if (!isActivated())
 		return;
 
-	if (m_transportMode & qtractorBus::Output) {
+	if (m_pJackClient && (m_transportMode & qtractorBus::Output)) {
 		jack_transport_stop(m_pJackClient);
 		jack_transport_locate(m_pJackClient, sessionCursor()->frame());
 	}
@@ -742,6 +747,13 @@ void qtractorAudioEngine::deactivate (void)
 	// Deactivate the JACK client first.
 	if (m_pJackClient)
 		jack_deactivate(m_pJackClient);
+
+	// Or stop the null/dummy audio driver...
+	if (m_pDummyDriver) {
+		if (m_pDummyDriver->isRunning()) do {
+			m_pDummyDriver->setRunState(false);
+		} while (!m_pDummyDriver->wait(100));
+	}
 }
 
 
@@ -768,6 +780,12 @@ void qtractorAudioEngine::clean (void)
 		m_pSyncThread = NULL;
 	}
 
+	// Terminate parallel process graph worker threads...
+	if (m_pGraph) {
+		delete m_pGraph;
+		m_pGraph = NULL;
+	}
+
 	// Audio-export stilll around? weird...
 	if (m_pExportBuffer) {
 		delete m_pExportBuffer;
@@ -790,6 +808,12 @@ void qtractorAudioEngine::clean (void)
 		m_pJackClient = NULL;
 	}
 
+	// Or the null/dummy audio driver.
+	if (m_pDummyDriver) {
+		delete m_pDummyDriver;
+		m_pDummyDriver = NULL;
+	}
+
 	// Null sample-rate/period.
 	// m_iSampleRate = 0;
 	// m_iBufferSize = 0;
@@ -803,6 +827,17 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	if (!isActivated())
 		return 0;
 
+	// Are we rendering offline for export?...
+	// just keep all output ports silent meanwhile.
+	if (m_bOffline) {
+		qtractorBus *pBus;
+		for (pBus = buses().first(); pBus && m_pJackClient; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->process_silence(nframes);
+		for (pBus = busesEx().first(); pBus && m_pJackClient; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->process_silence(nframes);
+		return 0;
+	}
+
 	// Reset buffer offset.
 	m_iBufferOffset = 0;
 
@@ -823,9 +858,23 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	if (pAudioCursor == NULL)
 		return 0;
 
-	// Session RT-safeness lock...
-	if (!pSession->acquire())
+	// Trace this cycle, if asked for...
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+	if (pXrunTrace)
+		pXrunTrace->beginCycle(nframes, pAudioCursor->frame());
+
+	// Session RT-safeness lock (engine reconfiguration only;
+	// track and clip edits never get this cycle skipped)...
+	if (!pSession->acquire()) {
+		if (pXrunTrace)
+			pXrunTrace->endCycle(true);
 		return 0;
+	}
+
+	// Current track topology snapshot...
+	qtractorSessionSnapshot *pSnapshot
+		= pSession->enterSnapshot(qtractorSession::AudioReader);
+	pAudioCursor->sync(pSnapshot);
 
 	// Track whether audio output buses
 	// buses needs monitoring while idle...
@@ -876,7 +925,8 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 
 #ifdef CONFIG_LV2
 #ifdef CONFIG_LV2_TIME
-	qtractorLv2Plugin::updateTime(m_pJackClient);
+	if (m_pJackClient)
+		qtractorLv2Plugin::updateTime(m_pJackClient);
 #endif
 #endif
 
@@ -897,8 +947,9 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	// Don't go any further, if not playing.
 	if (!isPlaying()) {
 		// Do the idle processing...
-		for (qtractorTrack *pTrack = pSession->tracks().first();
-				pTrack; pTrack = pTrack->next()) {
+		const unsigned int iTracks = pSnapshot->tracks();
+		for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
 			// Audio-buffers needs some preparation...
 			if (pTrack->trackType() == qtractorTrack::Audio) {
 				qtractorAudioBus *pInputBus
@@ -921,8 +972,9 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 					qtractorAudioBus *pOutputBus
 						= static_cast<qtractorAudioBus *> (pTrack->outputBus());
 					if (pOutputBus) {
-						pOutputBus->buffer_prepare(nframes, pInputBus);
-						pPluginList->process(pOutputBus->buffer(), nframes);
+						const bool bSilent
+							= pOutputBus->buffer_prepare(nframes, pInputBus);
+						pOutputBus->buffer_process(pPluginList, nframes, bSilent);
 						pAudioMonitor->process(pOutputBus->buffer(), nframes);
 						pOutputBus->buffer_commit(nframes);
 						++iOutputBus;
@@ -941,7 +993,10 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 		}
 		// Done as idle...
 		pAudioCursor->process(nframes);
+		pSession->leaveSnapshot(qtractorSession::AudioReader);
 		pSession->release();
+		if (pXrunTrace)
+			pXrunTrace->endCycle();
 		return 0;
 	}
 
@@ -990,7 +1045,7 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 				iFrameStart = pSession->loopStart();
 				iFrameEnd   = iFrameStart + (iFrameEnd - iLoopEnd);
 				// Set to new transport location...
-				if (m_transportMode & qtractorBus::Output)
+				if (m_pJackClient && (m_transportMode & qtractorBus::Output))
 					jack_transport_locate(m_pJackClient, iFrameStart);
 				pAudioCursor->seek(iFrameStart);
 			}
@@ -1018,7 +1073,7 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 		iFrameEnd = pSession->loopStart()
 			+ (iFrameEnd - pSession->loopEnd());
 		// Set to new transport location...
-		if (m_transportMode & qtractorBus::Output)
+		if (m_pJackClient && (m_transportMode & qtractorBus::Output))
 			jack_transport_locate(m_pJackClient, iFrameEnd);
 		// Take special care on metronome too...
 		if (m_bMetronome) {
@@ -1036,8 +1091,13 @@ int qtractorAudioEngine::process ( unsigned int nframes )
 	pSession->midiEngine()->sync();
 
 	// Release RT-safeness lock...
+	pSession->leaveSnapshot(qtractorSession::AudioReader);
 	pSession->release();
 
+	// Done tracing...
+	if (pXrunTrace)
+		pXrunTrace->endCycle();
+
 	// Process session stuff...
 	return 0;
 }
@@ -1061,11 +1121,25 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 	if (pAudioCursor == NULL)
 		return;
 
+	// Current track topology snapshot...
+	qtractorSessionSnapshot *pSnapshot
+		= pSession->enterSnapshot(qtractorSession::AudioReader);
+	pAudioCursor->sync(pSnapshot);
+	const unsigned int iTracks = pSnapshot->tracks();
+
 	// Make sure we're in a valid state...
 	QListIterator<qtractorAudioBus *> iter(*m_pExportBuses);
 	// Prepare the output buses first...
-	while (iter.hasNext())
-		iter.next()->process_prepare(nframes);
+	if (m_bOffline) {
+		// Offline: all buses own their private buffers...
+		for (qtractorBus *pBus = buses().first();
+				pBus; pBus = pBus->next()) {
+			static_cast<qtractorAudioBus *> (pBus)->process_prepare(nframes);
+		}
+	} else {
+		while (iter.hasNext())
+			iter.next()->process_prepare(nframes);
+	}
 	// Prepare all extra audio buses...
 	for (qtractorBus *pBusEx = busesEx().first();
 			pBusEx; pBusEx = pBusEx->next()) {
@@ -1081,28 +1155,47 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 
 	// Write output bus buffers to export audio file...
 	if (iFrameStart < m_iExportEnd && iFrameEnd > m_iExportStart) {
+		// Render timing statistics, if any...
+		qtractorRenderStats *pRenderStats = qtractorRenderStats::getInstance();
+		const unsigned long long iCycleTime
+			= (pRenderStats ? qtractorRenderStats::clock() : 0);
 		// Prepare mix-down buffer...
 		m_pExportBuffer->process_prepare(nframes);
 		// Force/sync every audio clip approaching...
 	#ifdef CONFIG_LV2
 	#ifdef CONFIG_LV2_TIME
-		qtractorLv2Plugin::updateTime(m_pJackClient);
+		if (m_pJackClient)
+			qtractorLv2Plugin::updateTime(m_pJackClient);
 	#endif
 	#endif
-		// MIDI plugin manager processing...
-		qtractorMidiManager *pMidiManager
-			= pSession->midiManagers().first();
+		// MIDI plugin manager processing (not on single track export)...
+		qtractorMidiManager *pMidiManager = NULL;
+		if (m_pExportTrack == NULL)
+			pMidiManager = pSession->midiManagers().first();
 		while (pMidiManager) {
 			pMidiManager->process(iFrameStart, iFrameEnd);
 			pMidiManager = pMidiManager->next();
 		}
-		// Perform all tracks processing...
-		int iTrack = 0;
-		for (qtractorTrack *pTrack = pSession->tracks().first();
-				pTrack; pTrack = pTrack->next()) {
+		// Perform all tracks processing
+		// (audio tracks split on their own automation boundaries)...
+		bool bGraph = false;
+		// Offline: parallel process graph, if any
+		// (track automation gets processed there too)...
+		if (m_bOffline && m_pGraph && m_pExportTrack == NULL) {
+			bGraph = m_pGraph->process(
+				pAudioCursor, iFrameStart, iFrameEnd, true);
+		}
+		// Otherwise serial, in track order...
+		for (unsigned int iTrack = 0; iTrack < iTracks && !bGraph; ++iTrack) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
+			if (m_pExportTrack && m_pExportTrack != pTrack)
+				continue;
+			const unsigned long long iTrackTime
+				= (pRenderStats ? qtractorRenderStats::clock() : 0);
 			pTrack->process_export(pAudioCursor->clip(iTrack),
 				iFrameStart, iFrameEnd);
-			++iTrack;
+			if (pRenderStats) pRenderStats->addTime(pTrack,
+				qtractorRenderStats::clock() - iTrackTime);
 		}
 		// Prepare advance for next cycle...
 		pAudioCursor->seek(iFrameEnd);
@@ -1118,6 +1211,11 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 		}
 		// Write to export file...
 		m_pExportFile->write(m_pExportBuffer->buffer(), nframes);
+		// Render timing statistics, if any...
+		if (pRenderStats) pRenderStats->addCycle(nframes,
+			qtractorRenderStats::clock() - iCycleTime, m_bOffline, bGraph);
+		// Done with current track topology...
+		pSession->leaveSnapshot(qtractorSession::AudioReader);
 		// HACK! Freewheeling observers update (non RT safe!)...
 		qtractorSubject::flushQueue(false);
 	} else {
@@ -1134,8 +1232,8 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 		}
 		// HACK: Shut-off (panic) all MIDI tracks...
 		QHash<qtractorMidiBus *, unsigned short> channels;
-		for (qtractorTrack *pTrack = pSession->tracks().first();
-				pTrack; pTrack = pTrack->next()) {
+		for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
 			if (pTrack->trackType() != qtractorTrack::Midi)
 				continue;
 			qtractorMidiBus *pMidiBus
@@ -1157,6 +1255,8 @@ void qtractorAudioEngine::process_export ( unsigned int nframes )
 		}
 		// HACK: Reset all audio monitors...
 		resetAllMonitors();
+		// Done with current track topology...
+		pSession->leaveSnapshot(qtractorSession::AudioReader);
 	}
 }
 
@@ -1346,10 +1446,46 @@ bool qtractorAudioEngine::isExporting (void) const
 }
 
 
+// Single track export accessor (eg. track freeze).
+qtractorTrack *qtractorAudioEngine::exportTrack (void) const
+{
+	return m_pExportTrack;
+}
+
+
+// Single track export mix-down (pre-fader, freewheeling only).
+void qtractorAudioEngine::process_export_add ( float **ppBuffer,
+	unsigned short iChannels, unsigned int nframes, unsigned int iOffset )
+{
+	if (m_pExportBuffer) {
+		m_pExportBuffer->process_add(
+			ppBuffer, iChannels, nframes, m_iBufferOffset + iOffset);
+	}
+}
+
+
+// Whether a bus has audio inserts activated (offline export check).
+static bool qtractorAudioEngine_isAudioInsert ( qtractorBus *pBus )
+{
+	qtractorAudioBus *pAudioBus = static_cast<qtractorAudioBus *> (pBus);
+
+	qtractorPluginList *pPluginList = pAudioBus->pluginList_in();
+	if (pPluginList && pPluginList->isAudioInsertActivated())
+		return true;
+
+	pPluginList = pAudioBus->pluginList_out();
+	if (pPluginList && pPluginList->isAudioInsertActivated())
+		return true;
+
+	return false;
+}
+
+
 // Audio-export method.
 bool qtractorAudioEngine::fileExport (
 	const QString& sExportPath, const QList<qtractorAudioBus *>& exportBuses,
-	unsigned long iExportStart, unsigned long iExportEnd )
+	unsigned long iExportStart, unsigned long iExportEnd,
+	qtractorTrack *pExportTrack )
 {
 	// No simultaneous or foul exports...
 	if (!isActivated() || isPlaying() || isExporting())
@@ -1375,9 +1511,14 @@ bool qtractorAudioEngine::fileExport (
 	if (iExportStart >= iExportEnd)
 		return false;
 
-	// We'll grab the first bus around, as reference...
-	qtractorAudioBus *pExportBus
-		= static_cast<qtractorAudioBus *> (buses().first());
+	// We'll grab the first bus around, as reference;
+	// otherwise the one and only exported track's...
+	qtractorAudioBus *pExportBus = NULL;
+	if (pExportTrack == NULL)
+		pExportBus = static_cast<qtractorAudioBus *> (buses().first());
+	else
+	if (pExportTrack->trackType() == qtractorTrack::Audio)
+		pExportBus = static_cast<qtractorAudioBus *> (pExportTrack->outputBus());
 	if (pExportBus == NULL)
 		return false;
 
@@ -1407,6 +1548,7 @@ bool qtractorAudioEngine::fileExport (
 	m_pExportBuses = new QList<qtractorAudioBus *> (exportBuses);
 	m_pExportFile  = pExportFile;
 	m_pExportBuffer = new qtractorAudioExportBuffer(iChannels, bufferSize());
+	m_pExportTrack = pExportTrack;
 	m_iExportStart = iExportStart;
 	m_iExportEnd   = iExportEnd;
 	m_bExportDone  = false;
@@ -1436,23 +1578,73 @@ bool qtractorAudioEngine::fileExport (
 	// Special initialization.
 	m_iBufferOffset = 0;
 
-	// Start export (freewheeling)...
-	jack_set_freewheel(m_pJackClient, 1);
-
-	// Wait for the export to end.
-	struct timespec ts;
-	ts.tv_sec  = 0;
-	ts.tv_nsec = 20000000L; // 20msec.
-
-	while (m_bExporting && !m_bExportDone) {
-		qtractorSession::stabilize(200);
-		::nanosleep(&ts, NULL); // Ain't that enough?
-		pProgressBar->setValue(pSession->playHead());
+	// Offline export, unless audio inserts are in the way
+	// (as those need the actual JACK round-trip)...
+	bool bOffline = m_bOfflineExport;
+	qtractorBus *pBus;
+	for (pBus = buses().first(); pBus && bOffline; pBus = pBus->next()) {
+		if (qtractorAudioEngine_isAudioInsert(pBus))
+			bOffline = false;
+	}
+	for (pBus = busesEx().first(); pBus && bOffline; pBus = pBus->next()) {
+		if (qtractorAudioEngine_isAudioInsert(pBus))
+			bOffline = false;
+	}
+	qtractorTrack *pTrack = pSession->tracks().first();
+	for ( ; pTrack && bOffline; pTrack = pTrack->next()) {
+		if ((pTrack->pluginList())->isAudioInsertActivated())
+			bOffline = false;
+	}
+
+	// No JACK freewheeling on the null/dummy driver, ever...
+	if (m_pDummyDriver)
+		bOffline = true;
+
+	if (bOffline) {
+		// Start export (offline)...
+		for (pBus = buses().first(); pBus; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->setOffline(true);
+		for (pBus = busesEx().first(); pBus; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->setOffline(true);
+		m_bOffline = true;
+		setFreewheel(true);
+		// Render as fast as we can, while keeping
+		// the user interface responsive enough...
+		const unsigned int iBufferSize = bufferSize();
+		while (m_bExporting && !m_bExportDone) {
+			QTime time;
+			time.start();
+			while (m_bExporting && !m_bExportDone && time.elapsed() < 100) {
+				m_iBufferOffset = 0;
+				process_export(iBufferSize);
+			}
+			qtractorSession::stabilize();
+			pProgressBar->setValue(pSession->playHead());
+		}
+		// Stop export (offline)...
+		setFreewheel(false);
+		m_bOffline = false;
+		// The null/dummy driver stays on private buffers...
+		for (pBus = busesEx().first(); pBus && m_pJackClient; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->setOffline(false);
+		for (pBus = buses().first(); pBus && m_pJackClient; pBus = pBus->next())
+			static_cast<qtractorAudioBus *> (pBus)->setOffline(false);
+	} else {
+		// Start export (freewheeling)...
+		jack_set_freewheel(m_pJackClient, 1);
+		// Wait for the export to end.
+		struct timespec ts;
+		ts.tv_sec  = 0;
+		ts.tv_nsec = 20000000L; // 20msec.
+		while (m_bExporting && !m_bExportDone) {
+			qtractorSession::stabilize(200);
+			::nanosleep(&ts, NULL); // Ain't that enough?
+			pProgressBar->setValue(pSession->playHead());
+		}
+		// Stop export (freewheeling)...
+		jack_set_freewheel(m_pJackClient, 0);
 	}
 
-	// Stop export (freewheeling)...
-	jack_set_freewheel(m_pJackClient, 0);
-
 	// May close the file...
 	m_pExportFile->close();
 
@@ -1481,6 +1673,7 @@ bool qtractorAudioEngine::fileExport (
 	m_pExportBuses = NULL;
 	m_pExportFile  = NULL;
 	m_pExportBuffer = NULL;
+	m_pExportTrack = NULL;
 	m_iExportStart = 0;
 	m_iExportEnd   = 0;
 	m_bExportDone  = true;
@@ -1498,7 +1691,7 @@ void qtractorAudioEngine::trackMute ( qtractorTrack *pTrack, bool bMute )
 {
 	if (bMute) (pTrack->pluginList())->resetBuffers();
 
-	sessionCursor()->updateTrackClip(pTrack);
+	session()->updateTrackClip(pTrack);
 }
 
 
@@ -2047,6 +2240,9 @@ void qtractorAudioEngine::resetTimebase (void)
 // Absolute number of frames elapsed since engine start.
 unsigned long qtractorAudioEngine::jackFrameTime (void) const
 {
+	if (m_pDummyDriver)
+		return m_pDummyDriver->frameTime();
+
 	return (m_pJackClient ? jack_frame_time(m_pJackClient) : 0);
 }
 
@@ -2085,6 +2281,121 @@ void qtractorAudioEngine::resetAllMonitors (void)
 }
 
 
+// Sample-accurate automation frame resolution (0=per-period).
+void qtractorAudioEngine::setAutomationFrames ( unsigned int iAutomationFrames )
+{
+	m_iAutomationFrames = iAutomationFrames;
+}
+
+unsigned int qtractorAudioEngine::automationFrames (void) const
+{
+	return m_iAutomationFrames;
+}
+
+
+// Silent plugin-chain tail hold time (msecs; 0=never idle).
+void qtractorAudioEngine::setPluginIdleTime ( unsigned int iPluginIdleTime )
+{
+	m_iPluginIdleTime = iPluginIdleTime;
+}
+
+unsigned int qtractorAudioEngine::pluginIdleTime (void) const
+{
+	return m_iPluginIdleTime;
+}
+
+
+// Parallel process graph threads (0=auto, 1=serial).
+void qtractorAudioEngine::setGraphThreads ( unsigned short iGraphThreads )
+{
+	m_iGraphThreads = iGraphThreads;
+}
+
+unsigned short qtractorAudioEngine::graphThreads (void) const
+{
+	return m_iGraphThreads;
+}
+
+
+// Offline (faster than real-time) audio-export mode.
+void qtractorAudioEngine::setOfflineExport ( bool bOfflineExport )
+{
+	m_bOfflineExport = bOfflineExport;
+}
+
+bool qtractorAudioEngine::isOfflineExport (void) const
+{
+	return m_bOfflineExport;
+}
+
+
+// Null/dummy audio driver (no JACK) settings.
+void qtractorAudioEngine::setDummyDriver ( bool bDummyDriver )
+{
+	m_bDummyDriver = bDummyDriver;
+}
+
+bool qtractorAudioEngine::isDummyDriver (void) const
+{
+	return m_bDummyDriver;
+}
+
+
+void qtractorAudioEngine::setDummySampleRate ( unsigned int iDummySampleRate )
+{
+	m_iDummySampleRate = iDummySampleRate;
+}
+
+unsigned int qtractorAudioEngine::dummySampleRate (void) const
+{
+	return m_iDummySampleRate;
+}
+
+
+void qtractorAudioEngine::setDummyBufferSize ( unsigned int iDummyBufferSize )
+{
+	m_iDummyBufferSize = iDummyBufferSize;
+}
+
+unsigned int qtractorAudioEngine::dummyBufferSize (void) const
+{
+	return m_iDummyBufferSize;
+}
+
+
+void qtractorAudioEngine::setDummyRealTime ( bool bDummyRealTime )
+{
+	m_bDummyRealTime = bDummyRealTime;
+}
+
+bool qtractorAudioEngine::isDummyRealTime (void) const
+{
+	return m_bDummyRealTime;
+}
+
+
+// Null/dummy audio driver accessor (NULL when on JACK).
+qtractorAudioDummyDriver *qtractorAudioEngine::dummyDriver (void) const
+{
+	return m_pDummyDriver;
+}
+
+
+// Parallel process graph accessor.
+qtractorAudioGraph *qtractorAudioEngine::graph (void) const
+{
+	return m_pGraph;
+}
+
+
+// Parallel process graph node buffers update (non RT-safe).
+void qtractorAudioEngine::updateGraph (void)
+{
+	if (m_pGraph)
+		m_pGraph->update();
+}
+
+
 //----------------------------------------------------------------------
 // class qtractorAudioBus -- Managed JACK port set
 //
@@ -2128,14 +2439,13 @@ qtractorAudioBus::qtractorAudioBus (
 	m_ppXBuffer = NULL;
 	m_ppYBuffer = NULL;
 
-	m_bEnabled  = false;
+	m_ppZBuffer = NULL;
+	m_ppWBuffer = NULL;
 
-#if defined(__SSE__)
-	if (sse_enabled())
-		m_pfnBufferAdd = sse_buffer_add;
-	else
-#endif
-	m_pfnBufferAdd = std_buffer_add;
+	m_ppIOffline = NULL;
+	m_ppOOffline = NULL;
+
+	m_bEnabled  = false;
 }
 
 
@@ -2212,8 +2522,10 @@ bool qtractorAudioBus::open (void)
 	if (pAudioEngine == NULL)
 		return false;
 
+	// Null/dummy audio driver buses have no ports at all...
 	jack_client_t *pJackClient = pAudioEngine->jackClient();
-	if (pJackClient == NULL)
+	const bool bDummyDriver = (pAudioEngine->dummyDriver() != NULL);
+	if (pJackClient == NULL && !bDummyDriver)
 		return false;
 
 	const qtractorBus::BusMode busMode
@@ -2230,11 +2542,14 @@ bool qtractorAudioBus::open (void)
 		m_ppIBuffer = new float * [m_iChannels];
 		const QString sIPortName(busName() + "/in_%1");
 		for (i = 0; i < m_iChannels; ++i) {
+			m_ppIPorts[i] = NULL;
+			m_ppIBuffer[i] = NULL;
+			if (bDummyDriver)
+				continue;
 			m_ppIPorts[i] = jack_port_register(pJackClient,
 				sIPortName.arg(i + 1).toUtf8().constData(),
 				JACK_DEFAULT_AUDIO_TYPE,
 				JackPortIsInput, 0);
-			m_ppIBuffer[i] = NULL;
 			if (m_ppIPorts[i] == NULL) ++iDisabled;
 		}
 	}
@@ -2245,11 +2560,14 @@ bool qtractorAudioBus::open (void)
 		m_ppOBuffer = new float * [m_iChannels];
 		const QString sOPortName(busName() + "/out_%1");
 		for (i = 0; i < m_iChannels; ++i) {
+			m_ppOPorts[i] = NULL;
+			m_ppOBuffer[i] = NULL;
+			if (bDummyDriver)
+				continue;
 			m_ppOPorts[i] = jack_port_register(pJackClient,
 				sOPortName.arg(i + 1).toUtf8().constData(),
 				JACK_DEFAULT_AUDIO_TYPE,
 				JackPortIsOutput, 0);
-			m_ppOBuffer[i] = NULL;
 			if (m_ppOPorts[i] == NULL) ++iDisabled;
 		}
 	}
@@ -2257,9 +2575,13 @@ bool qtractorAudioBus::open (void)
 	// Allocate internal working bus buffers...
 	m_ppXBuffer = new float * [m_iChannels];
 	m_ppYBuffer = new float * [m_iChannels];
+	m_ppZBuffer = new float * [m_iChannels];
+	m_ppWBuffer = new float * [m_iChannels];
 	for (i = 0; i < m_iChannels; ++i) {
 		m_ppXBuffer[i] = new float [iBufferSize];
 		m_ppYBuffer[i] = NULL;
+		m_ppZBuffer[i] = new float [iBufferSize];
+		m_ppWBuffer[i] = NULL;
 	}
 
 	// Update monitor subject names...
@@ -2274,6 +2596,10 @@ bool qtractorAudioBus::open (void)
 	// Finally, open for biz...
 	m_bEnabled = (iDisabled == 0);
 
+	// Null/dummy audio driver buses process on private buffers only...
+	if (bDummyDriver)
+		setOffline(true);
+
 	return true;
 }
 
@@ -2284,6 +2610,9 @@ void qtractorAudioBus::close (void)
 	// Close for biz, immediate...
 	m_bEnabled = false;
 
+	// Free offline buffers, if any...
+	setOffline(false);
+
 	qtractorAudioEngine *pAudioEngine
 		= static_cast<qtractorAudioEngine *> (engine());
 	if (pAudioEngine == NULL)
@@ -2350,6 +2679,18 @@ void qtractorAudioBus::close (void)
 		delete [] m_ppYBuffer;
 		m_ppYBuffer = NULL;
 	}
+
+	if (m_ppZBuffer) {
+		for (i = 0; i < m_iChannels; ++i)
+			delete [] m_ppZBuffer[i];
+		delete [] m_ppZBuffer;
+		m_ppZBuffer = NULL;
+	}
+
+	if (m_ppWBuffer) {
+		delete [] m_ppWBuffer;
+		m_ppWBuffer = NULL;
+	}
 }
 
 
@@ -2500,6 +2841,15 @@ void qtractorAudioBus::process_prepare ( unsigned int nframes )
 
 	unsigned short i;
 
+	// Offline export buffers are already set in place...
+	if (m_ppOOffline) {
+		if (busMode & qtractorBus::Output) {
+			for (i = 0; i < m_iChannels; ++i)
+				::memset(m_ppOBuffer[i], 0, nframes * sizeof(float));
+		}
+		return;
+	}
+
 	if (busMode & qtractorBus::Input) {
 		for (i = 0; i < m_iChannels; ++i) {
 			m_ppIBuffer[i] = static_cast<float *>
@@ -2518,6 +2868,78 @@ void qtractorAudioBus::process_prepare ( unsigned int nframes )
 }
 
 
+// Process cycle output silence (offline export only).
+void qtractorAudioBus::process_silence ( unsigned int nframes )
+{
+	if (!m_bEnabled)
+		return;
+
+	if ((busMode() & qtractorBus::Output) == 0)
+		return;
+
+	for (unsigned short i = 0; i < m_iChannels; ++i) {
+		float *pFrames = static_cast<float *>
+			(jack_port_get_buffer(m_ppOPorts[i], nframes));
+		::memset(pFrames, 0, nframes * sizeof(float));
+	}
+}
+
+
+// Offline (non-JACK) export buffers (non RT-safe).
+void qtractorAudioBus::setOffline ( bool bOffline )
+{
+	if (( m_ppOOffline && bOffline) ||
+		(!m_ppOOffline && !bOffline))
+		return;
+
+	unsigned short i;
+
+	if (!bOffline) {
+		for (i = 0; i < m_iChannels; ++i) {
+			delete [] m_ppIOffline[i];
+			delete [] m_ppOOffline[i];
+		}
+		delete [] m_ppIOffline;
+		delete [] m_ppOOffline;
+		m_ppIOffline = NULL;
+		m_ppOOffline = NULL;
+		return;
+	}
+
+	if (!m_bEnabled)
+		return;
+
+	qtractorAudioEngine *pAudioEngine
+		= static_cast<qtractorAudioEngine *> (engine());
+	if (pAudioEngine == NULL)
+		return;
+
+	const unsigned int iBufferSize = pAudioEngine->bufferSize();
+
+	const qtractorBus::BusMode busMode
+		= qtractorAudioBus::busMode();
+
+	m_ppIOffline = new float * [m_iChannels];
+	m_ppOOffline = new float * [m_iChannels];
+	for (i = 0; i < m_iChannels; ++i) {
+		m_ppIOffline[i] = new float [iBufferSize];
+		m_ppOOffline[i] = new float [iBufferSize];
+		::memset(m_ppIOffline[i], 0, iBufferSize * sizeof(float));
+		::memset(m_ppOOffline[i], 0, iBufferSize * sizeof(float));
+		// Offline inputs are always silent...
+		if (busMode & qtractorBus::Input)
+			m_ppIBuffer[i] = m_ppIOffline[i];
+		if (busMode & qtractorBus::Output)
+			m_ppOBuffer[i] = m_ppOOffline[i];
+	}
+}
+
+bool qtractorAudioBus::isOffline (void) const
+{
+	return (m_ppOOffline != NULL);
+}
+
+
 // Process cycle monitor.
 void qtractorAudioBus::process_monitor ( unsigned int nframes )
 {
@@ -2533,7 +2955,7 @@ void qtractorAudioBus::process_monitor ( unsigned int nframes )
 		if (m_pIAudioMonitor)
 			m_pIAudioMonitor->process(m_ppIBuffer, nframes);
 		if (isMonitor() && (busMode & qtractorBus::Output)) {
-			(*m_pfnBufferAdd)(m_ppOBuffer, m_ppIBuffer,
+			buffer_add(m_ppOBuffer, m_ppIBuffer,
 				nframes, m_iChannels, m_iChannels, 0);
 		}
 	}
@@ -2554,59 +2976,134 @@ void qtractorAudioBus::process_commit ( unsigned int nframes )
 
 
 // Bus-buffering methods.
-void qtractorAudioBus::buffer_prepare (
-	unsigned int nframes, qtractorAudioBus *pInputBus )
+bool qtractorAudioBus::buffer_prepare ( unsigned int nframes,
+	qtractorAudioBus *pInputBus, unsigned int iOffset )
+{
+	return buffer_prepare(m_ppXBuffer, m_ppYBuffer,
+		nframes, pInputBus, iOffset);
+}
+
+void qtractorAudioBus::buffer_process ( qtractorPluginList *pPluginList,
+	unsigned int nframes, bool bSilent, unsigned int iOffset )
+{
+	buffer_process(m_ppXBuffer, m_ppYBuffer,
+		m_ppZBuffer, m_ppWBuffer, pPluginList, nframes, bSilent, iOffset);
+}
+
+void qtractorAudioBus::buffer_commit (
+	unsigned int nframes, unsigned int iOffset )
+{
+	buffer_commit(m_ppXBuffer, nframes, iOffset);
+}
+
+
+// Bus-buffering methods (external work buffers).
+bool qtractorAudioBus::buffer_prepare ( float **ppXBuffer, float **ppYBuffer,
+	unsigned int nframes, qtractorAudioBus *pInputBus, unsigned int iOffset )
 {
 	if (!m_bEnabled)
-		return;
+		return false;
 
 	qtractorAudioEngine *pAudioEngine
 		= static_cast<qtractorAudioEngine *> (engine());
 	if (pAudioEngine == NULL)
-		return;
+		return false;
 
-	const unsigned int offset = pAudioEngine->bufferOffset();
+	const unsigned int offset = pAudioEngine->bufferOffset() + iOffset;
 	const unsigned int nbytes = nframes * sizeof(float);
 
 	if (pInputBus == NULL) {
 		for (unsigned short i = 0; i < m_iChannels; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memset(m_ppYBuffer[i], 0, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memset(ppYBuffer[i], 0, nbytes);
 		}
-		return;
+		return true;
 	}
 
 	const unsigned short iBuffers = pInputBus->channels();
 	float **ppBuffer = pInputBus->in();
 
+	// Input silence detection...
+	float fPeak = 0.0f;
+	for (unsigned short i = 0; i < iBuffers; ++i)
+		fPeak = qtractorAudioKernel::peak(ppBuffer[i] + offset, nframes, fPeak);
+
 	if (m_iChannels == iBuffers) {
 		// Exact buffer copy...
 		for (unsigned short i = 0; i < iBuffers; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memcpy(m_ppYBuffer[i], ppBuffer[i] + offset, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memcpy(ppYBuffer[i], ppBuffer[i] + offset, nbytes);
 		}
 	} else {
 		// Buffer merge/multiplex...
 		unsigned short i;
 		for (i = 0; i < m_iChannels; ++i) {
-			m_ppYBuffer[i] = m_ppXBuffer[i] + offset;
-			::memset(m_ppYBuffer[i], 0, nbytes);
+			ppYBuffer[i] = ppXBuffer[i] + offset;
+			::memset(ppYBuffer[i], 0, nbytes);
 		}
 		if (m_iChannels > iBuffers) {
 			unsigned short j = 0;
 			for (i = 0; i < m_iChannels; ++i) {
-				::memcpy(m_ppYBuffer[i], ppBuffer[j] + offset, nbytes);
+				::memcpy(ppYBuffer[i], ppBuffer[j] + offset, nbytes);
 				if (++j >= iBuffers)
 					j = 0;
 			}
 		} else { // (m_iChannels < iBuffers)
-			(*m_pfnBufferAdd)(m_ppXBuffer, ppBuffer,
+			buffer_add(ppXBuffer, ppBuffer,
 				nframes, m_iChannels, iBuffers, offset);
 		}
 	}
+
+	return (fPeak < QTRACTOR_AUDIO_SILENCE);
+}
+
+// Plugin-chain processing on the work buffers (zero-copy):
+// whenever the chain output ends on the alternate buffers,
+// ownership gets swapped instead of copying them back.
+void qtractorAudioBus::buffer_process (
+	float **ppXBuffer, float **ppYBuffer,
+	float **ppZBuffer, float **ppWBuffer,
+	qtractorPluginList *pPluginList, unsigned int nframes,
+	bool bSilent, unsigned int iOffset )
+{
+	if (!m_bEnabled || pPluginList == NULL)
+		return;
+
+	qtractorAudioEngine *pAudioEngine
+		= static_cast<qtractorAudioEngine *> (engine());
+	if (pAudioEngine == NULL)
+		return;
+
+	// Silent input, with plugin-chain tail long decayed?
+	if (pPluginList->process_idle(bSilent, pAudioEngine->pluginIdleFrames()))
+		return;
+
+	if (pPluginList->channels() != m_iChannels) {
+		pPluginList->process(ppYBuffer, nframes);
+		return;
+	}
+
+	const unsigned int offset = pAudioEngine->bufferOffset() + iOffset;
+
+	unsigned short i;
+	for (i = 0; i < m_iChannels; ++i)
+		ppWBuffer[i] = ppZBuffer[i] + offset;
+
+	if (pPluginList->process_swap(ppYBuffer, ppWBuffer, nframes)) {
+		for (i = 0; i < m_iChannels; ++i) {
+			float *pFrames = ppXBuffer[i];
+			ppXBuffer[i] = ppZBuffer[i];
+			ppZBuffer[i] = pFrames;
+			ppYBuffer[i] = ppWBuffer[i];
+			ppWBuffer[i] = pFrames + offset;
+		}
+	}
+
+	pPluginList->process_tail(ppYBuffer, nframes);
 }
 
-void qtractorAudioBus::buffer_commit ( unsigned int nframes )
+void qtractorAudioBus::buffer_commit ( float **ppXBuffer,
+	unsigned int nframes, unsigned int iOffset )
 {
 	if (!m_bEnabled || (busMode() & qtractorBus::Output) == 0)
 		return;
@@ -2616,8 +3113,8 @@ void qtractorAudioBus::buffer_commit ( unsigned int nframes )
 	if (pAudioEngine == NULL)
 		return;
 
-	(*m_pfnBufferAdd)(m_ppOBuffer, m_ppXBuffer,
-		nframes, m_iChannels, m_iChannels, pAudioEngine->bufferOffset());
+	buffer_add(m_ppOBuffer, ppXBuffer, nframes,
+		m_iChannels, m_iChannels, pAudioEngine->bufferOffset() + iOffset);
 }
 
 
@@ -36,6 +36,8 @@ class qtractorAudioBuffer;
 class qtractorAudioMonitor;
 class qtractorAudioFile;
 class qtractorAudioExportBuffer;
+class qtractorAudioGraph;
+class qtractorAudioDummyDriver;
 class qtractorPluginList;
 class qtractorCurveList;
 
@@ -148,7 +150,15 @@ public:
 	// Audio-export method.
 	bool fileExport(const QString& sExportPath,
 		const QList<qtractorAudioBus *>& exportBuses,
-		unsigned long iExportStart = 0, unsigned long iExportEnd = 0);
+		unsigned long iExportStart = 0, unsigned long iExportEnd = 0,
+		qtractorTrack *pExportTrack = NULL);
+
+	// Single track export accessor (eg. track freeze).
+	qtractorTrack *exportTrack() const;
+
+	// Single track export mix-down (pre-fader, freewheeling only).
+	void process_export_add(float **ppBuffer, unsigned short iChannels,
+		unsigned int nframes, unsigned int iOffset = 0);
 
 	// Special track-immediate methods.
 	void trackMute(qtractorTrack *pTrack, bool bMute);
@@ -227,6 +237,48 @@ public:
 	// Reset all audio monitoring...
 	void resetAllMonitors();
 
+	// Parallel process graph threads (0=auto, 1=serial).
+	void setGraphThreads(unsigned short iGraphThreads);
+	unsigned short graphThreads() const;
+
+	// Offline (faster than real-time) audio-export mode.
+	void setOfflineExport(bool bOfflineExport);
+	bool isOfflineExport() const;
+
+	// Null/dummy audio driver (no JACK) settings.
+	void setDummyDriver(bool bDummyDriver);
+	bool isDummyDriver() const;
+
+	void setDummySampleRate(unsigned int iDummySampleRate);
+	unsigned int dummySampleRate() const;
+
+	void setDummyBufferSize(unsigned int iDummyBufferSize);
+	unsigned int dummyBufferSize() const;
+
+	void setDummyRealTime(bool bDummyRealTime);
+	bool isDummyRealTime() const;
+
+	// Null/dummy audio driver accessor (NULL when on JACK).
+	qtractorAudioDummyDriver *dummyDriver() const;
+
+	// Sample-accurate automation frame resolution (0=per-period).
+	void setAutomationFrames(unsigned int iAutomationFrames);
+	unsigned int automationFrames() const;
+
+	// Silent plugin-chain tail hold time (msecs; 0=never idle).
+	void setPluginIdleTime(unsigned int iPluginIdleTime);
+	unsigned int pluginIdleTime() const;
+
+	// Silent plugin-chain tail hold frames (RT-safe).
+	unsigned long pluginIdleFrames() const
+		{ return (unsigned long) m_iPluginIdleTime * m_iSampleRate / 1000; }
+
+	// Parallel process graph accessor.
+	qtractorAudioGraph *graph() const;
+
+	// Parallel process graph node buffers update (non RT-safe).
+	void updateGraph();
+
 protected:
 
 	// Concrete device (de)activation methods.
@@ -262,6 +314,14 @@ private:
 	// Audio device instance variables.
 	jack_client_t *m_pJackClient;
 
+	// Null/dummy audio driver (no JACK).
+	qtractorAudioDummyDriver *m_pDummyDriver;
+
+	bool         m_bDummyDriver;
+	unsigned int m_iDummySampleRate;
+	unsigned int m_iDummyBufferSize;
+	bool         m_bDummyRealTime;
+
 	// JACK Session UUID.
 	QString m_sSessionId;
 
@@ -282,8 +342,20 @@ private:
 	// Common audio buffer sync thread.
 	qtractorAudioBufferThread *m_pSyncThread;
 
+	// Sample-accurate automation frame resolution.
+	unsigned int m_iAutomationFrames;
+
+	// Silent plugin-chain tail hold time.
+	unsigned int m_iPluginIdleTime;
+
+	// Parallel process graph.
+	unsigned short       m_iGraphThreads;
+	qtractorAudioGraph  *m_pGraph;
+
 	// Audio-export (in)active state.
 	volatile bool        m_bExporting;
+	bool                 m_bOfflineExport;
+	volatile bool        m_bOffline;
 	qtractorAudioFile   *m_pExportFile;
 	unsigned long        m_iExportStart;
 	unsigned long        m_iExportEnd;
@@ -291,6 +363,7 @@ private:
 
 	QList<qtractorAudioBus *> *m_pExportBuses;
 	qtractorAudioExportBuffer *m_pExportBuffer;
+	qtractorTrack             *m_pExportTrack;
 
 	// Audio metronome stuff.
 	bool                 m_bMetronome;
@@ -362,10 +435,32 @@ public:
 	void process_monitor(unsigned int nframes);
 	void process_commit(unsigned int nframes);
 
-	// Bus-buffering methods.
-	void buffer_prepare(unsigned int nframes,
-		qtractorAudioBus *pInputBus = NULL);
-	void buffer_commit(unsigned int nframes);
+	// Process cycle output silence (offline export only).
+	void process_silence(unsigned int nframes);
+
+	// Offline (non-JACK) export buffers (non RT-safe).
+	void setOffline(bool bOffline);
+	bool isOffline() const;
+
+	// Bus-buffering methods
+	// (prepare returns whether work buffers are left silent;
+	// optional offset is relative to current engine buffer offset).
+	bool buffer_prepare(unsigned int nframes,
+		qtractorAudioBus *pInputBus = NULL, unsigned int iOffset = 0);
+	void buffer_process(qtractorPluginList *pPluginList,
+		unsigned int nframes, bool bSilent = false, unsigned int iOffset = 0);
+	void buffer_commit(unsigned int nframes, unsigned int iOffset = 0);
+
+	// Bus-buffering methods (external work buffers).
+	bool buffer_prepare(float **ppXBuffer, float **ppYBuffer,
+		unsigned int nframes, qtractorAudioBus *pInputBus = NULL,
+		unsigned int iOffset = 0);
+	void buffer_process(float **ppXBuffer, float **ppYBuffer,
+		float **ppZBuffer, float **ppWBuffer,
+		qtractorPluginList *pPluginList, unsigned int nframes,
+		bool bSilent = false, unsigned int iOffset = 0);
+	void buffer_commit(float **ppXBuffer,
+		unsigned int nframes, unsigned int iOffset = 0);
 
 	// Up-and-running predicate.
 	bool isEnabled() const { return m_bEnabled; }
@@ -452,13 +547,17 @@ private:
 	float       **m_ppXBuffer;
 	float       **m_ppYBuffer;
 
+	// Alternate (swap) working buffers.
+	float       **m_ppZBuffer;
+	float       **m_ppWBuffer;
+
+	// Offline (non-JACK) export I/O buffers.
+	float       **m_ppIOffline;
+	float       **m_ppOOffline;
+
 	// Special under-work flag...
 	// (r/w access should be atomic)
 	volatile bool m_bEnabled;
-
-	// Buffer mix-down processor.
-	void (*m_pfnBufferAdd)(float **, float **, unsigned int,
-		unsigned short, unsigned short, unsigned int);
 };
 
 
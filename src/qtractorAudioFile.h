@@ -1,7 +1,7 @@
 // qtractorAudioFile.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2014, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -57,6 +57,9 @@ public:
 
 	// Other special informational methods.
 	virtual unsigned int sampleRate() const = 0;
+
+	// Whether read frames come straight from memory (mmap).
+	virtual bool isMapped() const { return false; }
 };
 
 
@@ -0,0 +1,520 @@
+// qtractorAudioGraph.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorAudioGraph.h"
+#include "qtractorAudioEngine.h"
+
+#include "qtractorSession.h"
+#include "qtractorSessionCursor.h"
+#include "qtractorSessionSnapshot.h"
+#include "qtractorPlugin.h"
+#include "qtractorRenderStats.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+
+
+// Closed job index (no more jobs this cycle).
+#define QTRACTOR_GRAPH_CLOSED	0x40000000
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraphThread -- Process graph worker thread.
+//
+
+// Constructor.
+qtractorAudioGraphThread::qtractorAudioGraphThread (
+	qtractorAudioGraph *pAudioGraph, int iPriority ) : QThread()
+{
+	m_pAudioGraph = pAudioGraph;
+	m_iPriority   = iPriority;
+	m_bRunState   = false;
+}
+
+
+// Run state accessor.
+void qtractorAudioGraphThread::setRunState ( bool bRunState )
+{
+	m_bRunState = bRunState;
+}
+
+bool qtractorAudioGraphThread::runState (void) const
+{
+	return m_bRunState;
+}
+
+
+// Thread run executive.
+void qtractorAudioGraphThread::run (void)
+{
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioGraphThread[%p]::run(): started.", this);
+#endif
+
+	// Same RT scheduling class as the JACK process thread, if any...
+	if (m_iPriority > 0) {
+		struct sched_param param;
+		param.sched_priority = m_iPriority;
+		if (::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param))
+			qWarning("qtractorAudioGraphThread[%p]::run(): "
+				"could not acquire RT scheduling (%d).", this, m_iPriority);
+	}
+
+	m_bRunState = true;
+
+	while (m_bRunState)
+		m_pAudioGraph->wait_work();
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioGraphThread[%p]::run(): stopped.", this);
+#endif
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraph -- Parallel track process graph.
+//
+
+// Constructor.
+qtractorAudioGraph::qtractorAudioGraph (
+	qtractorAudioEngine *pAudioEngine, unsigned short iThreads, int iPriority )
+{
+	m_pAudioEngine = pAudioEngine;
+
+	m_pNodeList = NULL;
+
+	m_ppJobs = NULL;
+	m_iJobs  = 0;
+
+	ATOMIC_SET(&m_iNextJob, QTRACTOR_GRAPH_CLOSED);
+	ATOMIC_SET(&m_iDoneJobs, 0);
+
+	m_iFrameStart = 0;
+	m_iFrameEnd   = 0;
+
+	m_bExport = false;
+	m_pRenderStats = NULL;
+
+	::sem_init(&m_semWork, 0, 0);
+	::sem_init(&m_semDone, 0, 0);
+
+	m_iThreads  = iThreads;
+	m_ppThreads = NULL;
+
+	if (m_iThreads > 0) {
+		m_ppThreads = new qtractorAudioGraphThread * [m_iThreads];
+		for (unsigned short i = 0; i < m_iThreads; ++i) {
+			m_ppThreads[i] = new qtractorAudioGraphThread(this, iPriority);
+			m_ppThreads[i]->start(QThread::TimeCriticalPriority);
+		}
+	}
+}
+
+
+// Destructor.
+qtractorAudioGraph::~qtractorAudioGraph (void)
+{
+	if (m_ppThreads) {
+		unsigned short i;
+		for (i = 0; i < m_iThreads; ++i)
+			m_ppThreads[i]->setRunState(false);
+		for (i = 0; i < m_iThreads; ++i) {
+			while (!m_ppThreads[i]->wait(100))
+				wake_all();
+			delete m_ppThreads[i];
+		}
+		delete [] m_ppThreads;
+	}
+
+	clear();
+
+	::sem_destroy(&m_semDone);
+	::sem_destroy(&m_semWork);
+}
+
+
+// Number of worker threads (not counting the RT caller).
+unsigned short qtractorAudioGraph::threads (void) const
+{
+	return m_iThreads;
+}
+
+
+// Node buffers helpers.
+void qtractorAudioGraph::allocNode ( Node *pNode,
+	unsigned short iChannels, unsigned int iBufferSize )
+{
+	pNode->channels = iChannels;
+	pNode->xbuffer  = new float * [iChannels];
+	pNode->ybuffer  = new float * [iChannels];
+	pNode->zbuffer  = new float * [iChannels];
+	pNode->wbuffer  = new float * [iChannels];
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		pNode->xbuffer[i] = new float [iBufferSize];
+		pNode->ybuffer[i] = NULL;
+		pNode->zbuffer[i] = new float [iBufferSize];
+		pNode->wbuffer[i] = NULL;
+	}
+}
+
+void qtractorAudioGraph::freeNode ( Node *pNode )
+{
+	if (pNode->xbuffer) {
+		for (unsigned short i = 0; i < pNode->channels; ++i)
+			delete [] pNode->xbuffer[i];
+		delete [] pNode->xbuffer;
+		pNode->xbuffer = NULL;
+	}
+
+	if (pNode->ybuffer) {
+		delete [] pNode->ybuffer;
+		pNode->ybuffer = NULL;
+	}
+
+	if (pNode->zbuffer) {
+		for (unsigned short i = 0; i < pNode->channels; ++i)
+			delete [] pNode->zbuffer[i];
+		delete [] pNode->zbuffer;
+		pNode->zbuffer = NULL;
+	}
+
+	if (pNode->wbuffer) {
+		delete [] pNode->wbuffer;
+		pNode->wbuffer = NULL;
+	}
+
+	pNode->track = NULL;
+	pNode->channels = 0;
+}
+
+
+// Node list helper (skipping shared node buffers).
+void qtractorAudioGraph::freeNodeList ( NodeList *pNodeList )
+{
+	bool *pbShared = pNodeList->shared;
+
+	if (pNodeList->nodes) {
+		for (unsigned int i = 0; i < pNodeList->count; ++i) {
+			if (pbShared == NULL || !pbShared[i])
+				freeNode(&pNodeList->nodes[i]);
+		}
+		delete [] pNodeList->nodes;
+	}
+
+	if (pNodeList->jobs)
+		delete [] pNodeList->jobs;
+
+	if (pbShared)
+		delete [] pbShared;
+
+	delete pNodeList;
+}
+
+
+// Node buffers (re)allocation (non RT-safe).
+void qtractorAudioGraph::update (void)
+{
+	if (m_iThreads < 1)
+		return;
+
+	qtractorSession *pSession = m_pAudioEngine->session();
+	if (pSession == NULL)
+		return;
+
+	qtractorSessionSnapshot *pSnapshot = pSession->snapshot();
+	if (pSnapshot == NULL)
+		return;
+
+	const unsigned int iBufferSize = m_pAudioEngine->bufferSize();
+	const unsigned int iNodes = pSnapshot->tracks();
+
+	NodeList *pNewNodeList = new NodeList;
+	pNewNodeList->nodes = NULL;
+	pNewNodeList->count = iNodes;
+	pNewNodeList->jobs  = NULL;
+	pNewNodeList->bufferSize = iBufferSize;
+	pNewNodeList->shared = NULL;
+
+	if (iNodes > 0) {
+		pNewNodeList->nodes = new Node [iNodes];
+		::memset(pNewNodeList->nodes, 0, iNodes * sizeof(Node));
+		pNewNodeList->jobs = new Node * [iNodes];
+	}
+
+	// Old node buffers might be shared whenever possible...
+	NodeList *pOldNodeList = m_pNodeList;
+	bool *pbShared = NULL;
+	if (pOldNodeList && pOldNodeList->count > 0
+		&& pOldNodeList->bufferSize == iBufferSize) {
+		pbShared = new bool [pOldNodeList->count];
+		for (unsigned int i = 0; i < pOldNodeList->count; ++i)
+			pbShared[i] = false;
+	}
+
+	for (unsigned int iNode = 0; iNode < iNodes; ++iNode) {
+		qtractorTrack *pTrack = pSnapshot->track(iNode);
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		qtractorAudioBus *pOutputBus
+			= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+		if (pOutputBus == NULL)
+			continue;
+		const unsigned short iChannels = pOutputBus->channels();
+		Node *pNode = &pNewNodeList->nodes[iNode];
+		for (unsigned int i = 0; pbShared && i < pOldNodeList->count; ++i) {
+			Node *pOldNode = &pOldNodeList->nodes[i];
+			if (!pbShared[i]
+				&& pOldNode->track == pTrack
+				&& pOldNode->channels == iChannels
+				&& pOldNode->xbuffer) {
+				pNode->channels = pOldNode->channels;
+				pNode->xbuffer  = pOldNode->xbuffer;
+				pNode->ybuffer  = pOldNode->ybuffer;
+				pNode->zbuffer  = pOldNode->zbuffer;
+				pNode->wbuffer  = pOldNode->wbuffer;
+				pbShared[i] = true;
+				break;
+			}
+		}
+		if (pNode->xbuffer == NULL)
+			allocNode(pNode, iChannels, iBufferSize);
+		pNode->track = pTrack;
+	}
+
+	// Swap to the new ones...
+	m_pNodeList = pNewNodeList;
+
+	// Retire the old ones...
+	if (pOldNodeList) {
+		pOldNodeList->shared = pbShared;
+		m_retiredNodeLists.append(pOldNodeList);
+	}
+
+	// Reclaim them all, once the RT thread has moved on;
+	// otherwise leave them for later (next update)...
+	if (!m_retiredNodeLists.isEmpty() && pSession->synchronize()) {
+		QListIterator<NodeList *> iter(m_retiredNodeLists);
+		while (iter.hasNext())
+			freeNodeList(iter.next());
+		m_retiredNodeLists.clear();
+	}
+}
+
+
+// Node buffers cleanup (non RT-safe).
+void qtractorAudioGraph::clear (void)
+{
+	m_iJobs = 0;
+	m_ppJobs = NULL;
+
+	if (m_pNodeList) {
+		freeNodeList(m_pNodeList);
+		m_pNodeList = NULL;
+	}
+
+	QListIterator<NodeList *> iter(m_retiredNodeLists);
+	while (iter.hasNext())
+		freeNodeList(iter.next());
+	m_retiredNodeLists.clear();
+}
+
+
+// Whether a track might be processed on its own.
+bool qtractorAudioGraph::isNodeJob ( Node *pNode, qtractorTrack *pTrack,
+	unsigned long iFrameStart, unsigned long iFrameEnd ) const
+{
+	if (pNode->track != pTrack || pNode->xbuffer == NULL)
+		return false;
+
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (pTrack->outputBus());
+	if (pOutputBus == NULL || !pOutputBus->isEnabled())
+		return false;
+	if (pOutputBus->channels() != pNode->channels)
+		return false;
+
+	// Audio inserts and aux-sends touch other buses;
+	// they must be processed serially, in track order...
+	qtractorPluginList *pPluginList = pTrack->pluginList();
+	if (pPluginList->isAudioInsertActivated()
+		|| pPluginList->isAudioAuxSendActivated())
+		return false;
+
+	// Tracks split in automation sub-blocks are also
+	// processed serially, as curves must be processed
+	// on this very (RT) thread, never on the workers...
+	if (pTrack->process_split(iFrameStart, iFrameEnd) < iFrameEnd)
+		return false;
+
+	return true;
+}
+
+
+// Process cycle executive (RT-safe).
+bool qtractorAudioGraph::process ( qtractorSessionCursor *pSessionCursor,
+	unsigned long iFrameStart, unsigned long iFrameEnd, bool bExport )
+{
+	NodeList *pNodeList = m_pNodeList;
+	if (m_iThreads < 1 || pNodeList == NULL || pNodeList->count < 2)
+		return false;
+
+	if (pNodeList->bufferSize < m_pAudioEngine->bufferSize())
+		return false;
+
+	qtractorSessionSnapshot *pSnapshot = pSessionCursor->snapshot();
+	if (pSnapshot == NULL)
+		return false;
+
+	const unsigned int iTracks = pSnapshot->tracks();
+	unsigned int iNodes = pNodeList->count;
+	if (iNodes > iTracks)
+		iNodes = iTracks;
+
+	Node *pNodes = pNodeList->nodes;
+
+	// Build this cycle job list...
+	int iJobs = 0;
+	unsigned int iNode = 0;
+	for ( ; iNode < iNodes; ++iNode) {
+		Node *pNode = &pNodes[iNode];
+		pNode->job = isNodeJob(pNode,
+			pSnapshot->track(iNode), iFrameStart, iFrameEnd);
+		if (pNode->job) {
+			pNode->clip = pSessionCursor->clip(iNode);
+			pNodeList->jobs[iJobs++] = pNode;
+		}
+	}
+
+	// Not worth it?
+	if (iJobs < 2) {
+		for (iNode = 0; iNode < iNodes; ++iNode)
+			pNodes[iNode].job = false;
+		return false;
+	}
+
+	// Job tracks automation processing goes first
+	// (the others do it on their own, serially)...
+	for (int iJob = 0; iJob < iJobs; ++iJob)
+		pNodeList->jobs[iJob]->track->process_curve(iFrameStart);
+
+	m_iFrameStart = iFrameStart;
+	m_iFrameEnd   = iFrameEnd;
+	m_bExport = bExport;
+	m_pRenderStats = (bExport ? qtractorRenderStats::getInstance() : NULL);
+	m_ppJobs = pNodeList->jobs;
+	m_iJobs = iJobs;
+
+	// Open for business...
+	ATOMIC_SET(&m_iDoneJobs, 0);
+	ATOMIC_SET(&m_iNextJob, 0);
+
+	// Wake up as many workers as needed...
+	int iWake = iJobs - 1;
+	if (iWake > int(m_iThreads))
+		iWake = int(m_iThreads);
+	while (iWake-- > 0)
+		::sem_post(&m_semWork);
+
+	// Do our own share of the work...
+	if (!work()) {
+		// Per-cycle barrier...
+		while (::sem_wait(&m_semDone) != 0 && errno == EINTR)
+			;
+	}
+
+	// Closed for business...
+	ATOMIC_SET(&m_iNextJob, QTRACTOR_GRAPH_CLOSED);
+
+	// Commit (or process) all tracks in strict order...
+	qtractorRenderStats *pRenderStats = m_pRenderStats;
+	const unsigned int nframes = iFrameEnd - iFrameStart;
+	for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+		qtractorTrack *pTrack = pSnapshot->track(iTrack);
+		Node *pNode = (iTrack < iNodes ? &pNodes[iTrack] : NULL);
+		if (pNode && pNode->job) {
+			pTrack->process_commit(nframes, pNode->xbuffer);
+			pNode->job = false;
+		}
+		else
+		if (bExport) {
+			const unsigned long long iTime
+				= (pRenderStats ? qtractorRenderStats::clock() : 0);
+			pTrack->process_export(pSessionCursor->clip(iTrack),
+				iFrameStart, iFrameEnd);
+			if (pRenderStats) pRenderStats->addTime(pTrack,
+				qtractorRenderStats::clock() - iTime);
+		}
+		else
+		if (pTrack->trackType() == qtractorTrack::Audio) {
+			pTrack->process(pSessionCursor->clip(iTrack),
+				iFrameStart, iFrameEnd);
+		}
+	}
+
+	return true;
+}
+
+
+// Process all pending jobs; returns true if last one done.
+bool qtractorAudioGraph::work (void)
+{
+	bool bLast = false;
+
+	int iJob = ATOMIC_INC(&m_iNextJob) - 1;
+	while (iJob < m_iJobs) {
+		Node *pNode = m_ppJobs[iJob];
+		const unsigned long long iTime
+			= (m_pRenderStats ? qtractorRenderStats::clock() : 0);
+		pNode->track->process_graph(pNode->clip,
+			m_iFrameStart, m_iFrameEnd, pNode->xbuffer, pNode->ybuffer,
+			pNode->zbuffer, pNode->wbuffer, m_bExport);
+		if (m_pRenderStats) m_pRenderStats->addTime(pNode->track,
+			qtractorRenderStats::clock() - iTime);
+		if (ATOMIC_INC(&m_iDoneJobs) == m_iJobs)
+			bLast = true;
+		iJob = ATOMIC_INC(&m_iNextJob) - 1;
+	}
+
+	return bLast;
+}
+
+
+// Worker thread executive (RT-safe).
+void qtractorAudioGraph::wait_work (void)
+{
+	while (::sem_wait(&m_semWork) != 0 && errno == EINTR)
+		;
+
+	if (work())
+		::sem_post(&m_semDone);
+}
+
+
+void qtractorAudioGraph::wake_all (void)
+{
+	for (unsigned short i = 0; i < m_iThreads; ++i)
+		::sem_post(&m_semWork);
+}
+
+
+// end of qtractorAudioGraph.cpp
@@ -0,0 +1,197 @@
+// qtractorAudioGraph.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioGraph_h
+#define __qtractorAudioGraph_h
+
+#include "qtractorAtomic.h"
+
+#include <QThread>
+#include <QList>
+
+#include <semaphore.h>
+
+
+// Forward declarations.
+class qtractorAudioGraph;
+class qtractorAudioEngine;
+class qtractorSessionCursor;
+class qtractorTrack;
+class qtractorClip;
+class qtractorRenderStats;
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraphThread -- Process graph worker thread.
+//
+
+class qtractorAudioGraphThread : public QThread
+{
+public:
+
+	// Constructor.
+	qtractorAudioGraphThread(qtractorAudioGraph *pAudioGraph, int iPriority);
+
+	// Thread run state accessors.
+	void setRunState(bool bRunState);
+	bool runState() const;
+
+protected:
+
+	// The main thread executive.
+	void run();
+
+private:
+
+	// Instance variables.
+	qtractorAudioGraph *m_pAudioGraph;
+
+	// RT scheduling priority (SCHED_FIFO; none if zero).
+	int m_iPriority;
+
+	// Whether the thread is logically running.
+	volatile bool m_bRunState;
+};
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioGraph -- Parallel track process graph.
+//
+// Audio tracks that have no side-effects on other buses (ie. no
+// audio inserts nor aux-sends activated on their plugin chains) are
+// processed concurrently into their own private work buffers, by a
+// pool of RT worker threads along with the JACK process thread itself.
+// After the per-cycle barrier, all tracks are then committed in strict
+// session order, so that output mix-down is identical to the serial one.
+// The very same graph also drives the offline (non-JACK) audio export,
+// in which case clips are read synchronously (export mode).
+//
+
+class qtractorAudioGraph
+{
+public:
+
+	// Constructor.
+	qtractorAudioGraph(qtractorAudioEngine *pAudioEngine,
+		unsigned short iThreads, int iPriority = 0);
+
+	// Destructor.
+	~qtractorAudioGraph();
+
+	// Number of worker threads (not counting the RT caller).
+	unsigned short threads() const;
+
+	// Node buffers (re)allocation (non RT-safe);
+	// follows current session track topology snapshot.
+	void update();
+
+	// Node buffers cleanup (non RT-safe).
+	void clear();
+
+	// Process cycle executive (RT-safe);
+	// returns false when serial processing is in order.
+	bool process(qtractorSessionCursor *pSessionCursor,
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		bool bExport = false);
+
+	// Worker thread executive (RT-safe).
+	void wait_work();
+	void wake_all();
+
+protected:
+
+	// Graph node (one per track).
+	struct Node
+	{
+		qtractorTrack  *track;
+		unsigned short  channels;
+		float         **xbuffer;
+		float         **ybuffer;
+		float         **zbuffer;
+		float         **wbuffer;
+		qtractorClip   *clip;
+		bool            job;
+	};
+
+	// Graph node list (one per track topology snapshot).
+	struct NodeList
+	{
+		Node         *nodes;
+		unsigned int  count;
+		Node        **jobs;
+		unsigned int  bufferSize;
+		bool         *shared;	// buffers handed over to next list.
+	};
+
+	// Node buffers helpers.
+	static void allocNode(Node *pNode,
+		unsigned short iChannels, unsigned int iBufferSize);
+	static void freeNode(Node *pNode);
+
+	// Node list helper (skipping shared node buffers).
+	static void freeNodeList(NodeList *pNodeList);
+
+	// Whether a track might be processed on its own.
+	bool isNodeJob(Node *pNode, qtractorTrack *pTrack,
+		unsigned long iFrameStart, unsigned long iFrameEnd) const;
+
+	// Process all pending jobs; returns true if last one done.
+	bool work();
+
+private:
+
+	// Instance variables.
+	qtractorAudioEngine *m_pAudioEngine;
+
+	// Worker thread pool.
+	unsigned short m_iThreads;
+	qtractorAudioGraphThread **m_ppThreads;
+
+	// Current node list (RCU-style).
+	NodeList *volatile m_pNodeList;
+
+	// Stale node lists, pending reclaim.
+	QList<NodeList *> m_retiredNodeLists;
+
+	// Current cycle job list.
+	Node         **m_ppJobs;
+	volatile int   m_iJobs;
+	qtractorAtomic m_iNextJob;
+	qtractorAtomic m_iDoneJobs;
+
+	// Current cycle frame range.
+	unsigned long  m_iFrameStart;
+	unsigned long  m_iFrameEnd;
+
+	// Current cycle export mode (and timing statistics).
+	bool           m_bExport;
+	qtractorRenderStats *m_pRenderStats;
+
+	// Cycle start/barrier semaphores.
+	sem_t m_semWork;
+	sem_t m_semDone;
+};
+
+
+#endif  // __qtractorAudioGraph_h
+
+
+// end of qtractorAudioGraph.h
@@ -0,0 +1,1492 @@
+// qtractorAudioKernel.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAudioKernel.h"
+
+#include <string.h>
+#include <math.h>
+
+
+// Wider vector kernels are compiled with per-function target
+// attributes, so that the whole build may still go SSE-only.
+#if defined(__SSE__) && defined(__GNUC__) && (defined(__clang__) \
+	|| __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define QTRACTOR_AUDIO_KERNEL_AVX
+#endif
+
+
+//----------------------------------------------------------------------
+// Standard (scalar) kernel versions.
+//
+
+static void std_gain (
+	float *pFrames, unsigned int iFrames, float fGain )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pFrames[n] *= fGain;
+}
+
+static void std_gain_ramp (
+	float *pFrames, unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	float fGainIter = fGain0;
+
+	for (unsigned int n = 0; n < iFrames; ++n, fGainIter += fGainStep)
+		pFrames[n] *= fGainIter;
+}
+
+static float std_gain_peak (
+	float *pFrames, unsigned int iFrames, float fGain, float fPeak )
+{
+	for (unsigned int n = 0; n < iFrames; ++n) {
+		pFrames[n] *= fGain;
+		if (fPeak < pFrames[n])
+			fPeak = pFrames[n];
+	}
+
+	return fPeak;
+}
+
+static float std_gain_ramp_peak ( float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1, float fPeak )
+{
+	if (iFrames < 1)
+		return fPeak;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	float fGainIter = fGain0;
+
+	for (unsigned int n = 0; n < iFrames; ++n, fGainIter += fGainStep) {
+		pFrames[n] *= fGainIter;
+		if (fPeak < pFrames[n])
+			fPeak = pFrames[n];
+	}
+
+	return fPeak;
+}
+
+static float std_peak (
+	const float *pFrames, unsigned int iFrames, float fPeak )
+{
+	for (unsigned int n = 0; n < iFrames; ++n) {
+		if (fPeak < pFrames[n])
+			fPeak = pFrames[n];
+	}
+
+	return fPeak;
+}
+
+static void std_accum ( const float *pFrames,
+	unsigned int iFrames, float *pfMax, float *pfMin, float *pfSum )
+{
+	float fMax = *pfMax;
+	float fMin = *pfMin;
+	float fSum = *pfSum;
+
+	for (unsigned int n = 0; n < iFrames; ++n) {
+		const float fSample = pFrames[n];
+		if (fMax < fSample)
+			fMax = fSample;
+		if (fMin > fSample)
+			fMin = fSample;
+		fSum += fSample * fSample;
+	}
+
+	*pfMax = fMax;
+	*pfMin = fMin;
+	*pfSum = fSum;
+}
+
+static void std_add (
+	float *pBuffer, const float *pFrames, unsigned int iFrames )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pBuffer[n] += pFrames[n];
+}
+
+static void std_add_gain ( float *pBuffer,
+	const float *pFrames, unsigned int iFrames, float fGain )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pBuffer[n] += fGain * pFrames[n];
+}
+
+static void std_add_ramp ( float *pBuffer, const float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	float fGainIter = fGain0;
+
+	for (unsigned int n = 0; n < iFrames; ++n, fGainIter += fGainStep)
+		pBuffer[n] += fGainIter * pFrames[n];
+}
+
+static void std_add_env ( float *pBuffer, const float *pFrames,
+	const float *pGains, unsigned int iFrames )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pBuffer[n] += pGains[n] * pFrames[n];
+}
+
+static void std_dry_wet ( float *pDry, const float *pWet,
+	unsigned int iFrames, float fDry, float fWet )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pDry[n] = fDry * pDry[n] + fWet * pWet[n];
+}
+
+static void std_convert ( float *pFrames,
+	const int *pSamples, unsigned int iFrames, float fScale )
+{
+	for (unsigned int n = 0; n < iFrames; ++n)
+		pFrames[n] = fScale * float(pSamples[n]);
+}
+
+static void std_interleave ( float *pBuffer, float **ppFrames,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels == 1) {
+		::memcpy(pBuffer, ppFrames[0], iFrames * sizeof(float));
+		return;
+	}
+
+	unsigned int n, k = 0;
+	for (n = 0; n < iFrames; ++n) {
+		for (unsigned short i = 0; i < iChannels; ++i)
+			pBuffer[k++] = ppFrames[i][n];
+	}
+}
+
+static void std_deinterleave ( float **ppFrames, const float *pBuffer,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels == 1) {
+		::memcpy(ppFrames[0], pBuffer, iFrames * sizeof(float));
+		return;
+	}
+
+	unsigned int n, k = 0;
+	for (n = 0; n < iFrames; ++n) {
+		for (unsigned short i = 0; i < iChannels; ++i)
+			ppFrames[i][n] = pBuffer[k++];
+	}
+}
+
+
+#if defined(__SSE__)
+
+#include <xmmintrin.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------
+// SSE kernel versions (4-wide).
+//
+
+static inline float sse_hmax ( __m128 v )
+{
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static inline float sse_hmin ( __m128 v )
+{
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static inline float sse_hadd ( __m128 v )
+{
+	v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static void sse_gain (
+	float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m128 v0 = _mm_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4)
+		_mm_storeu_ps(pFrames + n, _mm_mul_ps(_mm_loadu_ps(pFrames + n), v0));
+
+	std_gain(pFrames + n, iFrames - n, fGain);
+}
+
+static void sse_gain_ramp (
+	float *pFrames, unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m128 v0 = _mm_setr_ps(fGain0, fGain0 + fGainStep,
+		fGain0 + 2.0f * fGainStep, fGain0 + 3.0f * fGainStep);
+	const __m128 vs = _mm_set1_ps(4.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pFrames + n, _mm_mul_ps(_mm_loadu_ps(pFrames + n), v0));
+		v0 = _mm_add_ps(v0, vs);
+	}
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep)
+		pFrames[n] *= fGainIter;
+}
+
+static float sse_gain_peak (
+	float *pFrames, unsigned int iFrames, float fGain, float fPeak )
+{
+	const __m128 v0 = _mm_set1_ps(fGain);
+	__m128 v1 = _mm_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		const __m128 v2 = _mm_mul_ps(_mm_loadu_ps(pFrames + n), v0);
+		v1 = _mm_max_ps(v1, v2);
+		_mm_storeu_ps(pFrames + n, v2);
+	}
+
+	return std_gain_peak(pFrames + n, iFrames - n, fGain, sse_hmax(v1));
+}
+
+static float sse_gain_ramp_peak ( float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1, float fPeak )
+{
+	if (iFrames < 1)
+		return fPeak;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m128 v0 = _mm_setr_ps(fGain0, fGain0 + fGainStep,
+		fGain0 + 2.0f * fGainStep, fGain0 + 3.0f * fGainStep);
+	const __m128 vs = _mm_set1_ps(4.0f * fGainStep);
+	__m128 v1 = _mm_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		const __m128 v2 = _mm_mul_ps(_mm_loadu_ps(pFrames + n), v0);
+		v1 = _mm_max_ps(v1, v2);
+		_mm_storeu_ps(pFrames + n, v2);
+		v0 = _mm_add_ps(v0, vs);
+	}
+
+	fPeak = sse_hmax(v1);
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep) {
+		pFrames[n] *= fGainIter;
+		if (fPeak < pFrames[n])
+			fPeak = pFrames[n];
+	}
+
+	return fPeak;
+}
+
+static float sse_peak (
+	const float *pFrames, unsigned int iFrames, float fPeak )
+{
+	__m128 v1 = _mm_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4)
+		v1 = _mm_max_ps(v1, _mm_loadu_ps(pFrames + n));
+
+	return std_peak(pFrames + n, iFrames - n, sse_hmax(v1));
+}
+
+static void sse_accum ( const float *pFrames,
+	unsigned int iFrames, float *pfMax, float *pfMin, float *pfSum )
+{
+	__m128 v1 = _mm_set1_ps(*pfMax);
+	__m128 v2 = _mm_set1_ps(*pfMin);
+	__m128 v3 = _mm_setzero_ps();
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		const __m128 v0 = _mm_loadu_ps(pFrames + n);
+		v1 = _mm_max_ps(v1, v0);
+		v2 = _mm_min_ps(v2, v0);
+		v3 = _mm_add_ps(v3, _mm_mul_ps(v0, v0));
+	}
+
+	*pfMax  = sse_hmax(v1);
+	*pfMin  = sse_hmin(v2);
+	*pfSum += sse_hadd(v3);
+
+	std_accum(pFrames + n, iFrames - n, pfMax, pfMin, pfSum);
+}
+
+static void sse_add (
+	float *pBuffer, const float *pFrames, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pBuffer + n, _mm_add_ps(
+			_mm_loadu_ps(pBuffer + n), _mm_loadu_ps(pFrames + n)));
+	}
+
+	std_add(pBuffer + n, pFrames + n, iFrames - n);
+}
+
+static void sse_add_gain ( float *pBuffer,
+	const float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m128 v0 = _mm_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pBuffer + n, _mm_add_ps(_mm_loadu_ps(pBuffer + n),
+			_mm_mul_ps(_mm_loadu_ps(pFrames + n), v0)));
+	}
+
+	std_add_gain(pBuffer + n, pFrames + n, iFrames - n, fGain);
+}
+
+static void sse_add_ramp ( float *pBuffer, const float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m128 v0 = _mm_setr_ps(fGain0, fGain0 + fGainStep,
+		fGain0 + 2.0f * fGainStep, fGain0 + 3.0f * fGainStep);
+	const __m128 vs = _mm_set1_ps(4.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pBuffer + n, _mm_add_ps(_mm_loadu_ps(pBuffer + n),
+			_mm_mul_ps(_mm_loadu_ps(pFrames + n), v0)));
+		v0 = _mm_add_ps(v0, vs);
+	}
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep)
+		pBuffer[n] += fGainIter * pFrames[n];
+}
+
+static void sse_add_env ( float *pBuffer, const float *pFrames,
+	const float *pGains, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pBuffer + n, _mm_add_ps(_mm_loadu_ps(pBuffer + n),
+			_mm_mul_ps(_mm_loadu_ps(pFrames + n), _mm_loadu_ps(pGains + n))));
+	}
+
+	std_add_env(pBuffer + n, pFrames + n, pGains + n, iFrames - n);
+}
+
+static void sse_dry_wet ( float *pDry, const float *pWet,
+	unsigned int iFrames, float fDry, float fWet )
+{
+	const __m128 vWet = _mm_set1_ps(fWet);
+	const __m128 vDry = _mm_set1_ps(fDry);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pDry + n, _mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(pDry + n), vDry),
+			_mm_mul_ps(_mm_loadu_ps(pWet + n), vWet)));
+	}
+
+	std_dry_wet(pDry + n, pWet + n, iFrames - n, fDry, fWet);
+}
+
+#if defined(__SSE2__)
+
+static void sse_convert ( float *pFrames,
+	const int *pSamples, unsigned int iFrames, float fScale )
+{
+	const __m128 v0 = _mm_set1_ps(fScale);
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		_mm_storeu_ps(pFrames + n, _mm_mul_ps(v0, _mm_cvtepi32_ps(
+			_mm_loadu_si128((const __m128i *) (pSamples + n)))));
+	}
+
+	std_convert(pFrames + n, pSamples + n, iFrames - n, fScale);
+}
+
+#endif
+
+static void sse_interleave ( float *pBuffer, float **ppFrames,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels != 2) {
+		std_interleave(pBuffer, ppFrames, iChannels, iFrames);
+		return;
+	}
+
+	const float *pFramesL = ppFrames[0];
+	const float *pFramesR = ppFrames[1];
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		const __m128 vl = _mm_loadu_ps(pFramesL + n);
+		const __m128 vr = _mm_loadu_ps(pFramesR + n);
+		_mm_storeu_ps(pBuffer + (n << 1),     _mm_unpacklo_ps(vl, vr));
+		_mm_storeu_ps(pBuffer + (n << 1) + 4, _mm_unpackhi_ps(vl, vr));
+	}
+
+	for (; n < iFrames; ++n) {
+		pBuffer[(n << 1)]     = pFramesL[n];
+		pBuffer[(n << 1) + 1] = pFramesR[n];
+	}
+}
+
+static void sse_deinterleave ( float **ppFrames, const float *pBuffer,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels != 2) {
+		std_deinterleave(ppFrames, pBuffer, iChannels, iFrames);
+		return;
+	}
+
+	float *pFramesL = ppFrames[0];
+	float *pFramesR = ppFrames[1];
+
+	unsigned int n = 0;
+	for (; n + 4 <= iFrames; n += 4) {
+		const __m128 v0 = _mm_loadu_ps(pBuffer + (n << 1));
+		const __m128 v1 = _mm_loadu_ps(pBuffer + (n << 1) + 4);
+		_mm_storeu_ps(pFramesL + n,
+			_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(pFramesR + n,
+			_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	for (; n < iFrames; ++n) {
+		pFramesL[n] = pBuffer[(n << 1)];
+		pFramesR[n] = pBuffer[(n << 1) + 1];
+	}
+}
+
+#endif	// __SSE__
+
+
+#if defined(QTRACTOR_AUDIO_KERNEL_AVX)
+
+#include <immintrin.h>
+
+#define QTRACTOR_TARGET_AVX    __attribute__((target("avx")))
+#define QTRACTOR_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define QTRACTOR_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+//----------------------------------------------------------------------
+// AVX kernel versions (8-wide).
+//
+
+QTRACTOR_TARGET_AVX
+static inline float avx_hmax ( __m256 v )
+{
+	__m128 v1 = _mm_max_ps(_mm256_castps256_ps128(v),
+		_mm256_extractf128_ps(v, 1));
+	v1 = _mm_max_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(1, 0, 3, 2)));
+	v1 = _mm_max_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v1);
+}
+
+QTRACTOR_TARGET_AVX
+static inline float avx_hmin ( __m256 v )
+{
+	__m128 v1 = _mm_min_ps(_mm256_castps256_ps128(v),
+		_mm256_extractf128_ps(v, 1));
+	v1 = _mm_min_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(1, 0, 3, 2)));
+	v1 = _mm_min_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v1);
+}
+
+QTRACTOR_TARGET_AVX
+static inline float avx_hadd ( __m256 v )
+{
+	__m128 v1 = _mm_add_ps(_mm256_castps256_ps128(v),
+		_mm256_extractf128_ps(v, 1));
+	v1 = _mm_add_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(1, 0, 3, 2)));
+	v1 = _mm_add_ps(v1, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v1);
+}
+
+QTRACTOR_TARGET_AVX
+static inline __m256 avx_ramp ( float fGain0, float fGainStep )
+{
+	return _mm256_add_ps(_mm256_set1_ps(fGain0), _mm256_mul_ps(
+		_mm256_set1_ps(fGainStep),
+		_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)));
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_gain (
+	float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m256 v0 = _mm256_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pFrames + n,
+			_mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0));
+	}
+
+	std_gain(pFrames + n, iFrames - n, fGain);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_gain_ramp (
+	float *pFrames, unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m256 v0 = avx_ramp(fGain0, fGainStep);
+	const __m256 vs = _mm256_set1_ps(8.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pFrames + n,
+			_mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0));
+		v0 = _mm256_add_ps(v0, vs);
+	}
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep)
+		pFrames[n] *= fGainIter;
+}
+
+QTRACTOR_TARGET_AVX
+static float avx_gain_peak (
+	float *pFrames, unsigned int iFrames, float fGain, float fPeak )
+{
+	const __m256 v0 = _mm256_set1_ps(fGain);
+	__m256 v1 = _mm256_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		const __m256 v2 = _mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0);
+		v1 = _mm256_max_ps(v1, v2);
+		_mm256_storeu_ps(pFrames + n, v2);
+	}
+
+	return std_gain_peak(pFrames + n, iFrames - n, fGain, avx_hmax(v1));
+}
+
+QTRACTOR_TARGET_AVX
+static float avx_gain_ramp_peak ( float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1, float fPeak )
+{
+	if (iFrames < 1)
+		return fPeak;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m256 v0 = avx_ramp(fGain0, fGainStep);
+	const __m256 vs = _mm256_set1_ps(8.0f * fGainStep);
+	__m256 v1 = _mm256_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		const __m256 v2 = _mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0);
+		v1 = _mm256_max_ps(v1, v2);
+		_mm256_storeu_ps(pFrames + n, v2);
+		v0 = _mm256_add_ps(v0, vs);
+	}
+
+	fPeak = avx_hmax(v1);
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep) {
+		pFrames[n] *= fGainIter;
+		if (fPeak < pFrames[n])
+			fPeak = pFrames[n];
+	}
+
+	return fPeak;
+}
+
+QTRACTOR_TARGET_AVX
+static float avx_peak (
+	const float *pFrames, unsigned int iFrames, float fPeak )
+{
+	__m256 v1 = _mm256_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8)
+		v1 = _mm256_max_ps(v1, _mm256_loadu_ps(pFrames + n));
+
+	return std_peak(pFrames + n, iFrames - n, avx_hmax(v1));
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_accum ( const float *pFrames,
+	unsigned int iFrames, float *pfMax, float *pfMin, float *pfSum )
+{
+	__m256 v1 = _mm256_set1_ps(*pfMax);
+	__m256 v2 = _mm256_set1_ps(*pfMin);
+	__m256 v3 = _mm256_setzero_ps();
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		const __m256 v0 = _mm256_loadu_ps(pFrames + n);
+		v1 = _mm256_max_ps(v1, v0);
+		v2 = _mm256_min_ps(v2, v0);
+		v3 = _mm256_add_ps(v3, _mm256_mul_ps(v0, v0));
+	}
+
+	*pfMax  = avx_hmax(v1);
+	*pfMin  = avx_hmin(v2);
+	*pfSum += avx_hadd(v3);
+
+	std_accum(pFrames + n, iFrames - n, pfMax, pfMin, pfSum);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_add (
+	float *pBuffer, const float *pFrames, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_add_ps(
+			_mm256_loadu_ps(pBuffer + n), _mm256_loadu_ps(pFrames + n)));
+	}
+
+	std_add(pBuffer + n, pFrames + n, iFrames - n);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_add_gain ( float *pBuffer,
+	const float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m256 v0 = _mm256_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_add_ps(
+			_mm256_loadu_ps(pBuffer + n),
+			_mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0)));
+	}
+
+	std_add_gain(pBuffer + n, pFrames + n, iFrames - n, fGain);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_add_ramp ( float *pBuffer, const float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m256 v0 = avx_ramp(fGain0, fGainStep);
+	const __m256 vs = _mm256_set1_ps(8.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_add_ps(
+			_mm256_loadu_ps(pBuffer + n),
+			_mm256_mul_ps(_mm256_loadu_ps(pFrames + n), v0)));
+		v0 = _mm256_add_ps(v0, vs);
+	}
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep)
+		pBuffer[n] += fGainIter * pFrames[n];
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_add_env ( float *pBuffer, const float *pFrames,
+	const float *pGains, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_add_ps(
+			_mm256_loadu_ps(pBuffer + n),
+			_mm256_mul_ps(_mm256_loadu_ps(pFrames + n),
+				_mm256_loadu_ps(pGains + n))));
+	}
+
+	std_add_env(pBuffer + n, pFrames + n, pGains + n, iFrames - n);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_dry_wet ( float *pDry, const float *pWet,
+	unsigned int iFrames, float fDry, float fWet )
+{
+	const __m256 vWet = _mm256_set1_ps(fWet);
+	const __m256 vDry = _mm256_set1_ps(fDry);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pDry + n, _mm256_add_ps(
+			_mm256_mul_ps(_mm256_loadu_ps(pDry + n), vDry),
+			_mm256_mul_ps(_mm256_loadu_ps(pWet + n), vWet)));
+	}
+
+	std_dry_wet(pDry + n, pWet + n, iFrames - n, fDry, fWet);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_convert ( float *pFrames,
+	const int *pSamples, unsigned int iFrames, float fScale )
+{
+	const __m256 v0 = _mm256_set1_ps(fScale);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pFrames + n, _mm256_mul_ps(v0, _mm256_cvtepi32_ps(
+			_mm256_loadu_si256((const __m256i *) (pSamples + n)))));
+	}
+
+	std_convert(pFrames + n, pSamples + n, iFrames - n, fScale);
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_interleave ( float *pBuffer, float **ppFrames,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels != 2) {
+		std_interleave(pBuffer, ppFrames, iChannels, iFrames);
+		return;
+	}
+
+	const float *pFramesL = ppFrames[0];
+	const float *pFramesR = ppFrames[1];
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		const __m256 vl = _mm256_loadu_ps(pFramesL + n);
+		const __m256 vr = _mm256_loadu_ps(pFramesR + n);
+		const __m256 v0 = _mm256_unpacklo_ps(vl, vr);
+		const __m256 v1 = _mm256_unpackhi_ps(vl, vr);
+		_mm256_storeu_ps(pBuffer + (n << 1),
+			_mm256_permute2f128_ps(v0, v1, 0x20));
+		_mm256_storeu_ps(pBuffer + (n << 1) + 8,
+			_mm256_permute2f128_ps(v0, v1, 0x31));
+	}
+
+	for (; n < iFrames; ++n) {
+		pBuffer[(n << 1)]     = pFramesL[n];
+		pBuffer[(n << 1) + 1] = pFramesR[n];
+	}
+}
+
+QTRACTOR_TARGET_AVX
+static void avx_deinterleave ( float **ppFrames, const float *pBuffer,
+	unsigned short iChannels, unsigned int iFrames )
+{
+	if (iChannels != 2) {
+		std_deinterleave(ppFrames, pBuffer, iChannels, iFrames);
+		return;
+	}
+
+	float *pFramesL = ppFrames[0];
+	float *pFramesR = ppFrames[1];
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		const __m256 v0 = _mm256_loadu_ps(pBuffer + (n << 1));
+		const __m256 v1 = _mm256_loadu_ps(pBuffer + (n << 1) + 8);
+		const __m256 v2 = _mm256_permute2f128_ps(v0, v1, 0x20);
+		const __m256 v3 = _mm256_permute2f128_ps(v0, v1, 0x31);
+		_mm256_storeu_ps(pFramesL + n,
+			_mm256_shuffle_ps(v2, v3, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm256_storeu_ps(pFramesR + n,
+			_mm256_shuffle_ps(v2, v3, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	for (; n < iFrames; ++n) {
+		pFramesL[n] = pBuffer[(n << 1)];
+		pFramesR[n] = pBuffer[(n << 1) + 1];
+	}
+}
+
+
+//----------------------------------------------------------------------
+// AVX2+FMA kernel versions (8-wide, fused multiply-add).
+//
+
+QTRACTOR_TARGET_AVX2
+static void avx2_add_gain ( float *pBuffer,
+	const float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m256 v0 = _mm256_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_fmadd_ps(
+			_mm256_loadu_ps(pFrames + n), v0, _mm256_loadu_ps(pBuffer + n)));
+	}
+
+	std_add_gain(pBuffer + n, pFrames + n, iFrames - n, fGain);
+}
+
+QTRACTOR_TARGET_AVX2
+static void avx2_add_ramp ( float *pBuffer, const float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m256 v0 = avx_ramp(fGain0, fGainStep);
+	const __m256 vs = _mm256_set1_ps(8.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_fmadd_ps(
+			_mm256_loadu_ps(pFrames + n), v0, _mm256_loadu_ps(pBuffer + n)));
+		v0 = _mm256_add_ps(v0, vs);
+	}
+
+	float fGainIter = fGain0 + float(n) * fGainStep;
+	for (; n < iFrames; ++n, fGainIter += fGainStep)
+		pBuffer[n] += fGainIter * pFrames[n];
+}
+
+QTRACTOR_TARGET_AVX2
+static void avx2_add_env ( float *pBuffer, const float *pFrames,
+	const float *pGains, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pBuffer + n, _mm256_fmadd_ps(
+			_mm256_loadu_ps(pFrames + n), _mm256_loadu_ps(pGains + n),
+			_mm256_loadu_ps(pBuffer + n)));
+	}
+
+	std_add_env(pBuffer + n, pFrames + n, pGains + n, iFrames - n);
+}
+
+QTRACTOR_TARGET_AVX2
+static void avx2_dry_wet ( float *pDry, const float *pWet,
+	unsigned int iFrames, float fDry, float fWet )
+{
+	const __m256 vWet = _mm256_set1_ps(fWet);
+	const __m256 vDry = _mm256_set1_ps(fDry);
+
+	unsigned int n = 0;
+	for (; n + 8 <= iFrames; n += 8) {
+		_mm256_storeu_ps(pDry + n, _mm256_fmadd_ps(
+			_mm256_loadu_ps(pWet + n), vWet,
+			_mm256_mul_ps(_mm256_loadu_ps(pDry + n), vDry)));
+	}
+
+	std_dry_wet(pDry + n, pWet + n, iFrames - n, fDry, fWet);
+}
+
+
+//----------------------------------------------------------------------
+// AVX-512 kernel versions (16-wide, masked tails).
+//
+
+QTRACTOR_TARGET_AVX512
+static inline __mmask16 avx512_mask ( unsigned int iFrames )
+{
+	return __mmask16((1U << iFrames) - 1);
+}
+
+// NOTE: All-unmasked AVX-512 max/extract/convert intrinsics start off
+// from an undefined vector, which trips GCC's -Wmaybe-uninitialized;
+// the masked ones are used instead, given a defined source.
+
+QTRACTOR_TARGET_AVX512
+static inline __m256 avx512_lo ( __m512 v )
+{
+	return _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(
+		_mm256_setzero_pd(), 0xff, _mm512_castps_pd(v), 0));
+}
+
+QTRACTOR_TARGET_AVX512
+static inline __m256 avx512_hi ( __m512 v )
+{
+	return _mm256_castpd_ps(_mm512_mask_extractf64x4_pd(
+		_mm256_setzero_pd(), 0xff, _mm512_castps_pd(v), 1));
+}
+
+QTRACTOR_TARGET_AVX512
+static inline __m512 avx512_max ( __m512 v1, __m512 v2 )
+{
+	return _mm512_mask_max_ps(v1, 0xffff, v1, v2);
+}
+
+QTRACTOR_TARGET_AVX512
+static inline __m512 avx512_min ( __m512 v1, __m512 v2 )
+{
+	return _mm512_mask_min_ps(v1, 0xffff, v1, v2);
+}
+
+QTRACTOR_TARGET_AVX512
+static inline float avx512_hmax ( __m512 v )
+{
+	return avx_hmax(_mm256_max_ps(avx512_lo(v), avx512_hi(v)));
+}
+
+QTRACTOR_TARGET_AVX512
+static inline float avx512_hmin ( __m512 v )
+{
+	return avx_hmin(_mm256_min_ps(avx512_lo(v), avx512_hi(v)));
+}
+
+QTRACTOR_TARGET_AVX512
+static inline float avx512_hadd ( __m512 v )
+{
+	return avx_hadd(_mm256_add_ps(avx512_lo(v), avx512_hi(v)));
+}
+
+QTRACTOR_TARGET_AVX512
+static inline __m512 avx512_ramp ( float fGain0, float fGainStep )
+{
+	return _mm512_fmadd_ps(_mm512_set1_ps(fGainStep),
+		_mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+			8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f),
+		_mm512_set1_ps(fGain0));
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_gain (
+	float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m512 v0 = _mm512_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pFrames + n,
+			_mm512_mul_ps(_mm512_loadu_ps(pFrames + n), v0));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pFrames + n, m,
+			_mm512_mul_ps(_mm512_maskz_loadu_ps(m, pFrames + n), v0));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_gain_ramp (
+	float *pFrames, unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m512 v0 = avx512_ramp(fGain0, fGainStep);
+	const __m512 vs = _mm512_set1_ps(16.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pFrames + n,
+			_mm512_mul_ps(_mm512_loadu_ps(pFrames + n), v0));
+		v0 = _mm512_add_ps(v0, vs);
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pFrames + n, m,
+			_mm512_mul_ps(_mm512_maskz_loadu_ps(m, pFrames + n), v0));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static float avx512_gain_peak (
+	float *pFrames, unsigned int iFrames, float fGain, float fPeak )
+{
+	const __m512 v0 = _mm512_set1_ps(fGain);
+	__m512 v1 = _mm512_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		const __m512 v2 = _mm512_mul_ps(_mm512_loadu_ps(pFrames + n), v0);
+		v1 = avx512_max(v1, v2);
+		_mm512_storeu_ps(pFrames + n, v2);
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		const __m512 v2 = _mm512_mul_ps(_mm512_maskz_loadu_ps(m, pFrames + n), v0);
+		v1 = _mm512_mask_max_ps(v1, m, v1, v2);
+		_mm512_mask_storeu_ps(pFrames + n, m, v2);
+	}
+
+	return avx512_hmax(v1);
+}
+
+QTRACTOR_TARGET_AVX512
+static float avx512_gain_ramp_peak ( float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1, float fPeak )
+{
+	if (iFrames < 1)
+		return fPeak;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m512 v0 = avx512_ramp(fGain0, fGainStep);
+	const __m512 vs = _mm512_set1_ps(16.0f * fGainStep);
+	__m512 v1 = _mm512_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		const __m512 v2 = _mm512_mul_ps(_mm512_loadu_ps(pFrames + n), v0);
+		v1 = avx512_max(v1, v2);
+		_mm512_storeu_ps(pFrames + n, v2);
+		v0 = _mm512_add_ps(v0, vs);
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		const __m512 v2 = _mm512_mul_ps(_mm512_maskz_loadu_ps(m, pFrames + n), v0);
+		v1 = _mm512_mask_max_ps(v1, m, v1, v2);
+		_mm512_mask_storeu_ps(pFrames + n, m, v2);
+	}
+
+	return avx512_hmax(v1);
+}
+
+QTRACTOR_TARGET_AVX512
+static float avx512_peak (
+	const float *pFrames, unsigned int iFrames, float fPeak )
+{
+	__m512 v1 = _mm512_set1_ps(fPeak);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16)
+		v1 = avx512_max(v1, _mm512_loadu_ps(pFrames + n));
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		v1 = avx512_max(v1, _mm512_mask_loadu_ps(v1, m, pFrames + n));
+	}
+
+	return avx512_hmax(v1);
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_accum ( const float *pFrames,
+	unsigned int iFrames, float *pfMax, float *pfMin, float *pfSum )
+{
+	__m512 v1 = _mm512_set1_ps(*pfMax);
+	__m512 v2 = _mm512_set1_ps(*pfMin);
+	__m512 v3 = _mm512_setzero_ps();
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		const __m512 v0 = _mm512_loadu_ps(pFrames + n);
+		v1 = avx512_max(v1, v0);
+		v2 = avx512_min(v2, v0);
+		v3 = _mm512_fmadd_ps(v0, v0, v3);
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		const __m512 v0 = _mm512_maskz_loadu_ps(m, pFrames + n);
+		v1 = _mm512_mask_max_ps(v1, m, v1, v0);
+		v2 = _mm512_mask_min_ps(v2, m, v2, v0);
+		v3 = _mm512_fmadd_ps(v0, v0, v3);
+	}
+
+	*pfMax  = avx512_hmax(v1);
+	*pfMin  = avx512_hmin(v2);
+	*pfSum += avx512_hadd(v3);
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_add (
+	float *pBuffer, const float *pFrames, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pBuffer + n, _mm512_add_ps(
+			_mm512_loadu_ps(pBuffer + n), _mm512_loadu_ps(pFrames + n)));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pBuffer + n, m, _mm512_add_ps(
+			_mm512_maskz_loadu_ps(m, pBuffer + n),
+			_mm512_maskz_loadu_ps(m, pFrames + n)));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_add_gain ( float *pBuffer,
+	const float *pFrames, unsigned int iFrames, float fGain )
+{
+	const __m512 v0 = _mm512_set1_ps(fGain);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pBuffer + n, _mm512_fmadd_ps(
+			_mm512_loadu_ps(pFrames + n), v0, _mm512_loadu_ps(pBuffer + n)));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pBuffer + n, m, _mm512_fmadd_ps(
+			_mm512_maskz_loadu_ps(m, pFrames + n), v0,
+			_mm512_maskz_loadu_ps(m, pBuffer + n)));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_add_ramp ( float *pBuffer, const float *pFrames,
+	unsigned int iFrames, float fGain0, float fGain1 )
+{
+	if (iFrames < 1)
+		return;
+
+	const float fGainStep = (fGain1 - fGain0) / float(iFrames);
+	__m512 v0 = avx512_ramp(fGain0, fGainStep);
+	const __m512 vs = _mm512_set1_ps(16.0f * fGainStep);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pBuffer + n, _mm512_fmadd_ps(
+			_mm512_loadu_ps(pFrames + n), v0, _mm512_loadu_ps(pBuffer + n)));
+		v0 = _mm512_add_ps(v0, vs);
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pBuffer + n, m, _mm512_fmadd_ps(
+			_mm512_maskz_loadu_ps(m, pFrames + n), v0,
+			_mm512_maskz_loadu_ps(m, pBuffer + n)));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_add_env ( float *pBuffer, const float *pFrames,
+	const float *pGains, unsigned int iFrames )
+{
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pBuffer + n, _mm512_fmadd_ps(
+			_mm512_loadu_ps(pFrames + n), _mm512_loadu_ps(pGains + n),
+			_mm512_loadu_ps(pBuffer + n)));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pBuffer + n, m, _mm512_fmadd_ps(
+			_mm512_maskz_loadu_ps(m, pFrames + n),
+			_mm512_maskz_loadu_ps(m, pGains + n),
+			_mm512_maskz_loadu_ps(m, pBuffer + n)));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_dry_wet ( float *pDry, const float *pWet,
+	unsigned int iFrames, float fDry, float fWet )
+{
+	const __m512 vWet = _mm512_set1_ps(fWet);
+	const __m512 vDry = _mm512_set1_ps(fDry);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pDry + n, _mm512_fmadd_ps(
+			_mm512_loadu_ps(pWet + n), vWet,
+			_mm512_mul_ps(_mm512_loadu_ps(pDry + n), vDry)));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pDry + n, m, _mm512_fmadd_ps(
+			_mm512_maskz_loadu_ps(m, pWet + n), vWet,
+			_mm512_mul_ps(_mm512_maskz_loadu_ps(m, pDry + n), vDry)));
+	}
+}
+
+QTRACTOR_TARGET_AVX512
+static void avx512_convert ( float *pFrames,
+	const int *pSamples, unsigned int iFrames, float fScale )
+{
+	const __m512 v0 = _mm512_set1_ps(fScale);
+
+	unsigned int n = 0;
+	for (; n + 16 <= iFrames; n += 16) {
+		_mm512_storeu_ps(pFrames + n, _mm512_mul_ps(v0,
+			_mm512_maskz_cvtepi32_ps(0xffff,
+				_mm512_loadu_si512(pSamples + n))));
+	}
+
+	if (n < iFrames) {
+		const __mmask16 m = avx512_mask(iFrames - n);
+		_mm512_mask_storeu_ps(pFrames + n, m, _mm512_mul_ps(v0,
+			_mm512_maskz_cvtepi32_ps(m,
+				_mm512_maskz_loadu_epi32(m, pSamples + n))));
+	}
+}
+
+#endif	// QTRACTOR_AUDIO_KERNEL_AVX
+
+
+//----------------------------------------------------------------------
+// CPU feature detection.
+//
+
+#if defined(__SSE__) && defined(__GNUC__)
+
+static inline void cpuid ( unsigned int iLeaf, unsigned int iSubLeaf,
+	unsigned int& eax, unsigned int& ebx, unsigned int& ecx, unsigned int& edx )
+{
+#if defined(__x86_64__) || (!defined(PIC) && !defined(__PIC__))
+	__asm__ __volatile__ (
+		"cpuid\n\t" \
+		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) \
+		: "a" (iLeaf), "c" (iSubLeaf) : "cc");
+#else
+	__asm__ __volatile__ (
+		"push %%ebx\n\t" \
+		"cpuid\n\t" \
+		"movl %%ebx,%1\n\t" \
+		"pop %%ebx\n\t" \
+		: "=a" (eax), "=r" (ebx), "=c" (ecx), "=d" (edx) \
+		: "a" (iLeaf), "c" (iSubLeaf) : "cc");
+#endif
+}
+
+#if defined(QTRACTOR_AUDIO_KERNEL_AVX)
+
+// Extended control register (XCR0) state, as enabled by the OS.
+static inline unsigned int xgetbv0 (void)
+{
+	unsigned int eax, edx;
+	__asm__ __volatile__ (
+		".byte 0x0f, 0x01, 0xd0\n\t" \
+		: "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+}
+
+#endif
+
+#endif
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioKernel -- Audio DSP kernel dispatcher.
+//
+
+// Dispatched kernels (scalar until startup detection).
+void  (*qtractorAudioKernel::gain)(float *, unsigned int, float)
+	= std_gain;
+void  (*qtractorAudioKernel::gain_ramp)(float *, unsigned int, float, float)
+	= std_gain_ramp;
+float (*qtractorAudioKernel::gain_peak)(float *, unsigned int, float, float)
+	= std_gain_peak;
+float (*qtractorAudioKernel::gain_ramp_peak)(float *, unsigned int,
+	float, float, float) = std_gain_ramp_peak;
+float (*qtractorAudioKernel::peak)(const float *, unsigned int, float)
+	= std_peak;
+void  (*qtractorAudioKernel::accum)(const float *, unsigned int,
+	float *, float *, float *) = std_accum;
+void  (*qtractorAudioKernel::add)(float *, const float *, unsigned int)
+	= std_add;
+void  (*qtractorAudioKernel::add_gain)(float *, const float *,
+	unsigned int, float) = std_add_gain;
+void  (*qtractorAudioKernel::add_ramp)(float *, const float *,
+	unsigned int, float, float) = std_add_ramp;
+void  (*qtractorAudioKernel::add_env)(float *, const float *,
+	const float *, unsigned int) = std_add_env;
+void  (*qtractorAudioKernel::dry_wet)(float *, const float *,
+	unsigned int, float, float) = std_dry_wet;
+void  (*qtractorAudioKernel::convert)(float *, const int *,
+	unsigned int, float) = std_convert;
+void  (*qtractorAudioKernel::interleave)(float *, float **,
+	unsigned short, unsigned int) = std_interleave;
+void  (*qtractorAudioKernel::deinterleave)(float **, const float *,
+	unsigned short, unsigned int) = std_deinterleave;
+
+
+// Current (dispatched) level.
+static qtractorAudioKernel::Level g_audioKernelLevel
+	= qtractorAudioKernel::Scalar;
+
+qtractorAudioKernel::Level qtractorAudioKernel::level (void)
+{
+	return g_audioKernelLevel;
+}
+
+
+// Dispatched level override (capped to detected; non RT-safe).
+void qtractorAudioKernel::setLevel ( Level level )
+{
+	const Level maxLevel = detectLevel();
+	if (level > maxLevel)
+		level = maxLevel;
+
+	gain           = std_gain;
+	gain_ramp      = std_gain_ramp;
+	gain_peak      = std_gain_peak;
+	gain_ramp_peak = std_gain_ramp_peak;
+	peak           = std_peak;
+	accum          = std_accum;
+	add            = std_add;
+	add_gain       = std_add_gain;
+	add_ramp       = std_add_ramp;
+	add_env        = std_add_env;
+	dry_wet        = std_dry_wet;
+	convert        = std_convert;
+	interleave     = std_interleave;
+	deinterleave   = std_deinterleave;
+
+#if defined(__SSE__)
+	if (level >= SSE) {
+		gain           = sse_gain;
+		gain_ramp      = sse_gain_ramp;
+		gain_peak      = sse_gain_peak;
+		gain_ramp_peak = sse_gain_ramp_peak;
+		peak           = sse_peak;
+		accum          = sse_accum;
+		add            = sse_add;
+		add_gain       = sse_add_gain;
+		add_ramp       = sse_add_ramp;
+		add_env        = sse_add_env;
+		dry_wet        = sse_dry_wet;
+		interleave     = sse_interleave;
+		deinterleave   = sse_deinterleave;
+	#if defined(__SSE2__)
+		convert        = sse_convert;
+	#endif
+	}
+#endif
+
+#if defined(QTRACTOR_AUDIO_KERNEL_AVX)
+	if (level >= AVX) {
+		gain           = avx_gain;
+		gain_ramp      = avx_gain_ramp;
+		gain_peak      = avx_gain_peak;
+		gain_ramp_peak = avx_gain_ramp_peak;
+		peak           = avx_peak;
+		accum          = avx_accum;
+		add            = avx_add;
+		add_gain       = avx_add_gain;
+		add_ramp       = avx_add_ramp;
+		add_env        = avx_add_env;
+		dry_wet        = avx_dry_wet;
+		convert        = avx_convert;
+		interleave     = avx_interleave;
+		deinterleave   = avx_deinterleave;
+	}
+	if (level >= AVX2) {
+		add_gain       = avx2_add_gain;
+		add_ramp       = avx2_add_ramp;
+		add_env        = avx2_add_env;
+		dry_wet        = avx2_dry_wet;
+	}
+	if (level >= AVX512) {
+		gain           = avx512_gain;
+		gain_ramp      = avx512_gain_ramp;
+		gain_peak      = avx512_gain_peak;
+		gain_ramp_peak = avx512_gain_ramp_peak;
+		peak           = avx512_peak;
+		accum          = avx512_accum;
+		add            = avx512_add;
+		add_gain       = avx512_add_gain;
+		add_ramp       = avx512_add_ramp;
+		add_env        = avx512_add_env;
+		dry_wet        = avx512_dry_wet;
+		convert        = avx512_convert;
+	}
+#endif
+
+	g_audioKernelLevel = level;
+}
+
+
+// Highest level supported by the running CPU.
+qtractorAudioKernel::Level qtractorAudioKernel::detectLevel (void)
+{
+	Level level = Scalar;
+
+#if defined(__SSE__) && defined(__GNUC__)
+	unsigned int eax, ebx, ecx, edx;
+	cpuid(0, 0, eax, ebx, ecx, edx);
+	const unsigned int iMaxLeaf = eax;
+	if (iMaxLeaf < 1)
+		return level;
+	cpuid(1, 0, eax, ebx, ecx, edx);
+	if ((edx & (1 << 25)) == 0)
+		return level;
+	level = SSE;
+#if defined(QTRACTOR_AUDIO_KERNEL_AVX)
+	// AVX needs OS support for saving the YMM state (OSXSAVE+XCR0)...
+	const bool bFMA = (ecx & (1 << 12));
+	if ((ecx & (1 << 27)) == 0 || (ecx & (1 << 28)) == 0)
+		return level;
+	const unsigned int xcr0 = xgetbv0();
+	if ((xcr0 & 0x06) != 0x06)
+		return level;
+	level = AVX;
+	if (iMaxLeaf < 7)
+		return level;
+	cpuid(7, 0, eax, ebx, ecx, edx);
+	if ((ebx & (1 << 5)) == 0 || !bFMA)
+		return level;
+	level = AVX2;
+	// AVX-512 also needs the opmask and ZMM states enabled...
+	if ((ebx & (1 << 16)) && (xcr0 & 0xe0) == 0xe0)
+		level = AVX512;
+#endif
+#endif
+
+	return level;
+}
+
+
+// Level display name.
+const char *qtractorAudioKernel::levelName ( Level level )
+{
+	switch (level) {
+	case SSE:
+		return "SSE";
+	case AVX:
+		return "AVX";
+	case AVX2:
+		return "AVX2";
+	case AVX512:
+		return "AVX-512";
+	case Scalar:
+	default:
+		return "Scalar";
+	}
+}
+
+
+// Startup dispatcher (once and for all).
+static class qtractorAudioKernelInit
+{
+public:
+
+	qtractorAudioKernelInit()
+		{ qtractorAudioKernel::setLevel(qtractorAudioKernel::detectLevel()); }
+
+} g_audioKernelInit;
+
+
+// end of qtractorAudioKernel.cpp
@@ -0,0 +1,127 @@
+// qtractorAudioKernel.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorAudioKernel_h
+#define __qtractorAudioKernel_h
+
+
+// Silence detection threshold (about -100dB).
+#define QTRACTOR_AUDIO_SILENCE	1e-5f
+
+
+//----------------------------------------------------------------------
+// class qtractorAudioKernel -- Audio DSP kernel dispatcher.
+//
+// The audio buffer inner loops for gain, gain-ramps, dry/wet and
+// mix-down, peak metering, peak file accumulation, fixed-point
+// decoding conversion and de/interleaving go through these function
+// pointers, which are set once at startup to the widest instruction
+// set available on the running CPU (scalar, SSE, AVX, AVX2+FMA or
+// AVX-512). Monitor panning is just a per-channel gain here; there
+// are no RMS kernels, as peak files keep a plain sum of squares.
+// Gain-ramps are linear, from first gain (inclusive) to last gain
+// (exclusive); clip fades are mixed with per-frame gain envelopes
+// instead, as computed from their own lookup tables. None of these
+// assume any particular buffer alignment.
+//
+
+class qtractorAudioKernel
+{
+public:
+
+	// Instruction set levels.
+	enum Level { Scalar = 0, SSE = 1, AVX = 2, AVX2 = 3, AVX512 = 4 };
+
+	// Current (dispatched) level.
+	static Level level();
+
+	// Dispatched level override (capped to detected; non RT-safe).
+	static void setLevel(Level level);
+
+	// Highest level supported by the running CPU.
+	static Level detectLevel();
+
+	// Level display name.
+	static const char *levelName(Level level);
+
+	// In-place gain: pFrames *= fGain.
+	static void (*gain)(float *pFrames,
+		unsigned int iFrames, float fGain);
+
+	// In-place gain-ramp (also linear fade-in/out).
+	static void (*gain_ramp)(float *pFrames,
+		unsigned int iFrames, float fGain0, float fGain1);
+
+	// In-place gain (and ramp) with (positive) peak metering;
+	// returns the maximum of fPeak and all processed frames.
+	static float (*gain_peak)(float *pFrames,
+		unsigned int iFrames, float fGain, float fPeak);
+	static float (*gain_ramp_peak)(float *pFrames,
+		unsigned int iFrames, float fGain0, float fGain1, float fPeak);
+
+	// (Positive) peak meter; returns max of fPeak and all frames.
+	static float (*peak)(const float *pFrames,
+		unsigned int iFrames, float fPeak);
+
+	// Peak file accumulator: running maximum, minimum
+	// and sum of squares, updated with all frames.
+	static void (*accum)(const float *pFrames, unsigned int iFrames,
+		float *pfMax, float *pfMin, float *pfSum);
+
+	// Mix-down: pBuffer += pFrames.
+	static void (*add)(float *pBuffer,
+		const float *pFrames, unsigned int iFrames);
+
+	// Mix-down with gain: pBuffer += fGain * pFrames.
+	static void (*add_gain)(float *pBuffer,
+		const float *pFrames, unsigned int iFrames, float fGain);
+
+	// Mix-down with gain-ramp (linear fades).
+	static void (*add_ramp)(float *pBuffer, const float *pFrames,
+		unsigned int iFrames, float fGain0, float fGain1);
+
+	// Mix-down with per-frame gain envelope (clip fades):
+	// pBuffer += pGains * pFrames.
+	static void (*add_env)(float *pBuffer, const float *pFrames,
+		const float *pGains, unsigned int iFrames);
+
+	// Dry/wet mix, in place: pDry = fDry * pDry + fWet * pWet.
+	static void (*dry_wet)(float *pDry, const float *pWet,
+		unsigned int iFrames, float fDry, float fWet);
+
+	// Fixed-point to float: pFrames = fScale * pSamples.
+	static void (*convert)(float *pFrames, const int *pSamples,
+		unsigned int iFrames, float fScale);
+
+	// Interleave: pBuffer[n * iChannels + i] = ppFrames[i][n].
+	static void (*interleave)(float *pBuffer, float **ppFrames,
+		unsigned short iChannels, unsigned int iFrames);
+
+	// De-interleave: ppFrames[i][n] = pBuffer[n * iChannels + i].
+	static void (*deinterleave)(float **ppFrames, const float *pBuffer,
+		unsigned short iChannels, unsigned int iFrames);
+};
+
+
+#endif  // __qtractorAudioKernel_h
+
+
+// end of qtractorAudioKernel.h
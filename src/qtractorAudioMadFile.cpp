@@ -21,6 +21,7 @@
 
 #include "qtractorAbout.h"
 #include "qtractorAudioMadFile.h"
+#include "qtractorAudioKernel.h"
 
 #include <sys/stat.h>
 
@@ -283,25 +284,37 @@ bool qtractorAudioMadFile::decode (void)
 		m_iRingBufferWrite = 0;
 	}
 
-	const float fScale = 1.0f / (float) (1L << MAD_F_FRACBITS);
-	for (unsigned int n = 0; n < iFrames; ++n) {
-		if (m_curr.iOutputOffset >= m_iSeekOffset) {
-			for (unsigned short i = 0; i < m_iChannels; ++i) {
-				const int iSample = bError ? 0 : *(m_madSynth.pcm.samples[i] + n);
-				m_ppRingBuffer[i][m_iRingBufferWrite] = fScale * (float) iSample;
-			}
-			++m_iRingBufferWrite &= m_iRingBufferMask;
-		}
+	// Skip whatever falls short of the seek offset...
+	unsigned int n = 0;
+	if (m_curr.iOutputOffset < m_iSeekOffset) {
 	#ifdef DEBUG_0
-		else if (n == 0) {
-			qDebug("qtractorAudioMadFile::decode(%lu) i=%lu o=%lu c=%u",
-				m_iSeekOffset,
-				m_curr.iInputOffset,
-				m_curr.iOutputOffset,
-				m_curr.iDecodeCount);
-		}
+		qDebug("qtractorAudioMadFile::decode(%lu) i=%lu o=%lu c=%u",
+			m_iSeekOffset,
+			m_curr.iInputOffset,
+			m_curr.iOutputOffset,
+			m_curr.iDecodeCount);
 	#endif
-		++m_curr.iOutputOffset;
+		n = iFrames;
+		if (n > m_iSeekOffset - m_curr.iOutputOffset)
+			n = m_iSeekOffset - m_curr.iOutputOffset;
+		m_curr.iOutputOffset += n;
+	}
+
+	// Fixed-point to float, in (wrapped) ring-buffer chunks...
+	const float fScale = 1.0f / (float) (1L << MAD_F_FRACBITS);
+	while (n < iFrames) {
+		unsigned int nframes = iFrames - n;
+		if (nframes > m_iRingBufferSize - m_iRingBufferWrite)
+			nframes = m_iRingBufferSize - m_iRingBufferWrite;
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			qtractorAudioKernel::convert(
+				m_ppRingBuffer[i] + m_iRingBufferWrite,
+				m_madSynth.pcm.samples[i] + n, nframes, fScale);
+		}
+		m_iRingBufferWrite += nframes;
+		m_iRingBufferWrite &= m_iRingBufferMask;
+		m_curr.iOutputOffset += nframes;
+		n += nframes;
 	}
 
 	return true;
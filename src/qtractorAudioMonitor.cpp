@@ -1,7 +1,7 @@
 // qtractorAudioMonitor.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -20,142 +20,11 @@
 *****************************************************************************/
 
 #include "qtractorAudioMonitor.h"
+#include "qtractorAudioKernel.h"
 
 #include <math.h>
 
 
-#if defined(__SSE__)
-
-#include <xmmintrin.h>
-
-// SSE detection.
-static inline bool sse_enabled (void)
-{
-#if defined(__GNUC__)
-	unsigned int eax, ebx, ecx, edx;
-#if defined(__x86_64__) || (!defined(PIC) && !defined(__PIC__))
-	__asm__ __volatile__ (
-		"cpuid\n\t" \
-		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#else
-	__asm__ __volatile__ (
-		"push %%ebx\n\t" \
-		"cpuid\n\t" \
-		"movl %%ebx,%1\n\t" \
-		"pop %%ebx\n\t" \
-		: "=a" (eax), "=r" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#endif
-	return (edx & (1 << 25));
-#else
-	return false;
-#endif
-}
-
-
-// SSE enabled processor versions.
-static inline void sse_process (
-	float *pFrames, unsigned int iFrames, float fGain, float *pfValue )
-{
-	__m128 v0 = _mm_load_ps1(&fGain);
-	__m128 v1 = _mm_load_ps1(pfValue);
-	__m128 v2;
-
-	for (; (long(pFrames) & 15) && (iFrames > 0); --iFrames)
-		*pFrames++ *= fGain;
-	
-	for (; iFrames >= 4; iFrames -= 4) {
-		v2 = _mm_mul_ps(_mm_loadu_ps(pFrames), v0);
-		v1 = _mm_max_ps(v2, v1);
-		_mm_store_ps(pFrames, v2);
-		pFrames += 4;
-	}
-	
-	for (; iFrames > 0; --iFrames)
-		*pFrames++ *= fGain;
-
-	*pfValue = *(float *) &v1; // CHEAT: take 1st of 4 possible values.
-}
-
-static inline void sse_process_ramp ( float *pFrames, unsigned int iFrames,
-	float fGainIter, float fGainLast, float *pfValue )
-{
-	__m128 v1 = _mm_load_ps1(pfValue);
-	__m128 v2;
-
-	const float fGainStep = 4.0f * (fGainLast - fGainIter) / float(iFrames);
-
-	for (; (long(pFrames) & 15) && (iFrames > 0); --iFrames)
-		*pFrames++ *= fGainIter;
-
-	for (; iFrames >= 4; iFrames -= 4) {
-		v2 = _mm_mul_ps(_mm_loadu_ps(pFrames), _mm_load_ps1(&fGainIter));
-		v1 = _mm_max_ps(v2, v1);
-		_mm_store_ps(pFrames, v2);
-		fGainIter += fGainStep;
-		pFrames += 4;
-	}
-
-	for (; iFrames > 0; --iFrames)
-		*pFrames++ *= fGainIter;
-
-	*pfValue = *(float *) &v1; // CHEAT: take 1st of 4 possible values.
-}
-
-static inline void sse_process_meter (
-	float *pFrames, unsigned int iFrames, float *pfValue )
-{
-	__m128 v1 = _mm_load_ps1(pfValue);
-
-	for (; (long(pFrames) & 15) && (iFrames > 0); --iFrames)
-		++pFrames;
-	
-	for (; iFrames >= 4; iFrames -= 4) {
-		v1 = _mm_max_ps(_mm_loadu_ps(pFrames), v1);
-		pFrames += 4;
-	}
-	
-	*pfValue = *(float *) &v1; // CHEAT: take 1st of 4 possible values.
-}
-
-#endif
-
-
-// Standard processor versions.
-static inline void std_process (
-	float *pFrames, unsigned int iFrames, float fGain, float *pfValue )
-{
-	for (unsigned int n = 0; n < iFrames; ++n) {
-		pFrames[n] *= fGain;
-		if (*pfValue < pFrames[n])
-			*pfValue = pFrames[n];
-	}
-}
-
-static inline void std_process_ramp ( float *pFrames, unsigned int iFrames,
-	float fGainIter, float fGainLast, float *pfValue )
-{
-	const float fGainStep = (fGainLast - fGainIter) / float(iFrames);
-
-	for (unsigned int n = 0; n < iFrames; ++n) {
-		pFrames[n] *= fGainIter;
-		if (*pfValue < pFrames[n])
-			*pfValue = pFrames[n];
-		fGainIter += fGainStep;
-	}
-}
-
-static inline void std_process_meter (
-	float *pFrames, unsigned int iFrames, float *pfValue )
-{
-	for (unsigned int n = 0; n < iFrames; ++n) {
-		if (*pfValue < pFrames[n])
-			*pfValue = pFrames[n];
-	}
-}
-
-
 //----------------------------------------------------------------------------
 // qtractorAudioMonitor -- Audio monitor bridge value processor.
 
@@ -163,25 +32,11 @@ static inline void std_process_meter (
 qtractorAudioMonitor::qtractorAudioMonitor ( unsigned short iChannels,
 	float fGain, float fPanning ) : qtractorMonitor(fGain, fPanning),
 	m_iChannels(0), m_pfValues(NULL), m_pfGains(NULL), m_pfPrevGains(NULL),
-	m_iProcessRamp(0)
+	m_iProcessRamp(0), m_pfRampGains(NULL), m_iRampFrame(0), m_iRampFrames(0)
 {
 	qtractorMonitor::gainSubject()->setMaxValue(2.0f);	// +6dB
 	qtractorMonitor::gainObserver()->setLogarithmic(true);
 
-#if defined(__SSE__)
-	if (sse_enabled()) {
-		m_pfnProcess = sse_process;
-		m_pfnProcessRamp = sse_process_ramp;
-		m_pfnProcessMeter = sse_process_meter;
-	} else {
-#endif
-	m_pfnProcess = std_process;
-	m_pfnProcessRamp = std_process_ramp;
-	m_pfnProcessMeter = std_process_meter;
-#if defined(__SSE__)
-	}
-#endif
-
 	setChannels(iChannels);
 }
 
@@ -217,14 +72,25 @@ void qtractorAudioMonitor::setChannels ( unsigned short iChannels )
 		m_pfPrevGains = NULL;
 	}
 
+	if (m_pfRampGains) {
+		delete [] m_pfRampGains;
+		m_pfRampGains = NULL;
+	}
+
+	m_iRampFrame = 0;
+	m_iRampFrames = 0;
+
 	// Set new value holders...
 	m_iChannels = iChannels;
 	if (m_iChannels > 0) {
         m_pfValues = new float [m_iChannels];
         m_pfGains = new float [m_iChannels];
         m_pfPrevGains = new float [m_iChannels];
-        for (unsigned short i = 0; i < m_iChannels; ++i)
-            m_pfValues[i] = m_pfGains[i] = m_pfPrevGains[i] = 0.0f;
+        m_pfRampGains = new float [m_iChannels];
+        for (unsigned short i = 0; i < m_iChannels; ++i) {
+            m_pfValues[i] = m_pfGains[i] = 0.0f;
+            m_pfPrevGains[i] = m_pfRampGains[i] = 0.0f;
+        }
         // Initial population...
         update();
     }
@@ -251,76 +117,88 @@ void qtractorAudioMonitor::reset (void)
 	for (unsigned short i = 0; i < m_iChannels; ++i)
 		m_pfPrevGains[i] = m_pfValues[i] = 0.0f;
 
+	m_iRampFrames = 0;
+
 	++m_iProcessRamp;
 }
 
 
 // Batch processors.
-void qtractorAudioMonitor::process (
-	float **ppFrames, unsigned int iFrames, unsigned short iChannels )
+void qtractorAudioMonitor::process ( float **ppFrames,
+	unsigned int iFrames, unsigned short iChannels, unsigned int iRampFrames )
 {
 	if (iChannels < 1)
 		iChannels = m_iChannels;
 
 	if (m_iProcessRamp > 0) {
 		m_iProcessRamp = 0;
-		// Do ramp-processing...
-		if (iChannels == m_iChannels) {
-			for (unsigned short i = 0; i < m_iChannels; ++i) {
-				(*m_pfnProcessRamp)(ppFrames[i], iFrames,
-					m_pfPrevGains[i], m_pfGains[i], &m_pfValues[i]);
-			//	m_pfPrevGains[i] = m_pfGains[i];
-			}
-		}
-		else if (iChannels > m_iChannels) {
-			unsigned short i = 0;
-			for (unsigned short j = 0; j < iChannels; ++j) {
-				(*m_pfnProcessRamp)(ppFrames[j], iFrames,
-					m_pfPrevGains[i], m_pfGains[i], &m_pfValues[i]);
-			//	m_pfPrevGains[i] = m_pfGains[i];
-				if (++i >= m_iChannels)
-					i = 0;
+		// (Re)start ramping from the current gains,
+		// which might be still half-way a previous ramp...
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			float fGain = m_pfPrevGains[i];
+			if (m_iRampFrame < m_iRampFrames) {
+				fGain = m_pfRampGains[i] + (fGain - m_pfRampGains[i])
+					* float(m_iRampFrame) / float(m_iRampFrames);
 			}
+			m_pfRampGains[i] = fGain;
 		}
-		else { // (iChannels < m_iChannels)
-			unsigned short j = 0;
-			for (unsigned short i = 0; i < m_iChannels; ++i) {
-				(*m_pfnProcessRamp)(ppFrames[j], iFrames,
-					m_pfPrevGains[i], m_pfGains[i], &m_pfValues[i]);
-			//	m_pfPrevGains[i] = m_pfGains[i];
-				if (++j >= iChannels)
-					j = 0;
-			}
+		m_iRampFrame = 0;
+		m_iRampFrames = (iRampFrames > iFrames ? iRampFrames : iFrames);
+	}
+
+	if (iChannels == m_iChannels) {
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			m_pfValues[i] = process_gain(ppFrames[i], iFrames, i, m_pfValues[i]);
 		}
-		// Done ramp-processing.
-	} else {
-		// Do normal-processing...
-		if (iChannels == m_iChannels) {
-			for (unsigned short i = 0; i < m_iChannels; ++i) {
-				(*m_pfnProcess)(ppFrames[i], iFrames,
-					m_pfGains[i], &m_pfValues[i]);
-			}
+	}
+	else if (iChannels > m_iChannels) {
+		unsigned short i = 0;
+		for (unsigned short j = 0; j < iChannels; ++j) {
+			m_pfValues[i] = process_gain(ppFrames[j], iFrames, i, m_pfValues[i]);
+			if (++i >= m_iChannels)
+				i = 0;
 		}
-		else if (iChannels > m_iChannels) {
-			unsigned short i = 0;
-			for (unsigned short j = 0; j < iChannels; ++j) {
-				(*m_pfnProcess)(ppFrames[j], iFrames,
-					m_pfGains[i], &m_pfValues[i]);
-				if (++i >= m_iChannels)
-					i = 0;
-			}
+	}
+	else { // (iChannels < m_iChannels)
+		unsigned short j = 0;
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			m_pfValues[i] = process_gain(ppFrames[j], iFrames, i, m_pfValues[i]);
+			if (++j >= iChannels)
+				j = 0;
 		}
-		else { // (iChannels < m_iChannels)
-			unsigned short j = 0;
-			for (unsigned short i = 0; i < m_iChannels; ++i) {
-				(*m_pfnProcess)(ppFrames[j], iFrames,
-					m_pfGains[i], &m_pfValues[i]);
-				if (++j >= iChannels)
-					j = 0;
-			}
+	}
+
+	// Advance current ramp, if any...
+	if (m_iRampFrame < m_iRampFrames) {
+		m_iRampFrame += iFrames;
+		if (m_iRampFrame >= m_iRampFrames)
+			m_iRampFrames = m_iRampFrame = 0;
+	}
+}
+
+
+// Channel gain (ramp) processor.
+float qtractorAudioMonitor::process_gain ( float *pFrames,
+	unsigned int iFrames, unsigned short i, float fValue ) const
+{
+	const float fGain = m_pfGains[i];
+
+	if (m_iRampFrame < m_iRampFrames) {
+		const float fRampGain = m_pfRampGains[i];
+		const float fRampStep = (fGain - fRampGain) / float(m_iRampFrames);
+		const float fGain0 = fRampGain + fRampStep * float(m_iRampFrame);
+		const unsigned int iRampFrames = m_iRampFrames - m_iRampFrame;
+		if (iRampFrames >= iFrames) {
+			return qtractorAudioKernel::gain_ramp_peak(pFrames, iFrames,
+				fGain0, fGain0 + fRampStep * float(iFrames), fValue);
 		}
-		// Done normal-processing.
+		fValue = qtractorAudioKernel::gain_ramp_peak(pFrames, iRampFrames,
+			fGain0, fGain, fValue);
+		pFrames += iRampFrames;
+		iFrames -= iRampFrames;
 	}
+
+	return qtractorAudioKernel::gain_peak(pFrames, iFrames, fGain, fValue);
 }
 
 
@@ -331,13 +209,16 @@ void qtractorAudioMonitor::process_meter (
 		iChannels = m_iChannels;
 
 	if (iChannels == m_iChannels) {
-		for (unsigned short i = 0; i < m_iChannels; ++i)
-			(*m_pfnProcessMeter)(ppFrames[i], iFrames, &m_pfValues[i]);
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			m_pfValues[i] = qtractorAudioKernel::peak(
+				ppFrames[i], iFrames, m_pfValues[i]);
+		}
 	}
 	else if (iChannels > m_iChannels) {
 		unsigned short j = 0;
 		for (unsigned short i = 0; i < iChannels; ++i) {
-			(*m_pfnProcessMeter)(ppFrames[i], iFrames, &m_pfValues[j]);
+			m_pfValues[j] = qtractorAudioKernel::peak(
+				ppFrames[i], iFrames, m_pfValues[j]);
 			if (++j >= m_iChannels)
 				j = 0;
 		}
@@ -345,7 +226,8 @@ void qtractorAudioMonitor::process_meter (
 	else { // (iChannels < m_iChannels)
 		unsigned short i = 0;
 		for (unsigned short j = 0; j < m_iChannels; ++j) {
-			(*m_pfnProcessMeter)(ppFrames[i], iFrames, &m_pfValues[j]);
+			m_pfValues[j] = qtractorAudioKernel::peak(
+				ppFrames[i], iFrames, m_pfValues[j]);
 			if (++i >= iChannels)
 				i = 0;
 		}
@@ -1,7 +1,7 @@
 // qtractorAudioMonitor.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -46,9 +46,11 @@ public:
 	// Value holder accessor.
 	float value(unsigned short iChannel) const;
 
-	// Batch processors.
-	void process(float **ppFrames,
-		unsigned int iFrames, unsigned short iChannels = 0);
+	// Batch processors; gain changes are ramped
+	// over the given length, when longer (eg. whole period
+	// remainder, while processing in sub-blocks).
+	void process(float **ppFrames, unsigned int iFrames,
+		unsigned short iChannels = 0, unsigned int iRampFrames = 0);
 	void process_meter(float **ppFrames,
 		unsigned int iFrames, unsigned short iChannels = 0);
 
@@ -60,6 +62,10 @@ protected:
 	// Rebuild the whole panning-gain array...
 	void update();
 
+	// Channel gain (ramp) processor.
+	float process_gain(float *pFrames,
+		unsigned int iFrames, unsigned short i, float fValue) const;
+
 private:
 
 	// Instance variables.
@@ -69,10 +75,10 @@ private:
 	float         *m_pfPrevGains;
 	volatile int   m_iProcessRamp;
 
-	// Monitoring evaluator processor.
-	void (*m_pfnProcess)(float *, unsigned int, float, float *);
-	void (*m_pfnProcessRamp)(float *, unsigned int, float, float, float *);
-	void (*m_pfnProcessMeter)(float *, unsigned int, float *);
+	// Current gain ramp state.
+	float         *m_pfRampGains;
+	unsigned int   m_iRampFrame;
+	unsigned int   m_iRampFrames;
 };
 
 
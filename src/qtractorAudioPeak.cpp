@@ -23,6 +23,7 @@
 #include "qtractorAudioPeak.h"
 #include "qtractorAudioFile.h"
 #include "qtractorAudioEngine.h"
+#include "qtractorAudioKernel.h"
 
 #include "qtractorSession.h"
 
@@ -48,12 +49,18 @@ static const unsigned int c_iPeakFrames = (8 * 1024);
 // Default peak period as a digest representation in frames per channel.
 static const unsigned short c_iPeakPeriod = 1024;
 
+// Maximum number of peak file creation worker threads.
+static const int c_iPeakThreads = 8;
+
 // Default peak filename extension.
 static const QString c_sPeakFileExt = ".peak";
 
+// Peak file format signature (multi-level).
+static const char c_szPeakMagic[4] = { 'Q', 'T', 'P', 'K' };
+
 
 //----------------------------------------------------------------------
-// class qtractorAudioPeakThread -- Audio Peak file thread.
+// class qtractorAudioPeakThread -- Audio Peak file (pool) worker thread.
 //
 
 class qtractorAudioPeakThread : public QThread
@@ -61,17 +68,12 @@ class qtractorAudioPeakThread : public QThread
 public:
 
 	// Constructor.
-	qtractorAudioPeakThread(unsigned int iSyncSize = 128);
-	// Destructor.
-	~qtractorAudioPeakThread();
+	qtractorAudioPeakThread(qtractorAudioPeakFactory *pPeakFactory);
 
 	// Thread run state accessors.
 	void setRunState(bool bRunState);
 	bool runState() const;
 
-	// Wake from executive wait condition.
-	void sync(qtractorAudioPeakFile *pPeakFile = NULL);
-
 protected:
 
 	// The main thread executive.
@@ -83,25 +85,14 @@ protected:
 	bool writePeakFile();
 	void closePeakFile();
 
-	void notifyPeakEvent() const;
-
 private:
 
-	// The peak file queue instance reference.
-	unsigned int            m_iSyncSize;
-	unsigned int            m_iSyncMask;
-	qtractorAudioPeakFile **m_ppSyncItems;
-
-	volatile unsigned int   m_iSyncRead;
-	volatile unsigned int   m_iSyncWrite;
+	// The peak file factory (and queue) instance reference.
+	qtractorAudioPeakFactory *m_pPeakFactory;
 
 	// Whether the thread is logically running.
 	volatile bool m_bRunState;
 
-	// Thread synchronization objects.
-	QMutex m_mutex;
-	QWaitCondition m_cond;
-
 	// Current audio peak file instance.
 	qtractorAudioPeakFile *m_pPeakFile;
 
@@ -110,42 +101,38 @@ private:
 
 	// Current audio file buffer.
 	float **m_ppAudioFrames;
+
+	// Current progress (frames read and last percentage).
+	unsigned long m_iAudioRead;
+	int m_iProgress;
+
+	// Whether the whole source has been read.
+	bool m_bComplete;
 };
 
 
 // Constructor.
-qtractorAudioPeakThread::qtractorAudioPeakThread ( unsigned int iSyncSize )
+qtractorAudioPeakThread::qtractorAudioPeakThread (
+	qtractorAudioPeakFactory *pPeakFactory )
 {
-	m_iSyncSize = (64 << 1);
-	while (m_iSyncSize < iSyncSize)
-		m_iSyncSize <<= 1;
-	m_iSyncMask = (m_iSyncSize - 1);
-	m_ppSyncItems = new qtractorAudioPeakFile * [m_iSyncSize];
-	m_iSyncRead   = 0;
-	m_iSyncWrite  = 0;
-
-	::memset(m_ppSyncItems, 0, m_iSyncSize * sizeof(qtractorAudioPeakFile *));
+	m_pPeakFactory = pPeakFactory;
 
 	m_bRunState = false;
 
 	m_pPeakFile  = NULL;
 	m_pAudioFile = NULL;
 	m_ppAudioFrames = NULL;
-}
 
+	m_iAudioRead = 0;
+	m_iProgress  = 0;
 
-// Destructor.
-qtractorAudioPeakThread::~qtractorAudioPeakThread (void)
-{
-	delete [] m_ppSyncItems;
+	m_bComplete  = false;
 }
 
 
 // Run state accessor.
 void qtractorAudioPeakThread::setRunState ( bool bRunState )
 {
-//	QMutexLocker locker(&m_mutex);
-
 	m_bRunState = bRunState;
 }
 
@@ -155,49 +142,6 @@ bool qtractorAudioPeakThread::runState (void) const
 }
 
 
-// Wake from executive wait condition.
-void qtractorAudioPeakThread::sync ( qtractorAudioPeakFile *pPeakFile )
-{
-	if (pPeakFile == NULL) {
-		unsigned int r = m_iSyncRead;
-		unsigned int w = m_iSyncWrite;
-		while (r != w) {
-			qtractorAudioPeakFile *pSyncItem = m_ppSyncItems[r];
-			if (pSyncItem)
-				pSyncItem->setWaitSync(false);
-			++r &= m_iSyncMask;
-			w = m_iSyncWrite;
-		}
-	//	m_iSyncRead = r;
-	} else {
-		// !pPeakFile->isWaitSync()
-		unsigned int n;
-		unsigned int r = m_iSyncRead;
-		unsigned int w = m_iSyncWrite;
-		if (w > r) {
-			n = ((r - w + m_iSyncSize) & m_iSyncMask) - 1;
-		} else if (r > w) {
-			n = (r - w) - 1;
-		} else {
-			n = m_iSyncSize - 1;
-		}
-		if (n > 0) {
-			pPeakFile->setWaitSync(true);
-			m_ppSyncItems[w] = pPeakFile;
-			m_iSyncWrite = (w + 1) & m_iSyncMask;
-		}
-	}
-
-	if (m_mutex.tryLock()) {
-		m_cond.wakeAll();
-		m_mutex.unlock();
-	}
-#ifdef CONFIG_DEBUG_0
-	else qDebug("qtractorAudioPeakThread[%p]::sync(): tryLock() failed.", this);
-#endif
-}
-
-
 // The main thread executive cycle.
 void qtractorAudioPeakThread::run (void)
 {
@@ -205,42 +149,24 @@ void qtractorAudioPeakThread::run (void)
 	qDebug("qtractorAudioPeakThread[%p]::run(): started...", this);
 #endif
 
-	m_mutex.lock();
-
-	m_bRunState = true;
-
 	while (m_bRunState) {
-		// Do whatever we must, then wait for more...
-		unsigned int r = m_iSyncRead;
-		unsigned int w = m_iSyncWrite;
-		while (m_bRunState && r != w) {
-			m_pPeakFile = m_ppSyncItems[r];
-			if (m_pPeakFile && m_pPeakFile->isWaitSync()) {
-				if (openPeakFile()) {
-					// Go ahead with the whole bunch...
-					while (writePeakFile());
-					// We're done.
-					closePeakFile();
-				}
-				m_pPeakFile->setWaitSync(false);
-				m_pPeakFile = NULL;
-			}
-			m_ppSyncItems[r] = NULL;
-			++r &= m_iSyncMask;
-			w = m_iSyncWrite;
-		}
-		m_iSyncRead = r;
-		// Are we still in the game?
-		if (m_bRunState) {
-			// Send notification event, anyway...
-			notifyPeakEvent();
-			// Wait for sync...
-			m_cond.wait(&m_mutex);
+		// Wait for the next one in queue...
+		m_pPeakFile = m_pPeakFactory->syncNext(this);
+		if (m_pPeakFile == NULL)
+			continue;
+		if (openPeakFile()) {
+			// Go ahead with the whole bunch...
+			while (writePeakFile());
+			// We're done.
+			closePeakFile();
 		}
+		m_pPeakFactory->syncDone(m_pPeakFile);
+		m_pPeakFile = NULL;
+		// Send notification event, anyway...
+		if (m_bRunState)
+			m_pPeakFactory->notifyPeakEvent();
 	}
 
-	m_mutex.unlock();
-
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorAudioPeakThread[%p]::run(): stopped.\n", this);
 #endif
@@ -250,6 +176,10 @@ void qtractorAudioPeakThread::run (void)
 // Open the peak file for create.
 bool qtractorAudioPeakThread::openPeakFile (void)
 {
+	// Cancelled already?
+	if (!m_pPeakFile->isWaitSync())
+		return false;
+
 	m_pAudioFile
 		= qtractorAudioFileFactory::createAudioFile(m_pPeakFile->filename());
 	if (m_pAudioFile == NULL)
@@ -283,6 +213,14 @@ bool qtractorAudioPeakThread::openPeakFile (void)
 	// Make sure audio file decoder makes no head-start...
 	m_pAudioFile->seek(0);
 
+	m_iAudioRead = 0;
+	m_iProgress  = 0;
+
+	m_bComplete  = false;
+
+	if (m_bRunState)
+		m_pPeakFactory->notifyPeakProgress(m_pPeakFile, 0);
+
 	return true;
 }
 
@@ -293,6 +231,10 @@ bool qtractorAudioPeakThread::writePeakFile (void)
 	if (!m_bRunState)
 		return false;
 
+	// Cancelled meanwhile?
+	if (!m_pPeakFile->isWaitSync())
+		return false;
+
 	if (m_ppAudioFrames == NULL)
 		return false;
 
@@ -304,6 +246,20 @@ bool qtractorAudioPeakThread::writePeakFile (void)
 	int nread = m_pAudioFile->read(m_ppAudioFrames, c_iAudioFrames);
 	if (nread > 0)
 		nread = m_pPeakFile->write(m_ppAudioFrames, nread);
+	else
+	if (nread == 0)
+		m_bComplete = true;
+
+	// Report progress, in 10% steps...
+	const unsigned long iAudioFrames = m_pAudioFile->frames();
+	if (nread > 0 && iAudioFrames > 0) {
+		m_iAudioRead += nread;
+		const int iProgress = int((100 * m_iAudioRead) / iAudioFrames);
+		if (iProgress >= m_iProgress + 10 && iProgress < 100 && m_bRunState) {
+			m_iProgress = iProgress - (iProgress % 10);
+			m_pPeakFactory->notifyPeakProgress(m_pPeakFile, m_iProgress);
+		}
+	}
 
 	return (nread > 0);
 }
@@ -316,8 +272,9 @@ void qtractorAudioPeakThread::closePeakFile (void)
 	qDebug("qtractorAudioPeakThread::closePeakFile(%p)", m_pPeakFile);
 #endif
 
-	// Always force target file close.
-	m_pPeakFile->closeWrite();
+	// Always force target file close;
+	// an incomplete one is just discarded.
+	m_pPeakFile->closeWrite(m_bComplete && m_bRunState);
 
 	// Get rid of physical used stuff.
 	if (m_ppAudioFrames) {
@@ -334,21 +291,9 @@ void qtractorAudioPeakThread::closePeakFile (void)
 		m_pAudioFile = NULL;
 	}
 
-	// Send notification event, someway...
-	notifyPeakEvent();
-}
-
-
-// Send notification event, someway...
-void qtractorAudioPeakThread::notifyPeakEvent (void) const
-{
-	if (!m_bRunState)
-		return;
-
-	qtractorAudioPeakFactory *pPeakFactory
-		= qtractorAudioPeakFactory::getInstance();
-	if (pPeakFactory)
-		pPeakFactory->notifyPeakEvent();
+	// Done, someway...
+	if (m_bRunState)
+		m_pPeakFactory->notifyPeakProgress(m_pPeakFile, 100);
 }
 
 
@@ -366,13 +311,13 @@ qtractorAudioPeakFile::qtractorAudioPeakFile (
 
 	m_openMode = None;
 
-	m_peakHeader.period   = 0;
-	m_peakHeader.channels = 0;
+	::memset(&m_peakHeader, 0, sizeof(Header));
 
 	m_pBuffer      = NULL;
 	m_iBuffSize    = 0;
 	m_iBuffLength  = 0;
 	m_iBuffOffset  = 0;
+	m_iBuffLevel   = 0;
 
 	m_bWaitSync = false;
 
@@ -416,13 +361,9 @@ bool qtractorAudioPeakFile::openRead (void)
 	if (m_bWaitSync)
 		return false;
 
-	// Need some preliminary file information...
-	QFileInfo fileInfo(m_sFilename);
-	QFileInfo peakInfo(m_peakFile.fileName());
 	// Have we a peak file up-to-date,
 	// or must the peak file be (re)created?
-	if (!peakInfo.exists() || peakInfo.created() < fileInfo.created()) {
-	//	|| peakInfo.lastModified() < fileInfo.lastModified()) {
+	if (isStale()) {
 		qtractorAudioPeakFactory *pPeakFactory
 			= qtractorAudioPeakFactory::getInstance();
 		if (pPeakFactory)
@@ -438,9 +379,19 @@ bool qtractorAudioPeakFile::openRead (void)
 	if (!m_peakFile.open(QIODevice::ReadOnly))
 		return false;
 
+	// Old single-level or incomplete peak files
+	// must be (re)created as well...
 	if (m_peakFile.read((char *) &m_peakHeader, sizeof(Header))
-			!= qint64(sizeof(Header))) {
-		m_peakFile.close();
+			!= qint64(sizeof(Header))
+		|| ::memcmp(m_peakHeader.magic, c_szPeakMagic, sizeof(c_szPeakMagic))
+		|| m_peakHeader.levels < 1 || m_peakHeader.levels > MaxLevels) {
+		m_peakFile.remove();
+		::memset(&m_peakHeader, 0, sizeof(Header));
+		locker.unlock();
+		qtractorAudioPeakFactory *pPeakFactory
+			= qtractorAudioPeakFactory::getInstance();
+		if (pPeakFactory)
+			pPeakFactory->sync(this);
 		return false;
 	}
 
@@ -456,6 +407,8 @@ bool qtractorAudioPeakFile::openRead (void)
 	qDebug("frame       = %lu", sizeof(Frame));
 	qDebug("period      = %d", m_peakHeader.period);
 	qDebug("channels    = %d", m_peakHeader.channels);
+	qDebug("length      = %u", m_peakHeader.length);
+	qDebug("levels      = %d", m_peakHeader.levels);
 	qDebug("---");
 #endif
 
@@ -464,6 +417,18 @@ bool qtractorAudioPeakFile::openRead (void)
 }
 
 
+// Whether the peak file is missing or out-of-date.
+bool qtractorAudioPeakFile::isStale (void) const
+{
+	// Need some preliminary file information...
+	const QFileInfo fileInfo(m_sFilename);
+	const QFileInfo peakInfo(m_peakFile.fileName());
+
+	return (!peakInfo.exists() || peakInfo.created() < fileInfo.created());
+	//	|| peakInfo.lastModified() < fileInfo.lastModified());
+}
+
+
 // Free all attended resources for this peak file.
 void qtractorAudioPeakFile::closeRead (void)
 {
@@ -483,6 +448,7 @@ void qtractorAudioPeakFile::closeRead (void)
 	m_iBuffSize   = 0;
 	m_iBuffLength = 0;
 	m_iBuffOffset = 0;
+	m_iBuffLevel  = 0;
 }
 
 
@@ -520,10 +486,31 @@ unsigned short qtractorAudioPeakFile::channels (void)
 	return m_peakHeader.channels;
 }
 
+unsigned short qtractorAudioPeakFile::levels (void)
+{
+	// Only the base level while still being written...
+	return (m_peakHeader.levels > 0 ? m_peakHeader.levels : 1);
+}
+
+
+// Level position and length (in peak frames);
+// zero length if unknown (still being written).
+void qtractorAudioPeakFile::levelRange ( unsigned short iLevel,
+	unsigned long& iOffset, unsigned long& iLength ) const
+{
+	iOffset = 0;
+	iLength = m_peakHeader.length;
+
+	for (unsigned short i = 0; i < iLevel; ++i) {
+		iOffset += iLength;
+		iLength = (iLength + 1) >> 1;
+	}
+}
+
 
 // Read frames from peak file.
 qtractorAudioPeakFile::Frame *qtractorAudioPeakFile::read (
-	unsigned long iPeakOffset, unsigned int iPeakLength )
+	unsigned long iPeakOffset, unsigned int iPeakLength, unsigned short iLevel )
 {
 	// Must be open for something...
 	if (m_openMode == None)
@@ -533,13 +520,18 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeakFile::read (
 	QMutexLocker locker(&m_mutex);
 
 #ifdef CONFIG_DEBUG_0
-	qDebug("qtractorAudioPeakFile[%p]::read(%lu, %u) [%lu, %u, %u]", this,
-		iPeakOffset, iPeakLength, m_iBuffOffset, m_iBuffLength, m_iBuffSize);
+	qDebug("qtractorAudioPeakFile[%p]::read(%lu, %u, %u) [%lu, %u, %u]", this,
+		iPeakOffset, iPeakLength, iLevel, m_iBuffOffset, m_iBuffLength, m_iBuffSize);
 #endif
 
+	// Only the base level while still being written...
+	if (iLevel >= levels())
+		iLevel = 0;
+
 	// Cache effect, only valid if we're really reading...
 	const unsigned long iPeakEnd = iPeakOffset + iPeakLength;
-	if (iPeakOffset >= m_iBuffOffset && m_iBuffOffset < iPeakEnd) {
+	if (iLevel == m_iBuffLevel
+		&& iPeakOffset >= m_iBuffOffset && m_iBuffOffset < iPeakEnd) {
 		const unsigned long iBuffEnd = m_iBuffOffset + m_iBuffLength;
 		const unsigned long iBuffOffset
 			= m_peakHeader.channels * (iPeakOffset - m_iBuffOffset);
@@ -553,6 +545,7 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeakFile::read (
 	}
 
 	// Read peak data as requested...
+	m_iBuffLevel  = iLevel;
 	m_iBuffLength = readBuffer(0, iPeakOffset, iPeakLength);
 	m_iBuffOffset = iPeakOffset;
 
@@ -583,14 +576,27 @@ unsigned int qtractorAudioPeakFile::readBuffer (
 		m_iBuffOffset, m_iBuffLength, m_iBuffSize);
 #endif
 
+	// Current level bounds, if known...
+	unsigned long iLevelOffset, iLevelLength;
+	levelRange(m_iBuffLevel, iLevelOffset, iLevelLength);
+
+	unsigned int iReadLength = iPeakLength;
+	if (iLevelLength > 0) {
+		if (iPeakOffset >= iLevelLength)
+			iReadLength = 0;
+		else
+		if (iPeakOffset + iReadLength > iLevelLength)
+			iReadLength = iLevelLength - iPeakOffset;
+	}
+
 	// Grab new contents from peak file...
 	char *pBuffer = (char *) (m_pBuffer + m_peakHeader.channels * iBuffOffset);
-	const unsigned long iOffset	= iPeakOffset * nsize;
+	const unsigned long iOffset	= (iLevelOffset + iPeakOffset) * nsize;
 	const unsigned int iLength	= iPeakLength * nsize;
 
 	int nread = 0;
-	if (m_peakFile.seek(sizeof(Header) + iOffset))
-		nread = int(m_peakFile.read(&pBuffer[0], iLength));
+	if (iReadLength > 0 && m_peakFile.seek(sizeof(Header) + iOffset))
+		nread = int(m_peakFile.read(&pBuffer[0], iReadLength * nsize));
 
 	// Zero the remaining...
 	if (nread < int(iLength))
@@ -630,9 +636,14 @@ bool qtractorAudioPeakFile::openWrite (
 	// Set open mode...
 	m_openMode = Write;
 
-	// Initialize header...
+	// Initialize header (signature and levels are only
+	// committed when closing a complete peak file)...
+	::memset(m_peakHeader.magic, 0, sizeof(m_peakHeader.magic));
 	m_peakHeader.period   = pPeakFactory->peakPeriod();
 	m_peakHeader.channels = iChannels;
+	m_peakHeader.length   = 0;
+	m_peakHeader.levels   = 0;
+	m_peakHeader.reserved = 0;
 
 	// Write peak file header.
 	if (m_peakFile.write((const char *) &m_peakHeader, sizeof(Header))
@@ -696,16 +707,22 @@ bool qtractorAudioPeakFile::openWrite (
 
 
 // Close the (hopefully) created peak file.
-void qtractorAudioPeakFile::closeWrite (void)
+void qtractorAudioPeakFile::closeWrite ( bool bComplete )
 {
 	// Make things critical...
 	QMutexLocker locker(&m_mutex);
 
-	// Flush and close...
+	// Flush, build the reduced levels and close;
+	// otherwise get rid of the incomplete file...
 	if (m_openMode == Write) {
-		if (m_pWriter && m_pWriter->npeak > 0)
-			writeFrame();
-		m_peakFile.close();
+		if (bComplete && m_pWriter) {
+			if (m_pWriter->npeak > 0)
+				writeFrame();
+			writeLevels();
+			m_peakFile.close();
+		} else {
+			m_peakFile.remove();
+		}
 		m_openMode = None;
 	}
 
@@ -730,20 +747,25 @@ int qtractorAudioPeakFile::write (
 	if (m_openMode != Write || m_pWriter == NULL)
 		return 0;
 
-	for (unsigned int n = 0; n < iAudioFrames; ++n) {
-		// Accumulate for this sample frame...
+	unsigned int n = 0;
+	while (n < iAudioFrames) {
+		// Accumulate up to the next peak period stop...
+		unsigned int nframes = 1;
+		if (m_pWriter->nwrite > m_pWriter->nread) {
+			nframes = iAudioFrames - n;
+			if (nframes > m_pWriter->nwrite - m_pWriter->nread)
+				nframes = m_pWriter->nwrite - m_pWriter->nread;
+		}
 		for (unsigned short i = 0; i < m_peakHeader.channels; ++i) {
-			const float fSample = ppAudioFrames[i][n];
-			if (m_pWriter->amax[i] < fSample)
-				m_pWriter->amax[i] = fSample;
-			if (m_pWriter->amin[i] > fSample)
-				m_pWriter->amin[i] = fSample;
-			m_pWriter->arms[i] += (fSample * fSample);
+			qtractorAudioKernel::accum(ppAudioFrames[i] + n, nframes,
+				&m_pWriter->amax[i], &m_pWriter->amin[i], &m_pWriter->arms[i]);
 		}
+		n += nframes;
 		// Count peak frames (incremental)...
-		++m_pWriter->npeak;
+		m_pWriter->npeak += nframes;
+		m_pWriter->nread += nframes;
 		// Have we reached the peak accumulative period?
-		if (++m_pWriter->nread >= m_pWriter->nwrite) {
+		if (m_pWriter->nread >= m_pWriter->nwrite) {
 			// Estimate next stop...
 			m_pWriter->nwrite += m_pWriter->period_q;
 			// Apply rounding fraction, if any...
@@ -793,6 +815,71 @@ void qtractorAudioPeakFile::writeFrame (void)
 }
 
 
+// Build the reduced levels, each one half the previous,
+// then commit the final header (called on complete close).
+void qtractorAudioPeakFile::writeLevels (void)
+{
+	const unsigned short iChannels = m_peakHeader.channels;
+	if (iChannels < 1)
+		return;
+
+	const unsigned int nsize = iChannels * sizeof(Frame);
+
+	m_peakHeader.length = m_pWriter->offset / nsize;
+	m_peakHeader.levels = 1;
+
+	Frame *pBuffer = new Frame [iChannels * c_iPeakFrames];
+
+	unsigned long iOffset = 0;
+	unsigned long iLength = m_peakHeader.length;
+	while (iLength > 1 && m_peakHeader.levels < MaxLevels) {
+		const unsigned long iNextOffset = iOffset + iLength;
+		unsigned long iNextLength = 0;
+		// Reduce (even) chunks of the previous level...
+		for (unsigned long i = 0; i < iLength; i += c_iPeakFrames) {
+			const unsigned int n = (iLength - i < c_iPeakFrames
+				? iLength - i : c_iPeakFrames);
+			if (!m_peakFile.seek(sizeof(Header) + (iOffset + i) * nsize)
+				|| m_peakFile.read((char *) pBuffer, n * nsize)
+					!= qint64(n * nsize))
+				break;
+			unsigned int m = 0;
+			for (unsigned int j = 0; j < n; j += 2, ++m) {
+				for (unsigned short k = 0; k < iChannels; ++k) {
+					const Frame *pFrame1 = &pBuffer[j * iChannels + k];
+					const Frame *pFrame2 = (j + 1 < n ? pFrame1 + iChannels : pFrame1);
+					Frame frame;
+					frame.max = qMax(pFrame1->max, pFrame2->max);
+					frame.min = qMax(pFrame1->min, pFrame2->min);
+					frame.rms = (unsigned char) ::sqrtf(0.5f
+						* (float(pFrame1->rms) * float(pFrame1->rms)
+						+  float(pFrame2->rms) * float(pFrame2->rms)));
+					pBuffer[m * iChannels + k] = frame;
+				}
+			}
+			if (!m_peakFile.seek(sizeof(Header) + (iNextOffset + iNextLength) * nsize)
+				|| m_peakFile.write((const char *) pBuffer, m * nsize)
+					!= qint64(m * nsize))
+				break;
+			iNextLength += m;
+		}
+		// Incomplete level? bail out...
+		if (iNextLength < ((iLength + 1) >> 1))
+			break;
+		++m_peakHeader.levels;
+		iOffset = iNextOffset;
+		iLength = iNextLength;
+	}
+
+	delete [] pBuffer;
+
+	// Commit the final (signed) header...
+	::memcpy(m_peakHeader.magic, c_szPeakMagic, sizeof(c_szPeakMagic));
+	if (m_peakFile.seek(0))
+		m_peakFile.write((const char *) &m_peakHeader, sizeof(Header));
+}
+
+
 // Reference count methods.
 void qtractorAudioPeakFile::addRef (void)
 {
@@ -818,10 +905,17 @@ void qtractorAudioPeakFile::cleanup ( bool bAutoRemove )
 {
 	// Check if it's aborting (ought to be atomic)...
 	const bool bAborted = (m_bWaitSync || bAutoRemove);
-	m_bWaitSync = false;
 
-	// Close the file, anyway now.
-	closeWrite();
+	// Make sure no worker is (re)creating it meanwhile...
+	qtractorAudioPeakFactory *pPeakFactory
+		= qtractorAudioPeakFactory::getInstance();
+	if (pPeakFactory)
+		pPeakFactory->syncCancel(this);
+	else
+		m_bWaitSync = false;
+
+	// Close the file, anyway now (incomplete if still writing).
+	closeWrite(false);
 	closeRead();
 
 	// Physically remove the file if aborted...
@@ -899,8 +993,19 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeak::peakFrames (
 	if (iPeakPeriod < 1)
 		return NULL;
 
+	// Pick the coarsest level that still has
+	// at least as many peak frames as pixels to draw...
+	const unsigned int w2 = (width >> 1) + 1;
+	const unsigned short iLevels = m_pPeakFile->levels();
+	unsigned short iLevel = 0;
+	while (iLevel + 1 < iLevels && (iFrameLength
+		/ ((unsigned long) iPeakPeriod << (iLevel + 1))) >= w2)
+		++iLevel;
+	const unsigned long iLevelPeriod
+		= ((unsigned long) iPeakPeriod << iLevel);
+
 	// Peak frames length estimation...
-	const unsigned int iPeakLength = (iFrameLength / iPeakPeriod);
+	const unsigned int iPeakLength = (iFrameLength / iLevelPeriod);
 	if (iPeakLength < 1)
 		return NULL;
 
@@ -915,6 +1020,7 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeak::peakFrames (
 		if (!m_pPeakFile->isWaitSync()) {
 			const unsigned int iPeakHash
 				= qHash(iPeakPeriod)
+				^ qHash(iLevels)
 				^ qHash(iFrameOffset)
 				^ qHash(iFrameLength)
 				^ qHash(width);
@@ -929,30 +1035,32 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeak::peakFrames (
 	}
 
 	// Grab them in...
-	const unsigned long iPeakOffset = (iFrameOffset / iPeakPeriod);
+	const unsigned long iPeakOffset = (iFrameOffset / iLevelPeriod);
 	qtractorAudioPeakFile::Frame *pPeakFrames
-		= m_pPeakFile->read(iPeakOffset, iPeakLength);
+		= m_pPeakFile->read(iPeakOffset, iPeakLength, iLevel);
 	if (pPeakFrames == NULL)
 		return NULL;
 
-	// Check if we better aggregate over the frame buffer....
+	// Check if we better aggregate over the frame buffer
+	// (less than twice the pixels, from the proper level)...
 	const int p1 = int(iPeakLength);
 	const int n1 = iChannels * p1;
 
 	if (width < p1 && width > 1) {
-		const int w2 = (width >> 1) + 1;
 		const int n2 = iChannels * w2;
 		m_pPeakFrames = new qtractorAudioPeakFile::Frame [n2];
-		int n = 0; int i = 0;
-		while (n < n2) {
-			const int i2 = (n * p1) / w2;
+		int n = 0;
+		for (int i = 0; i < int(w2); ++i) {
+			const int j1 = (i * p1) / int(w2);
+			const int j2 = ((i + 1) * p1) / int(w2);
 			for (unsigned short k = 0; k < iChannels; ++k) {
 				qtractorAudioPeakFile::Frame *pNewFrame = &m_pPeakFrames[n++];
-				qtractorAudioPeakFile::Frame *pOldFrame = &pPeakFrames[i + k];
+				qtractorAudioPeakFile::Frame *pOldFrame
+					= &pPeakFrames[j1 * iChannels + k];
 				pNewFrame->max = pOldFrame->max;
 				pNewFrame->min = pOldFrame->min;
 				pNewFrame->rms = pOldFrame->rms;
-				for (int j = i + 1; j < i2; j += iChannels) {
+				for (int j = j1 + 1; j < j2; ++j) {
 					pOldFrame += iChannels;
 					if (pNewFrame->max < pOldFrame->max)
 						pNewFrame->max = pOldFrame->max;
@@ -962,10 +1070,9 @@ qtractorAudioPeakFile::Frame *qtractorAudioPeak::peakFrames (
 						pNewFrame->rms = pOldFrame->rms;
 				}
 			}
-			i = i2;
 		}
 		// New-indirect frame buffer length...
-		m_iPeakLength = n / iChannels;
+		m_iPeakLength = w2;
 		// Done-indirect.
 	} else {
 		// Direct-copy frame-buffer...
@@ -998,7 +1105,7 @@ qtractorAudioPeakFactory *qtractorAudioPeakFactory::getInstance (void)
 // Constructor.
 qtractorAudioPeakFactory::qtractorAudioPeakFactory ( QObject *pParent )
 	: QObject(pParent), m_bAutoRemove(false),
-		m_pPeakThread(NULL), m_iPeakPeriod(c_iPeakPeriod)
+		m_iPeakPeriod(c_iPeakPeriod)
 {
 	// Pseudo-singleton reference setup.
 	g_pPeakFactory = this;
@@ -1008,16 +1115,24 @@ qtractorAudioPeakFactory::qtractorAudioPeakFactory ( QObject *pParent )
 // Default destructor.
 qtractorAudioPeakFactory::~qtractorAudioPeakFactory (void)
 {
-	if (m_pPeakThread) {
-		if (m_pPeakThread->isRunning()) do {
-			m_pPeakThread->setRunState(false);
-		//	m_pPeakThread->terminate();
-			m_pPeakThread->sync();
-		} while (!m_pPeakThread->wait(100));
-		delete m_pPeakThread;
-		m_pPeakThread = NULL;
+	QListIterator<qtractorAudioPeakThread *> iter(m_peakThreads);
+	while (iter.hasNext())
+		iter.next()->setRunState(false);
+
+	iter.toFront();
+	while (iter.hasNext()) {
+		qtractorAudioPeakThread *pPeakThread = iter.next();
+		while (pPeakThread->isRunning()) {
+			m_syncMutex.lock();
+			m_syncCond.wakeAll();
+			m_syncMutex.unlock();
+			pPeakThread->wait(100);
+		}
 	}
 
+	qDeleteAll(m_peakThreads);
+	m_peakThreads.clear();
+
 	cleanup();
 
 	// Pseudo-singleton reference shut-down.
@@ -1060,9 +1175,20 @@ qtractorAudioPeak* qtractorAudioPeakFactory::createPeak (
 {
 	QMutexLocker locker(&m_mutex);
 
-	if (m_pPeakThread == NULL) {
-		m_pPeakThread = new qtractorAudioPeakThread();
-		m_pPeakThread->start();
+	// Start the worker threads pool, one per core...
+	if (m_peakThreads.isEmpty()) {
+		int iPeakThreads = QThread::idealThreadCount();
+		if (iPeakThreads > c_iPeakThreads)
+			iPeakThreads = c_iPeakThreads;
+		if (iPeakThreads < 1)
+			iPeakThreads = 1;
+		for (int i = 0; i < iPeakThreads; ++i) {
+			qtractorAudioPeakThread *pPeakThread
+				= new qtractorAudioPeakThread(this);
+			pPeakThread->setRunState(true);
+			pPeakThread->start();
+			m_peakThreads.append(pPeakThread);
+		}
 	}
 
 	const QString& sPeakName
@@ -1096,10 +1222,107 @@ void qtractorAudioPeakFactory::notifyPeakEvent (void)
 }
 
 
+// Peak creation progress notifier.
+void qtractorAudioPeakFactory::notifyPeakProgress (
+	qtractorAudioPeakFile *pPeakFile, int iPercent )
+{
+	emit peakProgress(pPeakFile->filename(), iPercent);
+}
+
+
 // Base sync method.
-void qtractorAudioPeakFactory::sync ( qtractorAudioPeakFile *pPeakFile )
+void qtractorAudioPeakFactory::sync (
+	qtractorAudioPeakFile *pPeakFile, bool bPriority )
+{
+	QMutexLocker locker(&m_syncMutex);
+
+	if (pPeakFile == NULL) {
+		// Abort all pending, but not the ones in progress...
+		QListIterator<qtractorAudioPeakFile *> iter(m_syncQueue);
+		while (iter.hasNext()) {
+			qtractorAudioPeakFile *pSyncItem = iter.next();
+			if (!m_syncBusy.contains(pSyncItem))
+				pSyncItem->setWaitSync(false);
+		}
+		m_syncQueue.clear();
+	} else {
+		// Background requests for the missing or out-of-date only...
+		if (!bPriority && (m_syncQueue.contains(pPeakFile)
+			|| m_syncBusy.contains(pPeakFile) || !pPeakFile->isStale()))
+			return;
+		m_syncQueue.removeAll(pPeakFile);
+		pPeakFile->setWaitSync(true);
+		if (bPriority)
+			m_syncQueue.prepend(pPeakFile);
+		else
+			m_syncQueue.append(pPeakFile);
+	}
+
+	m_syncCond.wakeAll();
+}
+
+
+// Worker thread queue methods: wait and take next in queue.
+qtractorAudioPeakFile *qtractorAudioPeakFactory::syncNext (
+	qtractorAudioPeakThread *pPeakThread )
 {
-	if (m_pPeakThread) m_pPeakThread->sync(pPeakFile);
+	QMutexLocker locker(&m_syncMutex);
+
+	while (pPeakThread->runState()) {
+		QMutableListIterator<qtractorAudioPeakFile *> iter(m_syncQueue);
+		while (iter.hasNext()) {
+			qtractorAudioPeakFile *pPeakFile = iter.next();
+			// Still in progress on another worker?
+			if (m_syncBusy.contains(pPeakFile))
+				continue;
+			iter.remove();
+			if (pPeakFile->isWaitSync()) {
+				m_syncBusy.append(pPeakFile);
+				return pPeakFile;
+			}
+		}
+		m_syncCond.wait(&m_syncMutex);
+	}
+
+	return NULL;
+}
+
+
+// Worker thread queue methods: done with one.
+void qtractorAudioPeakFactory::syncDone ( qtractorAudioPeakFile *pPeakFile )
+{
+	QMutexLocker locker(&m_syncMutex);
+
+	m_syncBusy.removeAll(pPeakFile);
+
+	// Unless it has been queued once again, meanwhile...
+	if (!m_syncQueue.contains(pPeakFile))
+		pPeakFile->setWaitSync(false);
+
+	m_syncCond.wakeAll();
+}
+
+
+// Dequeue or cancel an in-flight peak file, waiting for its
+// worker to bail out, so that it's safe to close or remove.
+void qtractorAudioPeakFactory::syncCancel ( qtractorAudioPeakFile *pPeakFile )
+{
+	QMutexLocker locker(&m_syncMutex);
+
+	m_syncQueue.removeAll(pPeakFile);
+	pPeakFile->setWaitSync(false);
+
+	while (m_syncBusy.contains(pPeakFile))
+		m_syncCond.wait(&m_syncMutex);
+}
+
+
+// Number of peak files pending or in progress.
+int qtractorAudioPeakFactory::syncPending (void)
+{
+	QMutexLocker locker(&m_syncMutex);
+
+	return m_syncQueue.count() + m_syncBusy.count();
 }
 
 
@@ -1118,6 +1341,12 @@ void qtractorAudioPeakFactory::cleanup (void)
 		pPeakFile->cleanup(m_bAutoRemove);
 	}
 
+	// Wait for the ones still in progress...
+	m_syncMutex.lock();
+	while (!m_syncBusy.isEmpty())
+		m_syncCond.wait(&m_syncMutex);
+	m_syncMutex.unlock();
+
 	qDeleteAll(m_peaks);
 	m_peaks.clear();
 
@@ -27,6 +27,7 @@
 #include <QHash>
 
 #include <QMutex>
+#include <QWaitCondition>
 
 #include <QStringList>
 
@@ -38,6 +39,11 @@ class qtractorAudioPeakThread;
 //----------------------------------------------------------------------
 // class qtractorAudioPeakFile -- Audio peak file (ref'counted)
 //
+// The peak file holds a pyramid of peak frame levels: the base level,
+// one peak frame per period, followed by successive 2x reductions of
+// it, so that a long clip drawn zoomed out only needs to read as many
+// peak frames as there are pixels to draw.
+//
 
 class qtractorAudioPeakFile
 {
@@ -59,12 +65,20 @@ public:
 	QString name() const;
 	unsigned short period();
 	unsigned short channels();
+	unsigned short levels();
+
+	// Maximum number of levels (base level included).
+	enum { MaxLevels = 16 };
 
 	// Audio peak file header.
 	struct Header
 	{
+		char           magic[4];
 		unsigned short period;
 		unsigned short channels;
+		unsigned int   length;
+		unsigned short levels;
+		unsigned short reserved;
 	};
 
 	// Audio peak file frame record.
@@ -76,14 +90,16 @@ public:
 	};
 
 	// Peak cache file methods.
+	bool isStale() const;
 	bool openRead();
-	Frame *read(unsigned long iPeakOffset, unsigned int iPeakLength);
+	Frame *read(unsigned long iPeakOffset, unsigned int iPeakLength,
+		unsigned short iLevel = 0);
 	void closeRead();
 
 	// Write peak from audio frame methods.
 	bool openWrite(unsigned short iChannels, unsigned int iSampleRate);
 	int write(float **ppAudioFrames, unsigned int iAudioFrames);
-	void closeWrite();
+	void closeWrite(bool bComplete);
 
 	// Reference count methods.
 	void addRef();
@@ -106,6 +122,11 @@ protected:
 
 	// Internal creational methods.
 	void writeFrame();
+	void writeLevels();
+
+	// Level position and length (in peak frames).
+	void levelRange(unsigned short iLevel,
+		unsigned long& iOffset, unsigned long& iLength) const;
 
 	// Read frames from peak file into local buffer cache.
 	unsigned int readBuffer(unsigned int iBuffOffset,
@@ -127,6 +148,7 @@ private:
 	unsigned int   m_iBuffSize;
 	unsigned int   m_iBuffLength;
 	unsigned long  m_iBuffOffset;
+	unsigned short m_iBuffLevel;
 
 	QMutex         m_mutex;
 
@@ -208,6 +230,10 @@ private:
 //----------------------------------------------------------------------
 // class qtractorAudioPeakFactory -- Audio peak file factory (singleton).
 //
+// Peak files are (re)created by a pool of worker threads, one per core,
+// taking from a common queue: the ones about to be shown (drawn) go in
+// front, the ones only just opened (imported) go last, in background.
+//
 
 class qtractorAudioPeakFactory : public QObject
 {
@@ -235,8 +261,23 @@ public:
 	// Peak ready event notification.
 	void notifyPeakEvent();
 
-	// Base sync method.
-	void sync(qtractorAudioPeakFile *pPeakFile = NULL);
+	// Peak creation progress notification.
+	void notifyPeakProgress(qtractorAudioPeakFile *pPeakFile, int iPercent);
+
+	// Base sync method: queue peak file for (re)creation, in
+	// front if priority, otherwise only if missing or out-of-date;
+	// abort all the pending ones, if none is given.
+	void sync(qtractorAudioPeakFile *pPeakFile = NULL, bool bPriority = true);
+
+	// Worker thread queue methods.
+	qtractorAudioPeakFile *syncNext(qtractorAudioPeakThread *pPeakThread);
+	void syncDone(qtractorAudioPeakFile *pPeakFile);
+
+	// Dequeue or cancel (and wait for) an in-flight peak file.
+	void syncCancel(qtractorAudioPeakFile *pPeakFile);
+
+	// Number of peak files pending or in progress.
+	int syncPending();
 
 	// Cleanup method.
 	void cleanup();
@@ -249,6 +290,9 @@ signals:
 	// Peak ready signal.
 	void peakEvent();
 
+	// Peak creation progress signal.
+	void peakProgress(const QString& sFilename, int iPercent);
+
 private:
 
 	// Factory mutex.
@@ -262,8 +306,15 @@ private:
 	// Auto-delete property.
 	bool m_bAutoRemove;
 
-	// The peak file creation detached thread.
-	qtractorAudioPeakThread *m_pPeakThread;
+	// The peak file creation worker threads (pool).
+	QList<qtractorAudioPeakThread *> m_peakThreads;
+
+	// The peak file creation queue.
+	QMutex         m_syncMutex;
+	QWaitCondition m_syncCond;
+
+	QList<qtractorAudioPeakFile *> m_syncQueue;
+	QList<qtractorAudioPeakFile *> m_syncBusy;
 
 	// The current running peak-period.
 	unsigned short m_iPeakPeriod;
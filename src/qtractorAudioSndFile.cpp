@@ -1,7 +1,7 @@
 // qtractorAudioSndFile.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2011, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -21,6 +21,18 @@
 
 #include "qtractorAbout.h"
 #include "qtractorAudioSndFile.h"
+#include "qtractorAudioKernel.h"
+
+#if !defined(WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+// Memory-mapped read-ahead advice window (in frames).
+#define QTRACTOR_MMAP_READAHEAD	65536
 
 
 //----------------------------------------------------------------------
@@ -42,6 +54,14 @@ qtractorAudioSndFile::qtractorAudioSndFile ( unsigned short iChannels,
 	m_pBuffer     = NULL;
 	m_iBufferSize = 1024;
 
+	m_iMapFd      = -1;
+	m_pMapAddr    = NULL;
+	m_iMapSize    = 0;
+	m_pMapFrames  = NULL;
+	m_iMapFrames  = 0;
+	m_iMapOffset  = 0;
+	m_iMapAdvise  = 0;
+
 	// Adjust size the next nearest power-of-two.
 	while (m_iBufferSize < iBufferSize)
 		m_iBufferSize <<= 1;
@@ -95,6 +115,10 @@ bool qtractorAudioSndFile::open ( const QString& sFilename, int iMode )
 	// Allocate initial de/interleaving buffer stuff.
 	m_pBuffer = new float [m_sfinfo.channels * m_iBufferSize];
 
+	// Try the zero-copy way, whenever possible...
+	if (m_iMode & qtractorAudioSndFile::Read)
+		mapFile(sFilename);
+
 	return true;
 }
 
@@ -105,15 +129,47 @@ int qtractorAudioSndFile::read ( float **ppFrames, unsigned int iFrames )
 #ifdef DEBUG_0
 	qDebug("qtractorAudioSndFile::read(%p, %d)", ppFrames, iFrames);
 #endif
+	// Memory-mapped read mode...
+	if (m_pMapFrames) {
+		const unsigned long iMapFrames = mapFramesCheck();
+		if (m_iMapOffset + iFrames > iMapFrames) {
+			if (m_iMapOffset < iMapFrames)
+				iFrames = iMapFrames - m_iMapOffset;
+			else
+				iFrames = 0;
+		}
+		if (iFrames > 0) {
+			const unsigned short iChannels = m_sfinfo.channels;
+		#if !defined(WIN32)
+			// Advise the kernel about what comes next...
+			const unsigned long iAdvise
+				= m_iMapOffset + iFrames + QTRACTOR_MMAP_READAHEAD;
+			if (m_iMapAdvise < iAdvise - (QTRACTOR_MMAP_READAHEAD >> 1)
+				&& m_iMapAdvise < m_iMapFrames) {
+				const unsigned long iPageMask = ::sysconf(_SC_PAGESIZE) - 1;
+				const unsigned char *pAddr = (const unsigned char *)
+					(m_pMapFrames + m_iMapOffset * iChannels);
+				const unsigned long iAddr = (unsigned long) pAddr & ~iPageMask;
+				unsigned long iSize = (unsigned long) (m_pMapFrames
+					+ iAdvise * iChannels) - iAddr;
+				if (iAddr + iSize > (unsigned long) (m_pMapAddr + m_iMapSize))
+					iSize = (unsigned long) (m_pMapAddr + m_iMapSize) - iAddr;
+				::madvise((void *) iAddr, iSize, MADV_WILLNEED);
+				m_iMapAdvise = iAdvise;
+			}
+		#endif
+			qtractorAudioKernel::deinterleave(ppFrames,
+				m_pMapFrames + m_iMapOffset * iChannels, iChannels, iFrames);
+			m_iMapOffset += iFrames;
+		}
+		return iFrames;
+	}
+
 	allocBufferCheck(iFrames);
 	int nread = ::sf_readf_float(m_pSndFile, m_pBuffer, iFrames);
 	if (nread > 0) {
-		unsigned short i;
-		unsigned int n, k = 0;
-		for (n = 0; n < (unsigned int) nread; ++n) {
-			for (i = 0; i < (unsigned short) m_sfinfo.channels; ++i)
-				ppFrames[i][n] = m_pBuffer[k++];
-		}
+		qtractorAudioKernel::deinterleave(ppFrames, m_pBuffer,
+			(unsigned short) m_sfinfo.channels, (unsigned int) nread);
 	}
 	return nread;
 }
@@ -126,12 +182,8 @@ int qtractorAudioSndFile::write ( float **ppFrames, unsigned int iFrames )
 	qDebug("qtractorAudioSndFile::write(%p, %d)", ppFrames, iFrames);
 #endif
 	allocBufferCheck(iFrames);
-	unsigned short i;
-	unsigned int n, k = 0;
-	for (n = 0; n < iFrames; ++n) {
-		for (i = 0; i < (unsigned short) m_sfinfo.channels; ++i)
-			m_pBuffer[k++] = ppFrames[i][n];
-	}
+	qtractorAudioKernel::interleave(m_pBuffer, ppFrames,
+		(unsigned short) m_sfinfo.channels, iFrames);
 	return ::sf_writef_float(m_pSndFile, m_pBuffer, iFrames);
 }
 
@@ -142,6 +194,15 @@ bool qtractorAudioSndFile::seek ( unsigned long iOffset )
 #ifdef DEBUG_0
 	qDebug("qtractorAudioSndFile::seek(%d)", iOffset);
 #endif
+	if (m_pMapFrames) {
+		if (iOffset > m_iMapFrames)
+			return false;
+		if (iOffset < m_iMapOffset || iOffset > m_iMapAdvise)
+			m_iMapAdvise = iOffset;
+		m_iMapOffset = iOffset;
+		return true;
+	}
+
 	return (::sf_seek(m_pSndFile, iOffset, SEEK_SET) == long(iOffset));
 }
 
@@ -153,6 +214,8 @@ void qtractorAudioSndFile::close (void)
 	qDebug("qtractorAudioSndFile::close()");
 #endif
 
+	unmapFile();
+
 	if (m_pSndFile) {
 		::sf_close(m_pSndFile);
 		m_pSndFile = NULL;
@@ -194,6 +257,13 @@ unsigned int qtractorAudioSndFile::sampleRate (void) const
 }
 
 
+// Memory-mapped read mode accessor.
+bool qtractorAudioSndFile::isMapped (void) const
+{
+	return (m_pMapFrames != NULL);
+}
+
+
 // De/interleaving buffer stuff.
 void qtractorAudioSndFile::allocBufferCheck ( unsigned int iBufferSize )
 {
@@ -211,4 +281,225 @@ void qtractorAudioSndFile::allocBufferCheck ( unsigned int iBufferSize )
 }
 
 
+// Memory-mapped read mode (32bit float PCM only) helpers.
+bool qtractorAudioSndFile::mapFile ( const QString& sFilename )
+{
+	unmapFile();
+
+#if !defined(WIN32) && (Q_BYTE_ORDER == Q_LITTLE_ENDIAN)
+
+	// Only native 32bit float samples are candidates...
+	if ((m_sfinfo.format & SF_FORMAT_SUBMASK) != SF_FORMAT_FLOAT)
+		return false;
+	if ((m_sfinfo.format & SF_FORMAT_ENDMASK) == SF_ENDIAN_BIG)
+		return false;
+
+	switch (m_sfinfo.format & SF_FORMAT_TYPEMASK) {
+	case SF_FORMAT_WAV:
+	case SF_FORMAT_WAVEX:
+	case SF_FORMAT_RF64:
+	case SF_FORMAT_CAF:
+		break;
+	default:
+		return false;
+	}
+
+	if (m_sfinfo.channels < 1 || m_sfinfo.frames < 1)
+		return false;
+
+	const QByteArray aFilename = sFilename.toUtf8();
+	const int fd = ::open(aFilename.constData(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) < 0 || st.st_size < 1) {
+		::close(fd);
+		return false;
+	}
+
+	const unsigned long iMapSize = st.st_size;
+	void *pMapAddr = ::mmap(NULL, iMapSize, PROT_READ, MAP_SHARED, fd, 0);
+	if (pMapAddr == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	// Keep the file descriptor open, for size checking...
+	m_iMapFd   = fd;
+	m_pMapAddr = (unsigned char *) pMapAddr;
+	m_iMapSize = iMapSize;
+
+	// Find where the PCM data really starts...
+	const unsigned long iDataOffset = mapDataOffset(iMapSize);
+	const unsigned long iFrameSize = m_sfinfo.channels * sizeof(float);
+	if (iDataOffset < 1 || (iDataOffset & (sizeof(float) - 1))
+		|| iDataOffset + m_sfinfo.frames * iFrameSize > iMapSize) {
+		unmapFile();
+		return false;
+	}
+
+	m_pMapFrames = (const float *) (m_pMapAddr + iDataOffset);
+	m_iMapFrames = m_sfinfo.frames;
+	m_iMapOffset = 0;
+	m_iMapAdvise = 0;
+
+	::madvise(pMapAddr, iMapSize, MADV_SEQUENTIAL);
+
+#ifdef CONFIG_DEBUG_0
+	qDebug("qtractorAudioSndFile[%p]::mapFile(\"%s\") offset=%lu frames=%lu",
+		this, aFilename.constData(), iDataOffset, m_iMapFrames);
+#endif
+
+	return true;
+
+#else
+
+	Q_UNUSED(sFilename);
+
+	return false;
+
+#endif
+}
+
+
+void qtractorAudioSndFile::unmapFile (void)
+{
+#if !defined(WIN32)
+	if (m_pMapAddr)
+		::munmap(m_pMapAddr, m_iMapSize);
+	if (m_iMapFd >= 0)
+		::close(m_iMapFd);
+#endif
+
+	m_iMapFd     = -1;
+	m_pMapAddr   = NULL;
+	m_iMapSize   = 0;
+	m_pMapFrames = NULL;
+	m_iMapFrames = 0;
+	m_iMapOffset = 0;
+	m_iMapAdvise = 0;
+}
+
+
+// Memory-mapped file size check, against truncation: touching
+// mapped pages past the current end-of-file raises SIGBUS, so the
+// file size is checked before each access; any frames lost are
+// just taken as an early end-of-file.
+unsigned long qtractorAudioSndFile::mapFramesCheck (void)
+{
+#if !defined(WIN32)
+	struct stat st;
+	if (m_iMapFd < 0 || ::fstat(m_iMapFd, &st) < 0)
+		return m_iMapFrames;
+
+	const unsigned long iDataOffset
+		= (const unsigned char *) m_pMapFrames - m_pMapAddr;
+	const unsigned long iFrameSize = m_sfinfo.channels * sizeof(float);
+	const unsigned long iFileSize = st.st_size;
+
+	unsigned long iMapFrames = 0;
+	if (iFileSize > iDataOffset)
+		iMapFrames = (iFileSize - iDataOffset) / iFrameSize;
+	if (m_iMapFrames > iMapFrames)
+		m_iMapFrames = iMapFrames;
+#endif
+
+	return m_iMapFrames;
+}
+
+
+// Locate the (32bit float, little-endian) PCM data chunk
+// within a WAV, RF64 or CAF file header; return byte offset.
+static inline unsigned long mapLE32 ( const unsigned char *p )
+{
+	return (unsigned long) p[0]
+		| ((unsigned long) p[1] << 8)
+		| ((unsigned long) p[2] << 16)
+		| ((unsigned long) p[3] << 24);
+}
+
+static inline quint64 mapLE64 ( const unsigned char *p )
+{
+	return quint64(mapLE32(p)) | (quint64(mapLE32(p + 4)) << 32);
+}
+
+static inline unsigned long mapBE32 ( const unsigned char *p )
+{
+	return (unsigned long) p[3]
+		| ((unsigned long) p[2] << 8)
+		| ((unsigned long) p[1] << 16)
+		| ((unsigned long) p[0] << 24);
+}
+
+static inline quint64 mapBE64 ( const unsigned char *p )
+{
+	return (quint64(mapBE32(p)) << 32) | quint64(mapBE32(p + 4));
+}
+
+unsigned long qtractorAudioSndFile::mapDataOffset (
+	unsigned long iMapSize ) const
+{
+	const unsigned char *pAddr = m_pMapAddr;
+	if (pAddr == NULL || iMapSize < 12)
+		return 0;
+
+	// RIFF/WAVE or RF64/WAVE...
+	const bool bRF64 = (::memcmp(pAddr, "RF64", 4) == 0);
+	if ((bRF64 || ::memcmp(pAddr, "RIFF", 4) == 0)
+		&& ::memcmp(pAddr + 8, "WAVE", 4) == 0) {
+		quint64 iDataSize64 = 0;
+		unsigned long i = 12;
+		while (i + 8 <= iMapSize) {
+			const unsigned char *pChunk = pAddr + i;
+			quint64 iChunkSize = mapLE32(pChunk + 4);
+			if (bRF64 && ::memcmp(pChunk, "ds64", 4) == 0
+				&& i + 8 + 16 <= iMapSize)
+				iDataSize64 = mapLE64(pChunk + 8 + 8);
+			else
+			if (::memcmp(pChunk, "data", 4) == 0) {
+				if (bRF64 && iChunkSize == 0xffffffff)
+					iChunkSize = iDataSize64;
+				if (iChunkSize < quint64(m_sfinfo.frames)
+					* m_sfinfo.channels * sizeof(float))
+					return 0;
+				return i + 8;
+			}
+			if (iChunkSize > quint64(iMapSize))
+				break;
+			i += 8 + iChunkSize + (iChunkSize & 1);
+		}
+		return 0;
+	}
+
+	// CAF (Core Audio Format)...
+	if (::memcmp(pAddr, "caff", 4) == 0) {
+		bool bFloatLE = false;
+		unsigned long i = 8;
+		while (i + 12 <= iMapSize) {
+			const unsigned char *pChunk = pAddr + i;
+			const quint64 iChunkSize = mapBE64(pChunk + 4);
+			if (::memcmp(pChunk, "desc", 4) == 0 && i + 12 + 32 <= iMapSize) {
+				// mFormatID == 'lpcm' and mFormatFlags (float|little-endian)...
+				const unsigned long iFormatFlags = mapBE32(pChunk + 12 + 12);
+				bFloatLE = (::memcmp(pChunk + 12 + 8, "lpcm", 4) == 0
+					&& (iFormatFlags & 3) == 3
+					&& mapBE32(pChunk + 12 + 28) == 32);
+			}
+			else
+			if (::memcmp(pChunk, "data", 4) == 0) {
+				// Skip the mEditCount field...
+				return (bFloatLE ? i + 12 + 4 : 0);
+			}
+			if (iChunkSize > quint64(iMapSize))
+				break;
+			i += 12 + iChunkSize;
+		}
+		return 0;
+	}
+
+	return 0;
+}
+
+
 // end of qtractorAudioSndFile.cpp
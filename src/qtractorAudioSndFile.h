@@ -1,7 +1,7 @@
 // qtractorAudioSndFile.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2011, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -58,11 +58,26 @@ public:
 	// Specialty methods.
 	unsigned int   sampleRate() const;
 
+	// Memory-mapped read mode accessor.
+	bool isMapped() const;
+
 protected:
 
 	// De/interleaving buffer (re)allocation check.
 	void allocBufferCheck(unsigned int iBufferSize);
 
+	// Memory-mapped read mode (32bit float PCM only) helpers.
+	bool mapFile(const QString& sFilename);
+	void unmapFile();
+
+	// Locate the (32bit float, little-endian) PCM data chunk
+	// within a WAV, RF64 or CAF file header; return byte offset.
+	unsigned long mapDataOffset(unsigned long iMapSize) const;
+
+	// Memory-mapped file size check, against truncation;
+	// return the number of frames still safe to access.
+	unsigned long mapFramesCheck();
+
 private:
 
 	int           m_iMode;          // open mode (Read|Write).
@@ -72,6 +87,15 @@ private:
 	// De/interleaving buffer stuff.
 	float        *m_pBuffer;
 	unsigned int  m_iBufferSize;
+
+	// Memory-mapped read mode stuff.
+	int            m_iMapFd;        // mapped file descriptor.
+	unsigned char *m_pMapAddr;      // whole file mapping.
+	unsigned long  m_iMapSize;      // whole file size (bytes).
+	const float   *m_pMapFrames;    // first PCM frame.
+	unsigned long  m_iMapFrames;    // total PCM frames.
+	unsigned long  m_iMapOffset;    // current frame position.
+	unsigned long  m_iMapAdvise;    // read-ahead advised up to frame.
 };
 
 
@@ -1,7 +1,7 @@
 // qtractorClip.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -52,8 +52,8 @@ qtractorClip::qtractorClip ( qtractorTrack *pTrack )
 
 	m_pTakeInfo = NULL;
 
-	m_pFadeInFunctor  = NULL;
-	m_pFadeOutFunctor = NULL;
+	m_pFadeInTable  = NULL;
+	m_pFadeOutTable = NULL;
 
 	clear();
 }
@@ -64,11 +64,6 @@ qtractorClip::~qtractorClip (void)
 {
 	if (m_pTakeInfo)
 		m_pTakeInfo->releaseRef();
-
-	if (m_pFadeInFunctor)
-		delete m_pFadeInFunctor;
-	if (m_pFadeOutFunctor)
-		delete m_pFadeOutFunctor;
 }
 
 
@@ -169,21 +164,31 @@ QString qtractorClip::clipTitle (void) const
 // Clip start frame accessor.
 void qtractorClip::setClipStart ( unsigned long iClipStart )
 {
+	const bool bChanged = (m_iClipStart != iClipStart);
+
 	m_iClipStart = iClipStart;
 
 	if (m_pTrack && m_pTrack->session())
 		m_iClipStartTime = m_pTrack->session()->tickFromFrame(iClipStart);
+
+	if (m_pTrack && bChanged)
+		m_pTrack->updateClipSerial();
 }
 
 
 // Clip frame length accessor.
 void qtractorClip::setClipLength ( unsigned long iClipLength )
 {
+	const bool bChanged = (m_iClipLength != iClipLength);
+
 	m_iClipLength = iClipLength;
 
 	if (m_pTrack && m_pTrack->session())
 		m_iClipLengthTime = m_pTrack->session()->tickFromFrameRange(
 			m_iClipStart, m_iClipStart + m_iClipLength);
+
+	if (m_pTrack && bChanged)
+		m_pTrack->updateClipSerial();
 }
 
 
@@ -251,11 +256,8 @@ void qtractorClip::setClipGain ( float fGain )
 // Clip fade-in accessors
 void qtractorClip::setFadeInType ( qtractorClip::FadeType fadeType )
 {
-	if (m_pFadeInFunctor)
-		delete m_pFadeInFunctor;
-
 	m_fadeInType = fadeType;
-	m_pFadeInFunctor = createFadeFunctor(FadeIn, fadeType);
+	m_pFadeInTable = fadeTable(FadeIn, fadeType);
 }
 
 
@@ -275,11 +277,8 @@ void qtractorClip::setFadeInLength ( unsigned long iFadeInLength )
 // Clip fade-out accessors
 void qtractorClip::setFadeOutType ( qtractorClip::FadeType fadeType )
 {
-	if (m_pFadeOutFunctor)
-		delete m_pFadeOutFunctor;
-
 	m_fadeOutType = fadeType;
-	m_pFadeOutFunctor = createFadeFunctor(FadeOut, fadeType);
+	m_pFadeOutTable = fadeTable(FadeOut, fadeType);
 }
 
 
@@ -297,6 +296,17 @@ void qtractorClip::setFadeOutLength ( unsigned long iFadeOutLength )
 }
 
 
+// Fade lookup table (linear) interpolation, given t in [0, 1].
+static inline float fadeTableValue ( const float *pTable, float t )
+{
+	const float x = t * float(qtractorClip::FadeTableSize);
+	const int i = int(x);
+	if (i >= qtractorClip::FadeTableSize)
+		return pTable[qtractorClip::FadeTableSize];
+	return pTable[i] + (x - float(i)) * (pTable[i + 1] - pTable[i]);
+}
+
+
 // Compute clip gain, given current fade-in/out slopes.
 float qtractorClip::gain ( unsigned long iOffset ) const
 {
@@ -306,12 +316,12 @@ float qtractorClip::gain ( unsigned long iOffset ) const
 	float fGain = m_fGain;
 
 	if (m_iFadeInLength > 0 && iOffset < m_iFadeInLength) {
-		fGain *= (*m_pFadeInFunctor)(
+		fGain *= fadeTableValue(m_pFadeInTable,
 			float(iOffset) / float(m_iFadeInLength));
 	}
 
 	if (m_iFadeOutLength > 0 && iOffset > m_iClipLength - m_iFadeOutLength) {
-		fGain *= (*m_pFadeOutFunctor)(
+		fGain *= fadeTableValue(m_pFadeOutTable,
 			float(iOffset - (m_iClipLength - m_iFadeOutLength))
 				/ float(m_iFadeOutLength));
 	}
@@ -320,6 +330,50 @@ float qtractorClip::gain ( unsigned long iOffset ) const
 }
 
 
+// Compute clip gain envelope, one value per frame, given current
+// fade-in/out slopes; false if there's no fade in range at all.
+bool qtractorClip::gains ( float *pGains,
+	unsigned long iOffset, unsigned int iFrames ) const
+{
+	const unsigned long iOffsetEnd = iOffset + iFrames;
+	const unsigned long iFadeOutStart = m_iClipLength - m_iFadeOutLength;
+
+	const bool bFadeIn = (m_iFadeInLength > 0
+		&& iOffset < m_iFadeInLength);
+	const bool bFadeOut = (m_iFadeOutLength > 0
+		&& iOffsetEnd > iFadeOutStart + 1);
+	if (!bFadeIn && !bFadeOut)
+		return false;
+
+	unsigned int n;
+
+	for (n = 0; n < iFrames; ++n)
+		pGains[n] = m_fGain;
+
+	if (bFadeIn) {
+		const unsigned int n1 = (iOffsetEnd < m_iFadeInLength
+			? iFrames : m_iFadeInLength - iOffset);
+		const double dDelta = 1.0 / double(m_iFadeInLength);
+		for (n = 0; n < n1; ++n) {
+			pGains[n] *= fadeTableValue(m_pFadeInTable,
+				float(double(iOffset + n) * dDelta));
+		}
+	}
+
+	if (bFadeOut) {
+		const unsigned int n0 = (iOffset < iFadeOutStart
+			? iFadeOutStart - iOffset : 0);
+		const double dDelta = 1.0 / double(m_iFadeOutLength);
+		for (n = n0; n < iFrames; ++n) {
+			pGains[n] *= fadeTableValue(m_pFadeOutTable,
+				float(double(iOffset + n - iFadeOutStart) * dDelta));
+		}
+	}
+
+	return true;
+}
+
+
 // Clip time reference settler method.
 void qtractorClip::updateClipTime (void)
 {
@@ -330,6 +384,9 @@ void qtractorClip::updateClipTime (void)
 	if (pSession == NULL)
 		return;
 
+	const unsigned long iClipStart  = m_iClipStart;
+	const unsigned long iClipLength = m_iClipLength;
+
 	m_iClipStart = pSession->frameFromTick(m_iClipStartTime);
 	m_iClipLength = pSession->frameFromTickRange(
 		m_iClipStartTime, m_iClipStartTime + m_iClipLengthTime);
@@ -341,6 +398,10 @@ void qtractorClip::updateClipTime (void)
 	m_iFadeOutLength = pSession->frameFromTickRange(
 		m_iClipStartTime + m_iClipLengthTime - m_iFadeOutTime,
 		m_iClipStartTime + m_iClipLengthTime);
+
+	// Clip index gets stale only when actually moved...
+	if (m_iClipStart != iClipStart || m_iClipLength != iClipLength)
+		m_pTrack->updateClipSerial();
 }
 
 
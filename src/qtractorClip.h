@@ -1,7 +1,7 @@
 // qtractorClip.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -194,6 +194,10 @@ public:
 	// Compute clip gain, given current fade-in/out slopes.
 	float gain(unsigned long iOffset) const;
 
+	// Compute clip gain envelope, one value per frame, given current
+	// fade-in/out slopes; false if there's no fade in range at all.
+	bool gains(float *pGains, unsigned long iOffset, unsigned int iFrames) const;
+
 	// Document element methods.
 	bool loadElement(qtractorDocument *pDocument, QDomElement *pElement);
 	bool saveElement(qtractorDocument *pDocument, QDomElement *pElement);
@@ -338,6 +342,14 @@ public:
 		virtual float operator() (float t) const = 0;
 	};
 
+	// Fade lookup table size (intervals).
+	enum { FadeTableSize = 1024 };
+
+	// Fade lookup table factory method (static);
+	// tables are shared and built from the functors,
+	// once and for all, on first use (non RT-safe).
+	static const float *fadeTable(FadeMode fadeMode, FadeType fadeType);
+
 protected:
 
 	// Fade functor factory method.
@@ -388,9 +400,10 @@ private:
 	FadeType m_fadeInType;              // Fade-in curve type.
 	FadeType m_fadeOutType;             // Fade-out curve type.
 
-	// Aproximations to exponential fade interpolation.
-	FadeFunctor *m_pFadeInFunctor;
-	FadeFunctor *m_pFadeOutFunctor;
+	// Aproximations to exponential fade interpolation
+	// (interpolated lookup tables).
+	const float *m_pFadeInTable;
+	const float *m_pFadeOutTable;
 
 	// Local dirty flag.
 	bool m_bDirty;
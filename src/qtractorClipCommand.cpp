@@ -24,6 +24,7 @@
 #include "qtractorTrackCommand.h"
 
 #include "qtractorMainForm.h"
+#include "qtractorMixer.h"
 
 #include "qtractorSession.h"
 #include "qtractorAudioClip.h"
@@ -579,7 +580,57 @@ bool qtractorClipCommand::execute ( bool bRedo )
 	if (pSession == NULL)
 		return false;
 
-	pSession->lock();
+	// Take all affected tracks out of RT processing sight,
+	// while the remaining ones just keep playing along...
+	QList<qtractorTrack *> tracks;
+	QListIterator<Item *> iter(m_items);
+	while (iter.hasNext()) {
+		Item *pItem = iter.next();
+		pSession->detachTrack(pItem->track);
+		qtractorTrack *pOldTrack = (pItem->clip)->track();
+		if (pOldTrack)
+			pSession->detachTrack(pOldTrack);
+		// Renames alone leave a frozen track be...
+		if (pItem->command == RenameClip)
+			continue;
+		if (!tracks.contains(pItem->track))
+			tracks.append(pItem->track);
+		if (pOldTrack && !tracks.contains(pOldTrack))
+			tracks.append(pOldTrack);
+	}
+
+	QHash<qtractorClip *, bool>::ConstIterator clip = m_clips.constBegin();
+	const QHash<qtractorClip *, bool>::ConstIterator& clip_end = m_clips.constEnd();
+	for ( ; clip != clip_end; ++clip) {
+		qtractorTrack *pClipTrack = clip.key()->track();
+		if (pClipTrack) {
+			pSession->detachTrack(pClipTrack);
+			if (!tracks.contains(pClipTrack))
+				tracks.append(pClipTrack);
+		}
+	}
+
+	// Bail out if the RT threads might still be about...
+	if (!pSession->updateSnapshot()) {
+		pSession->attachTracks();
+		return false;
+	}
+
+	// Edited frozen tracks get unfrozen first,
+	// as their pre-rendered clip would be stale...
+	if (bRedo) {
+		m_freezes.clear();
+		QListIterator<qtractorTrack *> track_iter(tracks);
+		while (track_iter.hasNext()) {
+			qtractorTrack *pTrack = track_iter.next();
+			if (!pTrack->isFrozen())
+				continue;
+			FreezeItem& item = m_freezes[pTrack];
+			item.filename = pTrack->freezeFilename();
+			item.start = pTrack->freezeStart();
+			pTrack->setFreezeEx(QString());
+		}
+	}
 
 	QListIterator<qtractorTrackCommand *> track(m_trackCommands);
 	while (track.hasNext()) {
@@ -591,14 +642,12 @@ bool qtractorClipCommand::execute ( bool bRedo )
 	}
 
 	// Pre-close needed clips once...
-	QHash<qtractorClip *, bool>::ConstIterator clip = m_clips.constBegin();
-	const QHash<qtractorClip *, bool>::ConstIterator& clip_end = m_clips.constEnd();
-	for ( ; clip != clip_end; ++clip) {
+	for (clip = m_clips.constBegin(); clip != clip_end; ++clip) {
 		if (clip.value()) // Scrap peak file (audio).
 			clip.key()->close();
 	}
 
-	QListIterator<Item *> iter(m_items);
+	iter.toFront();
 	while (iter.hasNext()) {
 		Item *pItem = iter.next();
 		qtractorClip  *pClip  = pItem->clip;
@@ -802,7 +851,34 @@ bool qtractorClipCommand::execute ( bool bRedo )
 	for (clip = m_clips.constBegin(); clip != clip_end; ++clip)
 		clip.key()->open();
 
-	pSession->unlock();
+	// Back to the frozen state, as it were...
+	if (!bRedo) {
+		QHash<qtractorTrack *, FreezeItem>::ConstIterator freeze
+			= m_freezes.constBegin();
+		const QHash<qtractorTrack *, FreezeItem>::ConstIterator& freeze_end
+			= m_freezes.constEnd();
+		for ( ; freeze != freeze_end; ++freeze) {
+			const FreezeItem& item = freeze.value();
+			freeze.key()->setFreezeEx(item.filename, item.start);
+		}
+	}
+
+	// Back into RT processing sight...
+	pSession->attachTracks();
+
+	// Refresh any (un)frozen track mixer strips...
+	if (!m_freezes.isEmpty()) {
+		qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
+		qtractorMixer *pMixer = (pMainForm ? pMainForm->mixer() : NULL);
+		if (pMixer) {
+			QHash<qtractorTrack *, FreezeItem>::ConstIterator freeze
+				= m_freezes.constBegin();
+			const QHash<qtractorTrack *, FreezeItem>::ConstIterator& freeze_end
+				= m_freezes.constEnd();
+			for ( ; freeze != freeze_end; ++freeze)
+				pMixer->updateTrackStrip(freeze.key());
+		}
+	}
 
 	return true;
 }
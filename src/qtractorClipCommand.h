@@ -157,6 +157,15 @@ private:
 
 	// When clips need to reopem.
 	QHash<qtractorClip *, bool> m_clips;
+
+	// When frozen tracks get edited (auto-unfreeze).
+	struct FreezeItem
+	{
+		QString       filename;
+		unsigned long start;
+	};
+
+	QHash<qtractorTrack *, FreezeItem> m_freezes;
 };
 
 
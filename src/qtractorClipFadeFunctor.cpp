@@ -1,7 +1,7 @@
 // qtractorClipFadeFunctor.cpp
 //
 /****************************************************************************
-   Copyright (C) 2010, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2010-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    Adapted and refactored from Robert Penner's easing equations.
    Copyright (C) 2001, Robert Penner.
@@ -248,4 +248,34 @@ qtractorClip::FadeFunctor *qtractorClip::createFadeFunctor (
 }
 
 
+// Fade lookup table factory method (static).
+//
+const float *qtractorClip::fadeTable ( FadeMode fadeMode, FadeType fadeType )
+{
+	static float s_tables[FadeOut + 1][InOutCubic + 1][FadeTableSize + 1];
+	static bool s_bTables = false;
+
+	if (!s_bTables) {
+		for (int iMode = FadeIn; iMode <= FadeOut; ++iMode) {
+			for (int iType = Linear; iType <= InOutCubic; ++iType) {
+				FadeFunctor *pFunctor
+					= createFadeFunctor(FadeMode(iMode), FadeType(iType));
+				float *pTable = s_tables[iMode][iType];
+				for (int i = 0; i <= FadeTableSize; ++i)
+					pTable[i] = (*pFunctor)(float(i) / float(FadeTableSize));
+				delete pFunctor;
+			}
+		}
+		s_bTables = true;
+	}
+
+	if (fadeMode < FadeIn || fadeMode > FadeOut)
+		fadeMode = FadeIn;
+	if (fadeType < Linear || fadeType > InOutCubic)
+		fadeType = Linear;
+
+	return s_tables[fadeMode][fadeType];
+}
+
+
 // end of qtractorClipFadeFunctor.cpp
@@ -1,7 +1,7 @@
 // qtractorCurve.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -578,6 +578,35 @@ float qtractorCurve::value ( unsigned long iFrame )
 }
 
 
+// Next automation split frame, for sub-block processing.
+unsigned long qtractorCurve::nextFrame ( unsigned long iFrame,
+	unsigned long iFrameEnd, unsigned int iFrames )
+{
+	if (!isProcess() || isCapture())
+		return iFrameEnd;
+
+	// Next node strictly ahead...
+	const Node *pNode = seek(iFrame);
+	while (pNode && pNode->frame <= iFrame)
+		pNode = pNode->next();
+
+	// Past the last node, value is constant...
+	if (pNode == NULL)
+		return iFrameEnd;
+
+	unsigned long iNextFrame = pNode->frame;
+
+	// Continuous segments are split on an absolute frame-grid...
+	if (mode() != Hold && iFrames > 0) {
+		const unsigned long iGridFrame = iFrame + iFrames - (iFrame % iFrames);
+		if (iNextFrame > iGridFrame)
+			iNextFrame = iGridFrame;
+	}
+
+	return (iNextFrame < iFrameEnd ? iNextFrame : iFrameEnd);
+}
+
+
 // Normalized scale converters.
 float qtractorCurve::valueFromScale ( float fScale ) const 
 {
@@ -1,7 +1,7 @@
 // qtractorCurve.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -211,6 +211,12 @@ public:
 
 	void process() { process(m_cursor.frame()); }
 
+	// Next automation split frame, for sub-block processing:
+	// curve node boundaries and/or a fixed frame-grid resolution
+	// for continuous (non-hold) curve segments.
+	unsigned long nextFrame(unsigned long iFrame,
+		unsigned long iFrameEnd, unsigned int iFrames);
+
 	// Record automation procedure.
 	void capture(unsigned long iFrame)
 	{
@@ -511,6 +517,22 @@ public:
 		}
 	}
 
+	// Next automation split frame (sub-block processing).
+	unsigned long nextFrame(unsigned long iFrame,
+		unsigned long iFrameEnd, unsigned int iFrames)
+	{
+		unsigned long iNextFrame = iFrameEnd;
+		qtractorCurve *pCurve = first();
+		while (pCurve && iNextFrame > iFrame + 1) {
+			const unsigned long iCurveFrame
+				= pCurve->nextFrame(iFrame, iNextFrame, iFrames);
+			if (iNextFrame > iCurveFrame)
+				iNextFrame = iCurveFrame;
+			pCurve = pCurve->next();
+		}
+		return iNextFrame;
+	}
+
 	// Process management.
 	void updateProcess(bool bProcess)
 	{
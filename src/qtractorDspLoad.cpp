@@ -0,0 +1,165 @@
+// qtractorDspLoad.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorDspLoad.h"
+
+#include "qtractorRenderStats.h"
+#include "qtractorXrunTrace.h"
+
+
+//----------------------------------------------------------------------
+// class qtractorDspLoad -- Per-object (track, plugin) DSP load meter.
+//
+
+// Global enablement.
+bool qtractorDspLoad::g_bEnabled = true;
+
+
+// Constructor.
+qtractorDspLoad::qtractorDspLoad (void)
+{
+	reset();
+}
+
+
+// Global enablement (non RT-safe).
+void qtractorDspLoad::setEnabled ( bool bEnabled )
+{
+	g_bEnabled = bEnabled;
+}
+
+bool qtractorDspLoad::isEnabled (void)
+{
+	return g_bEnabled;
+}
+
+
+// Time accounting bracket (RT-safe).
+void qtractorDspLoad::start (void)
+{
+	m_iStart = (g_bEnabled || qtractorXrunTrace::isEnabled()
+		? qtractorRenderStats::clock() : 0);
+}
+
+unsigned long long qtractorDspLoad::stop ( unsigned int nframes )
+{
+	if (m_iStart == 0)
+		return 0;
+
+	const unsigned long long iTime
+		= qtractorRenderStats::clock() - m_iStart;
+	m_iStart = 0;
+
+	m_iTime   += iTime;
+	m_iFrames += nframes;
+
+	// Histogram bucket (power-of-two microseconds)...
+	unsigned long long iMicros = iTime / 1000;
+	int iBucket = 0;
+	while (iMicros > 0 && iBucket < Buckets - 1) {
+		iMicros >>= 1;
+		++iBucket;
+	}
+	++m_histogram[iBucket];
+
+	return iTime;
+}
+
+
+// Periodic sampling (non RT-safe).
+void qtractorDspLoad::update ( unsigned int iSampleRate )
+{
+	const unsigned long long iTime   = m_iTime;
+	const unsigned long long iFrames = m_iFrames;
+
+	const unsigned long long iDeltaTime   = iTime - m_iLastTime;
+	const unsigned long long iDeltaFrames = iFrames - m_iLastFrames;
+
+	m_iLastTime   = iTime;
+	m_iLastFrames = iFrames;
+
+	// Time spent vs. real-time budget of the processed frames...
+	float fLoad = 0.0f;
+	if (iDeltaFrames > 0 && iSampleRate > 0) {
+		const float fBudget
+			= 1e9f * float(iDeltaFrames) / float(iSampleRate);
+		fLoad = 100.0f * float(iDeltaTime) / fBudget;
+	}
+
+	// Rise fast, fall slow...
+	if (fLoad > m_fLoad)
+		m_fLoad = fLoad;
+	else
+		m_fLoad = 0.5f * (m_fLoad + fLoad);
+
+	// Worst call since last update...
+	m_iPeakTime = 0;
+	for (int i = 0; i < Buckets; ++i) {
+		const unsigned int iCount = m_histogram[i];
+		if (iCount != m_lastHistogram[i])
+			m_iPeakTime = (1U << i);
+		m_lastHistogram[i] = iCount;
+	}
+}
+
+
+// Last sampled figures.
+float qtractorDspLoad::load (void) const
+{
+	return m_fLoad;
+}
+
+unsigned int qtractorDspLoad::peakTime (void) const
+{
+	return m_iPeakTime;
+}
+
+
+// Histogram bucket count (accumulated).
+unsigned int qtractorDspLoad::histogram ( int iBucket ) const
+{
+	return (iBucket >= 0 && iBucket < Buckets ? m_histogram[iBucket] : 0);
+}
+
+
+// Reset all counters (non RT-safe, not while processing).
+void qtractorDspLoad::reset (void)
+{
+	m_iStart = 0;
+
+	m_iTime   = 0;
+	m_iFrames = 0;
+
+	m_iLastTime   = 0;
+	m_iLastFrames = 0;
+
+	for (int i = 0; i < Buckets; ++i) {
+		m_histogram[i] = 0;
+		m_lastHistogram[i] = 0;
+	}
+
+	m_fLoad = 0.0f;
+	m_iPeakTime = 0;
+}
+
+
+// end of qtractorDspLoad.cpp
@@ -0,0 +1,99 @@
+// qtractorDspLoad.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorDspLoad_h
+#define __qtractorDspLoad_h
+
+
+//----------------------------------------------------------------------
+// class qtractorDspLoad -- Per-object (track, plugin) DSP load meter.
+//
+// The process thread brackets each call with start() and stop(),
+// accumulating the elapsed time, the processed frames and a histogram
+// of call times in power-of-two microsecond buckets. The GUI thread
+// then samples the counters periodically, with update(). Each object
+// is only ever processed by one thread at a time and only the GUI
+// thread ever reads, so no locking is needed at all. Calls are also
+// timed while the xrun trace is on, so that it gets its item times.
+//
+
+class qtractorDspLoad
+{
+public:
+
+	// Histogram size: bucket 0 is below 1us, bucket i (i > 0)
+	// is from 2^(i-1) up to 2^i us, last one open ended.
+	enum { Buckets = 16 };
+
+	// Constructor.
+	qtractorDspLoad();
+
+	// Global enablement (non RT-safe).
+	static void setEnabled(bool bEnabled);
+	static bool isEnabled();
+
+	// Time accounting bracket (RT-safe);
+	// stop() returns the elapsed time (ns).
+	void start();
+	unsigned long long stop(unsigned int nframes);
+
+	// Periodic sampling (non RT-safe); load figures are
+	// relative to the real-time budget of the processed frames.
+	void update(unsigned int iSampleRate);
+
+	// Last sampled figures: (smoothed) load percentage
+	// and worst call time (histogram bucket upper bound, us).
+	float load() const;
+	unsigned int peakTime() const;
+
+	// Histogram bucket count (accumulated).
+	unsigned int histogram(int iBucket) const;
+
+	// Reset all counters (non RT-safe, not while processing).
+	void reset();
+
+private:
+
+	// Running (RT) counters.
+	unsigned long long m_iStart;
+
+	volatile unsigned long long m_iTime;
+	volatile unsigned long long m_iFrames;
+	volatile unsigned int m_histogram[Buckets];
+
+	// Last sampled (GUI) counters.
+	unsigned long long m_iLastTime;
+	unsigned long long m_iLastFrames;
+	unsigned int m_lastHistogram[Buckets];
+
+	// Last sampled figures.
+	float        m_fLoad;
+	unsigned int m_iPeakTime;
+
+	// Global enablement.
+	static bool g_bEnabled;
+};
+
+
+#endif  // __qtractorDspLoad_h
+
+
+// end of qtractorDspLoad.h
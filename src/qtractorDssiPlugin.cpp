@@ -1,7 +1,7 @@
 // qtractorDssiPlugin.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -1094,10 +1094,11 @@ void qtractorDssiPlugin::process (
 				pMidiManager->events(), pMidiManager->count());
 		}
 		else (*pLadspaDescriptor->run)(handle, nframes);
-		// Wrap dangling output channels?...
-		for (j = iOChannel; j < iChannels; ++j)
-			::memset(ppOBuffer[j], 0, nframes * sizeof(float));
 	}
+
+	// Wrap dangling output channels?...
+	for (j = iOChannel; j < iChannels; ++j)
+		::memset(ppOBuffer[j], 0, nframes * sizeof(float));
 }
 
 
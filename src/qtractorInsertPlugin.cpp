@@ -1,7 +1,7 @@
 // qtractorInsertPlugin.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
    Copyright (C) 2011, Holger Dehnhardt.
 
    This program is free software; you can redistribute it and/or
@@ -27,170 +27,39 @@
 #include "qtractorSession.h"
 #include "qtractorSessionCursor.h"
 #include "qtractorAudioEngine.h"
+#include "qtractorAudioKernel.h"
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiManager.h"
 
 #include "qtractorPluginListView.h"
 
 
-#if defined(__SSE__)
-
-#include <xmmintrin.h>
-
-// SSE detection.
-static inline bool sse_enabled (void)
-{
-#if defined(__GNUC__)
-	unsigned int eax, ebx, ecx, edx;
-#if defined(__x86_64__) || (!defined(PIC) && !defined(__PIC__))
-	__asm__ __volatile__ (
-		"cpuid\n\t" \
-		: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#else
-	__asm__ __volatile__ (
-		"push %%ebx\n\t" \
-		"cpuid\n\t" \
-		"movl %%ebx,%1\n\t" \
-		"pop %%ebx\n\t" \
-		: "=a" (eax), "=r" (ebx), "=c" (ecx), "=d" (edx) \
-		: "a" (1) : "cc");
-#endif
-	return (edx & (1 << 25));
-#else
-	return false;
-#endif
-}
-
-// SSE enabled processor versions.
-static inline void sse_process_gain (
+// Multi-channel processors.
+static inline void process_gain (
 	float **ppFrames, unsigned int iFrames,
 	unsigned short iChannels, float fGain )
 {
-	__m128 v0 = _mm_load_ps1(&fGain);
-
-	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pFrames = ppFrames[i];
-		unsigned int nframes = iFrames;
-		for (; (long(pFrames) & 15) && (nframes > 0); --nframes)
-			*pFrames++ *= fGain;	
-		for (; nframes >= 4; nframes -= 4) {
-			_mm_store_ps(pFrames,
-				_mm_mul_ps(
-					_mm_loadu_ps(pFrames), v0
-				)
-			);
-			pFrames += 4;
-		}
-		for (; nframes > 0; --nframes)
-			*pFrames++ *= fGain;
-	}
-}
-
-static inline void sse_process_dry_wet (
-	float **ppBuffer, float **ppFrames, unsigned int iFrames,
-	unsigned short iChannels, float fDry, float fWet )
-{
-	__m128 v0 = _mm_load_ps1(&fDry);
-	__m128 v1 = _mm_load_ps1(&fWet);
-
-	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[i];
-		float *pFrames = ppFrames[i];
-		unsigned int nframes = iFrames;
-		for (; (long(pBuffer) & 15) && (nframes > 0); --nframes) {
-			*pBuffer   *= fWet;
-			*pBuffer++ += fDry * *pFrames++;
-		}
-		for (; nframes >= 4; nframes -= 4) {
-			_mm_store_ps(pBuffer,
-				_mm_mul_ps(
-					_mm_loadu_ps(pBuffer), v1
-				)
-			);
-			_mm_store_ps(pBuffer,
-				_mm_add_ps(
-					_mm_loadu_ps(pBuffer),
-					_mm_mul_ps(
-						_mm_loadu_ps(pFrames), v0)
-					)
-			);
-			pFrames += 4;
-			pBuffer += 4;
-		}
-		for (; nframes > 0; --nframes) {
-			*pBuffer   *= fWet;
-			*pBuffer++ += fDry * *pFrames++;
-		}
-	}
-}
-
-static inline void sse_process_add (
-	float **ppBuffer, float **ppFrames, unsigned int iFrames,
-	unsigned short iChannels, float fGain )
-{
-	__m128 v0 = _mm_load_ps1(&fGain);
-
-	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[i];
-		float *pFrames = ppFrames[i];
-		unsigned int nframes = iFrames;
-		for (; (long(pBuffer) & 15) && (nframes > 0); --nframes)
-			*pBuffer++ += fGain * *pFrames++;
-		for (; nframes >= 4; nframes -= 4) {
-			_mm_store_ps(pBuffer,
-				_mm_add_ps(
-					_mm_loadu_ps(pBuffer),
-					_mm_mul_ps(
-						_mm_loadu_ps(pFrames), v0)
-					)
-			);
-			pFrames += 4;
-			pBuffer += 4;
-		}
-		for (; nframes > 0; --nframes)
-			*pBuffer++ += fGain * *pFrames++;
-	}
-}
-
-#endif
-
-
-// Standard processor versions.
-static inline void std_process_gain (
-	float **ppFrames, unsigned int iFrames,
-	unsigned short iChannels, float fGain )
-{
-	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pFrames = ppFrames[i];
-		for (unsigned int n = 0; n < iFrames; ++n)
-			*pFrames++ *= fGain;
-	}
+	for (unsigned short i = 0; i < iChannels; ++i)
+		qtractorAudioKernel::gain(ppFrames[i], iFrames, fGain);
 }
 
-static inline void std_process_dry_wet (
-	float **ppBuffer, float **ppFrames, unsigned int iFrames,
+static inline void process_dry_wet (
+	float **ppDry, float **ppWet, unsigned int iFrames,
 	unsigned short iChannels, float fDry, float fWet )
 {
 	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[i];
-		float *pFrames = ppFrames[i];
-		for (unsigned int n = 0; n < iFrames; ++n) {
-			*pBuffer   *= fWet;
-			*pBuffer++ += fDry * *pFrames++;
-		}
+		qtractorAudioKernel::dry_wet(
+			ppDry[i], ppWet[i], iFrames, fDry, fWet);
 	}
 }
 
-static inline void std_process_add (
+static inline void process_add (
 	float **ppBuffer, float **ppFrames, unsigned int iFrames,
 	unsigned short iChannels, float fGain )
 {
 	for (unsigned short i = 0; i < iChannels; ++i) {
-		float *pBuffer = ppBuffer[i];
-		float *pFrames = ppFrames[i];
-		for (unsigned int n = 0; n < iFrames; ++n)
-			*pBuffer++ += fGain * *pFrames++;
+		qtractorAudioKernel::add_gain(
+			ppBuffer[i], ppFrames[i], iFrames, fGain);
 	}
 }
 
@@ -260,6 +129,7 @@ bool qtractorAudioInsertPluginType::open (void)
 	// Cache flags.
 	m_bRealtime  = true;
 	m_bConfigure = true;
+	m_bInPlace   = true;
 
 	// Done.
 	return true;
@@ -322,6 +192,7 @@ bool qtractorMidiInsertPluginType::open (void)
 	// Cache flags.
 	m_bRealtime  = true;
 	m_bConfigure = true;
+	m_bInPlace   = true;
 
 	// Done.
 	return true;
@@ -362,19 +233,6 @@ qtractorAudioInsertPlugin::qtractorAudioInsertPlugin (
 		this, pInsertType->channels());
 #endif
 
-	// Custom optimized processors.
-#if defined(__SSE__)
-	if (sse_enabled()) {
-		m_pfnProcessGain = sse_process_gain;
-		m_pfnProcessDryWet = sse_process_dry_wet;
-	} else {
-#endif
-	m_pfnProcessGain = std_process_gain;
-	m_pfnProcessDryWet = std_process_dry_wet;
-#if defined(__SSE__)
-	}
-#endif
-
 	// Create and attach the custom parameters...
 	m_pSendGainParam = new qtractorInsertPluginParam(this, 0);
 	m_pSendGainParam->setName(QObject::tr("Send Gain"));
@@ -527,15 +385,18 @@ void qtractorAudioInsertPlugin::process (
 
 	for (unsigned short i = 0; i < iChannels; ++i) {
 		::memcpy(ppOut[i], ppIBuffer[i], nframes * sizeof(float));
-		::memcpy(ppOBuffer[i], ppIn[i], nframes * sizeof(float));
+		if (ppOBuffer[i] != ppIBuffer[i])
+			::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
 	}
 
 	const float fGain = m_pSendGainParam->value();
-	(*m_pfnProcessGain)(ppOut, nframes, iChannels, fGain);
+	process_gain(ppOut, nframes, iChannels, fGain);
 
+	// Output (dry) buffer may be the very same as input (in-place)...
 	const float fDry = m_pDryGainParam->value();
 	const float fWet = m_pWetGainParam->value();
-	(*m_pfnProcessDryWet)(ppOBuffer, ppIBuffer, nframes, iChannels, fDry, fWet);
+	// Dry: the output copy of the input; wet: the insert returns.
+	process_dry_wet(ppOBuffer, ppIn, nframes, iChannels, fDry, fWet);
 
 //	m_pAudioBus->process_commit(nframes);
 }
@@ -843,8 +704,10 @@ void qtractorMidiInsertPlugin::process (
 	}
 
 	const unsigned short iChannels = channels();
-	for (unsigned short i = 0; i < iChannels; ++i)
-		::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		if (ppOBuffer[i] != ppIBuffer[i])
+			::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	}
 }
 
 
@@ -1014,6 +877,7 @@ bool qtractorAudioAuxSendPluginType::open (void)
 	// Cache flags.
 	m_bRealtime  = true;
 	m_bConfigure = true;
+	m_bInPlace   = true;
 
 	// Done.
 	return true;
@@ -1076,6 +940,7 @@ bool qtractorMidiAuxSendPluginType::open (void)
 	// Cache flags.
 	m_bRealtime  = true;
 	m_bConfigure = true;
+	m_bInPlace   = true;
 
 	// Done.
 	return true;
@@ -1116,17 +981,6 @@ qtractorAudioAuxSendPlugin::qtractorAudioAuxSendPlugin (
 		this, pAuxSendType->channels());
 #endif
 
-	// Custom optimized processors.
-#if defined(__SSE__)
-	if (sse_enabled()) {
-		m_pfnProcessAdd = sse_process_add;
-	} else {
-#endif
-		m_pfnProcessAdd = std_process_add;
-#if defined(__SSE__)
-	}
-#endif
-
 	// Create and attach the custom parameters...
 	m_pSendGainParam = new qtractorInsertPluginParam(this, 0);
 	m_pSendGainParam->setName(QObject::tr("Send Gain"));
@@ -1282,11 +1136,13 @@ void qtractorAudioAuxSendPlugin::process (
 
 	const unsigned short iChannels = channels();
 
-	for (unsigned short i = 0; i < iChannels; ++i)
-		::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		if (ppOBuffer[i] != ppIBuffer[i])
+			::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	}
 
 	const float fGain = m_pSendGainParam->value();
-	(*m_pfnProcessAdd)(ppOut, ppOBuffer, nframes, iChannels, fGain);
+	process_add(ppOut, ppOBuffer, nframes, iChannels, fGain);
 
 //	m_pAudioBus->process_commit(nframes);
 }
@@ -1295,12 +1151,14 @@ void qtractorAudioAuxSendPlugin::process (
 // Do the actual activation.
 void qtractorAudioAuxSendPlugin::activate (void)
 {
+	list()->setAudioAuxSendActivated(true);
 }
 
 
 // Do the actual deactivation.
 void qtractorAudioAuxSendPlugin::deactivate (void)
 {
+	list()->setAudioAuxSendActivated(false);
 }
 
 
@@ -1534,8 +1392,10 @@ void qtractorMidiAuxSendPlugin::process (
 	}
 
 	const unsigned short iChannels = channels();
-	for (unsigned short i = 0; i < iChannels; ++i)
-		::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		if (ppOBuffer[i] != ppIBuffer[i])
+			::memcpy(ppOBuffer[i], ppIBuffer[i], nframes * sizeof(float));
+	}
 }
 
 
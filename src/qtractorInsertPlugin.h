@@ -1,7 +1,7 @@
 // qtractorInsertPlugin.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
    Copyright (C) 2011, Holger Dehnhardt.
 
    This program is free software; you can redistribute it and/or
@@ -178,12 +178,6 @@ private:
 	qtractorInsertPluginParam *m_pSendGainParam;
 	qtractorInsertPluginParam *m_pDryGainParam;
 	qtractorInsertPluginParam *m_pWetGainParam;
-
-	// Custom optimized processors.
-	void (*m_pfnProcessGain)(float **, unsigned int,
-		unsigned short, float);
-	void (*m_pfnProcessDryWet)(float **, float **, unsigned int,
-		unsigned short, float, float);
 };
 
 
@@ -363,10 +357,6 @@ private:
 	QString           m_sAudioBusName;
 
 	qtractorInsertPluginParam *m_pSendGainParam;
-
-	// Custom optimized processors.
-	void (*m_pfnProcessAdd)(float **, float **, unsigned int,
-		unsigned short, float);
 };
 
 
@@ -1,7 +1,7 @@
 // qtractorLadspaPlugin.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -86,6 +86,7 @@ bool qtractorLadspaPluginType::open (void)
 
 	// Cache flags.
 	m_bRealtime = LADSPA_IS_HARD_RT_CAPABLE(m_pLadspaDescriptor->Properties);
+	m_bInPlace  = !LADSPA_IS_INPLACE_BROKEN(m_pLadspaDescriptor->Properties);
 
 	// Done.
 	return true;
@@ -456,10 +457,11 @@ void qtractorLadspaPlugin::process (
 		}
 		// Make it run...
 		(*pLadspaDescriptor->run)(handle, nframes);
-		// Wrap dangling output channels?...
-		for (j = iOChannel; j < iChannels; ++j)
-			::memset(ppOBuffer[j], 0, nframes * sizeof(float));
 	}
+
+	// Wrap dangling output channels?...
+	for (j = iOChannel; j < iChannels; ++j)
+		::memset(ppOBuffer[j], 0, nframes * sizeof(float));
 }
 
 
@@ -59,6 +59,10 @@ public:
 	// Reset method.
 	void clear();
 
+	// Forget all items at once, without unlinking nor
+	// deleting any (caller takes over the whole chain).
+	Node *detach();
+
 	// Random accessors.
 	Node *at (int iNode) const;
 
@@ -270,6 +274,19 @@ void qtractorList<Node>::clear (void)
 }
 
 
+// Detach method.
+template <class Node>
+Node *qtractorList<Node>::detach (void)
+{
+	Node *pFirst = m_pFirst;
+
+	m_pFirst = m_pLast = 0;
+	m_iCount = 0;
+
+	return pFirst;
+}
+
+
 // Random accessor.
 template <class Node>
 Node *qtractorList<Node>::at ( int iNode ) const
@@ -947,6 +947,7 @@ static LilvNode *g_lv2_qt5_ui_class = NULL;
 
 // Supported plugin features.
 static LilvNode *g_lv2_realtime_hint = NULL;
+static LilvNode *g_lv2_inplace_broken_hint = NULL;
 static LilvNode *g_lv2_extension_data_hint = NULL;
 
 #ifdef CONFIG_LV2_WORKER
@@ -1522,6 +1523,7 @@ bool qtractorLv2PluginType::open (void)
 
 	// Cache flags.
 	m_bRealtime = lilv_plugin_has_feature(m_lv2_plugin, g_lv2_realtime_hint);
+	m_bInPlace  = !lilv_plugin_has_feature(m_lv2_plugin, g_lv2_inplace_broken_hint);
 
 	m_bConfigure = false;
 #ifdef CONFIG_LV2_STATE
@@ -1724,6 +1726,8 @@ void qtractorLv2PluginType::lv2_open (void)
 	// Set up the feature we may want to know (as hints).
 	g_lv2_realtime_hint = lilv_new_uri(g_lv2_world,
 		LV2_CORE__hardRTCapable);
+	g_lv2_inplace_broken_hint = lilv_new_uri(g_lv2_world,
+		LV2_CORE__inPlaceBroken);
 	g_lv2_extension_data_hint = lilv_new_uri(g_lv2_world,
 		LV2_CORE__extensionData);
 
@@ -1919,6 +1923,7 @@ void qtractorLv2PluginType::lv2_close (void)
 #endif
 
 	lilv_node_free(g_lv2_extension_data_hint);
+	lilv_node_free(g_lv2_inplace_broken_hint);
 	lilv_node_free(g_lv2_realtime_hint);
 
 	lilv_node_free(g_lv2_input_class);
@@ -1983,6 +1988,7 @@ void qtractorLv2PluginType::lv2_close (void)
 #endif
 
 	g_lv2_extension_data_hint = NULL;
+	g_lv2_inplace_broken_hint = NULL;
 	g_lv2_realtime_hint = NULL;
 
 	g_lv2_input_class   = NULL;
@@ -3010,12 +3016,13 @@ void qtractorLv2Plugin::process (
 		#endif	// CONFIG_LV2_ATOM
 			// Make it run...
 			lilv_instance_run(instance, nframes);
-			// Wrap dangling output channels?...
-			for (j = iOChannel; j < iChannels; ++j)
-				::memset(ppOBuffer[j], 0, nframes * sizeof(float));
 		}
 	}
 
+	// Wrap dangling output channels?...
+	for (j = iOChannel; j < iChannels; ++j)
+		::memset(ppOBuffer[j], 0, nframes * sizeof(float));
+
 #ifdef CONFIG_LV2_WORKER
 	if (m_lv2_worker)
 		m_lv2_worker->commit();
@@ -38,6 +38,7 @@
 #include "qtractorSpinBox.h"
 
 #include "qtractorAudioPeak.h"
+#include "qtractorAudioCache.h"
 #include "qtractorAudioBuffer.h"
 #include "qtractorAudioEngine.h"
 #include "qtractorMidiEngine.h"
@@ -80,6 +81,11 @@
 
 #include "qtractorMessageList.h"
 
+#include "qtractorRenderStats.h"
+#include "qtractorRenderBench.h"
+#include "qtractorDspLoad.h"
+#include "qtractorXrunTrace.h"
+
 #include "qtractorPluginFactory.h"
 
 #ifdef CONFIG_DSSI
@@ -122,6 +128,7 @@
 #include <QDateTime>
 #include <QClipboard>
 #include <QProgressBar>
+#include <QTextStream>
 
 #include <QColorDialog>
 
@@ -299,6 +306,18 @@ qtractorMainForm::qtractorMainForm (
 		QObject::connect(pPeakFactory,
 			SIGNAL(peakEvent()),
 			SLOT(peakNotify()));
+		QObject::connect(pPeakFactory,
+			SIGNAL(peakProgress(const QString&, int)),
+			SLOT(peakProgress(const QString&, int)));
+	}
+
+	// Configure the audio cache file factory...
+	qtractorAudioCacheFactory *pCacheFactory
+		= m_pSession->audioCacheFactory();
+	if (pCacheFactory) {
+		QObject::connect(pCacheFactory,
+			SIGNAL(cacheEvent(const QString&)),
+			SLOT(cacheNotify(const QString&)));
 	}
 
 	// Configure the audio engine event handling...
@@ -877,6 +896,9 @@ qtractorMainForm::qtractorMainForm (
 	QObject::connect(m_ui.trackAutoMonitorAction,
 		SIGNAL(triggered(bool)),
 		SLOT(trackAutoMonitor(bool)));
+	QObject::connect(m_ui.trackFreezeAction,
+		SIGNAL(triggered(bool)),
+		SLOT(trackFreeze(bool)));
 	QObject::connect(m_ui.trackImportAudioAction,
 		SIGNAL(triggered(bool)),
 		SLOT(trackImportAudio()));
@@ -1482,6 +1504,15 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 	qtractorAudioBuffer::setResampleType(m_pOptions->iAudioResampleType);
 	qtractorAudioBuffer::setWsolaTimeStretch(m_pOptions->bAudioWsolaTimeStretch);
 	qtractorAudioBuffer::setWsolaQuickSeek(m_pOptions->bAudioWsolaQuickSeek);
+	qtractorAudioBuffer::setWsolaFftSeek(m_pOptions->bAudioWsolaFftSeek);
+	// Set maximum audio-buffer read-ahead workers...
+	qtractorAudioBufferThread::setSyncWorkers(m_pOptions->iAudioSyncWorkers);
+	// Set track-freeze plugin-chain tail render time...
+	qtractorTrackFreezeCommand::setTailTime(m_pOptions->iAudioFreezeTailTime);
+	qtractorAudioCacheFactory::setEnabled(m_pOptions->bAudioDecodeCache);
+	qtractorAudioCacheFactory::setStretchEnabled(m_pOptions->bAudioStretchCache);
+	qtractorDspLoad::setEnabled(m_pOptions->bAudioDspLoad);
+	qtractorXrunTrace::setEnabled(m_pOptions->bAudioXrunTrace);
 
 	// Load (action) keyboard shortcuts...
 	m_pOptions->loadActionShortcuts(this);
@@ -1492,8 +1523,18 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 
 	// Some special defaults...
 	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
-	if (pAudioEngine)
+	if (pAudioEngine) {
 		pAudioEngine->setMasterAutoConnect(m_pOptions->bAudioMasterAutoConnect);
+		pAudioEngine->setGraphThreads(m_pOptions->iAudioGraphThreads);
+		pAudioEngine->setOfflineExport(m_pOptions->bAudioOfflineExport);
+		pAudioEngine->setDummyDriver(
+			m_pOptions->bAudioDummyDriver || m_pOptions->bDummyDriver);
+		pAudioEngine->setDummySampleRate(m_pOptions->iAudioDummySampleRate);
+		pAudioEngine->setDummyBufferSize(m_pOptions->iAudioDummyBufferSize);
+		pAudioEngine->setDummyRealTime(m_pOptions->bAudioDummyRealTime);
+		pAudioEngine->setAutomationFrames(m_pOptions->iAudioAutomationFrames);
+		pAudioEngine->setPluginIdleTime(m_pOptions->iAudioPluginIdleTime);
+	}
 	
 	// Final widget slot connections....
 	QObject::connect(m_pFiles->toggleViewAction(),
@@ -1603,8 +1644,9 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 				m_pOptions->sSessionDir.clear();
 			}
 		}
-		// Open up with a new empty session...
-		if (!autoSaveOpen())
+		// Open up with a new empty session
+		// (no crash-recovery when benchmarking)...
+		if (m_pOptions->iBenchCycles > 0 || !autoSaveOpen())
 			newSession();
 	}
 
@@ -1615,6 +1657,171 @@ void qtractorMainForm::setup ( qtractorOptions *pOptions )
 }
 
 
+// Headless command line render (export).
+bool qtractorMainForm::renderSession (void)
+{
+	if (m_pOptions == NULL || m_pSession == NULL)
+		return false;
+
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+
+	const QString& sRenderFile = m_pOptions->sRenderFile;
+	if (sRenderFile.isEmpty())
+		return false;
+
+	// Startup session file is only cleared when loaded...
+	if (!m_pOptions->sSessionFile.isEmpty()) {
+		err << tr("Render: session \"%1\" could not be loaded.")
+			.arg(m_pOptions->sSessionFile) << '\n';
+		return false;
+	}
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL || !pAudioEngine->isActivated()) {
+		err << tr("Render: audio engine is not activated.") << '\n';
+		return false;
+	}
+
+	// Render the first (master) output bus...
+	qtractorAudioBus *pRenderBus = NULL;
+	for (qtractorBus *pBus = pAudioEngine->buses().first();
+			pBus && pRenderBus == NULL; pBus = pBus->next()) {
+		if (pBus->busMode() & qtractorBus::Output)
+			pRenderBus = static_cast<qtractorAudioBus *> (pBus);
+	}
+	if (pRenderBus == NULL) {
+		err << tr("Render: no audio output bus.") << '\n';
+		return false;
+	}
+
+	QList<qtractorAudioBus *> renderBuses;
+	renderBuses.append(pRenderBus);
+
+	// Render range (default: whole session)...
+	const float fSampleRate = float(m_pSession->sampleRate());
+	const unsigned long iRenderStart
+		= (unsigned long) (m_pOptions->fRenderStart * fSampleRate);
+	const unsigned long iRenderEnd
+		= (unsigned long) (m_pOptions->fRenderEnd * fSampleRate);
+
+	// Render timing statistics, if asked...
+	qtractorRenderStats *pRenderStats = NULL;
+	if (m_pOptions->bRenderStats) {
+		pRenderStats = new qtractorRenderStats(m_pSession);
+		pRenderStats->reset();
+		qtractorRenderStats::setInstance(pRenderStats);
+		pRenderStats->start();
+	}
+
+	out << tr("Render: \"%1\" (%2) started...")
+		.arg(sRenderFile).arg(pRenderBus->busName()) << '\n';
+	out.flush();
+
+	const bool bResult = pAudioEngine->fileExport(
+		sRenderFile, renderBuses, iRenderStart, iRenderEnd);
+
+	if (pRenderStats) {
+		pRenderStats->stop();
+		qtractorRenderStats::setInstance(NULL);
+	}
+
+	if (bResult) {
+		out << tr("Render: \"%1\" complete.").arg(sRenderFile) << '\n';
+		if (pRenderStats)
+			pRenderStats->report(out);
+	} else {
+		err << tr("Render: \"%1\" failed.").arg(sRenderFile) << '\n';
+	}
+
+	if (pRenderStats)
+		delete pRenderStats;
+
+	return bResult;
+}
+
+
+// Whether running headless (render or benchmark).
+bool qtractorMainForm::isHeadless (void) const
+{
+	return (m_pOptions && (m_pOptions->iBenchCycles > 0
+		|| !m_pOptions->sRenderFile.isEmpty()));
+}
+
+
+// Headless command line synthetic session benchmark.
+bool qtractorMainForm::benchSession (void)
+{
+	if (m_pOptions == NULL || m_pSession == NULL)
+		return false;
+
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+
+	if (m_pOptions->iBenchCycles < 1)
+		return false;
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL || !pAudioEngine->isActivated()) {
+		err << tr("Bench: audio engine is not activated.") << '\n';
+		return false;
+	}
+
+	QString sBenchFile = m_pOptions->sBenchFile;
+	if (sBenchFile.isEmpty())
+		sBenchFile = QFileInfo("qtractor-bench.json").absoluteFilePath();
+
+	// All generated files go into a scratch directory...
+	const QString& sBenchDir = QDir::temp().absoluteFilePath(
+		QString("qtractor-bench-%1").arg(QCoreApplication::applicationPid()));
+
+	qtractorRenderBench bench(m_pSession,
+		m_pOptions->iBenchAudioTracks,
+		m_pOptions->iBenchMidiTracks,
+		m_pOptions->iBenchCycles);
+
+	out << tr("Bench: %1 audio, %2 MIDI tracks, %3 cycles...")
+		.arg(m_pOptions->iBenchAudioTracks)
+		.arg(m_pOptions->iBenchMidiTracks)
+		.arg(m_pOptions->iBenchCycles) << '\n';
+	out.flush();
+
+	bool bResult = bench.build(sBenchDir);
+	if (!bResult)
+		err << tr("Bench: could not build synthetic session.") << '\n';
+
+	if (bResult) {
+		bResult = bench.run();
+		if (!bResult)
+			err << tr("Bench: render failed.") << '\n';
+	}
+
+	// Time-stretch search check (still reported if failed)...
+	bool bStretch = true;
+	if (bResult) {
+		bStretch = bench.stretch();
+		if (!bStretch)
+			err << tr("Bench: time-stretch block search is not bit-exact.") << '\n';
+	}
+
+	if (bResult) {
+		bench.report(out);
+		bResult = bench.save(sBenchFile);
+		if (bResult)
+			out << tr("Bench: \"%1\" saved.").arg(sBenchFile) << '\n';
+		else
+			err << tr("Bench: \"%1\" could not be saved.").arg(sBenchFile) << '\n';
+	}
+
+	// Leave no traces behind...
+	m_iDirtyCount = 0;
+	closeSession();
+	bench.clean();
+
+	return bResult && bStretch;
+}
+
+
 // LADISH Level 1 -- SIGUSR1 signal handler.
 void qtractorMainForm::handle_sigusr1 (void)
 {
@@ -2307,7 +2514,8 @@ bool qtractorMainForm::loadSessionFileEx (
 			info.setFile(info.path() + QDir::separator() + info.completeBaseName());
 			if (info.exists() && info.isDir()) {
 				bool bArchiveRemove = true;
-				bool bConfirmArchive = (m_pOptions && m_pOptions->bConfirmArchive);
+				bool bConfirmArchive = (m_pOptions
+					&& m_pOptions->bConfirmArchive && !isHeadless());
 				if (bConfirmArchive) {
 					const QString& sTitle
 						= tr("Warning") + " - " QTRACTOR_TITLE;
@@ -3729,6 +3937,37 @@ void qtractorMainForm::trackAutoMonitor ( bool bOn )
 }
 
 
+// Freeze (pre-render) current track.
+void qtractorMainForm::trackFreeze ( bool bOn )
+{
+	qtractorTrack *pTrack = NULL;
+	if (m_pTracks)
+		pTrack = m_pTracks->currentTrack();
+	if (pTrack == NULL)
+		return;
+
+#ifdef CONFIG_DEBUG
+	qDebug("qtractorMainForm::trackFreeze(%d)", int(bOn));
+#endif
+
+	// Freeze rendering might take a while...
+	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+
+	const bool bResult = m_pSession->execute(
+		new qtractorTrackFreezeCommand(pTrack, bOn));
+
+	QApplication::restoreOverrideCursor();
+
+	if (!bResult && bOn) {
+		appendMessagesError(
+			tr("Track could not be frozen:\n\n\"%1\".\n\nSorry.")
+			.arg(pTrack->trackName()));
+	}
+
+	stabilizeForm();
+}
+
+
 // Import some tracks from Audio file.
 void qtractorMainForm::trackImportAudio (void)
 {
@@ -6453,6 +6692,12 @@ void qtractorMainForm::updatePeakAutoRemove (void)
 		= m_pSession->audioPeakFactory();
 	if (pPeakFactory)
 		pPeakFactory->setAutoRemove(m_pOptions->bPeakAutoRemove);
+
+	// Decoded-PCM cache files follow the very same fate...
+	qtractorAudioCacheFactory *pCacheFactory
+		= m_pSession->audioCacheFactory();
+	if (pCacheFactory)
+		pCacheFactory->setAutoRemove(m_pOptions->bPeakAutoRemove);
 }
 
 
@@ -6746,6 +6991,9 @@ void qtractorMainForm::updateTrackMenu (void)
 //	m_ui.trackAutoMonitorAction->setEnabled(m_pTracks != NULL);
 	m_ui.trackInstrumentMenu->setEnabled(
 		bEnabled && pTrack->trackType() == qtractorTrack::Midi);
+	m_ui.trackFreezeAction->setEnabled(
+		bEnabled && pTrack->trackType() == qtractorTrack::Audio
+		&& !bPlaying && !pTrack->isRecord());
 
 	// Update track menu state...
 	if (bEnabled) {
@@ -6753,6 +7001,7 @@ void qtractorMainForm::updateTrackMenu (void)
 		m_ui.trackStateMuteAction->setChecked(pTrack->isMute());
 		m_ui.trackStateSoloAction->setChecked(pTrack->isSolo());
 		m_ui.trackStateMonitorAction->setChecked(pTrack->isMonitor());
+		m_ui.trackFreezeAction->setChecked(pTrack->isFrozen());
 	}
 }
 
@@ -7160,12 +7409,18 @@ void qtractorMainForm::appendMessagesText( const QString& s )
 
 void qtractorMainForm::appendMessagesError( const QString& s )
 {
-	if (m_pMessages)
+	const bool bHeadless = isHeadless();
+
+	if (m_pMessages && !bHeadless)
 		m_pMessages->show();
 
 	appendMessagesColor(s.simplified(), "#ff0000");
 
-	QMessageBox::critical(this, tr("Error") + " - " QTRACTOR_TITLE, s);
+	// No one to acknowledge a modal dialog when headless...
+	if (bHeadless)
+		QTextStream(stderr) << tr("Error: %1").arg(s.simplified()) << '\n';
+	else
+		QMessageBox::critical(this, tr("Error") + " - " QTRACTOR_TITLE, s);
 }
 
 
@@ -7440,6 +7695,7 @@ void qtractorMainForm::timerSlot (void)
 	if ( m_iPeakTimer  > 0 &&
 		(m_iPeakTimer -= QTRACTOR_TIMER_MSECS) < 0) {
 		 m_iPeakTimer  = 0;
+		m_pTracks->trackView()->clearTiles();
 		m_pTracks->trackView()->updateContents();
 	}
 
@@ -7460,6 +7716,23 @@ void qtractorMainForm::timerSlot (void)
 		appendMessagesColor(
 			tr("XRUN(%1): some frames might have been lost.")
 			.arg(m_iXrunCount), "#cc0033");
+		// Dump the (frozen) process cycle trace, if any...
+		qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+		if (pXrunTrace && pXrunTrace->isFrozen()) {
+			QStringListIterator iter(
+				pXrunTrace->summary(m_pSession->sampleRate()));
+			while (iter.hasNext())
+				appendMessagesColor(iter.next(), "#cc0033");
+			QString sTraceDir = m_pSession->sessionDir();
+			if (sTraceDir.isEmpty() || !QDir(sTraceDir).exists())
+				sTraceDir = QDir::tempPath();
+			const QString& sTraceFile = QDir(sTraceDir).absoluteFilePath(
+				QString("qtractor-xrun-%1.log").arg(QDateTime::currentDateTime()
+					.toString("yyyyMMdd-hhmmss")));
+			if (pXrunTrace->save(sTraceFile, m_pSession))
+				appendMessages(tr("XRUN trace: saved to \"%1\".").arg(sTraceFile));
+			pXrunTrace->thaw();
+		}
 		// Let the XRUN status item get an update...
 		stabilizeForm();
 	}
@@ -7566,6 +7839,27 @@ void qtractorMainForm::peakNotify (void)
 }
 
 
+// Audio file peak creation progress slot.
+void qtractorMainForm::peakProgress ( const QString& sFilename, int iPercent )
+{
+	qtractorAudioPeakFactory *pPeakFactory
+		= m_pSession->audioPeakFactory();
+	const int iPending = (pPeakFactory ? pPeakFactory->syncPending() : 0);
+
+	statusBar()->showMessage(tr("Peak file %1: %2% (%3 pending)")
+		.arg(QFileInfo(sFilename).fileName())
+		.arg(iPercent).arg(iPending), 3000);
+}
+
+
+// Audio cache file ready notification slot.
+void qtractorMainForm::cacheNotify ( const QString& sCachePath )
+{
+	// Switch any playing clips over to it...
+	m_pSession->updateAudioCache(sCachePath);
+}
+
+
 // ALSA sequencer notification slot.
 void qtractorMainForm::alsaNotify (void)
 {
@@ -7674,6 +7968,9 @@ void qtractorMainForm::audioBuffNotify ( unsigned int iBufferSize )
 	m_pSession->shutdown();
 	m_pConnections->clear();
 
+	// Audio clips fades gain envelopes must grow too...
+	m_pSession->updateBufferSize(iBufferSize);
+
 	// HACK: Done.
 	m_pSession->unlock();
 
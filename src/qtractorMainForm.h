@@ -85,6 +85,15 @@ public:
 
 	void setup(qtractorOptions *pOptions);
 
+	// Headless command line render (export).
+	bool renderSession();
+
+	// Headless command line synthetic session benchmark.
+	bool benchSession();
+
+	// Whether running headless (render or benchmark).
+	bool isHeadless() const;
+
 	qtractorTracks *tracks() const;
 	qtractorFiles *files() const;
 	qtractorConnections *connections() const;
@@ -178,6 +187,7 @@ public slots:
 	void trackHeightDown();
 	void trackHeightReset();
 	void trackAutoMonitor(bool bOn);
+	void trackFreeze(bool bOn);
 	void trackImportAudio();
 	void trackImportMidi();
 	void trackExportAudio();
@@ -295,6 +305,8 @@ protected slots:
 	void timerSlot();
 
 	void peakNotify();
+	void peakProgress(const QString& sFilename, int iPercent);
+	void cacheNotify(const QString& sCachePath);
 	void alsaNotify();
 
 	void audioShutNotify();
@@ -26,6 +26,7 @@
 
 #include "qtractorSession.h"
 #include "qtractorSessionCursor.h"
+#include "qtractorSessionSnapshot.h"
 
 #include "qtractorDocument.h"
 
@@ -517,6 +518,7 @@ qtractorSessionCursor *qtractorMidiOutputThread::midiCursorSync ( bool bStart )
 
 	// Can MIDI be ever behind audio?
 	if (bStart) {
+		pMidiCursor->sync((m_pMidiEngine->session())->snapshot());
 		pMidiCursor->seek(pAudioCursor->frame());
 	//	pMidiCursor->setFrameTime(pAudioCursor->frameTime());
 	}
@@ -573,6 +575,10 @@ void qtractorMidiOutputThread::process (void)
 	if (pMidiCursor == NULL)
 		return;
 
+	// Current track topology snapshot...
+	pMidiCursor->sync(
+		pSession->enterSnapshot(qtractorSession::MidiOutputReader));
+
 	// Free overriden SysEx queued events.
 	m_pMidiEngine->clearSysexCache();
 
@@ -620,6 +626,9 @@ void qtractorMidiOutputThread::process (void)
 	// Flush the MIDI engine output queue...
 	snd_seq_drain_output(m_pMidiEngine->alsaSeq());
 
+	// Done with current track topology...
+	pSession->leaveSnapshot(qtractorSession::MidiOutputReader);
+
 	// Always do the queue drift stats
 	// at the bottom of the pack...
 	m_pMidiEngine->driftCheck();
@@ -1769,8 +1778,11 @@ void qtractorMidiEngine::capture ( snd_seq_event_t *pEv )
 	}
 #endif
 	// Now check which bus and track we're into...
-	for (qtractorTrack *pTrack = pSession->tracks().first();
-			pTrack; pTrack = pTrack->next()) {
+	qtractorSessionSnapshot *pSnapshot
+		= pSession->enterSnapshot(qtractorSession::MidiInputReader);
+	const unsigned int iTracks = pSnapshot->tracks();
+	for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+		qtractorTrack *pTrack = pSnapshot->track(iTrack);
 		// Must be a MIDI track...
 		if (pTrack->trackType() != qtractorTrack::Midi)
 			continue;
@@ -1850,6 +1862,7 @@ void qtractorMidiEngine::capture ( snd_seq_event_t *pEv )
 			}
 		}
 	}
+	pSession->leaveSnapshot(qtractorSession::MidiInputReader);
 
 	// MIDI Bus monitoring...
 	qtractorMidiBus *pMidiBus = m_inputBuses.value(iAlsaPort, NULL);
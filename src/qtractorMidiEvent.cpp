@@ -0,0 +1,233 @@
+// qtractorMidiEvent.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorMidiEvent.h"
+
+#include "qtractorAtomic.h"
+
+#include <QThread>
+
+#include <new>
+
+#include <stdlib.h>
+#include <time.h>
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiEventPool -- MIDI event slab allocator.
+//
+
+// Pool node: either a live event or a free list link.
+union qtractorMidiEventNode
+{
+	qtractorMidiEventNode *next;
+	unsigned char data[sizeof(qtractorMidiEvent)];
+	unsigned long align;
+};
+
+// Pool slab.
+struct qtractorMidiEventSlab
+{
+	qtractorMidiEventSlab *next;
+	qtractorMidiEventNode  nodes[qtractorMidiEventPool::SlabSize];
+};
+
+
+// Pool state (all guarded by the spin-lock).
+static qtractorMidiEventSlab *g_pSlabs    = NULL;
+static qtractorMidiEventNode *g_pFreeList = NULL;
+
+static unsigned int  g_iSlabs  = 0;
+static unsigned long g_iEvents = 0;
+
+static qtractorAtomic g_lock;
+
+
+// Spin-lock helpers: back off when contended for long,
+// so that a (RT) thread never spins forever over a
+// lower priority lock holder on the same core.
+static inline void pool_lock (void)
+{
+	unsigned int iSpin = 0;
+	while (!ATOMIC_TAS(&g_lock)) {
+		if (++iSpin < 64)
+			continue;
+		if (iSpin < 256) {
+			QThread::yieldCurrentThread();
+		} else {
+			struct timespec ts;
+			ts.tv_sec  = 0;
+			ts.tv_nsec = 20000L;
+			::nanosleep(&ts, NULL);
+		}
+	}
+}
+
+static inline void pool_unlock (void)
+{
+	ATOMIC_SET(&g_lock, 0);
+}
+
+
+// Node allocation.
+void *qtractorMidiEventPool::alloc (void)
+{
+	pool_lock();
+
+	qtractorMidiEventNode *pNode = g_pFreeList;
+	if (pNode) {
+		g_pFreeList = pNode->next;
+		++g_iEvents;
+	}
+
+	pool_unlock();
+
+	if (pNode)
+		return pNode;
+
+	// Grab a brand new slab, if none left
+	// (outside the lock, this is the slow path)...
+	qtractorMidiEventSlab *pSlab = static_cast<qtractorMidiEventSlab *> (
+		::malloc(sizeof(qtractorMidiEventSlab)));
+	if (pSlab == NULL)
+		return NULL;
+
+	// Chain nodes in address order,
+	// first one is kept for ourselves...
+	qtractorMidiEventNode *pLast = &pSlab->nodes[SlabSize - 1];
+	for (pNode = &pSlab->nodes[1]; pNode < pLast; ++pNode)
+		pNode->next = pNode + 1;
+
+	pool_lock();
+
+	pLast->next = g_pFreeList;
+	g_pFreeList = &pSlab->nodes[1];
+	pSlab->next = g_pSlabs;
+	g_pSlabs = pSlab;
+	++g_iSlabs;
+	++g_iEvents;
+
+	pool_unlock();
+
+	return &pSlab->nodes[0];
+}
+
+
+// Node release.
+void qtractorMidiEventPool::release ( void *pNode )
+{
+	if (pNode == NULL)
+		return;
+
+	pool_lock();
+
+	qtractorMidiEventNode *pFreeNode
+		= static_cast<qtractorMidiEventNode *> (pNode);
+	pFreeNode->next = g_pFreeList;
+	g_pFreeList = pFreeNode;
+	--g_iEvents;
+
+	pool_unlock();
+}
+
+
+// Bulk release of a whole (forward linked) event chain:
+// events are destroyed in place and their nodes chained
+// together, then spliced onto the free list in one go.
+void qtractorMidiEventPool::releaseList ( qtractorMidiEvent *pEvent )
+{
+	qtractorMidiEventNode *pFirst = NULL;
+	qtractorMidiEventNode *pLast  = NULL;
+	unsigned long iNodes = 0;
+
+	while (pEvent) {
+		qtractorMidiEvent *pNextEvent = pEvent->next();
+		pEvent->~qtractorMidiEvent();
+		qtractorMidiEventNode *pNode
+			= reinterpret_cast<qtractorMidiEventNode *> (pEvent);
+		if (pLast)
+			pLast->next = pNode;
+		else
+			pFirst = pNode;
+		pLast = pNode;
+		++iNodes;
+		pEvent = pNextEvent;
+	}
+
+	if (pFirst == NULL)
+		return;
+
+	pool_lock();
+
+	pLast->next = g_pFreeList;
+	g_pFreeList = pFirst;
+	g_iEvents -= iNodes;
+
+	pool_unlock();
+}
+
+
+// Pool statistics.
+unsigned int qtractorMidiEventPool::slabs (void)
+{
+	return g_iSlabs;
+}
+
+unsigned long qtractorMidiEventPool::events (void)
+{
+	return g_iEvents;
+}
+
+unsigned long qtractorMidiEventPool::bytes (void)
+{
+	return (unsigned long) g_iSlabs * sizeof(qtractorMidiEventSlab);
+}
+
+
+//----------------------------------------------------------------------
+// class qtractorMidiEvent -- The generic MIDI event element.
+//
+
+// Pooled allocation.
+void *qtractorMidiEvent::operator new ( size_t iSize )
+{
+	// Derived classes (if ever) would just go the usual way...
+	if (iSize != sizeof(qtractorMidiEvent))
+		return ::operator new(iSize);
+
+	void *pNode = qtractorMidiEventPool::alloc();
+	if (pNode == NULL)
+		throw std::bad_alloc();
+
+	return pNode;
+}
+
+void qtractorMidiEvent::operator delete ( void *pNode, size_t iSize )
+{
+	if (iSize != sizeof(qtractorMidiEvent))
+		::operator delete(pNode);
+	else
+		qtractorMidiEventPool::release(pNode);
+}
+
+
+// end of qtractorMidiEvent.cpp
@@ -1,7 +1,7 @@
 // qtractorMidiEvent.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2013, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -28,6 +28,46 @@
 #include <string.h>
 
 
+//----------------------------------------------------------------------
+// class qtractorMidiEventPool -- MIDI event slab allocator.
+//
+// All MIDI events are allocated from big fixed-size slabs, instead of
+// one heap node each: dense sequences then cost no allocator overhead
+// per event, events read in a row (eg. on file load) lay contiguously
+// in memory and clearing a whole sequence destroys its events in place
+// and splices them back onto the free list, all at once (releaseList).
+// Slabs are kept for reuse, never given back.
+// Events might be (de)allocated from any thread, so a (very short)
+// spin-lock is held while picking or returning nodes; new slabs are
+// allocated outside of it.
+// NOTE: the event record itself is unchanged (no compact form) and
+// SysEx payloads still get their own heap buffers (no side buffer).
+//
+
+class qtractorMidiEvent;
+
+class qtractorMidiEventPool
+{
+public:
+
+	// Slab size (events).
+	enum { SlabSize = 4096 };
+
+	// Node allocation and release.
+	static void *alloc();
+	static void release(void *pNode);
+
+	// Bulk release of a whole (forward linked) event chain.
+	static void releaseList(qtractorMidiEvent *pEvent);
+
+	// Pool statistics: number of slabs, events
+	// currently allocated and total memory held (bytes).
+	static unsigned int  slabs();
+	static unsigned long events();
+	static unsigned long bytes();
+};
+
+
 //----------------------------------------------------------------------
 // class qtractorMidiEvent -- The generic MIDI event element.
 //
@@ -99,6 +139,10 @@ public:
 	~qtractorMidiEvent()
 		{ if (m_type == SYSEX && m_u.pSysex) delete [] m_u.pSysex; }
 
+	// Pooled allocation (see qtractorMidiEventPool).
+	static void *operator new(size_t iSize);
+	static void operator delete(void *pNode, size_t iSize);
+
 	// Event properties accessors (getters).
 	unsigned long time()       const { return m_time; }
 	EventType     type()       const { return m_type; }
@@ -1,7 +1,7 @@
 // qtractorMidiManager.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -647,7 +647,7 @@ void qtractorMidiManager::process (
 			m_pAudioOutputBus->process_commit(nframes);
 		} else {
 			m_pAudioOutputBus->buffer_prepare(nframes);
-			m_pPluginList->process(m_pAudioOutputBus->buffer(), nframes);
+			m_pAudioOutputBus->buffer_process(m_pPluginList, nframes);
 			m_pAudioOutputBus->buffer_commit(nframes);
 		}
 	}
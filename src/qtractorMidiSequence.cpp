@@ -64,6 +64,8 @@ void qtractorMidiSequence::clear (void)
 
 	m_duration = 0;
 
+	// Release all events back to the pool, in one go...
+	qtractorMidiEventPool::releaseList(m_events.detach());
 	m_events.clear();
 	m_notes.clear();
 }
@@ -230,6 +232,7 @@ void qtractorMidiSequence::replaceEvents ( qtractorMidiSequence *pSeq,
 void qtractorMidiSequence::copyEvents ( qtractorMidiSequence *pSeq )
 {
 	// Remove existing events.
+	qtractorMidiEventPool::releaseList(m_events.detach());
 	m_events.clear();
 	
 	// Clone new ones...
@@ -23,6 +23,7 @@
 #include "qtractorMixer.h"
 
 #include "qtractorPluginListView.h"
+#include "qtractorPlugin.h"
 
 #include "qtractorAudioMeter.h"
 #include "qtractorMidiMeter.h"
@@ -292,6 +293,17 @@ void qtractorMixerStrip::initMixerStrip (void)
 	m_pPluginListView->setTinyScrollBar(true);
 	m_pLayout->addWidget(m_pPluginListView, 1);
 
+	m_pDspLoadLabel = new QLabel(/*this*/);
+	m_pDspLoadLabel->setFont(font3);
+	m_pDspLoadLabel->setFixedHeight(iFixedHeight);
+	m_pDspLoadLabel->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+	m_pDspLoadLabel->setAutoFillBackground(true);
+	m_pDspLoadLabel->setVisible(qtractorDspLoad::isEnabled());
+	m_pLayout->addWidget(m_pDspLoadLabel);
+
+	m_fDspLoad = 0.0f;
+	m_bDspLoadHeaviest = false;
+
 	const QSizePolicy buttonPolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
 
 	m_pButtonLayout = new QHBoxLayout(/*this*/);
@@ -723,6 +735,93 @@ void qtractorMixerStrip::setSelected ( bool bSelected )
 void qtractorMixerStrip::refresh (void)
 {
 	if (m_pMeter) m_pMeter->refresh();
+
+	updateDspLoad();
+}
+
+
+// DSP load meter refreshment.
+void qtractorMixerStrip::updateDspLoad (void)
+{
+	const bool bEnabled = qtractorDspLoad::isEnabled();
+	if (m_pDspLoadLabel->isVisible() != bEnabled)
+		m_pDspLoadLabel->setVisible(bEnabled);
+	if (!bEnabled)
+		return;
+
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession == NULL)
+		return;
+
+	const unsigned int iSampleRate = pSession->sampleRate();
+
+	// Plugin chain first...
+	float fPluginsLoad = 0.0f;
+	qtractorPluginList *pPluginList = m_pPluginListView->pluginList();
+	if (pPluginList) {
+		fPluginsLoad = pPluginList->updateDspLoad(iSampleRate);
+		if (pPluginList->count() > 0)
+			m_pPluginListView->viewport()->update();
+	}
+
+	// Tracks account for all their processing,
+	// buses for their plugin chains only...
+	unsigned int iPeakTime = 0;
+	if (m_pTrack) {
+		qtractorDspLoad *pDspLoad = m_pTrack->dspLoad();
+		pDspLoad->update(iSampleRate);
+		m_fDspLoad = pDspLoad->load();
+		iPeakTime = pDspLoad->peakTime();
+	} else {
+		m_fDspLoad = fPluginsLoad;
+	}
+
+	m_pDspLoadLabel->setText(QString::number(m_fDspLoad, 'f', 1) + '%');
+
+	QString sToolTip = tr("DSP load: %1%")
+		.arg(m_fDspLoad, 0, 'f', 1);
+	if (iPeakTime > 0)
+		sToolTip += tr(" (worst cycle < %1 us)").arg(iPeakTime);
+	if (pPluginList && pPluginList->count() > 0) {
+		sToolTip += '\n' + tr("Plugins: %1%").arg(fPluginsLoad, 0, 'f', 1);
+		if (pPluginList->isIdle())
+			sToolTip += ' ' + tr("(idle)");
+		const unsigned long iProcessCycles = pPluginList->processCycles();
+		if (iProcessCycles > 0) {
+			sToolTip += '\n' + tr("Idle cycles: %1 of %2")
+				.arg(pPluginList->idleCycles()).arg(iProcessCycles);
+		}
+	}
+	m_pDspLoadLabel->setToolTip(sToolTip);
+
+	// Color by load, unless the heaviest one...
+	if (!m_bDspLoadHeaviest) {
+		QPalette pal(QFrame::palette());
+		if (m_fDspLoad >= 50.0f)
+			pal.setColor(QPalette::WindowText, Qt::red);
+		else
+		if (m_fDspLoad >= 20.0f)
+			pal.setColor(QPalette::WindowText, Qt::darkYellow);
+		m_pDspLoadLabel->setPalette(pal);
+	}
+}
+
+
+// Heaviest DSP load strip highlighting.
+void qtractorMixerStrip::setDspLoadHeaviest ( bool bDspLoadHeaviest )
+{
+	if (( m_bDspLoadHeaviest && bDspLoadHeaviest) ||
+		(!m_bDspLoadHeaviest && !bDspLoadHeaviest))
+		return;
+
+	m_bDspLoadHeaviest = bDspLoadHeaviest;
+
+	QPalette pal(QFrame::palette());
+	if (m_bDspLoadHeaviest) {
+		pal.setColor(QPalette::Window, Qt::darkRed);
+		pal.setColor(QPalette::WindowText, Qt::white);
+	}
+	m_pDspLoadLabel->setPalette(pal);
 }
 
 
@@ -1137,10 +1236,26 @@ void qtractorMixerRack::updateStrip (
 // Complete rack refreshment.
 void qtractorMixerRack::refresh (void)
 {
+	// Also find out the heaviest DSP load offender,
+	// if above some minimum (1%)...
+	qtractorMixerStrip *pDspLoadHeaviest = NULL;
+	float fDspLoadMax = 1.0f;
+
 	Strips::ConstIterator strip = m_strips.constBegin();
 	const Strips::ConstIterator& strip_end = m_strips.constEnd();
-	for ( ; strip != strip_end; ++strip)
-		strip.value()->refresh();
+	for ( ; strip != strip_end; ++strip) {
+		qtractorMixerStrip *pStrip = strip.value();
+		pStrip->refresh();
+		if (fDspLoadMax < pStrip->dspLoad()) {
+			fDspLoadMax = pStrip->dspLoad();
+			pDspLoadHeaviest = pStrip;
+		}
+	}
+
+	for (strip = m_strips.constBegin(); strip != strip_end; ++strip) {
+		qtractorMixerStrip *pStrip = strip.value();
+		pStrip->setDspLoadHeaviest(pStrip == pDspLoadHeaviest);
+	}
 }
 
 
@@ -146,6 +146,13 @@ public:
 	// Strip refreshment.
 	void refresh();
 
+	// DSP load meter, as of last refreshment.
+	float dspLoad() const
+		{ return m_fDspLoad; }
+
+	// Heaviest DSP load strip highlighting.
+	void setDspLoadHeaviest(bool bDspLoadHeaviest);
+
 	// Hacko-list-management marking...
 	void setMark(int iMark)
 		{ m_iMark = iMark; }
@@ -175,6 +182,7 @@ protected:
 
 	void updateMidiLabel();
 	void updateName();
+	void updateDspLoad();
 
 	// Mouse selection event handlers.
 	void mousePressEvent(QMouseEvent *);
@@ -206,6 +214,11 @@ private:
 	qtractorMeter          *m_pMeter;
 	QPushButton            *m_pBusButton;
 	QLabel                 *m_pMidiLabel;
+	QLabel                 *m_pDspLoadLabel;
+
+	// DSP load meter state.
+	float m_fDspLoad;
+	bool  m_bDspLoadHeaviest;
 
 	// Selection stuff.
 	bool m_bSelected;
@@ -29,6 +29,7 @@
 #include <QList>
 
 #include <QTextStream>
+#include <QFileInfo>
 
 
 // Supposed to be determinant as default audio file type
@@ -61,6 +62,16 @@ qtractorOptions::qtractorOptions (void)
 	// Pseudo-singleton reference setup.
 	g_pOptions = this;
 
+	// Command line (non-persistent) render options.
+	fRenderStart = 0.0f;
+	fRenderEnd   = 0.0f;
+	bRenderStats = false;
+	bDummyDriver = false;
+
+	iBenchAudioTracks = 0;
+	iBenchMidiTracks  = 0;
+	iBenchCycles      = 0;
+
 	loadOptions();
 }
 
@@ -138,6 +149,7 @@ void qtractorOptions::loadOptions (void)
 	bAudioAutoTimeStretch = m_settings.value("/AutoTimeStretch", false).toBool();
 	bAudioWsolaTimeStretch = m_settings.value("/WsolaTimeStretch", true).toBool();
 	bAudioWsolaQuickSeek = m_settings.value("/WsolaQuickSeek", false).toBool();
+	bAudioWsolaFftSeek = m_settings.value("/WsolaFftSeek", false).toBool();
 	bAudioPlayerBus      = m_settings.value("/PlayerBus", false).toBool();
 	bAudioMetroBus       = m_settings.value("/MetroBus", false).toBool();
 	bAudioMetronome      = m_settings.value("/Metronome", false).toBool();
@@ -145,6 +157,20 @@ void qtractorOptions::loadOptions (void)
 	bAudioPlayerAutoConnect = m_settings.value("/PlayerAutoConnect", true).toBool();
 	bAudioMetroAutoConnect = m_settings.value("/MetroAutoConnect", true).toBool();
 	iAudioMetroOffset  = (unsigned long) m_settings.value("/MetroOffset", 0).toUInt();
+	iAudioGraphThreads = m_settings.value("/GraphThreads", 0).toInt();
+	iAudioAutomationFrames = m_settings.value("/AutomationFrames", 64).toInt();
+	iAudioPluginIdleTime = m_settings.value("/PluginIdleTime", 2000).toInt();
+	iAudioSyncWorkers = m_settings.value("/SyncWorkers", 4).toInt();
+	iAudioFreezeTailTime = m_settings.value("/FreezeTailTime", 2000).toInt();
+	bAudioDecodeCache = m_settings.value("/DecodeCache", true).toBool();
+	bAudioStretchCache = m_settings.value("/StretchCache", true).toBool();
+	bAudioOfflineExport = m_settings.value("/OfflineExport", true).toBool();
+	bAudioDummyDriver = m_settings.value("/DummyDriver", false).toBool();
+	iAudioDummySampleRate = m_settings.value("/DummySampleRate", 48000).toInt();
+	iAudioDummyBufferSize = m_settings.value("/DummyBufferSize", 1024).toInt();
+	bAudioDummyRealTime = m_settings.value("/DummyRealTime", true).toBool();
+	bAudioDspLoad = m_settings.value("/DspLoad", true).toBool();
+	bAudioXrunTrace = m_settings.value("/XrunTrace", false).toBool();
 	m_settings.endGroup();
 
 	// MIDI rendering options group.
@@ -426,6 +452,7 @@ void qtractorOptions::saveOptions (void)
 	m_settings.setValue("/AutoTimeStretch", bAudioAutoTimeStretch);
 	m_settings.setValue("/WsolaTimeStretch", bAudioWsolaTimeStretch);
 	m_settings.setValue("/WsolaQuickSeek", bAudioWsolaQuickSeek);
+	m_settings.setValue("/WsolaFftSeek", bAudioWsolaFftSeek);
 	m_settings.setValue("/PlayerBus", bAudioPlayerBus);
 	m_settings.setValue("/MetroBus", bAudioMetroBus);
 	m_settings.setValue("/Metronome", bAudioMetronome);
@@ -433,6 +460,20 @@ void qtractorOptions::saveOptions (void)
 	m_settings.setValue("/PlayerAutoConnect", bAudioPlayerAutoConnect);
 	m_settings.setValue("/MetroAutoConnect", bAudioMetroAutoConnect);
 	m_settings.setValue("/MetroOffset", uint(iAudioMetroOffset));
+	m_settings.setValue("/GraphThreads", iAudioGraphThreads);
+	m_settings.setValue("/AutomationFrames", iAudioAutomationFrames);
+	m_settings.setValue("/PluginIdleTime", iAudioPluginIdleTime);
+	m_settings.setValue("/SyncWorkers", iAudioSyncWorkers);
+	m_settings.setValue("/FreezeTailTime", iAudioFreezeTailTime);
+	m_settings.setValue("/DecodeCache", bAudioDecodeCache);
+	m_settings.setValue("/StretchCache", bAudioStretchCache);
+	m_settings.setValue("/OfflineExport", bAudioOfflineExport);
+	m_settings.setValue("/DummyDriver", bAudioDummyDriver);
+	m_settings.setValue("/DummySampleRate", iAudioDummySampleRate);
+	m_settings.setValue("/DummyBufferSize", iAudioDummyBufferSize);
+	m_settings.setValue("/DummyRealTime", bAudioDummyRealTime);
+	m_settings.setValue("/DspLoad", bAudioDspLoad);
+	m_settings.setValue("/XrunTrace", bAudioXrunTrace);
 	m_settings.endGroup();
 
 	// MIDI rendering options group.
@@ -668,6 +709,18 @@ void qtractorOptions::print_usage ( const QString& arg0 )
 	out << "  -s, --session-id=[uuid]" + sEot +
 		QObject::tr("Set session identification (uuid)") + sEol;
 #endif
+	out << "  -x, --render=[file]" + sEot +
+		QObject::tr("Render (export) session audio to file and quit (headless)") + sEol;
+	out << "  -r, --range=[start:end]" + sEot +
+		QObject::tr("Set render range in seconds (default: whole session)") + sEol;
+	out << "  -b, --bench" + sEot +
+		QObject::tr("Print render timing statistics") + sEol;
+	out << "  -d, --dummy" + sEot +
+		QObject::tr("Use the null/dummy audio driver (no JACK)") + sEol;
+	out << "  -B, --bench-synth=[audio:midi:cycles]" + sEot +
+		QObject::tr("Render a synthetic session benchmark and quit (headless)") + sEol;
+	out << "  -o, --bench-output=[file]" + sEot +
+		QObject::tr("Set benchmark results file (default: qtractor-bench.json)") + sEol;
 	out << "  -h, --help" + sEot +
 		QObject::tr("Show help about command line options") + sEol;
 	out << "  -v, --version" + sEot +
@@ -693,8 +746,6 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 		}
 
 		QString sArg = args.at(i);
-
-	#ifdef CONFIG_JACK_SESSION
 		QString sVal = QString::null;
 		int iEqual = sArg.indexOf('=');
 		if (iEqual >= 0) {
@@ -706,6 +757,67 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 			if (sVal[0] == '-')
 				sVal.clear();
 		}
+
+		if (sArg == "-x" || sArg == "--render") {
+			if (sVal.isNull()) {
+				out << QObject::tr("Option -x requires an argument (file).") + sEol;
+				return false;
+			}
+			sRenderFile = QFileInfo(sVal).absoluteFilePath();
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-r" || sArg == "--range") {
+			const QStringList& range = sVal.split(':');
+			bool bStart = false;
+			bool bEnd = false;
+			if (range.count() == 2) {
+				fRenderStart = range.at(0).toFloat(&bStart);
+				fRenderEnd   = range.at(1).toFloat(&bEnd);
+			}
+			if (!bStart || !bEnd || fRenderStart < 0.0f
+				|| fRenderEnd <= fRenderStart) {
+				out << QObject::tr("Option -r requires an argument (start:end).") + sEol;
+				return false;
+			}
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-b" || sArg == "--bench") {
+			bRenderStats = true;
+		}
+		else if (sArg == "-d" || sArg == "--dummy") {
+			bDummyDriver = true;
+		}
+		else if (sArg == "-B" || sArg == "--bench-synth") {
+			const QStringList& bench = sVal.split(':');
+			bool bAudio = false;
+			bool bMidi = false;
+			bool bCycles = false;
+			if (bench.count() == 3) {
+				iBenchAudioTracks = bench.at(0).toInt(&bAudio);
+				iBenchMidiTracks  = bench.at(1).toInt(&bMidi);
+				iBenchCycles      = bench.at(2).toInt(&bCycles);
+			}
+			if (!bAudio || !bMidi || !bCycles || iBenchAudioTracks < 0
+				|| iBenchMidiTracks < 0 || iBenchCycles < 1) {
+				out << QObject::tr("Option -B requires an argument (audio:midi:cycles).") + sEol;
+				return false;
+			}
+			if (iEqual < 0)
+				++i;
+		}
+		else if (sArg == "-o" || sArg == "--bench-output") {
+			if (sVal.isNull()) {
+				out << QObject::tr("Option -o requires an argument (file).") + sEol;
+				return false;
+			}
+			sBenchFile = QFileInfo(sVal).absoluteFilePath();
+			if (iEqual < 0)
+				++i;
+		}
+		else
+	#ifdef CONFIG_JACK_SESSION
 		if (sArg == "-s" || sArg == "--session-id") {
 			if (sVal.isNull()) {
 				out << QObject::tr("Option -s requires an argument (session-id).") + sEol;
@@ -732,7 +844,7 @@ bool qtractorOptions::parse_args ( const QStringList& args )
 		else {
 			// If we don't have one by now,
 			// this will be the startup session file...
-			sSessionFile += sArg;
+			sSessionFile += args.at(i);
 			++iCmdArgs;
 		}
 	}
@@ -62,6 +62,21 @@ public:
 	// Startup supplied session file.
 	QString sSessionFile;
 
+	// Command line headless render (export) options.
+	QString sRenderFile;
+	float   fRenderStart;
+	float   fRenderEnd;
+	bool    bRenderStats;
+
+	// Command line null/dummy audio driver (non-persistent).
+	bool    bDummyDriver;
+
+	// Command line synthetic session benchmark (non-persistent).
+	int     iBenchAudioTracks;
+	int     iBenchMidiTracks;
+	int     iBenchCycles;
+	QString sBenchFile;
+
 	// Display options...
 	QString sMessagesFont;
 	bool    bMessagesLimit;
@@ -109,6 +124,7 @@ public:
 	bool    bAudioAutoTimeStretch;
 	bool    bAudioWsolaTimeStretch;
 	bool    bAudioWsolaQuickSeek;
+	bool    bAudioWsolaFftSeek;
 	bool    bAudioPlayerBus;
 	bool    bAudioMetroBus;
 	bool    bAudioMetronome;
@@ -120,6 +136,42 @@ public:
 	// Audio metronome latency offset compensation.
 	unsigned long iAudioMetroOffset;
 
+	// Audio parallel process graph threads (0=auto, 1=serial).
+	int     iAudioGraphThreads;
+
+	// Audio automation sub-block frame resolution (0=per-period).
+	int     iAudioAutomationFrames;
+
+	// Audio silent plugin-chain tail hold time (msecs; 0=never idle).
+	int     iAudioPluginIdleTime;
+
+	// Audio clip read-ahead/write-behind workers (shared pool).
+	int     iAudioSyncWorkers;
+
+	// Audio track-freeze plugin-chain tail render time (msecs).
+	int     iAudioFreezeTailTime;
+
+	// Audio compressed clip decoded-PCM cache files.
+	bool    bAudioDecodeCache;
+
+	// Audio time-stretch/pitch-shift clip pre-rendered cache files.
+	bool    bAudioStretchCache;
+
+	// Audio offline (faster than real-time) export mode.
+	bool    bAudioOfflineExport;
+
+	// Audio null/dummy driver (no JACK) options.
+	bool    bAudioDummyDriver;
+	int     iAudioDummySampleRate;
+	int     iAudioDummyBufferSize;
+	bool    bAudioDummyRealTime;
+
+	// Audio per-track and per-plugin DSP load meters.
+	bool    bAudioDspLoad;
+
+	// Audio process cycle trace, dumped on xrun.
+	bool    bAudioXrunTrace;
+
 	// Audio metronome parameters.
 	QString sMetroBarFilename;
 	float   fMetroBarGain;
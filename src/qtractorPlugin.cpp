@@ -1,7 +1,7 @@
 // qtractorPlugin.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -27,6 +27,7 @@
 #include "qtractorPluginForm.h"
 
 #include "qtractorAudioEngine.h"
+#include "qtractorAudioKernel.h"
 #include "qtractorMidiManager.h"
 
 #include "qtractorMainForm.h"
@@ -36,6 +37,8 @@
 #include "qtractorSession.h"
 #include "qtractorDocument.h"
 #include "qtractorCurveFile.h"
+#include "qtractorRenderStats.h"
+#include "qtractorXrunTrace.h"
 
 #include "qtractorMessageList.h"
 
@@ -1298,6 +1301,9 @@ void qtractorPluginParam::Observer::update ( bool bUpdate )
 	if (bUpdate && pPlugin->directAccessParamIndex() == long(m_pParam->index()))
 		pPlugin->updateDirectAccessParam();
 	pPlugin->updateParam(m_pParam, qtractorMidiControlObserver::value(), bUpdate);
+
+	// Parameter changes (eg. automation) wake up the chain...
+	pPlugin->list()->wakeIdle();
 }
 
 
@@ -1318,6 +1324,16 @@ qtractorPluginList::qtractorPluginList (
 	m_pppBuffers[0] = NULL;
 	m_pppBuffers[1] = NULL;
 
+	m_bIdle = false;
+	m_bIdleSilent = false;
+	m_bIdleWake = false;
+	m_iIdleFrames = 0;
+	m_iTailFrames = 0;
+	m_iProcessCycles = 0;
+	m_iIdleCycles = 0;
+
+	m_pDspLoadHeaviest = NULL;
+
 	m_pCurveList = new qtractorCurveList();
 
 	m_bAudioOutputBus
@@ -1326,6 +1342,9 @@ qtractorPluginList::qtractorPluginList (
 		= qtractorMidiManager::isDefaultAudioOutputAutoConnect();
 
 	m_iAudioInsertActivated = 0;
+	m_iAudioAuxSendActivated = 0;
+
+	m_bFrozen = false;
 
 	setChannels(iChannels, iFlags);
 }
@@ -1444,15 +1463,19 @@ void qtractorPluginList::setChannelsEx (
 		}
 	}
 
-	// Reset all plugin chain channels...
+	// Reset all plugin chain channels
+	// (frozen ones are left unrealized)...
 	for (qtractorPlugin *pPlugin = first();
 			pPlugin; pPlugin = pPlugin->next()) {
-		if (bReset && m_iChannels > 0) {
+		const unsigned short iPluginChannels
+			= (m_bFrozen && pPlugin->type()->typeHint()
+				!= qtractorPluginType::AuxSend ? 0 : m_iChannels);
+		if (bReset && iPluginChannels > 0) {
 			pPlugin->freezeConfigs();
 			pPlugin->freezeValues();
 		}
-		pPlugin->setChannels(m_iChannels);
-		if (bReset && m_iChannels > 0) {
+		pPlugin->setChannels(iPluginChannels);
+		if (bReset && iPluginChannels > 0) {
 			pPlugin->realizeConfigs();
 			pPlugin->realizeValues();
 			pPlugin->releaseConfigs();
@@ -1462,6 +1485,32 @@ void qtractorPluginList::setChannelsEx (
 }
 
 
+// Frozen (pre-rendered) plugin chain state: all but the
+// aux-sends are left unrealized, with their state kept.
+void qtractorPluginList::setFrozen ( bool bFrozen )
+{
+	if ((bFrozen && m_bFrozen) || (!bFrozen && !m_bFrozen))
+		return;
+
+	m_bFrozen = bFrozen;
+
+	for (qtractorPlugin *pPlugin = first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if (pPlugin->type()->typeHint() == qtractorPluginType::AuxSend)
+			continue;
+		if (m_bFrozen) {
+			if (pPlugin->instances() > 0) {
+				pPlugin->freezeConfigs();
+				pPlugin->freezeValues();
+			}
+			pPlugin->setChannels(0);
+		} else {
+			pPlugin->setChannels(m_iChannels);
+		}
+	}
+}
+
+
 // Reset and (re)activate all plugin chain.
 void qtractorPluginList::resetBuffers (void)
 {
@@ -1619,6 +1668,9 @@ void qtractorPluginList::removePlugin ( qtractorPlugin *pPlugin )
 	// Just unlink the plugin from the list...
 	unlink(pPlugin);
 
+	if (m_pDspLoadHeaviest == pPlugin)
+		m_pDspLoadHeaviest = NULL;
+
 	if (pPlugin->isActivated())
 		updateActivated(false);
 
@@ -1701,31 +1753,191 @@ void qtractorPluginList::process ( float **ppBuffer, unsigned int nframes )
 	// Start from first input buffer...
 	m_pppBuffers[0] = ppBuffer;
 
+	// Now for the output buffer commitment, if ever...
+	if (process_chain(m_pppBuffers[0], m_pppBuffers[1], nframes, true)) {
+		for (unsigned short i = 0; i < m_iChannels; ++i) {
+			::memcpy(ppBuffer[i], m_pppBuffers[1][i],
+				nframes * sizeof(float));
+		}
+	}
+}
+
+
+// The zero-copy plugin-chain procedure variant.
+bool qtractorPluginList::process_swap (
+	float **ppBuffer, float **ppSwapBuffer, unsigned int nframes )
+{
+	// Sanity checks...
+	if (!isActivated())
+		return false;
+
+	if (ppBuffer == NULL || *ppBuffer == NULL || ppSwapBuffer == NULL)
+		return false;
+
+	return process_chain(ppBuffer, ppSwapBuffer, nframes, false);
+}
+
+
+// Plugin-chain processing executive (in-place aware).
+bool qtractorPluginList::process_chain ( float **ppBuffer,
+	float **ppSwapBuffer, unsigned int nframes, bool bEven )
+{
+	float **pppBuffers[2] = { ppBuffer, ppSwapBuffer };
+
+	// Should we need the output back on the first input buffer,
+	// an odd number of out-of-place plugins is evened out by
+	// having one of the in-place capable ones out-of-place...
+	qtractorPlugin *pOutPlacePlugin = NULL;
+	if (bEven) {
+		unsigned int iOutPlace = 0;
+		for (qtractorPlugin *pPlugin = first();
+				pPlugin; pPlugin = pPlugin->next()) {
+			if (!pPlugin->isActivated() || pPlugin->instances() < 1)
+				continue;
+			if (!pPlugin->isInPlace())
+				++iOutPlace;
+			else
+			if (pOutPlacePlugin == NULL)
+				pOutPlacePlugin = pPlugin;
+		}
+		if ((iOutPlace & 1) == 0)
+			pOutPlacePlugin = NULL;
+	}
+
 	// Buffer binary iterator...
 	unsigned short iBuffer = 0;
 
+	// Render timing statistics and xrun trace, if any...
+	qtractorRenderStats *pRenderStats = qtractorRenderStats::getInstance();
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+
 	// For each plugin in chain (in order, of course...)
 	for (qtractorPlugin *pPlugin = first();
 			pPlugin; pPlugin = pPlugin->next()) {
 
-		// Must be properly activated...
-		if (!pPlugin->isActivated())
+		// Must be properly activated (and realized)...
+		if (!pPlugin->isActivated() || pPlugin->instances() < 1)
 			continue;
 
+		const unsigned long long iTime
+			= (pRenderStats ? qtractorRenderStats::clock() : 0);
+		qtractorDspLoad *pDspLoad = pPlugin->dspLoad();
+		pDspLoad->start();
+
 		// Set proper buffers for this plugin...
-		float **ppIBuffer = m_pppBuffers[  iBuffer & 1];
-		float **ppOBuffer = m_pppBuffers[++iBuffer & 1];
+		float **ppIBuffer = pppBuffers[iBuffer & 1];
 		// Time for the real thing...
-		pPlugin->process(ppIBuffer, ppOBuffer, nframes);
+		if (pPlugin->isInPlace() && pPlugin != pOutPlacePlugin) {
+			pPlugin->process(ppIBuffer, ppIBuffer, nframes);
+		} else {
+			float **ppOBuffer = pppBuffers[++iBuffer & 1];
+			pPlugin->process(ppIBuffer, ppOBuffer, nframes);
+		}
+
+		const unsigned long long iLoadTime = pDspLoad->stop(nframes);
+		if (pXrunTrace) pXrunTrace->addItem(qtractorXrunTrace::Plugin,
+			pPlugin, iLoadTime);
+		if (pRenderStats) pRenderStats->addTime(pPlugin,
+			qtractorRenderStats::clock() - iTime);
 	}
 
-	// Now for the output buffer commitment...
-	if (iBuffer & 1) {
-		for (unsigned short i = 0; i < m_iChannels; ++i) {
-			::memcpy(ppBuffer[i], m_pppBuffers[1][i],
-				nframes * sizeof(float));
+	return (iBuffer & 1);
+}
+
+
+// Silence-aware idle (sleep) executive.
+bool qtractorPluginList::process_idle ( bool bSilent, unsigned long iIdleFrames )
+{
+	m_bIdleSilent = false;
+
+	if (!isActivated())
+		return false;
+
+	++m_iProcessCycles;
+
+	// Non-silent input or any pending change wakes us up...
+	if (!bSilent || iIdleFrames < 1 || m_bIdleWake) {
+		m_bIdleWake = false;
+		m_bIdle = false;
+		m_iTailFrames = 0;
+		return false;
+	}
+
+	// Sleeping already?
+	if (m_bIdle) {
+		++m_iIdleCycles;
+		return true;
+	}
+
+	// Tail decay measurement is in order...
+	m_bIdleSilent = true;
+	m_iIdleFrames = iIdleFrames;
+
+	return false;
+}
+
+
+// Tail decay measurement (on silent input only).
+void qtractorPluginList::process_tail ( float **ppBuffer, unsigned int nframes )
+{
+	if (!m_bIdleSilent)
+		return;
+
+	m_bIdleSilent = false;
+
+	float fPeak = 0.0f;
+	for (unsigned short i = 0; i < m_iChannels; ++i)
+		fPeak = qtractorAudioKernel::peak(ppBuffer[i], nframes, fPeak);
+
+	if (fPeak > QTRACTOR_AUDIO_SILENCE) {
+		m_iTailFrames = 0;
+		return;
+	}
+
+	m_iTailFrames += nframes;
+	if (m_iTailFrames < m_iIdleFrames)
+		return;
+
+	// Inserts, instruments and generators may never sleep;
+	// otherwise wait for the longest declared tail, if any...
+	if (m_pMidiManager || isAudioInsertActivated())
+		return;
+
+	for (qtractorPlugin *pPlugin = first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		if (!pPlugin->isActivated())
+			continue;
+		if (pPlugin->audioIns() < 1 || pPlugin->midiIns() > 0)
+			return;
+		if (m_iTailFrames < pPlugin->tailFrames())
+			return;
+	}
+
+	m_bIdle = true;
+}
+
+
+// DSP load meters periodic sampling (non RT-safe).
+float qtractorPluginList::updateDspLoad ( unsigned int iSampleRate )
+{
+	float fLoad = 0.0f;
+	float fLoadMax = 0.0f;
+
+	m_pDspLoadHeaviest = NULL;
+
+	for (qtractorPlugin *pPlugin = first();
+			pPlugin; pPlugin = pPlugin->next()) {
+		qtractorDspLoad *pDspLoad = pPlugin->dspLoad();
+		pDspLoad->update(iSampleRate);
+		const float fPluginLoad = pDspLoad->load();
+		if (fLoadMax < fPluginLoad) {
+			fLoadMax = fPluginLoad;
+			m_pDspLoadHeaviest = pPlugin;
 		}
+		fLoad += fPluginLoad;
 	}
+
+	return fLoad;
 }
 
 
@@ -2007,8 +2219,9 @@ bool qtractorPluginList::saveElement ( qtractorDocument *pDocument,
 		// Add this plugin...
 		pElement->appendChild(ePlugin);
 
-		// May release plugin state...
-		pPlugin->releaseConfigs();
+		// May release plugin state (unless unrealized, eg. frozen)...
+		if (pPlugin->instances() > 0)
+			pPlugin->releaseConfigs();
 	}
 
 	// Save audio output-bus connects...
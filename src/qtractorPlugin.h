@@ -1,7 +1,7 @@
 // qtractorPlugin.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -26,6 +26,8 @@
 
 #include "qtractorMidiControlObserver.h"
 
+#include "qtractorDspLoad.h"
+
 #include <QLibrary>
 
 #include <QStringList>
@@ -126,7 +128,8 @@ public:
 		Hint typeHint) : m_iUniqueID(0), m_iControlIns(0), m_iControlOuts(0),
 			m_iAudioIns(0), m_iAudioOuts(0), m_iMidiIns(0), m_iMidiOuts(0),
 			m_bRealtime(false), m_bConfigure(false), m_bEditor(false),
-			m_pFile(pFile), m_iIndex(iIndex), m_typeHint(typeHint) {}
+			m_bInPlace(false), m_pFile(pFile), m_iIndex(iIndex),
+			m_typeHint(typeHint) {}
 
 	// Destructor (virtual)
 	virtual ~qtractorPluginType()
@@ -163,6 +166,9 @@ public:
 	bool isConfigure() const { return m_bConfigure; }
 	bool isEditor()    const { return m_bEditor;    }
 
+	// Whether output buffers may be the very same as input ones.
+	bool isInPlace()   const { return m_bInPlace;   }
+
 	bool isMidi() const { return m_iMidiIns + m_iMidiOuts > 0; }
 
 	// Compute the number of instances needed
@@ -202,6 +208,7 @@ protected:
 	bool m_bRealtime;
 	bool m_bConfigure;
 	bool m_bEditor;
+	bool m_bInPlace;
 
 	// Instance cached-deferred variables.
 	QString m_sAboutText;
@@ -355,6 +362,12 @@ public:
 	// Chain helper ones.
 	unsigned short channels() const;
 
+	// Whether it may process in-place, given current instances
+	// (ie. each instance reads/writes the very same channels).
+	bool isInPlace() const
+		{ return m_pType->isInPlace()
+			&& (m_iInstances < 2 || audioIns() == audioOuts()); }
+
 	// Unique ID methods.
 	void setUniqueID(unsigned long iUniqueID)
 		{ m_iUniqueID = iUniqueID; }
@@ -439,6 +452,9 @@ public:
 	// Specific MIDI instrument selector.
 	virtual void selectProgram(int /*iBank*/, int /*iProg*/) {}
 
+	// Declared tail length in frames (zero if unknown).
+	virtual unsigned long tailFrames() const { return 0; }
+
 	// Program (patch) descriptor.
 	struct Program
 	{
@@ -644,6 +660,10 @@ public:
 	// Parameter update executive.
 	void updateParamValue(unsigned long iIndex, float fValue, bool bUpdate);
 
+	// DSP load meter accessor.
+	qtractorDspLoad *dspLoad()
+		{ return &m_dspLoad; }
+
 protected:
 
 	// Instance number settler.
@@ -725,6 +745,9 @@ private:
 	// Direct access parameter, if any.
 	long m_iDirectAccessParamIndex;
 
+	// DSP load meter.
+	qtractorDspLoad m_dspLoad;
+
 	// Default preset name.
 	static QString g_sDefPreset;
 };
@@ -797,6 +820,7 @@ public:
 		else
 		if (m_iActivated > 0)
 			--m_iActivated;
+		m_bIdleWake = true;
 	}
 
 	bool isActivatedAll() const
@@ -824,6 +848,39 @@ public:
 	// The meta-main audio-processing plugin-chain procedure.
 	void process(float **ppBuffer, unsigned int nframes);
 
+	// The zero-copy plugin-chain procedure variant: output may be
+	// left on the alternate (swap) buffers, which must have the same
+	// number of channels, in which case returns true.
+	bool process_swap(float **ppBuffer, float **ppSwapBuffer,
+		unsigned int nframes);
+
+	// Silence-aware idle (sleep) executive, to be called before
+	// processing each cycle; returns true when the chain input is
+	// silent and its tail has already decayed for iIdleFrames,
+	// so that chain processing may be skipped altogether.
+	bool process_idle(bool bSilent, unsigned long iIdleFrames);
+
+	// Tail decay measurement, to be called after processing
+	// each cycle, on the plugin-chain output buffers.
+	void process_tail(float **ppBuffer, unsigned int nframes);
+
+	// Wake up from idle state, on next cycle (eg. automation).
+	void wakeIdle() { m_bIdleWake = true; }
+
+	// Idle state and cycle counters (DSP load savings).
+	bool isIdle() const { return m_bIdle; }
+	unsigned long processCycles() const { return m_iProcessCycles; }
+	unsigned long idleCycles() const { return m_iIdleCycles; }
+	void resetCycles() { m_iProcessCycles = m_iIdleCycles = 0; }
+
+	// DSP load meters periodic sampling (non RT-safe);
+	// returns the whole plugin chain load percentage.
+	float updateDspLoad(unsigned int iSampleRate);
+
+	// Heaviest plugin in chain, as of last sampling.
+	qtractorPlugin *dspLoadHeaviest() const
+		{ return m_pDspLoadHeaviest; }
+
 	// Document element methods.
 	bool loadElement(qtractorDocument *pDocument, QDomElement *pElement);
 	bool saveElement(qtractorDocument *pDocument, QDomElement *pElement);
@@ -910,12 +967,36 @@ public:
 	bool isAudioInsertActivated() const
 		{ return (m_iAudioInsertActivated > 0); }
 
+	// Special audio aux-sends activation state methods.
+	void setAudioAuxSendActivated(bool bAudioAuxSendActivated)
+	{
+		if (bAudioAuxSendActivated)
+			++m_iAudioAuxSendActivated;
+		else
+		if (m_iAudioAuxSendActivated > 0)
+			--m_iAudioAuxSendActivated;
+	}
+
+	bool isAudioAuxSendActivated() const
+		{ return (m_iAudioAuxSendActivated > 0); }
+
+	// Frozen (pre-rendered) plugin chain state: all but
+	// the aux-sends are left unrealized, state kept.
+	void setFrozen(bool bFrozen);
+	bool isFrozen() const
+		{ return m_bFrozen; }
+
 protected:
 
 	// Check/sanitize plugin file-path.
 	bool checkPluginFile(QString& sFilename,
 		qtractorPluginType::Hint typeHint) const;
 
+	// Plugin-chain processing executive (in-place aware);
+	// returns true if output was left on the alternate buffers.
+	bool process_chain(float **ppBuffer, float **ppSwapBuffer,
+		unsigned int nframes, bool bEven);
+
 private:
 
 	// Instance variables.
@@ -949,9 +1030,27 @@ private:
 	// Audio inserts activation state.
 	unsigned int m_iAudioInsertActivated;
 
+	// Audio aux-sends activation state.
+	unsigned int m_iAudioAuxSendActivated;
+
+	// Frozen (pre-rendered) plugin chain state.
+	bool m_bFrozen;
+
 	// Internal running buffer chain references.
 	float **m_pppBuffers[2];
 
+	// Silence-aware idle (sleep) state.
+	bool           m_bIdle;
+	bool           m_bIdleSilent;
+	volatile bool  m_bIdleWake;
+	unsigned long  m_iIdleFrames;
+	unsigned long  m_iTailFrames;
+	unsigned long  m_iProcessCycles;
+	unsigned long  m_iIdleCycles;
+
+	// Heaviest plugin in chain (DSP load).
+	qtractorPlugin *m_pDspLoadHeaviest;
+
 	// MIDI bank/program observable subject.
 	MidiProgramSubject *m_pMidiProgramSubject;
 
@@ -1,7 +1,7 @@
 // qtractorPluginListView.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -152,6 +152,28 @@ protected:
 				pItem->icon().pixmap(iconSize));
 			// Draw the text...
 			rect.setLeft(iconSize.width() + 2);
+			// Draw the DSP load, if significant;
+			// the heaviest one in chain gets highlighted...
+			if (pPlugin && pPlugin->isActivated()
+				&& qtractorDspLoad::isEnabled()) {
+				const float fLoad = pPlugin->dspLoad()->load();
+				if (fLoad >= 0.1f) {
+					const QString& sLoad
+						= QString::number(fLoad, 'f', 1) + '%';
+					qtractorPluginList *pPluginList
+						= static_cast<qtractorPluginListView *> (
+							m_pListWidget)->pluginList();
+					if (pPluginList && fLoad >= 1.0f
+						&& pPluginList->dspLoadHeaviest() == pPlugin)
+						pPainter->setPen(Qt::red);
+					else
+						pPainter->setPen(rgbFore);
+					pPainter->drawText(rect.adjusted(0, 0, -2, 0),
+						Qt::AlignRight | Qt::AlignVCenter, sLoad);
+					rect.setRight(rect.right() - 4
+						- pPainter->fontMetrics().width(sLoad));
+				}
+			}
 			pPainter->setPen(rgbFore);
 			pPainter->drawText(rect,
 				Qt::AlignLeft | Qt::AlignVCenter, pItem->text());
@@ -0,0 +1,688 @@
+// qtractorRenderBench.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorRenderBench.h"
+
+#include "qtractorSession.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorAudioClip.h"
+#include "qtractorAudioFile.h"
+#include "qtractorAudioCache.h"
+#include "qtractorAudioMonitor.h"
+#include "qtractorMidiClip.h"
+#include "qtractorMidiFile.h"
+#include "qtractorMidiSequence.h"
+#include "qtractorMidiEvent.h"
+#include "qtractorInsertPlugin.h"
+#include "qtractorPluginFactory.h"
+#include "qtractorPluginCommand.h"
+#include "qtractorTrackCommand.h"
+#include "qtractorCurve.h"
+#include "qtractorTimeStretch.h"
+
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+
+#include <math.h>
+#include <string.h>
+
+
+// Audio file generator chunk size (frames).
+#define QTRACTOR_BENCH_CHUNK	4096
+
+// Time-stretch check chunk size (frames) and signal length (chunks).
+#define QTRACTOR_BENCH_STRETCH_CHUNK	1024
+#define QTRACTOR_BENCH_STRETCH_CHUNKS	600
+
+
+//----------------------------------------------------------------------
+// class qtractorRenderBench -- Synthetic session render benchmark.
+//
+
+// Constructor.
+qtractorRenderBench::qtractorRenderBench ( qtractorSession *pSession,
+	unsigned int iAudioTracks, unsigned int iMidiTracks, unsigned int iCycles )
+	: m_pSession(pSession), m_iAudioTracks(iAudioTracks),
+		m_iMidiTracks(iMidiTracks), m_iCycles(iCycles),
+		m_iPlugins(0), m_bLadspa(false), m_iLoadTime(0),
+		m_iMidiEvents(0), m_iMidiBytes(0), m_stats(pSession)
+{
+	::memset(&m_syncStats, 0, sizeof(m_syncStats));
+
+	m_bStretchEnabled = qtractorAudioCacheFactory::isStretchEnabled();
+}
+
+
+// Destructor.
+qtractorRenderBench::~qtractorRenderBench (void)
+{
+	if (qtractorRenderStats::getInstance() == &m_stats)
+		qtractorRenderStats::setInstance(NULL);
+
+	// Restore the global audio cache setting...
+	qtractorAudioCacheFactory::setStretchEnabled(m_bStretchEnabled);
+}
+
+
+// Synthetic session generator (non RT-safe).
+bool qtractorRenderBench::build ( const QString& sDir )
+{
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL || !pAudioEngine->isActivated())
+		return false;
+
+	qtractorBus *pMasterBus = pAudioEngine->buses().first();
+	if (pMasterBus == NULL)
+		return false;
+
+	if (m_iCycles < 1)
+		return false;
+
+	if (!QDir().mkpath(sDir))
+		return false;
+
+	m_sDir = sDir;
+
+	// Whole render length, plus some slack
+	// so that time-stretched clips cover it all...
+	const unsigned long iFrames
+		= (unsigned long) m_iCycles * pAudioEngine->bufferSize();
+	const unsigned long iFileFrames = iFrames + (iFrames >> 2);
+
+	const unsigned short iChannels
+		= static_cast<qtractorAudioBus *> (pMasterBus)->channels();
+
+	// Measure the live time-stretcher, always...
+	qtractorAudioCacheFactory::setStretchEnabled(false);
+
+	qtractorImportTrackCommand *pImportTrackCommand
+		= new qtractorImportTrackCommand(m_pSession->tracks().last());
+
+	QList<qtractorTrack *> audioTracks;
+
+	int iTrack = m_pSession->tracks().count();
+
+	// Audio tracks, streaming clips...
+	for (unsigned int i = 0; i < m_iAudioTracks; ++i) {
+		const QString& sFilename = QFileInfo(m_sDir,
+			QString("bench-audio-%1.wav").arg(i + 1)).absoluteFilePath();
+		const float fFreq = 110.0f * float(1 + (i % 8));
+		if (!createAudioFile(sFilename, iChannels, iFileFrames, fFreq))
+			continue;
+		m_files.append(sFilename);
+		const QColor& color = qtractorTrack::trackColor(++iTrack);
+		qtractorTrack *pTrack = new qtractorTrack(m_pSession, qtractorTrack::Audio);
+		pTrack->setTrackName(QString("Audio %1").arg(i + 1));
+		pTrack->setBackground(color);
+		pTrack->setForeground(color.darker());
+		qtractorAudioClip *pAudioClip = new qtractorAudioClip(pTrack);
+		pAudioClip->setFilename(sFilename);
+		pAudioClip->setClipStart(0);
+		// Every other one gets time-stretched...
+		if (i & 1)
+			pAudioClip->setTimeStretch(0.9f);
+		pTrack->addClip(pAudioClip);
+		pImportTrackCommand->addTrack(pTrack);
+		audioTracks.append(pTrack);
+	}
+
+	// MIDI tracks, dense sequence clips...
+	for (unsigned int j = 0; j < m_iMidiTracks; ++j) {
+		const QString& sFilename = QFileInfo(m_sDir,
+			QString("bench-midi-%1.mid").arg(j + 1)).absoluteFilePath();
+		const unsigned short iNote = 36 + (j % 48);
+		if (!createMidiFile(sFilename, iFileFrames, iNote))
+			continue;
+		m_files.append(sFilename);
+		const QColor& color = qtractorTrack::trackColor(++iTrack);
+		qtractorTrack *pTrack = new qtractorTrack(m_pSession, qtractorTrack::Midi);
+		pTrack->setTrackName(QString("MIDI %1").arg(j + 1));
+		pTrack->setBackground(color);
+		pTrack->setForeground(color.darker());
+		qtractorMidiClip *pMidiClip = new qtractorMidiClip(pTrack);
+		pMidiClip->setFilename(sFilename);
+		pMidiClip->setTrackChannel(0);
+		pMidiClip->setClipStart(0);
+		pTrack->addClip(pMidiClip);
+		pTrack->setMidiChannel(j % 16);
+		pImportTrackCommand->addTrack(pTrack);
+	}
+
+	// Time the whole lot being opened (loaded)...
+	const unsigned long iMidiEvents = qtractorMidiEventPool::events();
+	const unsigned long iMidiBytes = qtractorMidiEventPool::bytes();
+	const unsigned long long iLoadStart = qtractorRenderStats::clock();
+
+	if (!m_pSession->execute(pImportTrackCommand))
+		return false;
+
+	m_iLoadTime = qtractorRenderStats::clock() - iLoadStart;
+	m_iMidiEvents = qtractorMidiEventPool::events() - iMidiEvents;
+	m_iMidiBytes = qtractorMidiEventPool::bytes() - iMidiBytes;
+
+	// Plugin chains and automation, now that tracks are open...
+	m_iPlugins = 0;
+	QListIterator<qtractorTrack *> iter(audioTracks);
+	while (iter.hasNext()) {
+		qtractorTrack *pTrack = iter.next();
+		m_iPlugins += addAudioPlugins(pTrack);
+		addAudioCurve(pTrack, iFrames);
+	}
+
+	return true;
+}
+
+
+// Render the fixed number of cycles (non RT-safe).
+bool qtractorRenderBench::run (void)
+{
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL || !pAudioEngine->isActivated())
+		return false;
+
+	// Render the first (master) output bus...
+	qtractorAudioBus *pRenderBus = NULL;
+	for (qtractorBus *pBus = pAudioEngine->buses().first();
+			pBus && pRenderBus == NULL; pBus = pBus->next()) {
+		if (pBus->busMode() & qtractorBus::Output)
+			pRenderBus = static_cast<qtractorAudioBus *> (pBus);
+	}
+	if (pRenderBus == NULL)
+		return false;
+
+	QList<qtractorAudioBus *> renderBuses;
+	renderBuses.append(pRenderBus);
+
+	const QString& sRenderFile
+		= QFileInfo(m_sDir, "bench-render.wav").absoluteFilePath();
+	m_files.append(sRenderFile);
+
+	const unsigned long iFrames
+		= (unsigned long) m_iCycles * pAudioEngine->bufferSize();
+
+	m_stats.reset();
+	qtractorAudioBufferThread::resetSyncStats();
+	qtractorRenderStats::setInstance(&m_stats);
+	m_stats.start();
+
+	const bool bResult = pAudioEngine->fileExport(
+		sRenderFile, renderBuses, 0, iFrames);
+
+	m_stats.stop();
+	qtractorRenderStats::setInstance(NULL);
+	qtractorAudioBufferThread::syncStats(m_syncStats);
+
+	return bResult;
+}
+
+
+// Time-stretch overlap search check (non RT-safe).
+bool qtractorRenderBench::stretch (void)
+{
+	static const unsigned int s_aiSampleRates[] = { 44100, 96000, 192000, 0 };
+	static const float s_afTempos[] = { 0.5f, 0.75f, 0.9f, 1.25f, 1.5f, 2.0f, 0.0f };
+
+	const unsigned short iChannels = 2;
+	const unsigned long iFrames = (unsigned long)
+		QTRACTOR_BENCH_STRETCH_CHUNKS * QTRACTOR_BENCH_STRETCH_CHUNK;
+
+	float **ppFrames = new float * [iChannels];
+	for (unsigned short i = 0; i < iChannels; ++i)
+		ppFrames[i] = new float [iFrames];
+
+	QVector<float> ref[iChannels];
+	QVector<float> out[iChannels];
+
+	bool bResult = true;
+
+	m_stretchStats.clear();
+
+	for (int r = 0; s_aiSampleRates[r] > 0; ++r) {
+		const unsigned int iSampleRate = s_aiSampleRates[r];
+		// Synthetic signal: two sines, slightly detuned between
+		// channels, plus some (deterministic) noise...
+		const float w1 = 2.0f * float(M_PI) * 220.0f / float(iSampleRate);
+		const float w2 = 2.0f * float(M_PI) * 1375.0f / float(iSampleRate);
+		unsigned int iSeed = 1;
+		for (unsigned long n = 0; n < iFrames; ++n) {
+			for (unsigned short i = 0; i < iChannels; ++i) {
+				iSeed = iSeed * 1103515245 + 12345;
+				const float fNoise
+					= float((iSeed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+				ppFrames[i][n]
+					= 0.3f * ::sinf(w1 * float(1 + i) * float(n))
+					+ 0.2f * ::sinf(w2 * float(n)) + 0.05f * fNoise;
+			}
+		}
+		StretchStats stats;
+		::memset(&stats, 0, sizeof(stats));
+		stats.sampleRate = iSampleRate;
+		for (int t = 0; s_afTempos[t] > 0.0f; ++t) {
+			const float fTempo = s_afTempos[t];
+			stats.refTime += stretchRun(ppFrames, iFrames,
+				iSampleRate, fTempo, StretchRef, ref);
+			// Block (SIMD) search must be bit-exact...
+			stats.blockTime += stretchRun(ppFrames, iFrames,
+				iSampleRate, fTempo, StretchBlock, out);
+			for (unsigned short i = 0; i < iChannels; ++i) {
+				const float *pRef = ref[i].constData();
+				const float *pOut = out[i].constData();
+				const int iSize = qMin(ref[i].size(), out[i].size());
+				stats.mismatches += qAbs(ref[i].size() - out[i].size());
+				for (int k = 0; k < iSize; ++k) {
+					if (::memcmp(pRef + k, pOut + k, sizeof(float)))
+						++stats.mismatches;
+				}
+			}
+			// FFT-assisted search is not, so just how far...
+			stats.fftTime += stretchRun(ppFrames, iFrames,
+				iSampleRate, fTempo, StretchFft, out);
+			for (unsigned short i = 0; i < iChannels; ++i) {
+				const float *pRef = ref[i].constData();
+				const float *pOut = out[i].constData();
+				const int iSize = qMin(ref[i].size(), out[i].size());
+				for (int k = 0; k < iSize; ++k) {
+					const float fDelta = ::fabsf(pRef[k] - pOut[k]);
+					if (stats.fftDelta < fDelta)
+						stats.fftDelta = fDelta;
+				}
+			}
+		}
+		if (stats.mismatches > 0)
+			bResult = false;
+		m_stretchStats.append(stats);
+	}
+
+	for (unsigned short i = 0; i < iChannels; ++i)
+		delete [] ppFrames[i];
+	delete [] ppFrames;
+
+	return bResult;
+}
+
+
+// Remove all generated files.
+void qtractorRenderBench::clean (void)
+{
+	QStringListIterator iter(m_files);
+	while (iter.hasNext())
+		QFile::remove(iter.next());
+
+	m_files.clear();
+
+	if (!m_sDir.isEmpty())
+		QDir().rmdir(m_sDir);
+}
+
+
+// Human readable report.
+void qtractorRenderBench::report ( QTextStream& out ) const
+{
+	out << QString("Audio tracks: %1\n").arg(m_iAudioTracks);
+	out << QString("MIDI tracks:  %1\n").arg(m_iMidiTracks);
+	out << QString("Plugins:      %1%2\n").arg(m_iPlugins)
+		.arg(m_bLadspa ? "" : " (no LADSPA gain)");
+	out << QString("Load time:    %1 ms\n")
+		.arg(float(m_iLoadTime) * 1e-6f, 0, 'f', 1);
+	out << QString("MIDI events:  %1 (%2 KB)\n")
+		.arg(m_iMidiEvents).arg(m_iMidiBytes >> 10);
+	out << QString("Sync picks:   %1 (%2 overdue, %3 underruns,"
+		" %4 frames headroom, %5 workers)\n")
+		.arg(m_syncStats.picks).arg(m_syncStats.overdue)
+		.arg(m_syncStats.underruns).arg(m_syncStats.headroom)
+		.arg(m_syncStats.workers);
+
+	QListIterator<StretchStats> iter(m_stretchStats);
+	while (iter.hasNext()) {
+		const StretchStats& stats = iter.next();
+		out << QString("Stretch %1k:  %2 ms (ref), %3 ms (block),"
+			" %4 ms (fft); %5 mismatches, %6 fft delta\n")
+			.arg(float(stats.sampleRate) * 1e-3f, 0, 'f', 1)
+			.arg(float(stats.refTime)   * 1e-6f, 0, 'f', 1)
+			.arg(float(stats.blockTime) * 1e-6f, 0, 'f', 1)
+			.arg(float(stats.fftTime)   * 1e-6f, 0, 'f', 1)
+			.arg(stats.mismatches)
+			.arg(stats.fftDelta, 0, 'g', 3);
+	}
+
+	m_stats.report(out);
+}
+
+
+// Machine readable (JSON) results file.
+bool qtractorRenderBench::save ( const QString& sFilename ) const
+{
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	const float fWallTime = float(m_stats.wallTime()) * 1e-9f;
+	const unsigned int iSampleRate = m_pSession->sampleRate();
+	const float fAudioTime = (iSampleRate > 0
+		? float(m_stats.frames()) / float(iSampleRate) : 0.0f);
+
+	unsigned int iBufferSize = 0;
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine)
+		iBufferSize = pAudioEngine->bufferSize();
+
+	QTextStream out(&file);
+
+	out << "{\n";
+	out << "  \"version\": \"" CONFIG_BUILD_VERSION "\",\n";
+	out << QString("  \"sampleRate\": %1,\n").arg(iSampleRate);
+	out << QString("  \"bufferSize\": %1,\n").arg(iBufferSize);
+	out << QString("  \"audioTracks\": %1,\n").arg(m_iAudioTracks);
+	out << QString("  \"midiTracks\": %1,\n").arg(m_iMidiTracks);
+	out << QString("  \"plugins\": %1,\n").arg(m_iPlugins);
+	out << QString("  \"ladspa\": %1,\n").arg(m_bLadspa ? "true" : "false");
+	out << QString("  \"loadTime\": %1,\n")
+		.arg(float(m_iLoadTime) * 1e-9f, 0, 'f', 6);
+	out << QString("  \"midiEvents\": %1,\n").arg(m_iMidiEvents);
+	out << QString("  \"midiBytes\": %1,\n").arg(m_iMidiBytes);
+	out << "  \"sync\": {\n";
+	out << QString("    \"picks\": %1,\n").arg(m_syncStats.picks);
+	out << QString("    \"overdue\": %1,\n").arg(m_syncStats.overdue);
+	out << QString("    \"underruns\": %1,\n").arg(m_syncStats.underruns);
+	out << QString("    \"headroom\": %1,\n").arg(m_syncStats.headroom);
+	out << QString("    \"pending\": %1,\n").arg(m_syncStats.pending);
+	out << QString("    \"workers\": %1\n").arg(m_syncStats.workers);
+	out << "  },\n";
+	out << "  \"stretch\": [\n";
+	QListIterator<StretchStats> iter(m_stretchStats);
+	while (iter.hasNext()) {
+		const StretchStats& stats = iter.next();
+		out << "    {\n";
+		out << QString("      \"sampleRate\": %1,\n").arg(stats.sampleRate);
+		out << QString("      \"refTime\": %1,\n")
+			.arg(float(stats.refTime)   * 1e-9f, 0, 'f', 6);
+		out << QString("      \"blockTime\": %1,\n")
+			.arg(float(stats.blockTime) * 1e-9f, 0, 'f', 6);
+		out << QString("      \"fftTime\": %1,\n")
+			.arg(float(stats.fftTime)   * 1e-9f, 0, 'f', 6);
+		out << QString("      \"mismatches\": %1,\n").arg(stats.mismatches);
+		out << QString("      \"fftDelta\": %1\n").arg(stats.fftDelta, 0, 'g', 6);
+		out << (iter.hasNext() ? "    },\n" : "    }\n");
+	}
+	out << "  ],\n";
+	out << QString("  \"cycles\": %1,\n").arg(m_stats.cycles());
+	out << QString("  \"offlineCycles\": %1,\n").arg(m_stats.offlineCycles());
+	out << QString("  \"graphCycles\": %1,\n").arg(m_stats.graphCycles());
+	out << QString("  \"frames\": %1,\n").arg(m_stats.frames());
+	out << QString("  \"wallTime\": %1,\n").arg(fWallTime, 0, 'f', 6);
+	out << QString("  \"cyclesPerSecond\": %1,\n")
+		.arg(fWallTime > 0.0f ? float(m_stats.cycles()) / fWallTime : 0.0f, 0, 'f', 2);
+	out << QString("  \"realTimeFactor\": %1,\n")
+		.arg(fWallTime > 0.0f ? fAudioTime / fWallTime : 0.0f, 0, 'f', 3);
+	out << "  \"cycleTimeUs\": {\n";
+	out << QString("    \"min\": %1,\n")
+		.arg(float(m_stats.cycleTime(0.0f))   * 1e-3f, 0, 'f', 2);
+	out << QString("    \"avg\": %1,\n")
+		.arg(float(m_stats.cycleAvgTime())    * 1e-3f, 0, 'f', 2);
+	out << QString("    \"p50\": %1,\n")
+		.arg(float(m_stats.cycleTime(50.0f))  * 1e-3f, 0, 'f', 2);
+	out << QString("    \"p90\": %1,\n")
+		.arg(float(m_stats.cycleTime(90.0f))  * 1e-3f, 0, 'f', 2);
+	out << QString("    \"p99\": %1,\n")
+		.arg(float(m_stats.cycleTime(99.0f))  * 1e-3f, 0, 'f', 2);
+	out << QString("    \"max\": %1\n")
+		.arg(float(m_stats.cycleTime(100.0f)) * 1e-3f, 0, 'f', 2);
+	out << "  }\n";
+	out << "}\n";
+
+	file.close();
+
+	return true;
+}
+
+
+// Synthetic audio file generator (plain sine wave).
+bool qtractorRenderBench::createAudioFile ( const QString& sFilename,
+	unsigned short iChannels, unsigned long iFrames, float fFreq ) const
+{
+	const unsigned int iSampleRate = m_pSession->sampleRate();
+	if (iSampleRate < 1 || iChannels < 1)
+		return false;
+
+	qtractorAudioFile *pFile
+		= qtractorAudioFileFactory::createAudioFile(
+			sFilename, iChannels, iSampleRate);
+	if (pFile == NULL)
+		return false;
+
+	if (!pFile->open(sFilename, qtractorAudioFile::Write)) {
+		delete pFile;
+		return false;
+	}
+
+	float **ppFrames = new float * [iChannels];
+	for (unsigned short i = 0; i < iChannels; ++i)
+		ppFrames[i] = new float [QTRACTOR_BENCH_CHUNK];
+
+	const float w = 2.0f * float(M_PI) * fFreq / float(iSampleRate);
+
+	unsigned long iFrame = 0;
+	while (iFrame < iFrames) {
+		unsigned int nframes = QTRACTOR_BENCH_CHUNK;
+		if (nframes > iFrames - iFrame)
+			nframes = iFrames - iFrame;
+		for (unsigned int n = 0; n < nframes; ++n) {
+			const float fValue = 0.25f * ::sinf(w * float(iFrame + n));
+			for (unsigned short i = 0; i < iChannels; ++i)
+				ppFrames[i][n] = fValue;
+		}
+		pFile->write(ppFrames, nframes);
+		iFrame += nframes;
+	}
+
+	for (unsigned short i = 0; i < iChannels; ++i)
+		delete [] ppFrames[i];
+	delete [] ppFrames;
+
+	pFile->close();
+	delete pFile;
+
+	return true;
+}
+
+
+// Synthetic MIDI file generator (dense sixteenth-note chords
+// and a modulation controller sweep).
+bool qtractorRenderBench::createMidiFile ( const QString& sFilename,
+	unsigned long iFrames, unsigned short iNote ) const
+{
+	const unsigned short iTicksPerBeat = m_pSession->ticksPerBeat();
+	const unsigned long iTicks = m_pSession->tickFromFrame(iFrames);
+	const unsigned long iStep = (iTicksPerBeat >> 2);
+	if (iStep < 1)
+		return false;
+
+	qtractorMidiSequence seq(QFileInfo(sFilename).baseName(), 0, iTicksPerBeat);
+
+	unsigned int k = 0;
+	for (unsigned long t = 0; t + iStep <= iTicks; t += iStep, ++k) {
+		const unsigned short iVelocity = 64 + (k % 4) * 16;
+		seq.insertEvent(new qtractorMidiEvent(t,
+			qtractorMidiEvent::NOTEON, iNote, iVelocity, iStep));
+		seq.insertEvent(new qtractorMidiEvent(t,
+			qtractorMidiEvent::NOTEON, iNote + 4, iVelocity, iStep));
+		seq.insertEvent(new qtractorMidiEvent(t,
+			qtractorMidiEvent::NOTEON, iNote + 7, iVelocity, iStep));
+		seq.insertEvent(new qtractorMidiEvent(t,
+			qtractorMidiEvent::CONTROLLER, 1, k & 0x7f));
+	}
+
+	seq.setDuration(iTicks);
+
+	return qtractorMidiFile::saveCopyFile(sFilename, QString(), 0, 0,
+		&seq, m_pSession->timeScale());
+}
+
+
+// Time-stretch the given (stereo) signal, in chunks,
+// whole output appended (return elapsed time, ns).
+unsigned long long qtractorRenderBench::stretchRun ( float **ppFrames,
+	unsigned long iFrames, unsigned int iSampleRate, float fTempo,
+	StretchMode mode, QVector<float> *pOutput ) const
+{
+	const unsigned short iChannels = 2;
+
+	qtractorTimeStretch ts(iChannels, iSampleRate);
+	ts.setTempo(fTempo);
+	ts.setBlockSeek(mode != StretchRef);
+	ts.setFftSeek(mode == StretchFft);
+
+	float  aBuffer[iChannels][QTRACTOR_BENCH_STRETCH_CHUNK];
+	float *ppBuffer[iChannels];
+	float *ppInput[iChannels];
+
+	for (unsigned short i = 0; i < iChannels; ++i) {
+		ppBuffer[i] = &aBuffer[i][0];
+		pOutput[i].clear();
+		pOutput[i].reserve(int(float(iFrames) / fTempo)
+			+ QTRACTOR_BENCH_STRETCH_CHUNK);
+	}
+
+	const unsigned long long iStart = qtractorRenderStats::clock();
+
+	unsigned long iFrame = 0;
+	while (iFrame <= iFrames) {
+		if (iFrame < iFrames) {
+			unsigned int nframes = QTRACTOR_BENCH_STRETCH_CHUNK;
+			if (nframes > iFrames - iFrame)
+				nframes = iFrames - iFrame;
+			for (unsigned short i = 0; i < iChannels; ++i)
+				ppInput[i] = ppFrames[i] + iFrame;
+			ts.putFrames(ppInput, nframes);
+			iFrame += nframes;
+		} else {
+			// Last samples in the pipeline...
+			ts.flushInput();
+			++iFrame;
+		}
+		unsigned int nread;
+		while ((nread = ts.receiveFrames(ppBuffer,
+				QTRACTOR_BENCH_STRETCH_CHUNK)) > 0) {
+			for (unsigned short i = 0; i < iChannels; ++i) {
+				for (unsigned int n = 0; n < nread; ++n)
+					pOutput[i].append(aBuffer[i][n]);
+			}
+		}
+	}
+
+	return qtractorRenderStats::clock() - iStart;
+}
+
+
+// Audio track plugin chain: a LADSPA gain (if any) and an aux-send
+// to the master bus (return count); no audio insert, lest the render
+// falls back from the offline (graph) path to JACK freewheeling.
+unsigned int qtractorRenderBench::addAudioPlugins ( qtractorTrack *pTrack )
+{
+	qtractorPluginList *pPluginList = pTrack->pluginList();
+	if (pPluginList == NULL || pPluginList->channels() < 1)
+		return 0;
+
+	qtractorAddPluginCommand *pAddPluginCommand
+		= new qtractorAddPluginCommand();
+	unsigned int iPlugins = 0;
+
+#ifdef CONFIG_LADSPA
+	// Look for the usual (LADSPA SDK) simple amplifier...
+	qtractorPluginFactory *pPluginFactory
+		= qtractorPluginFactory::getInstance();
+	if (pPluginFactory) {
+		const QStringList& paths
+			= pPluginFactory->pluginPaths(qtractorPluginType::Ladspa);
+		QStringListIterator iter(paths);
+		while (iter.hasNext()) {
+			const QFileInfo info(iter.next(), "amp.so");
+			if (!info.exists())
+				continue;
+			qtractorPlugin *pPlugin
+				= qtractorPluginFactory::createPlugin(pPluginList,
+					info.absoluteFilePath(), 0, qtractorPluginType::Ladspa);
+			if (pPlugin) {
+				pPlugin->setActivated(true);
+				pAddPluginCommand->addPlugin(pPlugin);
+				m_bLadspa = true;
+				++iPlugins;
+				break;
+			}
+		}
+	}
+#endif
+
+	const unsigned short iChannels = pPluginList->channels();
+
+	// Aux-send to the master output bus, lest it's a no-op...
+	qtractorPlugin *pAuxSend
+		= qtractorAuxSendPluginType::createPlugin(pPluginList, iChannels);
+	if (pAuxSend) {
+		qtractorAudioAuxSendPlugin *pAudioAuxSend
+			= static_cast<qtractorAudioAuxSendPlugin *> (pAuxSend);
+		qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+		for (qtractorBus *pBus = pAudioEngine->buses().first();
+				pBus; pBus = pBus->next()) {
+			if (pBus->busMode() & qtractorBus::Output) {
+				pAudioAuxSend->setAudioBusName(pBus->busName());
+				break;
+			}
+		}
+		pAuxSend->setActivated(true);
+		pAddPluginCommand->addPlugin(pAuxSend);
+		++iPlugins;
+	}
+
+	if (iPlugins > 0)
+		m_pSession->execute(pAddPluginCommand);
+	else
+		delete pAddPluginCommand;
+
+	return iPlugins;
+}
+
+
+// Audio track gain automation (linear fade-in over the whole range).
+void qtractorRenderBench::addAudioCurve (
+	qtractorTrack *pTrack, unsigned long iFrames ) const
+{
+	qtractorCurveList *pCurveList = pTrack->curveList();
+	if (pCurveList == NULL)
+		return;
+
+	qtractorAudioMonitor *pAudioMonitor
+		= static_cast<qtractorAudioMonitor *> (pTrack->monitor());
+	if (pAudioMonitor == NULL)
+		return;
+
+	qtractorCurve *pCurve = new qtractorCurve(pCurveList,
+		pAudioMonitor->gainSubject(), qtractorCurve::Linear);
+	pCurve->addNode(0, 0.5f);
+	pCurve->addNode(iFrames, 1.0f);
+	pCurve->setProcess(true);
+}
+
+
+// end of qtractorRenderBench.cpp
@@ -0,0 +1,160 @@
+// qtractorRenderBench.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorRenderBench_h
+#define __qtractorRenderBench_h
+
+#include "qtractorRenderStats.h"
+#include "qtractorAudioBuffer.h"
+
+#include <QStringList>
+#include <QVector>
+#include <QList>
+
+
+// Forward declarations.
+class qtractorSession;
+class qtractorTrack;
+class QTextStream;
+
+
+//----------------------------------------------------------------------
+// class qtractorRenderBench -- Synthetic session render benchmark.
+//
+// Fills the current (empty) session with a number of audio tracks,
+// each one streaming a generated audio file clip, some time-stretched,
+// all with a gain automation curve and a plugin chain (a LADSPA gain,
+// if one is found, and an aux-send; no audio inserts, as those would
+// force the JACK freewheeling export path); plus a number of
+// MIDI tracks, each one with a dense generated sequence clip. It then
+// renders (exports) the session for a fixed number of cycles, with
+// timing statistics, and saves the results to a JSON file, so that
+// it can be compared between builds and versions. The time it takes
+// to load (open) all tracks and the MIDI event memory are also kept.
+//
+// Separately, the time-stretch (WSOLA) overlap search is checked on
+// a synthetic stereo signal, at a few tempos and sample rates: the
+// block (SIMD) and FFT-assisted searches are timed against the plain
+// one position at a time reference, and their output compared to it;
+// the block search one must be bit-exact.
+//
+
+class qtractorRenderBench
+{
+public:
+
+	// Constructor.
+	qtractorRenderBench(qtractorSession *pSession,
+		unsigned int iAudioTracks, unsigned int iMidiTracks,
+		unsigned int iCycles);
+
+	// Destructor.
+	~qtractorRenderBench();
+
+	// Synthetic session generator, all files
+	// created in the given directory (non RT-safe).
+	bool build(const QString& sDir);
+
+	// Render the fixed number of cycles (non RT-safe).
+	bool run();
+
+	// Time-stretch overlap search check (non RT-safe);
+	// false if the block search output is not bit-exact.
+	bool stretch();
+
+	// Remove all generated files.
+	void clean();
+
+	// Human readable report.
+	void report(QTextStream& out) const;
+
+	// Machine readable (JSON) results file.
+	bool save(const QString& sFilename) const;
+
+protected:
+
+	// Synthetic file generators.
+	bool createAudioFile(const QString& sFilename,
+		unsigned short iChannels, unsigned long iFrames, float fFreq) const;
+	bool createMidiFile(const QString& sFilename,
+		unsigned long iFrames, unsigned short iNote) const;
+
+	// Audio track plugin chain and automation.
+	unsigned int addAudioPlugins(qtractorTrack *pTrack);
+	void addAudioCurve(qtractorTrack *pTrack, unsigned long iFrames) const;
+
+	// Time-stretch overlap search modes.
+	enum StretchMode { StretchRef, StretchBlock, StretchFft };
+
+	// Time-stretch the given signal, whole output appended (ns).
+	unsigned long long stretchRun(float **ppFrames, unsigned long iFrames,
+		unsigned int iSampleRate, float fTempo, StretchMode mode,
+		QVector<float> *pOutput) const;
+
+private:
+
+	// Instance variables.
+	qtractorSession *m_pSession;
+
+	unsigned int m_iAudioTracks;
+	unsigned int m_iMidiTracks;
+	unsigned int m_iCycles;
+
+	unsigned int m_iPlugins;
+	bool         m_bLadspa;
+
+	// Saved (global) audio cache time-stretch setting.
+	bool         m_bStretchEnabled;
+
+	// Session load time (ns) and MIDI event figures.
+	unsigned long long m_iLoadTime;
+	unsigned long      m_iMidiEvents;
+	unsigned long      m_iMidiBytes;
+
+	// Generated files.
+	QString      m_sDir;
+	QStringList  m_files;
+
+	// Render timing statistics.
+	qtractorRenderStats m_stats;
+
+	// Audio clip read-ahead scheduling statistics.
+	qtractorAudioBufferThread::SyncStats m_syncStats;
+
+	// Time-stretch overlap search statistics, per sample rate.
+	struct StretchStats
+	{
+		unsigned int       sampleRate;
+		unsigned long long refTime;     // one at a time (ns)
+		unsigned long long blockTime;   // block (SIMD) search (ns)
+		unsigned long long fftTime;     // FFT-assisted search (ns)
+		unsigned long      mismatches;  // block vs. reference samples
+		float              fftDelta;    // FFT vs. reference max. abs.
+	};
+
+	QList<StretchStats> m_stretchStats;
+};
+
+
+#endif  // __qtractorRenderBench_h
+
+
+// end of qtractorRenderBench.h
@@ -0,0 +1,309 @@
+// qtractorRenderStats.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorRenderStats.h"
+
+#include "qtractorSession.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorPlugin.h"
+
+#include <QTextStream>
+
+#include <algorithm>
+
+#include <time.h>
+
+
+//----------------------------------------------------------------------
+// class qtractorRenderStats -- Audio export (render) timing statistics.
+//
+
+// Global (current) instance.
+qtractorRenderStats *qtractorRenderStats::g_pRenderStats = NULL;
+
+
+// Constructor.
+qtractorRenderStats::qtractorRenderStats ( qtractorSession *pSession )
+	: m_pSession(pSession)
+{
+	m_iFrames    = 0;
+	m_iWallStart = 0;
+	m_iWallTime  = 0;
+
+	m_iOfflineCycles = 0;
+	m_iGraphCycles   = 0;
+}
+
+
+// Destructor.
+qtractorRenderStats::~qtractorRenderStats (void)
+{
+	if (g_pRenderStats == this)
+		g_pRenderStats = NULL;
+}
+
+
+// Monotonic clock (nanoseconds).
+unsigned long long qtractorRenderStats::clock (void)
+{
+	struct timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+// Global (current) instance accessors (non RT-safe).
+void qtractorRenderStats::setInstance ( qtractorRenderStats *pRenderStats )
+{
+	g_pRenderStats = pRenderStats;
+}
+
+qtractorRenderStats *qtractorRenderStats::getInstance (void)
+{
+	return g_pRenderStats;
+}
+
+
+// Reset all statistics (non RT-safe).
+void qtractorRenderStats::reset (void)
+{
+	m_iFrames    = 0;
+	m_iWallStart = 0;
+	m_iWallTime  = 0;
+
+	m_iOfflineCycles = 0;
+	m_iGraphCycles   = 0;
+
+	m_cycles.clear();
+	m_index.clear();
+
+	// Register all tracks and plugins...
+	QList<qtractorPluginList *> lists;
+	for (qtractorTrack *pTrack = m_pSession->tracks().first();
+			pTrack; pTrack = pTrack->next()) {
+		m_index.insert(pTrack, m_index.count());
+		lists.append(pTrack->pluginList());
+	}
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine) {
+		for (qtractorBus *pBus = pAudioEngine->buses().first();
+				pBus; pBus = pBus->next()) {
+			qtractorAudioBus *pAudioBus
+				= static_cast<qtractorAudioBus *> (pBus);
+			if (pAudioBus->pluginList_in())
+				lists.append(pAudioBus->pluginList_in());
+			if (pAudioBus->pluginList_out())
+				lists.append(pAudioBus->pluginList_out());
+		}
+	}
+
+	QListIterator<qtractorPluginList *> iter(lists);
+	while (iter.hasNext()) {
+		qtractorPluginList *pPluginList = iter.next();
+		for (qtractorPlugin *pPlugin = pPluginList->first();
+				pPlugin; pPlugin = pPlugin->next()) {
+			m_index.insert(pPlugin, m_index.count());
+		}
+	}
+
+	m_times.fill(0, m_index.count());
+}
+
+
+// Wall time start/stop (non RT-safe).
+void qtractorRenderStats::start (void)
+{
+	m_iWallStart = clock();
+}
+
+void qtractorRenderStats::stop (void)
+{
+	m_iWallTime += clock() - m_iWallStart;
+}
+
+
+// Render cycle time accounting.
+void qtractorRenderStats::addCycle ( unsigned int nframes,
+	unsigned long long iTime, bool bOffline, bool bGraph )
+{
+	m_iFrames += nframes;
+	m_cycles.append(iTime);
+
+	if (bOffline)
+		++m_iOfflineCycles;
+	if (bGraph)
+		++m_iGraphCycles;
+}
+
+
+// Track or plugin time accounting (registered ones only).
+void qtractorRenderStats::addTime (
+	const void *pObject, unsigned long long iTime )
+{
+	QHash<const void *, int>::ConstIterator iter = m_index.constFind(pObject);
+	if (iter != m_index.constEnd())
+		m_times[iter.value()] += iTime;
+}
+
+
+// Statistics accessors (nanoseconds).
+unsigned long qtractorRenderStats::cycles (void) const
+{
+	return m_cycles.count();
+}
+
+unsigned long qtractorRenderStats::offlineCycles (void) const
+{
+	return m_iOfflineCycles;
+}
+
+unsigned long qtractorRenderStats::graphCycles (void) const
+{
+	return m_iGraphCycles;
+}
+
+unsigned long long qtractorRenderStats::frames (void) const
+{
+	return m_iFrames;
+}
+
+unsigned long long qtractorRenderStats::wallTime (void) const
+{
+	return m_iWallTime;
+}
+
+
+// Cycle time percentile (0=min, 100=max).
+unsigned long long qtractorRenderStats::cycleTime ( float fPercent ) const
+{
+	const int iCycles = m_cycles.count();
+	if (iCycles < 1)
+		return 0;
+
+	QVector<unsigned long long> cycles(m_cycles);
+	int i = int(fPercent * float(iCycles - 1) / 100.0f + 0.5f);
+	if (i < 0)
+		i = 0;
+	else
+	if (i > iCycles - 1)
+		i = iCycles - 1;
+	std::nth_element(cycles.begin(), cycles.begin() + i, cycles.end());
+
+	return cycles.at(i);
+}
+
+
+unsigned long long qtractorRenderStats::cycleAvgTime (void) const
+{
+	const int iCycles = m_cycles.count();
+	if (iCycles < 1)
+		return 0;
+
+	unsigned long long iTime = 0;
+	for (int i = 0; i < iCycles; ++i)
+		iTime += m_cycles.at(i);
+
+	return iTime / iCycles;
+}
+
+
+unsigned long long qtractorRenderStats::time ( const void *pObject ) const
+{
+	QHash<const void *, int>::ConstIterator iter = m_index.constFind(pObject);
+	if (iter != m_index.constEnd())
+		return m_times.at(iter.value());
+	else
+		return 0;
+}
+
+
+// Human readable report.
+void qtractorRenderStats::report ( QTextStream& out ) const
+{
+	const float fWallTime = float(m_iWallTime) * 1e-9f;
+	const unsigned int iSampleRate = m_pSession->sampleRate();
+	const float fAudioTime = (iSampleRate > 0
+		? float(m_iFrames) / float(iSampleRate) : 0.0f);
+
+	out << QString("Frames:      %1 (%2 s)\n")
+		.arg(m_iFrames).arg(fAudioTime, 0, 'f', 3);
+	out << QString("Wall time:   %1 s (%2x real-time)\n")
+		.arg(fWallTime, 0, 'f', 3)
+		.arg(fWallTime > 0.0f ? fAudioTime / fWallTime : 0.0f, 0, 'f', 2);
+	out << QString("Cycles:      %1 (%2 offline, %3 graph)\n")
+		.arg(cycles()).arg(m_iOfflineCycles).arg(m_iGraphCycles);
+	out << QString("Cycle time:  min %1 / avg %2 / p99 %3 / max %4 us\n")
+		.arg(float(cycleTime(0.0f))   * 1e-3f, 0, 'f', 1)
+		.arg(float(cycleAvgTime())    * 1e-3f, 0, 'f', 1)
+		.arg(float(cycleTime(99.0f))  * 1e-3f, 0, 'f', 1)
+		.arg(float(cycleTime(100.0f)) * 1e-3f, 0, 'f', 1);
+
+	// Per-track (and per-plugin) CPU load,
+	// relative to the total wall time...
+	const float fScale = (m_iWallTime > 0 ? 100.0f / float(m_iWallTime) : 0.0f);
+	out << "Tracks:\n";
+	for (qtractorTrack *pTrack = m_pSession->tracks().first();
+			pTrack; pTrack = pTrack->next()) {
+		out << QString("  %1: %2 ms (%3%)\n")
+			.arg(pTrack->trackName())
+			.arg(float(time(pTrack)) * 1e-6f, 0, 'f', 1)
+			.arg(float(time(pTrack)) * fScale, 0, 'f', 1);
+		qtractorPluginList *pPluginList = pTrack->pluginList();
+		for (qtractorPlugin *pPlugin = pPluginList->first();
+				pPlugin; pPlugin = pPlugin->next()) {
+			out << QString("    %1: %2 ms (%3%)\n")
+				.arg(pPlugin->type()->name())
+				.arg(float(time(pPlugin)) * 1e-6f, 0, 'f', 1)
+				.arg(float(time(pPlugin)) * fScale, 0, 'f', 1);
+		}
+	}
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return;
+
+	out << "Buses:\n";
+	for (qtractorBus *pBus = pAudioEngine->buses().first();
+			pBus; pBus = pBus->next()) {
+		qtractorAudioBus *pAudioBus
+			= static_cast<qtractorAudioBus *> (pBus);
+		out << QString("  %1:\n").arg(pAudioBus->busName());
+		qtractorPluginList *pPluginLists[2]
+			= { pAudioBus->pluginList_in(), pAudioBus->pluginList_out() };
+		for (int i = 0; i < 2; ++i) {
+			if (pPluginLists[i] == NULL)
+				continue;
+			for (qtractorPlugin *pPlugin = pPluginLists[i]->first();
+					pPlugin; pPlugin = pPlugin->next()) {
+				out << QString("    %1: %2 ms (%3%)\n")
+					.arg(pPlugin->type()->name())
+					.arg(float(time(pPlugin)) * 1e-6f, 0, 'f', 1)
+					.arg(float(time(pPlugin)) * fScale, 0, 'f', 1);
+			}
+		}
+	}
+}
+
+
+// end of qtractorRenderStats.cpp
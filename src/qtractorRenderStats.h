@@ -0,0 +1,118 @@
+// qtractorRenderStats.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorRenderStats_h
+#define __qtractorRenderStats_h
+
+#include <QHash>
+#include <QVector>
+
+
+// Forward declarations.
+class qtractorSession;
+class QTextStream;
+
+
+//----------------------------------------------------------------------
+// class qtractorRenderStats -- Audio export (render) timing statistics.
+//
+// While a global instance is set, every export (render) cycle gets
+// its wall time recorded, along with the time spent on each track and
+// on each plugin. All the tracks and plugins are registered up-front,
+// so that accounting doesn't need any locking at all: each one is
+// only ever processed by one thread at a time.
+//
+
+class qtractorRenderStats
+{
+public:
+
+	// Constructor.
+	qtractorRenderStats(qtractorSession *pSession);
+
+	// Destructor.
+	~qtractorRenderStats();
+
+	// Monotonic clock (nanoseconds).
+	static unsigned long long clock();
+
+	// Global (current) instance accessors (non RT-safe).
+	static void setInstance(qtractorRenderStats *pRenderStats);
+	static qtractorRenderStats *getInstance();
+
+	// Reset all statistics (non RT-safe);
+	// follows current session tracks and plugins.
+	void reset();
+
+	// Wall time start/stop (non RT-safe).
+	void start();
+	void stop();
+
+	// Render cycle time accounting;
+	// also which path (offline, parallel graph) it took.
+	void addCycle(unsigned int nframes, unsigned long long iTime,
+		bool bOffline = false, bool bGraph = false);
+
+	// Track or plugin time accounting (registered ones only).
+	void addTime(const void *pObject, unsigned long long iTime);
+
+	// Statistics accessors (nanoseconds).
+	unsigned long cycles() const;
+	unsigned long offlineCycles() const;
+	unsigned long graphCycles() const;
+	unsigned long long frames() const;
+	unsigned long long wallTime() const;
+	unsigned long long cycleTime(float fPercent) const;
+	unsigned long long cycleAvgTime() const;
+	unsigned long long time(const void *pObject) const;
+
+	// Human readable report.
+	void report(QTextStream& out) const;
+
+private:
+
+	// Instance variables.
+	qtractorSession *m_pSession;
+
+	unsigned long long m_iFrames;
+	unsigned long long m_iWallStart;
+	unsigned long long m_iWallTime;
+
+	// Offline and parallel graph cycle counts.
+	unsigned long m_iOfflineCycles;
+	unsigned long m_iGraphCycles;
+
+	// Per-cycle times.
+	QVector<unsigned long long> m_cycles;
+
+	// Per-track and per-plugin accumulated times.
+	QHash<const void *, int> m_index;
+	QVector<unsigned long long> m_times;
+
+	// Global (current) instance.
+	static qtractorRenderStats *g_pRenderStats;
+};
+
+
+#endif  // __qtractorRenderStats_h
+
+
+// end of qtractorRenderStats.h
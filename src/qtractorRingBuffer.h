@@ -1,7 +1,7 @@
 // qtractorRingBuffer.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2011, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -29,9 +29,22 @@
 #include <string.h>
 
 
+// Cache-line size (bytes; for padding purposes only).
+#define QTRACTOR_CACHE_LINE_SIZE	64
+
+
 //----------------------------------------------------------------------
 // class qtractorRingBuffer -- Ring buffer/cache template declaration.
 //
+// Lock-free single-producer/single-consumer ring-buffer. The read and
+// write indexes live on their own separate cache-lines, along with a
+// cached copy of the opposite index, so that the producer and consumer
+// threads only touch each other's cache-line when their own cached view
+// runs short (acquire), while each read() or write() publishes its new
+// index just once, for all channels (release). Index overrides (seek,
+// reset) bump an epoch counter first, then publish the new index, so
+// that whoever sees the new index also sees the new epoch.
+//
 
 template<typename T>
 class qtractorRingBuffer
@@ -70,15 +83,45 @@ public:
 	void setWriteIndex(unsigned int iWriteIndex);
 	unsigned int writeIndex() const;
 
+	// Zero-copy write commitment (producer): publish frames
+	// already stored through the direct buffer accessor.
+	void commitWrite(unsigned int iFrames);
+
+protected:
+
+	// Frame data copy helpers.
+	void copyFrom(T **ppFrames, unsigned int iOffset,
+		unsigned int i0, unsigned int iFrames);
+	void copyTo(T **ppFrames, unsigned int iOffset,
+		unsigned int i0, unsigned int iFrames);
+
 private:
 
+	// Shared read-only properties.
 	unsigned short m_iChannels;
 	unsigned int   m_iBufferSize;
 	unsigned int   m_iBufferMask;
+
+	T** m_ppBuffer;
+
+	// Index reset/override epoch (seldom written).
+	qtractorAtomic m_iEpoch;
+
+	char m_pad0[QTRACTOR_CACHE_LINE_SIZE];
+
+	// Consumer side.
 	qtractorAtomic m_iReadIndex;
+	unsigned int   m_iWriteCache;
+	int            m_iWriteEpoch;
+
+	char m_pad1[QTRACTOR_CACHE_LINE_SIZE];
+
+	// Producer side.
 	qtractorAtomic m_iWriteIndex;
+	unsigned int   m_iReadCache;
+	int            m_iReadEpoch;
 
-	T** m_ppBuffer;
+	char m_pad2[QTRACTOR_CACHE_LINE_SIZE];
 };
 
 
@@ -107,8 +150,16 @@ qtractorRingBuffer<T>::qtractorRingBuffer ( unsigned short iChannels,
 	for (unsigned short i = 0; i < m_iChannels; ++i)
 		m_ppBuffer[i] = new T [m_iBufferSize];
 
+	ATOMIC_SET(&m_iEpoch, 0);
+
 	ATOMIC_SET(&m_iReadIndex,  0);
 	ATOMIC_SET(&m_iWriteIndex, 0);
+
+	m_iWriteCache = 0;
+	m_iWriteEpoch = 0;
+
+	m_iReadCache  = 0;
+	m_iReadEpoch  = 0;
 }
 
 // Default destructor.
@@ -124,117 +175,127 @@ qtractorRingBuffer<T>::~qtractorRingBuffer (void)
 }
 
 
+// Ring-buffer cache properties (exact; any thread).
 template<typename T>
 unsigned int qtractorRingBuffer<T>::readable (void) const
 {
-	unsigned int w = ATOMIC_GET(&m_iWriteIndex);
-	unsigned int r = ATOMIC_GET(&m_iReadIndex);
-	if (w > r) {
-		return (w - r);
-	} else {
-		return (w - r + m_iBufferSize) & m_iBufferMask;
-	}
+	const unsigned int w = ATOMIC_GET_ACQUIRE(&m_iWriteIndex);
+	const unsigned int r = ATOMIC_GET_ACQUIRE(&m_iReadIndex);
+	return (w - r) & m_iBufferMask;
 }
 
 template<typename T>
 unsigned int qtractorRingBuffer<T>::writable (void) const
 {
-	unsigned int w = ATOMIC_GET(&m_iWriteIndex);
-	unsigned int r = ATOMIC_GET(&m_iReadIndex);
-	if (w > r){
-		return ((r - w + m_iBufferSize) & m_iBufferMask) - 1;
-	} else if (r > w) {
-		return (r - w) - 1;
-	} else {
-		return m_iBufferSize - 1;
-	}
+	const unsigned int w = ATOMIC_GET_ACQUIRE(&m_iWriteIndex);
+	const unsigned int r = ATOMIC_GET_ACQUIRE(&m_iReadIndex);
+	return (r - w - 1) & m_iBufferMask;
 }
 
 
-// Buffer raw data read.
+// Buffer raw data read (consumer).
 template<typename T>
 int qtractorRingBuffer<T>::read ( T **ppFrames, unsigned int iFrames,
 	unsigned int iOffset )
 {
-	unsigned int rs = readable();
+	const unsigned int r = ATOMIC_GET(&m_iReadIndex);
+
+	// Refresh producer index only when the cached one falls short...
+	const int iEpoch = ATOMIC_GET_ACQUIRE(&m_iEpoch);
+	unsigned int rs = (m_iWriteCache - r) & m_iBufferMask;
+	if (rs < iFrames || m_iWriteEpoch != iEpoch) {
+		m_iWriteCache = ATOMIC_GET_ACQUIRE(&m_iWriteIndex);
+		m_iWriteEpoch = iEpoch;
+		rs = (m_iWriteCache - r) & m_iBufferMask;
+	}
+
 	if (rs == 0)
 		return 0;
 
 	if (iFrames > rs)
 		iFrames = rs;
 
-	unsigned int r = ATOMIC_GET(&m_iReadIndex);
-
-	unsigned int n1, n2;
 	if (r + iFrames > m_iBufferSize) {
-		n1 = (m_iBufferSize - r);
-		n2 = (r + iFrames) & m_iBufferMask;
+		const unsigned int n1 = (m_iBufferSize - r);
+		copyTo(ppFrames, iOffset, r, n1);
+		copyTo(ppFrames, iOffset + n1, 0, iFrames - n1);
 	} else {
-		n1 = iFrames;
-		n2 = 0;
+		copyTo(ppFrames, iOffset, r, iFrames);
 	}
 
-	for (unsigned short i = 0; i < m_iChannels; ++i) {
-		::memcpy((T *)(ppFrames[i] + iOffset),
-			(T *)(m_ppBuffer[i] + r), n1 * sizeof(T));
-		if (n2) {
-			n1 += iOffset;
-			::memcpy((T *)(ppFrames[i] + n1),
-				m_ppBuffer[i], n2 * sizeof(T));
-		}
-	}
-
-	ATOMIC_SET(&m_iReadIndex, (r + iFrames) & m_iBufferMask);
+	ATOMIC_SET_RELEASE(&m_iReadIndex, (r + iFrames) & m_iBufferMask);
 
 	return iFrames;
 }
 
 
-// Buffer raw data write.
+// Buffer raw data write (producer).
 template<typename T>
 int qtractorRingBuffer<T>::write ( T **ppFrames, unsigned int iFrames,
 	unsigned int iOffset )
 {
-	unsigned int ws = writable();
+	const unsigned int w = ATOMIC_GET(&m_iWriteIndex);
+
+	// Refresh consumer index only when the cached one falls short...
+	const int iEpoch = ATOMIC_GET_ACQUIRE(&m_iEpoch);
+	unsigned int ws = (m_iReadCache - w - 1) & m_iBufferMask;
+	if (ws < iFrames || m_iReadEpoch != iEpoch) {
+		m_iReadCache = ATOMIC_GET_ACQUIRE(&m_iReadIndex);
+		m_iReadEpoch = iEpoch;
+		ws = (m_iReadCache - w - 1) & m_iBufferMask;
+	}
+
 	if (ws == 0)
 		return 0;
 
 	if (iFrames > ws)
 		iFrames = ws;
 
-	unsigned int w = ATOMIC_GET(&m_iWriteIndex);
-
-	unsigned int n1, n2;
 	if (w + iFrames > m_iBufferSize) {
-		n1 = (m_iBufferSize - w);
-		n2 = (w + iFrames) & m_iBufferMask;
+		const unsigned int n1 = (m_iBufferSize - w);
+		copyFrom(ppFrames, iOffset, w, n1);
+		copyFrom(ppFrames, iOffset + n1, 0, iFrames - n1);
 	} else {
-		n1 = iFrames;
-		n2 = 0;
+		copyFrom(ppFrames, iOffset, w, iFrames);
 	}
 
+	ATOMIC_SET_RELEASE(&m_iWriteIndex, (w + iFrames) & m_iBufferMask);
+
+	return iFrames;
+}
+
+
+// Frame data copy helpers: ring-buffer from/to frames.
+template<typename T>
+void qtractorRingBuffer<T>::copyFrom ( T **ppFrames, unsigned int iOffset,
+	unsigned int i0, unsigned int iFrames )
+{
 	for (unsigned short i = 0; i < m_iChannels; ++i) {
-		::memcpy((T *)(m_ppBuffer[i] + w),
-			(T *)(ppFrames[i] + iOffset), n1 * sizeof(T));
-		if (n2 > 0) {
-			n1 += iOffset;
-			::memcpy(m_ppBuffer[i],
-				(T *)(ppFrames[i] + n1), n2 * sizeof(T));
-		}
+		::memcpy((T *)(m_ppBuffer[i] + i0),
+			(T *)(ppFrames[i] + iOffset), iFrames * sizeof(T));
 	}
+}
 
-	ATOMIC_SET(&m_iWriteIndex, (w + iFrames) & m_iBufferMask);
-
-	return iFrames;
+template<typename T>
+void qtractorRingBuffer<T>::copyTo ( T **ppFrames, unsigned int iOffset,
+	unsigned int i0, unsigned int iFrames )
+{
+	for (unsigned short i = 0; i < m_iChannels; ++i) {
+		::memcpy((T *)(ppFrames[i] + iOffset),
+			(T *)(m_ppBuffer[i] + i0), iFrames * sizeof(T));
+	}
 }
 
 
-// Reset this buffers state.
+// Reset this buffers state
+// (epoch goes first, before publishing the new indexes).
 template<typename T>
 void qtractorRingBuffer<T>::reset (void)
 {
-	ATOMIC_SET(&m_iReadIndex,  0);
-	ATOMIC_SET(&m_iWriteIndex, 0);
+	ATOMIC_INC(&m_iEpoch);
+
+	ATOMIC_SET_RELEASE(&m_iReadIndex,  0);
+	ATOMIC_SET_RELEASE(&m_iWriteIndex, 0);
 }
 
 
@@ -242,13 +303,15 @@ void qtractorRingBuffer<T>::reset (void)
 template<typename T>
 void qtractorRingBuffer<T>::setReadIndex ( unsigned int iReadIndex )
 {
-	ATOMIC_SET(&m_iReadIndex, (iReadIndex & m_iBufferMask));
+	ATOMIC_INC(&m_iEpoch);
+
+	ATOMIC_SET_RELEASE(&m_iReadIndex, (iReadIndex & m_iBufferMask));
 }
 
 template<typename T>
 unsigned int qtractorRingBuffer<T>::readIndex (void) const
 {
-	return ATOMIC_GET(&m_iReadIndex);
+	return ATOMIC_GET_ACQUIRE(&m_iReadIndex);
 }
 
 
@@ -256,13 +319,25 @@ unsigned int qtractorRingBuffer<T>::readIndex (void) const
 template<typename T>
 void qtractorRingBuffer<T>::setWriteIndex ( unsigned int iWriteIndex )
 {
-	ATOMIC_SET(&m_iWriteIndex, (iWriteIndex & m_iBufferMask));
+	ATOMIC_INC(&m_iEpoch);
+
+	ATOMIC_SET_RELEASE(&m_iWriteIndex, (iWriteIndex & m_iBufferMask));
 }
 
 template<typename T>
 unsigned int qtractorRingBuffer<T>::writeIndex (void) const
 {
-	return ATOMIC_GET(&m_iWriteIndex);
+	return ATOMIC_GET_ACQUIRE(&m_iWriteIndex);
+}
+
+
+// Zero-copy write commitment (producer; no index override epoch).
+template<typename T>
+void qtractorRingBuffer<T>::commitWrite ( unsigned int iFrames )
+{
+	const unsigned int w = ATOMIC_GET(&m_iWriteIndex);
+
+	ATOMIC_SET_RELEASE(&m_iWriteIndex, (w + iFrames) & m_iBufferMask);
 }
 
 
@@ -22,13 +22,16 @@
 #include "qtractorAbout.h"
 #include "qtractorSession.h"
 #include "qtractorSessionCursor.h"
+#include "qtractorSessionSnapshot.h"
 
 #include "qtractorSessionDocument.h"
 
 #include "qtractorAudioEngine.h"
 #include "qtractorAudioPeak.h"
+#include "qtractorAudioCache.h"
 #include "qtractorAudioClip.h"
 #include "qtractorAudioBuffer.h"
+#include "qtractorAudioGraph.h"
 
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiClip.h"
@@ -54,6 +57,14 @@
 #include <stdlib.h>
 
 
+// Snapshot pointer atomic load (acquire).
+#if QT_VERSION >= 0x050000
+#define SNAPSHOT_GET(p)	((p)->loadAcquire())
+#else
+#define SNAPSHOT_GET(p)	((qtractorSessionSnapshot *) *(p))
+#endif
+
+
 //-------------------------------------------------------------------------
 // qtractorSession::Properties -- Session properties structure.
 
@@ -107,15 +118,27 @@ qtractorSession::qtractorSession (void)
 	// Initial comon client name.
 	m_sClientName = QTRACTOR_TITLE;
 
+	// Initial (empty) track topology snapshot.
+	m_pMidiEngine  = NULL;
+	m_pAudioEngine = NULL;
+
+	for (int i = 0; i < SnapshotReaders; ++i)
+		ATOMIC_SET(&m_snapshotReaders[i], 0);
+
+	m_iSnapshotSerial = 1;
+	m_pSnapshot.fetchAndStoreOrdered(
+		new qtractorSessionSnapshot(m_iSnapshotSerial, 0));
+
 	// Singleton ownings.
 	m_pFiles       = new qtractorFileList();
 	m_pCommands    = new qtractorCommandList();
 	m_pInstruments = new qtractorInstrumentList();
 
 	// The dubious permanency of the crucial device engines.
-	m_pMidiEngine       = new qtractorMidiEngine(this);
-	m_pAudioEngine      = new qtractorAudioEngine(this);
-	m_pAudioPeakFactory = new qtractorAudioPeakFactory();
+	m_pMidiEngine        = new qtractorMidiEngine(this);
+	m_pAudioEngine       = new qtractorAudioEngine(this);
+	m_pAudioPeakFactory  = new qtractorAudioPeakFactory();
+	m_pAudioCacheFactory = new qtractorAudioCacheFactory();
 
 	m_bAutoTimeStretch  = false;
 
@@ -131,6 +154,7 @@ qtractorSession::~qtractorSession (void)
 	close();
 	clear();
 
+	delete m_pAudioCacheFactory;
 	delete m_pAudioPeakFactory;
 	delete m_pAudioEngine;
 	delete m_pMidiEngine;
@@ -140,6 +164,16 @@ qtractorSession::~qtractorSession (void)
 
 	delete m_pFiles;
 
+	delete SNAPSHOT_GET(&m_pSnapshot);
+
+	qDeleteAll(m_retiredSnapshots);
+	m_retiredSnapshots.clear();
+
+	QListIterator<qtractorClip **> iter(m_retiredClips);
+	while (iter.hasNext())
+		delete [] iter.next();
+	m_retiredClips.clear();
+
 	g_pSession = NULL;
 }
 
@@ -240,6 +274,16 @@ void qtractorSession::clear (void)
 
 	m_pCurrentTrack = NULL;
 
+	// Get all tracks out of sight first...
+	m_detachedTracks.clear();
+	m_changedTracks.clear();
+
+	// Wait for them all to be really out of sight...
+	if (!publishSnapshot(new qtractorSessionSnapshot(++m_iSnapshotSerial, 0))) {
+		while (!synchronize())
+			stabilize();
+	}
+
 	m_tracks.clear();
 	m_cursors.clear();
 
@@ -308,6 +352,7 @@ void qtractorSession::clear (void)
 	}
 
 	m_pAudioPeakFactory->cleanup();
+	m_pAudioCacheFactory->cleanup();
 
 	qtractorMidiControl *pMidiControl = qtractorMidiControl::getInstance();
 	if (pMidiControl)
@@ -414,6 +459,11 @@ void qtractorSession::updateSession (
 	if (pMarker &&
 		m_iSessionEnd < pMarker->frame)
 		m_iSessionEnd = pMarker->frame;
+
+	// Refresh track clip indexes, if any gone stale...
+	qtractorSessionSnapshot *pSnapshot = snapshot();
+	if (pSnapshot && pSnapshot->isClipIndexStale())
+		updateSnapshot();
 }
 
 
@@ -843,6 +893,30 @@ void qtractorSession::updateSampleRate ( unsigned int iSampleRate )
 }
 
 
+// Update from a bigger buffer-size (period);
+// must be called while the engines are shut down.
+void qtractorSession::updateBufferSize ( unsigned int iBufferSize )
+{
+	for (qtractorTrack *pTrack = m_tracks.first();
+			pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		for (qtractorClip *pClip = pTrack->clips().first();
+				pClip; pClip = pClip->next()) {
+			qtractorAudioClip *pAudioClip
+				= static_cast<qtractorAudioClip *> (pClip);
+			if (pAudioClip)
+				pAudioClip->setBufferSize(iBufferSize);
+		}
+		// Track freeze (hidden) clip too, if any...
+		qtractorAudioClip *pFreezeClip
+			= static_cast<qtractorAudioClip *> (pTrack->freezeClip());
+		if (pFreezeClip)
+			pFreezeClip->setBufferSize(iBufferSize);
+	}
+}
+
+
 
 // Alternate properties accessor.
 qtractorSession::Properties& qtractorSession::properties (void)
@@ -890,15 +964,12 @@ void qtractorSession::insertTrack ( qtractorTrack *pTrack,
 	if (pTrack->curveList())
 		m_curves.insert(pTrack->curveList(), pTrack);
 
-	qtractorSessionCursor *pSessionCursor = m_cursors.first();
-	while (pSessionCursor) {
-		pSessionCursor->addTrack(pTrack);
-		pSessionCursor = pSessionCursor->next();
-	}
-
 	pTrack->setLoop(m_iLoopStart, m_iLoopEnd);
 	pTrack->open();
 
+	// Only now it gets into the RT threads sight...
+	updateSnapshot();
+
 //	unlock();
 }
 
@@ -914,11 +985,7 @@ void qtractorSession::moveTrack (
 	else
 		m_tracks.append(pTrack);
 
-	qtractorSessionCursor *pSessionCursor = m_cursors.first();
-	while (pSessionCursor) {
-		pSessionCursor->resetClips();
-		pSessionCursor = pSessionCursor->next();
-	}
+	updateSnapshot();
 
 //	unlock();
 }
@@ -930,11 +997,8 @@ void qtractorSession::updateTrack ( qtractorTrack *pTrack )
 
 	pTrack->setLoop(m_iLoopStart, m_iLoopEnd);
 
-	qtractorSessionCursor *pSessionCursor = m_cursors.first();
-	while (pSessionCursor) {
-		pSessionCursor->updateTrack(pTrack);
-		pSessionCursor = pSessionCursor->next();
-	}
+	// Session cursors shall relocate on next snapshot...
+	m_changedTracks.insert(pTrack);
 
 //	unlock();
 }
@@ -944,13 +1008,16 @@ void qtractorSession::unlinkTrack ( qtractorTrack *pTrack )
 {
 //	lock();
 
-	pTrack->setLoop(0, 0);
-	pTrack->close();
+	// Get it out of the RT threads sight first...
+	m_tracks.unlink(pTrack);
+	m_detachedTracks.remove(pTrack);
+	m_changedTracks.remove(pTrack);
 
-	qtractorSessionCursor *pSessionCursor = m_cursors.first();
-	while (pSessionCursor) {
-		pSessionCursor->removeTrack(pTrack);
-		pSessionCursor = pSessionCursor->next();
+	// Only close it when surely out of sight; otherwise
+	// leave it open, to be closed on its own deletion...
+	if (updateSnapshot()) {
+		pTrack->setLoop(0, 0);
+		pTrack->close();
 	}
 
 	if (pTrack->isRecord())
@@ -966,12 +1033,19 @@ void qtractorSession::unlinkTrack ( qtractorTrack *pTrack )
 	if (pTrack->trackType() == qtractorTrack::Midi)
 		releaseMidiTag(pTrack);
 
-	m_tracks.unlink(pTrack);
-
 //	unlock();
 }
 
 
+// Update current track clip under (RT) cursors.
+void qtractorSession::updateTrackClip ( qtractorTrack *pTrack )
+{
+	m_changedTracks.insert(pTrack);
+
+	updateSnapshot();
+}
+
+
 qtractorTrack *qtractorSession::trackAt ( int iTrack ) const
 {
 	return m_tracks.at(iTrack);
@@ -1100,6 +1174,51 @@ void qtractorSession::resetAllPlugins (void)
 }
 
 
+// Switch audio clips over to a ready cache file, as soon as it gets
+// done, instead of waiting for their next (re)open: all buffers still
+// reading from source (eg. stretching on the fly) are just reopened.
+void qtractorSession::updateAudioCache ( const QString& sCachePath )
+{
+	QList<qtractorAudioClip *> clips;
+	QList<qtractorAudioBuffer *> buffers;
+
+	for (qtractorTrack *pTrack = m_tracks.first();
+			pTrack; pTrack = pTrack->next()) {
+		if (pTrack->trackType() != qtractorTrack::Audio)
+			continue;
+		for (qtractorClip *pClip = pTrack->clips().first();
+				pClip; pClip = pClip->next()) {
+			qtractorAudioClip *pAudioClip
+				= static_cast<qtractorAudioClip *> (pClip);
+			qtractorAudioBuffer *pBuff = pAudioClip->buffer();
+			if (pBuff == NULL || buffers.contains(pBuff))
+				continue;
+			if (pBuff->cachePending() != sCachePath)
+				continue;
+			clips.append(pAudioClip);
+			buffers.append(pBuff);
+			detachTrack(pTrack);
+		}
+	}
+
+	if (clips.isEmpty())
+		return;
+
+	// Take those tracks out of RT processing sight...
+	if (updateSnapshot()) {
+		// Reopen (seeking back in sync is up to the RT thread)...
+		QListIterator<qtractorAudioClip *> iter(clips);
+		while (iter.hasNext()) {
+			qtractorAudioClip *pAudioClip = iter.next();
+			pAudioClip->buffer()->open(pAudioClip->filename());
+		}
+	}
+
+	// Back into RT processing sight...
+	attachTracks();
+}
+
+
 // MIDI engine accessor.
 qtractorMidiEngine *qtractorSession::midiEngine (void) const
 {
@@ -1211,8 +1330,15 @@ void qtractorSession::seek ( unsigned long iFrame, bool bSync )
 	if (bSync)
 		resetAllPlugins();
 
-	m_pAudioEngine->sessionCursor()->seek(iFrame, bSync);
-	m_pMidiEngine->sessionCursor()->seek(iFrame, bSync);
+	qtractorSessionSnapshot *pSnapshot = snapshot();
+
+	qtractorSessionCursor *pAudioCursor = m_pAudioEngine->sessionCursor();
+	pAudioCursor->sync(pSnapshot);
+	pAudioCursor->seek(iFrame, bSync);
+
+	qtractorSessionCursor *pMidiCursor = m_pMidiEngine->sessionCursor();
+	pMidiCursor->sync(pSnapshot);
+	pMidiCursor->seek(iFrame, bSync);
 }
 
 
@@ -1245,6 +1371,9 @@ void qtractorSession::unlock (void)
 	// Unwind pending locks and force back to business...
 	if (ATOMIC_DEC(&m_locks) < 1) {
 		ATOMIC_SET(&m_locks, 0);
+		// Parallel process graph might need an update...
+		if (m_pAudioEngine)
+			m_pAudioEngine->updateGraph();
 		release();
 	}
 }
@@ -1257,6 +1386,157 @@ bool qtractorSession::isBusy (void) const
 }
 
 
+// Track topology snapshot read-side section (RT-safe).
+qtractorSessionSnapshot *qtractorSession::enterSnapshot (
+	SnapshotReader reader )
+{
+	// Odd means we're inside...
+	ATOMIC_INC(&m_snapshotReaders[reader]);
+
+	return SNAPSHOT_GET(&m_pSnapshot);
+}
+
+void qtractorSession::leaveSnapshot ( SnapshotReader reader )
+{
+	// Even means we're outside, again...
+	ATOMIC_INC(&m_snapshotReaders[reader]);
+}
+
+
+// Current track topology snapshot (non RT-safe).
+qtractorSessionSnapshot *qtractorSession::snapshot (void) const
+{
+	return SNAPSHOT_GET(&m_pSnapshot);
+}
+
+
+// (Re)publish current track topology snapshot (non RT-safe).
+bool qtractorSession::updateSnapshot (void)
+{
+	qtractorSessionSnapshot *pOldSnapshot = snapshot();
+
+	// Keep track of last change serials...
+	QHash<qtractorTrack *, unsigned int> serials;
+	const unsigned int iOldTracks = pOldSnapshot->tracks();
+	for (unsigned int i = 0; i < iOldTracks; ++i)
+		serials.insert(pOldSnapshot->track(i), pOldSnapshot->trackSerial(i));
+
+	const unsigned int iSerial = ++m_iSnapshotSerial;
+	const unsigned int iTracks = m_tracks.count();
+	qtractorSessionSnapshot *pNewSnapshot
+		= new qtractorSessionSnapshot(iSerial, iTracks);
+
+	unsigned int iTrack = 0;
+	qtractorTrack *pTrack = m_tracks.first();
+	for ( ; pTrack && iTrack < iTracks; pTrack = pTrack->next(), ++iTrack) {
+		unsigned int iTrackSerial = serials.value(pTrack, 0);
+		if (iTrackSerial == 0 || m_changedTracks.contains(pTrack))
+			iTrackSerial = iSerial;
+		pNewSnapshot->setTrack(iTrack, pTrack, iTrackSerial,
+			m_detachedTracks.contains(pTrack));
+	}
+
+	m_changedTracks.clear();
+
+	return publishSnapshot(pNewSnapshot);
+}
+
+
+// Track topology snapshot publisher.
+bool qtractorSession::publishSnapshot ( qtractorSessionSnapshot *pNewSnapshot )
+{
+	// Make room on every session cursor beforehand...
+	const unsigned int iTracks = pNewSnapshot->tracks();
+	qtractorSessionCursor *pSessionCursor = m_cursors.first();
+	while (pSessionCursor) {
+		qtractorClip **ppOldClips = pSessionCursor->reserve(iTracks);
+		if (ppOldClips)
+			m_retiredClips.append(ppOldClips);
+		pSessionCursor = pSessionCursor->next();
+	}
+
+	// Publish it...
+	qtractorSessionSnapshot *pOldSnapshot
+		= m_pSnapshot.fetchAndStoreOrdered(pNewSnapshot);
+	if (pOldSnapshot)
+		m_retiredSnapshots.append(pOldSnapshot);
+
+	// Non-RT cursors may follow immediately; engine
+	// ones will follow on their own next process cycle.
+	pSessionCursor = m_cursors.first();
+	while (pSessionCursor) {
+		if (pSessionCursor->syncType() == qtractorTrack::None)
+			pSessionCursor->sync(pNewSnapshot);
+		pSessionCursor = pSessionCursor->next();
+	}
+
+	// Parallel process graph might need an update...
+	if (m_pAudioEngine)
+		m_pAudioEngine->updateGraph();
+
+	// Reclaim stale ones, once no reader is left behind;
+	// otherwise leave them for later (next publish)...
+	if (!synchronize())
+		return false;
+
+	qDeleteAll(m_retiredSnapshots);
+	m_retiredSnapshots.clear();
+	QListIterator<qtractorClip **> iter(m_retiredClips);
+	while (iter.hasNext())
+		delete [] iter.next();
+	m_retiredClips.clear();
+
+	return true;
+}
+
+
+// Wait for all current snapshot readers to leave (non RT-safe).
+bool qtractorSession::synchronize (void)
+{
+	int iReaders[SnapshotReaders];
+	for (int i = 0; i < SnapshotReaders; ++i)
+		iReaders[i] = ATOMIC_GET(&m_snapshotReaders[i]);
+
+	QTime t;
+	t.start();
+
+	for (int i = 0; i < SnapshotReaders; ++i) {
+		// Wait only for the ones inside (odd)...
+		if ((iReaders[i] & 1) == 0)
+			continue;
+		while (ATOMIC_GET(&m_snapshotReaders[i]) == iReaders[i]) {
+			// Reader is stuck (or engine shutdown)?
+			if (t.elapsed() > 1000)
+				return false;
+			QThread::yieldCurrentThread();
+		}
+	}
+
+	return true;
+}
+
+
+// Track clip-list editing primitives (non RT-safe).
+void qtractorSession::detachTrack ( qtractorTrack *pTrack )
+{
+	m_detachedTracks.insert(pTrack);
+}
+
+void qtractorSession::attachTracks (void)
+{
+	if (m_detachedTracks.isEmpty())
+		return;
+
+	QSetIterator<qtractorTrack *> iter(m_detachedTracks);
+	while (iter.hasNext())
+		m_changedTracks.insert(iter.next());
+
+	m_detachedTracks.clear();
+
+	updateSnapshot();
+}
+
+
 // Playhead positioning.
 void qtractorSession::setPlayHead ( unsigned long iPlayHead )
 {
@@ -1383,8 +1663,15 @@ void qtractorSession::setLoop (
 	m_iLoopEndTime   = tickFromFrame(iLoopEnd);
 
 	// Replace last known play-head...
-	m_pAudioEngine->sessionCursor()->seek(iFrame, true);
-	m_pMidiEngine->sessionCursor()->seek(iFrame, true);
+	qtractorSessionSnapshot *pSnapshot = snapshot();
+
+	qtractorSessionCursor *pAudioCursor = m_pAudioEngine->sessionCursor();
+	pAudioCursor->sync(pSnapshot);
+	pAudioCursor->seek(iFrame, true);
+
+	qtractorSessionCursor *pMidiCursor = m_pMidiEngine->sessionCursor();
+	pMidiCursor->sync(pSnapshot);
+	pMidiCursor->seek(iFrame, true);
 
 	setPlaying(bPlaying);
 	unlock();
@@ -1711,6 +1998,13 @@ qtractorAudioPeakFactory *qtractorSession::audioPeakFactory (void) const
 }
 
 
+// Audio decoded-PCM cache factory accessor.
+qtractorAudioCacheFactory *qtractorSession::audioCacheFactory (void) const
+{
+	return m_pAudioCacheFactory;
+}
+
+
 // MIDI track tagging specifics.
 unsigned short qtractorSession::midiTag (void) const
 {
@@ -1785,22 +2079,51 @@ void qtractorSession::process (
 {
 	const qtractorTrack::TrackType syncType = pSessionCursor->syncType();
 
-	// Now, for every track...
-	int iTrack = 0;
-	qtractorTrack *pTrack = m_tracks.first();
-	while (pTrack) {
-		// Track automation processing...
-		if (syncType == qtractorTrack::Audio) {
-			qtractorCurveList *pCurveList = pTrack->curveList();
-			if (pCurveList && pCurveList->isProcess())
-				pCurveList->process(iFrameStart);
+	// Current track topology, as last synced by cursor...
+	qtractorSessionSnapshot *pSnapshot = pSessionCursor->snapshot();
+	if (pSnapshot == NULL)
+		return;
+
+	const unsigned int iTracks = pSnapshot->tracks();
+
+	// Parallel process graph, if any...
+	qtractorAudioGraph *pAudioGraph = NULL;
+	if (syncType == qtractorTrack::Audio)
+		pAudioGraph = m_pAudioEngine->graph();
+	if (pAudioGraph) {
+		// Track automation processing goes first
+		// (audio tracks do it on their own sub-blocks)...
+		for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
+			if (pTrack->trackType() != qtractorTrack::Audio)
+				pTrack->process_curve(iFrameStart);
+		}
+		// Then all tracks, concurrently...
+		if (pAudioGraph->process(pSessionCursor, iFrameStart, iFrameEnd))
+			return;
+		// Otherwise, fall back to serial processing...
+		for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
+			if (syncType == pTrack->trackType()) {
+				pTrack->process(pSessionCursor->clip(iTrack),
+					iFrameStart, iFrameEnd);
+			}
 		}
+		return;
+	}
+
+	// Now, for every track...
+	for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+		qtractorTrack *pTrack = pSnapshot->track(iTrack);
+		// Track automation processing
+		// (audio tracks do it on their own sub-blocks)...
+		if (syncType == qtractorTrack::Audio
+			&& pTrack->trackType() != qtractorTrack::Audio)
+			pTrack->process_curve(iFrameStart);
 		if (syncType == pTrack->trackType()) {
 			pTrack->process(pSessionCursor->clip(iTrack),
 				iFrameStart, iFrameEnd);
 		}
-		pTrack = pTrack->next();
-		++iTrack;
 	}
 }
 
@@ -1809,9 +2132,16 @@ void qtractorSession::process (
 void qtractorSession::process_record (
 	unsigned long iFrameStart, unsigned long iFrameEnd )
 {
+	// Current track topology, as last synced by audio cursor...
+	qtractorSessionSnapshot *pSnapshot
+		= m_pAudioEngine->sessionCursor()->snapshot();
+	if (pSnapshot == NULL)
+		return;
+
 	// Now, for every Audio track...
-	for (qtractorTrack *pTrack = m_tracks.first();
-			pTrack; pTrack = pTrack->next()) {
+	const unsigned int iTracks = pSnapshot->tracks();
+	for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+		qtractorTrack *pTrack = pSnapshot->track(iTrack);
 		if (pTrack->trackType() == qtractorTrack::Audio && pTrack->isRecord())
 			pTrack->process_record(iFrameStart, iFrameEnd);
 	}
@@ -26,6 +26,8 @@
 #include "qtractorTrack.h"
 #include "qtractorTimeScale.h"
 
+#include <QSet>
+
 
 // Forward declarations.
 class qtractorClip;
@@ -34,7 +36,9 @@ class qtractorClip;
 class qtractorMidiEngine;
 class qtractorAudioEngine;
 class qtractorAudioPeakFactory;
+class qtractorAudioCacheFactory;
 class qtractorSessionCursor;
+class qtractorSessionSnapshot;
 class qtractorSessionDocument;
 class qtractorMidiManager;
 class qtractorInstrumentList;
@@ -175,6 +179,9 @@ public:
 	// Update from disparate sample-rate.
 	void updateSampleRate(unsigned int iSampleRate);
 
+	// Update from a bigger buffer-size (period).
+	void updateBufferSize(unsigned int iBufferSize);
+
 	// Track list management methods.
 	const qtractorList<qtractorTrack>& tracks() const;
 
@@ -184,6 +191,9 @@ public:
 	void updateTrack(qtractorTrack *pTrack);
 	void unlinkTrack(qtractorTrack *pTrack);
 
+	// Update current track clip under (RT) cursors.
+	void updateTrackClip(qtractorTrack *pTrack);
+
 	qtractorTrack *trackAt(int iTrack) const;
 
 	// Current number of record-armed tracks.
@@ -215,6 +225,9 @@ public:
 	// Reset (reactivate) all plugin chains...
 	void resetAllPlugins();
 
+	// Switch audio clips over to a ready cache file...
+	void updateAudioCache(const QString& sCachePath);
+
 	// Device engine accessors.
 	qtractorMidiEngine  *midiEngine() const;
 	qtractorAudioEngine *audioEngine() const;
@@ -225,7 +238,11 @@ public:
 	// Consolidated session engine activation status.
 	bool isActivated() const;
 
-	// Session RT-safe pseudo-locking primitives.
+	// Session RT-safe pseudo-locking primitives: the audio
+	// cycle is still skipped while the session is locked, so
+	// these are only for engine reconfiguration (buses, time-map,
+	// transport, shutdown and restart); track and clip edits must
+	// go through the track topology snapshot instead (see below).
 	bool acquire();
 	void release();
 	void lock();
@@ -234,6 +251,31 @@ public:
 	// Re-entrancy check.
 	bool isBusy() const;
 
+	// Track topology snapshot readers (RT threads).
+	enum SnapshotReader {
+		AudioReader = 0, MidiOutputReader, MidiInputReader, SnapshotReaders };
+
+	// Track topology snapshot read-side section (RT-safe).
+	qtractorSessionSnapshot *enterSnapshot(SnapshotReader reader);
+	void leaveSnapshot(SnapshotReader reader);
+
+	// Current track topology snapshot (non RT-safe).
+	qtractorSessionSnapshot *snapshot() const;
+
+	// (Re)publish current track topology snapshot (non RT-safe);
+	// returns false if some RT reader might still be walking
+	// an older one (timeout), reclaim being then deferred.
+	bool updateSnapshot();
+
+	// Wait for all current snapshot readers to leave (non RT-safe).
+	bool synchronize();
+
+	// Track clip-list editing primitives (non RT-safe);
+	// detached tracks are left alone by the RT threads
+	// until next snapshot update after being attached back.
+	void detachTrack(qtractorTrack *pTrack);
+	void attachTracks();
+
 	// Consolidated session engine start status.
 	void setPlaying(bool bPlaying);
 	bool isPlaying() const;
@@ -308,6 +350,9 @@ public:
 	// Audio peak factory accessor.
 	qtractorAudioPeakFactory *audioPeakFactory() const;
 
+	// Audio decoded-PCM cache factory accessor.
+	qtractorAudioCacheFactory *audioCacheFactory() const;
+
 	// MIDI track tagging specifics.
 	unsigned short midiTag() const;
 	void acquireMidiTag(qtractorTrack *pTrack);
@@ -418,6 +463,9 @@ private:
 	// Audio peak factory (singleton) instance.
 	qtractorAudioPeakFactory *m_pAudioPeakFactory;
 
+	// Audio decoded-PCM cache factory (singleton) instance.
+	qtractorAudioCacheFactory *m_pAudioCacheFactory;
+
 	// Track recording counts.
 	unsigned short m_iAudioRecord;
 	unsigned short m_iMidiRecord;
@@ -474,6 +522,24 @@ private:
 	// Curve-to-track mapping.
 	QHash<qtractorCurveList *, qtractorTrack *> m_curves;
 
+	// Track topology snapshot publisher.
+	bool publishSnapshot(qtractorSessionSnapshot *pSnapshot);
+
+	// Current track topology snapshot (RCU-style).
+	QAtomicPointer<qtractorSessionSnapshot> m_pSnapshot;
+	unsigned int m_iSnapshotSerial;
+
+	// Snapshot readers state (odd while inside).
+	qtractorAtomic m_snapshotReaders[SnapshotReaders];
+
+	// Tracks under edit and tracks changed since last snapshot.
+	QSet<qtractorTrack *> m_detachedTracks;
+	QSet<qtractorTrack *> m_changedTracks;
+
+	// Stale snapshots and cursor caches pending disposal.
+	QList<qtractorSessionSnapshot *> m_retiredSnapshots;
+	QList<qtractorClip **> m_retiredClips;
+
 	// File registry.
 	qtractorFileList *m_pFiles;
 
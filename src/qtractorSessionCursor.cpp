@@ -1,7 +1,7 @@
 // qtractorSessionCursor.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2014, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -21,6 +21,7 @@
 
 #include "qtractorAbout.h"
 #include "qtractorSessionCursor.h"
+#include "qtractorSessionSnapshot.h"
 #include "qtractorSession.h"
 #include "qtractorClip.h"
 
@@ -29,6 +30,20 @@
 // class qtractorSessionCursor - implementation.
 //
 
+// Clip position sync helper.
+static inline void clip_seek ( qtractorClip *pClip,
+	unsigned long iFrame, bool bLooping )
+{
+	const unsigned long iClipStart = pClip->clipStart();
+	if (iFrame >= iClipStart &&
+		iFrame <  iClipStart + pClip->clipLength()) {
+		pClip->seek(iFrame - iClipStart);
+	} else {
+		pClip->reset(bLooping);
+	}
+}
+
+
 // Constructor.
 qtractorSessionCursor::qtractorSessionCursor ( qtractorSession *pSession,
 	unsigned long iFrame, qtractorTrack::TrackType syncType )
@@ -37,9 +52,12 @@ qtractorSessionCursor::qtractorSessionCursor ( qtractorSession *pSession,
 	m_iFrame   = iFrame;
 	m_syncType = syncType;
 
+	m_pSnapshot = NULL;
+	m_iSerial   = 0;
+
 	m_iTracks  = 0;
 	m_ppClips  = NULL;
-	m_iSize    = 0;
+	ATOMIC_SET(&m_iSize, 0);
 
 	resetClips();
 	reset();
@@ -80,16 +98,18 @@ void qtractorSessionCursor::seek ( unsigned long iFrame, bool bSync )
 	if (iFrame == m_iFrame)
 		return;
 
-	unsigned int iTrack = 0; 
-	qtractorTrack *pTrack = m_pSession->tracks().first();
-	while (pTrack && iTrack < m_iTracks) {
+	for (unsigned int iTrack = 0; iTrack < m_iTracks; ++iTrack) {
+		// Leave tracks under edit alone...
+		if (m_pSnapshot->isTrackDetached(iTrack))
+			continue;
+		qtractorTrack *pTrack = m_pSnapshot->track(iTrack);
 		qtractorClip *pClip = NULL;
 		qtractorClip *pClipLast = m_ppClips[iTrack];
 		// Optimize if seeking forward...
 		if (iFrame > m_iFrame)
 			pClip = pClipLast;
 		// Locate first clip not past the target frame position..
-		pClip = seekClip(pTrack, pClip, iFrame);
+		pClip = seekClip(m_pSnapshot, iTrack, pClip, iFrame);
 		// Update cursor track clip...
 		m_ppClips[iTrack] = pClip;
 		// Now something fulcral for clips around...
@@ -101,26 +121,25 @@ void qtractorSessionCursor::seek ( unsigned long iFrame, bool bSync )
 				pClipLast->reset(bLooping);
 			// Set final position within target clip...
 			if (pClip && bSync) {
-				// Take care of overlapping clips...
-				const unsigned long iClipEnd
-					= pClip->clipStart() + pClip->clipLength();
-				while (pClip) {
-					const unsigned long iClipStart = pClip->clipStart();
-					if (iClipStart > iClipEnd)
-						break;
-					if (iFrame >= iClipStart &&
-						iFrame <  iClipStart + pClip->clipLength()) {
-						pClip->seek(iFrame - iClipStart);
-					} else {
-						pClip->reset(bLooping);
+				// Take care of overlapping clips,
+				// bounded by the track clip index...
+				qtractorClip **ppClips = NULL;
+				unsigned int iClips = 0;
+				if (pClip != pTrack->freezeClip()
+					&& m_pSnapshot->seekClips(iTrack, iFrame, &ppClips, &iClips)) {
+					for (unsigned int i = 0; i < iClips; ++i)
+						clip_seek(ppClips[i], iFrame, bLooping);
+				} else {
+					// Otherwise just walk the clip list...
+					const unsigned long iClipEnd
+						= pClip->clipStart() + pClip->clipLength();
+					while (pClip && pClip->clipStart() <= iClipEnd) {
+						clip_seek(pClip, iFrame, bLooping);
+						pClip = pClip->next();
 					}
-					pClip = pClip->next();
 				}
 			}
 		}
-		// Next track...
-		pTrack = pTrack->next();
-		++iTrack;
 	}
 
 	// Done.
@@ -164,8 +183,21 @@ qtractorClip *qtractorSessionCursor::clip ( unsigned int iTrack ) const
 
 // Clip locate method.
 qtractorClip *qtractorSessionCursor::seekClip (
-	qtractorTrack *pTrack, qtractorClip *pClip, unsigned long iFrame ) const
+	qtractorSessionSnapshot *pSnapshot, unsigned int iTrack,
+	qtractorClip *pClip, unsigned long iFrame ) const
 {
+	qtractorTrack *pTrack = pSnapshot->track(iTrack);
+
+	// Frozen tracks just play their own pre-rendered clip...
+	qtractorClip *pFreezeClip = pTrack->freezeClip();
+	if (pFreezeClip)
+		return pFreezeClip;
+
+	// Binary search the track clip index, if up-to-date;
+	// otherwise just walk the clip list, the slow way...
+	if (pSnapshot->seekClip(iTrack, iFrame, &pClip))
+		return pClip;
+
 	if (pClip == NULL)
 		pClip = pTrack->clips().first();
 
@@ -182,97 +214,74 @@ qtractorClip *qtractorSessionCursor::seekClip (
 }
 
 
-// Add a track to cursor.
-void qtractorSessionCursor::addTrack ( qtractorTrack *pTrack )
+// Current track topology snapshot accessor.
+qtractorSessionSnapshot *qtractorSessionCursor::snapshot (void) const
 {
-	if (pTrack == NULL)
-		pTrack = m_pSession->tracks().last();
-
-	const unsigned int iTracks = m_iTracks + 1;
-	if (iTracks < m_iSize) {
-		updateClips(m_ppClips, iTracks);
-	} else {
-		m_iSize += iTracks;
-		qtractorClip **ppOldClips = m_ppClips;
-		qtractorClip **ppNewClips = new qtractorClip * [m_iSize];
-		updateClips(ppNewClips, iTracks);
-		m_ppClips = ppNewClips;
-		if (ppOldClips)
-			delete [] ppOldClips;
-	}
-	m_iTracks = iTracks;
-}
-
-
-// Update track after adding/removing a clip from cursor.
-void qtractorSessionCursor::updateTrack ( qtractorTrack *pTrack )
-{
-	const int iTrack = m_pSession->tracks().find(pTrack);
-	if (iTrack >= 0) {
-		qtractorClip *pClip = seekClip(pTrack, NULL, m_iFrame);
-		if (pClip && pTrack->trackType() == m_syncType
-			&& m_iFrame >= pClip->clipStart()
-			&& m_iFrame <  pClip->clipStart() + pClip->clipLength()) {
-			pClip->seek(m_iFrame - pClip->clipStart());
-		}
-		m_ppClips[iTrack] = pClip;
-	}
+	return m_pSnapshot;
 }
 
 
-// Remove a track from cursor.
-void qtractorSessionCursor::removeTrack ( qtractorTrack *pTrack )
+// Track/clips cache resync to a published snapshot (RT-safe).
+void qtractorSessionCursor::sync ( qtractorSessionSnapshot *pSnapshot )
 {
-	const int iTrack = m_pSession->tracks().find(pTrack);
-	if (iTrack >= 0)
-		removeTrack((unsigned int) iTrack);
-}
+	if (pSnapshot == NULL || pSnapshot->serial() == m_iSerial)
+		return;
 
-void qtractorSessionCursor::removeTrack ( unsigned int iTrack )
-{
-	--m_iTracks;	
-	for ( ; iTrack < m_iTracks; ++iTrack)
-		m_ppClips[iTrack] = m_ppClips[iTrack + 1];
-	m_ppClips[iTrack] = NULL;
-}
+	// Size first (acquire), array next: it may only be bigger...
+	const unsigned int iSize = ATOMIC_GET_ACQUIRE(&m_iSize);
+	qtractorClip **ppClips = m_ppClips;
 
+	unsigned int iTracks = pSnapshot->tracks();
+	if (iTracks > iSize)
+		iTracks = iSize;
 
-// Update current track clip under cursor.
-void qtractorSessionCursor::updateTrackClip ( qtractorTrack *pTrack )
-{
-	const int iTrack = m_pSession->tracks().find(pTrack);
-	if (iTrack >= 0) {
-		qtractorClip *pClip = m_ppClips[iTrack];
-		if (pClip && pTrack->trackType() == m_syncType) {
-			if (m_iFrame >= pClip->clipStart() &&
-				m_iFrame <  pClip->clipStart() + pClip->clipLength()) {
-				pClip->seek(m_iFrame - pClip->clipStart());
-			} else {
-				pClip->reset(m_iFrame >= m_pSession->loopStart());
+	// Relocate clips of every track changed since last sync...
+	for (unsigned int iTrack = 0; iTrack < iTracks; ++iTrack) {
+		qtractorClip *pClip = NULL;
+		if (!pSnapshot->isTrackDetached(iTrack)) {
+			qtractorTrack *pTrack = pSnapshot->track(iTrack);
+			pClip = seekClip(pSnapshot, iTrack, NULL, m_iFrame);
+			if (pClip && pTrack->trackType() == m_syncType
+				&& pSnapshot->trackSerial(iTrack) > m_iSerial) {
+				if (m_iFrame >= pClip->clipStart() &&
+					m_iFrame <  pClip->clipStart() + pClip->clipLength()) {
+					pClip->seek(m_iFrame - pClip->clipStart());
+				} else {
+					pClip->reset(m_iFrame >= m_pSession->loopStart());
+				}
 			}
 		}
+		ppClips[iTrack] = pClip;
 	}
+
+	m_iTracks   = iTracks;
+	m_pSnapshot = pSnapshot;
+	m_iSerial   = pSnapshot->serial();
 }
 
 
-// Update (stabilize) cursor.
-void qtractorSessionCursor::updateClips ( qtractorClip **ppClips,
-	unsigned int iTracks )
+// Track/clips cache capacity (non RT-safe).
+//
+// Any clip the RT thread relocates on the old array while this
+// copy is being made is lost, but that's harmless: this is only
+// called right before a new snapshot gets published, which makes
+// the next sync() rebuild every single track entry all over again.
+qtractorClip **qtractorSessionCursor::reserve ( unsigned int iTracks )
 {
-	// Reset clip positions...
-	unsigned int iTrack = 0; 
-	qtractorTrack *pTrack = m_pSession->tracks().first();
-	while (pTrack && iTrack < iTracks) {
-		qtractorClip *pClip = seekClip(pTrack, NULL, m_iFrame);
-		if (pClip && pTrack->trackType() == m_syncType
-			&& m_iFrame >= pClip->clipStart()
-			&& m_iFrame <  pClip->clipStart() + pClip->clipLength()) {
-			pClip->seek(m_iFrame - pClip->clipStart());
-		}
-		ppClips[iTrack] = pClip;
-		pTrack = pTrack->next();
-		++iTrack;
-	}
+	if (iTracks <= (unsigned int) ATOMIC_GET(&m_iSize))
+		return NULL;
+
+	const unsigned int iSize = (iTracks << 1);
+	qtractorClip **ppNewClips = new qtractorClip * [iSize];
+	for (unsigned int i = 0; i < iSize; ++i)
+		ppNewClips[i] = (i < m_iTracks ? m_ppClips[i] : NULL);
+
+	// Array first, size last (release)...
+	qtractorClip **ppOldClips = m_ppClips;
+	m_ppClips = ppNewClips;
+	ATOMIC_SET_RELEASE(&m_iSize, int(iSize));
+
+	return ppOldClips;
 }
 
 
@@ -288,29 +297,26 @@ void qtractorSessionCursor::reset (void)
 }
 
 
-// Reset track/clips cache.
+// Reset track/clips cache (non RT-safe).
 void qtractorSessionCursor::resetClips (void)
 {
 #ifdef CONFIG_DEBUG_0
 	qDebug("qtractorSessionCursor[%p,%d]::resetClips()", this, (int) m_syncType);
 #endif
 
-	// Free existing clip references.
-	if (m_ppClips) {
-		qtractorClip **ppOldClips = m_ppClips;
-		m_ppClips = NULL;
+	qtractorSessionSnapshot *pSnapshot = m_pSession->snapshot();
+	if (pSnapshot == NULL)
+		return;
+
+	// Make room for the whole bunch...
+	qtractorClip **ppOldClips = reserve(pSnapshot->tracks());
+	if (ppOldClips)
 		delete [] ppOldClips;
-	}
 
 	// Rebuild the whole bunch...
-	m_iTracks = m_pSession->tracks().count();
-	m_iSize   = (m_iTracks << 1);
+	m_iSerial = 0;
 
-	if (m_iSize > 0) {
-		qtractorClip **ppNewClips = new qtractorClip * [m_iSize];
-		updateClips(ppNewClips, m_iTracks);
-		m_ppClips = ppNewClips;
-	}
+	sync(pSnapshot);
 }
 
 
@@ -1,7 +1,7 @@
 // qtractorSessionCursor.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2014, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -24,8 +24,11 @@
 
 #include "qtractorTrack.h"
 
+#include "qtractorAtomic.h"
+
 // Forward declarations.
 class qtractorClip;
+class qtractorSessionSnapshot;
 
 
 //----------------------------------------------------------------------
@@ -63,20 +66,20 @@ public:
 	// Current track clip accessor.
 	qtractorClip *clip(unsigned int iTrack) const;
 
-	// Add a track to cursor.
-	void addTrack    (qtractorTrack *pTrack);
-	// Update track after adding/removing a clip from cursor.
-	void updateTrack (qtractorTrack *pTrack);
-	// Remove a track from cursor.
-	void removeTrack (qtractorTrack *pTrack);
+	// Current track topology snapshot accessor.
+	qtractorSessionSnapshot *snapshot() const;
+
+	// Track/clips cache resync to a published snapshot (RT-safe).
+	void sync(qtractorSessionSnapshot *pSnapshot);
 
-	// Update current track clip under cursor.
-	void updateTrackClip(qtractorTrack *pTrack);
+	// Track/clips cache capacity (non RT-safe);
+	// returns the replaced cache, if any, for deferred disposal.
+	qtractorClip **reserve(unsigned int iTracks);
 
 	// Reset cursor.
 	void reset();
 
-	// Reset track/clips cache.
+	// Reset track/clips cache (non RT-safe).
 	void resetClips();
 
 	// Frame-time processor (increment only).
@@ -85,14 +88,8 @@ public:
 protected:
 
 	// Clip locate method.
-	qtractorClip *seekClip(qtractorTrack *pTrack,
-		qtractorClip *pClip, unsigned long iFrame) const;
-
-	// Update (stabilize) cursor.
-	void updateClips(qtractorClip **ppClips, unsigned int iTracks);
-
-	// Remove a track from cursor (by index).
-	void removeTrack (unsigned int iTrack);
+	qtractorClip *seekClip(qtractorSessionSnapshot *pSnapshot,
+		unsigned int iTrack, qtractorClip *pClip, unsigned long iFrame) const;
 
 private:
 
@@ -103,9 +100,15 @@ private:
 	unsigned long            m_iFrameDelta;
 	qtractorTrack::TrackType m_syncType;
 
+	qtractorSessionSnapshot *m_pSnapshot;
+	unsigned int             m_iSerial;
+
+	// Track/clips cache: the array is always replaced before
+	// its size gets published (release), so that whoever reads
+	// the size first (acquire) never sees it past the array end.
 	unsigned int   m_iTracks;
-	qtractorClip **m_ppClips;
-	unsigned int   m_iSize;
+	qtractorClip **volatile m_ppClips;
+	qtractorAtomic m_iSize;
 };
 
 
@@ -0,0 +1,206 @@
+// qtractorSessionSnapshot.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorSessionSnapshot.h"
+
+#include "qtractorTrack.h"
+#include "qtractorClip.h"
+
+#include <string.h>
+
+
+//----------------------------------------------------------------------
+// class qtractorSessionSnapshot -- Immutable session track topology.
+//
+
+// Constructor.
+qtractorSessionSnapshot::qtractorSessionSnapshot (
+	unsigned int iSerial, unsigned int iTracks )
+	: m_iSerial(iSerial), m_iTracks(iTracks), m_pItems(NULL)
+{
+	if (m_iTracks > 0) {
+		m_pItems = new Item [m_iTracks];
+		::memset(m_pItems, 0, m_iTracks * sizeof(Item));
+	}
+}
+
+
+// Destructor.
+qtractorSessionSnapshot::~qtractorSessionSnapshot (void)
+{
+	if (m_pItems) {
+		for (unsigned int i = 0; i < m_iTracks; ++i) {
+			Item *pItem = &m_pItems[i];
+			if (pItem->clips)
+				delete [] pItem->clips;
+			if (pItem->clipEnds)
+				delete [] pItem->clipEnds;
+		}
+		delete [] m_pItems;
+	}
+}
+
+
+// Track item builder (non RT-safe).
+void qtractorSessionSnapshot::setTrack ( unsigned int iTrack,
+	qtractorTrack *pTrack, unsigned int iTrackSerial, bool bDetached )
+{
+	if (iTrack < m_iTracks) {
+		Item *pItem = &m_pItems[iTrack];
+		pItem->track    = pTrack;
+		pItem->serial   = iTrackSerial;
+		pItem->detached = bDetached;
+		// Build the clip index, if not under edit...
+		if (pTrack && !bDetached) {
+			pItem->clipSerial = pTrack->clipSerial();
+			const unsigned int iClips = pTrack->clips().count();
+			if (iClips > 0) {
+				pItem->clips = new qtractorClip * [iClips];
+				pItem->clipEnds = new unsigned long [iClips];
+			}
+			unsigned int i = 0;
+			unsigned long iClipEnd = 0;
+			qtractorClip *pClip = pTrack->clips().first();
+			for ( ; pClip && i < iClips; pClip = pClip->next(), ++i) {
+				const unsigned long iClipEnd2
+					= pClip->clipStart() + pClip->clipLength();
+				if (iClipEnd < iClipEnd2)
+					iClipEnd = iClipEnd2;
+				pItem->clips[i] = pClip;
+				pItem->clipEnds[i] = iClipEnd;
+			}
+			pItem->clipCount = i;
+		}
+	}
+}
+
+
+// Track index finder (-1 if not found).
+int qtractorSessionSnapshot::findTrack ( qtractorTrack *pTrack ) const
+{
+	for (unsigned int i = 0; i < m_iTracks; ++i) {
+		if (m_pItems[i].track == pTrack)
+			return int(i);
+	}
+
+	return -1;
+}
+
+
+// Track clip index lookup (first clip not ending
+// before the given frame, or the last one).
+const qtractorSessionSnapshot::Item *qtractorSessionSnapshot::seekItem (
+	unsigned int iTrack, unsigned long iFrame, unsigned int *piClip ) const
+{
+	if (iTrack >= m_iTracks)
+		return NULL;
+
+	const Item *pItem = &m_pItems[iTrack];
+	if (pItem->track == NULL || pItem->detached
+		|| pItem->clipSerial != pItem->track->clipSerial())
+		return NULL;
+
+	const unsigned int iClips = pItem->clipCount;
+
+	unsigned int i = 0;
+	unsigned int j = iClips;
+	while (i < j) {
+		const unsigned int k = (i + j) >> 1;
+		if (iFrame > pItem->clipEnds[k])
+			i = k + 1;
+		else
+			j = k;
+	}
+
+	*piClip = (i < iClips || iClips < 1 ? i : iClips - 1);
+	return pItem;
+}
+
+
+// Track clip index locate (RT-safe): first clip not ending before
+// the given frame, or else the last one; false if index is stale.
+bool qtractorSessionSnapshot::seekClip ( unsigned int iTrack,
+	unsigned long iFrame, qtractorClip **ppClip ) const
+{
+	unsigned int i = 0;
+	const Item *pItem = seekItem(iTrack, iFrame, &i);
+	if (pItem == NULL)
+		return false;
+
+	*ppClip = (i < pItem->clipCount ? pItem->clips[i] : NULL);
+	return true;
+}
+
+
+// Track clip index span (RT-safe): the clip located as above and
+// all the following ones starting before its end (overlapping);
+// false if index is stale.
+bool qtractorSessionSnapshot::seekClips ( unsigned int iTrack,
+	unsigned long iFrame, qtractorClip ***pppClips, unsigned int *piClips ) const
+{
+	unsigned int i = 0;
+	const Item *pItem = seekItem(iTrack, iFrame, &i);
+	if (pItem == NULL)
+		return false;
+
+	const unsigned int iClips = pItem->clipCount;
+	if (i >= iClips) {
+		*pppClips = NULL;
+		*piClips = 0;
+		return true;
+	}
+
+	// Clips are sorted by start: binary search the
+	// last one starting not after the located clip end...
+	qtractorClip *pClip = pItem->clips[i];
+	const unsigned long iClipEnd = pClip->clipStart() + pClip->clipLength();
+	unsigned int j = iClips;
+	unsigned int k = i + 1;
+	while (k < j) {
+		const unsigned int m = (k + j) >> 1;
+		if (pItem->clips[m]->clipStart() > iClipEnd)
+			j = m;
+		else
+			k = m + 1;
+	}
+
+	*pppClips = &pItem->clips[i];
+	*piClips = j - i;
+	return true;
+}
+
+
+// Whether any track clip index is stale.
+bool qtractorSessionSnapshot::isClipIndexStale (void) const
+{
+	for (unsigned int i = 0; i < m_iTracks; ++i) {
+		const Item *pItem = &m_pItems[i];
+		if (pItem->track && !pItem->detached
+			&& pItem->clipSerial != pItem->track->clipSerial())
+			return true;
+	}
+
+	return false;
+}
+
+
+// end of qtractorSessionSnapshot.cpp
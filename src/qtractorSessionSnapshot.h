@@ -0,0 +1,127 @@
+// qtractorSessionSnapshot.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorSessionSnapshot_h
+#define __qtractorSessionSnapshot_h
+
+
+// Forward declarations.
+class qtractorTrack;
+class qtractorClip;
+
+
+//----------------------------------------------------------------------
+// class qtractorSessionSnapshot -- Immutable session track topology.
+//
+// Built and published by the (non RT) editing thread, read-only
+// thereafter: the RT threads walk this array instead of the session
+// track list, which may then be freely (re)linked meanwhile.
+// A track may be published as detached, meaning that its clip list
+// is currently under edit and must be left alone by the RT threads.
+// Each attached track also gets a clip lookup index: its clips in
+// list (start) order, along with the running maximum of their ends,
+// which is monotonic and may then be binary searched; it's only good
+// for as long as the track clip list change serial stays the same.
+//
+
+class qtractorSessionSnapshot
+{
+public:
+
+	// Constructor.
+	qtractorSessionSnapshot(unsigned int iSerial, unsigned int iTracks);
+
+	// Destructor.
+	~qtractorSessionSnapshot();
+
+	// Publishing serial number (always increasing).
+	unsigned int serial() const
+		{ return m_iSerial; }
+
+	// Number of tracks.
+	unsigned int tracks() const
+		{ return m_iTracks; }
+
+	// Track item builder (non RT-safe).
+	void setTrack(unsigned int iTrack, qtractorTrack *pTrack,
+		unsigned int iTrackSerial, bool bDetached);
+
+	// Track item accessors.
+	qtractorTrack *track(unsigned int iTrack) const
+		{ return m_pItems[iTrack].track; }
+
+	// Serial number of last track clip list change.
+	unsigned int trackSerial(unsigned int iTrack) const
+		{ return m_pItems[iTrack].serial; }
+
+	// Whether track clip list is currently under edit.
+	bool isTrackDetached(unsigned int iTrack) const
+		{ return m_pItems[iTrack].detached; }
+
+	// Track index finder (-1 if not found).
+	int findTrack(qtractorTrack *pTrack) const;
+
+	// Track clip index locate (RT-safe): first clip not ending before
+	// the given frame, or else the last one; false if index is stale.
+	bool seekClip(unsigned int iTrack,
+		unsigned long iFrame, qtractorClip **ppClip) const;
+
+	// Track clip index span (RT-safe): the clip located as above and
+	// all the following ones starting before its end (overlapping);
+	// false if index is stale.
+	bool seekClips(unsigned int iTrack, unsigned long iFrame,
+		qtractorClip ***pppClips, unsigned int *piClips) const;
+
+	// Whether any track clip index is stale.
+	bool isClipIndexStale() const;
+
+private:
+
+	// Track item.
+	struct Item
+	{
+		qtractorTrack *track;
+		unsigned int   serial;
+		bool           detached;
+
+		// Track clip index.
+		unsigned int   clipSerial;
+		unsigned int   clipCount;
+		qtractorClip **clips;
+		unsigned long *clipEnds;
+	};
+
+	// Track clip index lookup (first clip not ending
+	// before the given frame, or the last one).
+	const Item *seekItem(unsigned int iTrack,
+		unsigned long iFrame, unsigned int *piClip) const;
+
+	// Instance variables.
+	unsigned int m_iSerial;
+	unsigned int m_iTracks;
+	Item        *m_pItems;
+};
+
+
+#endif  // __qtractorSessionSnapshot_h
+
+
+// end of qtractorSessionSnapshot.h
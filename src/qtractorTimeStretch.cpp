@@ -1,7 +1,7 @@
 // qtractorTimeStretch.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2014, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    Adapted and refactored from the SoundTouch library (L)GPL,
    Copyright (C) 2001-2012, Olli Parviainen.
@@ -24,9 +24,19 @@
 
 #include "qtractorTimeStretch.h"
 
+#include "qtractorAudioKernel.h"
+
 #include <math.h>
 
 
+// Maximum number of channels and positions at a time for linear search.
+static const unsigned short c_iMaxChannels = 8;
+static const unsigned short c_iMaxCrossCorrN = 8;
+
+// Minimum seek window length (in frames) for FFT-assisted search.
+static const unsigned int c_iFftSeekLength = 2048;
+
+
 // Cross-correlation value calculation over the overlap period.
 //
 
@@ -34,6 +44,13 @@
 
 #include <xmmintrin.h>
 
+// Wider vector kernels are compiled with per-function target
+// attributes, so that the whole build may still go SSE-only.
+#if defined(__GNUC__) && (defined(__clang__) \
+	|| __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define QTRACTOR_TIME_STRETCH_AVX
+#endif
+
 // SSE detection.
 static inline bool sse_enabled (void)
 {
@@ -119,6 +136,128 @@ static inline float sse_cross_corr (
 	return (pvCorr[0] + pvCorr[1] + pvCorr[2] + pvCorr[3]) / ::sqrtf(fNorm);
 }
 
+
+// SSE enabled version, four consecutive positions at once:
+// pfCorr[k] = sse_cross_corr(pV1 + k, pV2, iOverlapLength), k = 0..3.
+// Each position keeps its very own accumulators and summation order,
+// so results are bit-exact to the above, while the four independent
+// dependency chains are interleaved for much better throughput.
+static inline void sse_cross_corr4 ( const float *pV1, const float *pV2,
+	unsigned int iOverlapLength, float *pfCorr )
+{
+	__m128 vCorr0, vCorr1, vCorr2, vCorr3;
+	__m128 vNorm0, vNorm1, vNorm2, vNorm3;
+	__m128 vTemp0, vTemp1, vTemp2, vTemp3, vRef, *pVec2;
+
+	iOverlapLength >>= 4;
+
+	pVec2 = (__m128 *) pV2;
+	vCorr0 = vCorr1 = vCorr2 = vCorr3 = _mm_setzero_ps();
+	vNorm0 = vNorm1 = vNorm2 = vNorm3 = _mm_setzero_ps();
+
+	for (unsigned int i = 0; i < iOverlapLength; ++i) {
+		for (unsigned int j = 0; j < 4; ++j) {
+			vRef   = pVec2[j];
+			vTemp0 = _mm_loadu_ps(pV1);
+			vTemp1 = _mm_loadu_ps(pV1 + 1);
+			vTemp2 = _mm_loadu_ps(pV1 + 2);
+			vTemp3 = _mm_loadu_ps(pV1 + 3);
+			vCorr0 = _mm_add_ps(vCorr0, _mm_mul_ps(vTemp0, vRef));
+			vCorr1 = _mm_add_ps(vCorr1, _mm_mul_ps(vTemp1, vRef));
+			vCorr2 = _mm_add_ps(vCorr2, _mm_mul_ps(vTemp2, vRef));
+			vCorr3 = _mm_add_ps(vCorr3, _mm_mul_ps(vTemp3, vRef));
+			vNorm0 = _mm_add_ps(vNorm0, _mm_mul_ps(vTemp0, vTemp0));
+			vNorm1 = _mm_add_ps(vNorm1, _mm_mul_ps(vTemp1, vTemp1));
+			vNorm2 = _mm_add_ps(vNorm2, _mm_mul_ps(vTemp2, vTemp2));
+			vNorm3 = _mm_add_ps(vNorm3, _mm_mul_ps(vTemp3, vTemp3));
+			pV1 += 4;
+		}
+		pVec2 += 4;
+	}
+
+	const __m128 vCorr[4] = { vCorr0, vCorr1, vCorr2, vCorr3 };
+	const __m128 vNorm[4] = { vNorm0, vNorm1, vNorm2, vNorm3 };
+
+	for (unsigned int k = 0; k < 4; ++k) {
+		const float *pvNorm = (const float *) &vNorm[k];
+		float fNorm = (pvNorm[0] + pvNorm[1] + pvNorm[2] + pvNorm[3]);
+		if (fNorm < 1e-9f) fNorm = 1.0f; // avoid div by zero
+		const float *pvCorr = (const float *) &vCorr[k];
+		pfCorr[k] = (pvCorr[0] + pvCorr[1] + pvCorr[2] + pvCorr[3]) / ::sqrtf(fNorm);
+	}
+}
+
+#if defined(QTRACTOR_TIME_STRETCH_AVX)
+
+#include <immintrin.h>
+
+#define QTRACTOR_TARGET_AVX __attribute__((target("avx")))
+
+// AVX detection (as currently dispatched for audio kernels).
+static inline bool avx_enabled (void)
+{
+	return (qtractorAudioKernel::level() >= qtractorAudioKernel::AVX);
+}
+
+
+// AVX enabled version, eight consecutive positions at once:
+// pfCorr[k] = sse_cross_corr(pV1 + k, pV2, iOverlapLength), k = 0..7.
+// Positions k and k + 4 share each 256bit register, being that the
+// lower and upper 128bit lanes are summed up exactly as the SSE one,
+// hence still bit-exact (no FMA contraction here, on purpose).
+QTRACTOR_TARGET_AVX
+static void avx_cross_corr8 ( const float *pV1, const float *pV2,
+	unsigned int iOverlapLength, float *pfCorr )
+{
+	__m256 vCorr0, vCorr1, vCorr2, vCorr3;
+	__m256 vNorm0, vNorm1, vNorm2, vNorm3;
+	__m256 vTemp0, vTemp1, vTemp2, vTemp3, vRef;
+
+	// Same truncation as above (multiple of 16 frames).
+	iOverlapLength = (iOverlapLength >> 4) << 2;
+
+	vCorr0 = vCorr1 = vCorr2 = vCorr3 = _mm256_setzero_ps();
+	vNorm0 = vNorm1 = vNorm2 = vNorm3 = _mm256_setzero_ps();
+
+	for (unsigned int i = 0; i < iOverlapLength; ++i) {
+		vRef   = _mm256_broadcast_ps((const __m128 *) pV2);
+		vTemp0 = _mm256_loadu_ps(pV1);
+		vTemp1 = _mm256_loadu_ps(pV1 + 1);
+		vTemp2 = _mm256_loadu_ps(pV1 + 2);
+		vTemp3 = _mm256_loadu_ps(pV1 + 3);
+		vCorr0 = _mm256_add_ps(vCorr0, _mm256_mul_ps(vTemp0, vRef));
+		vCorr1 = _mm256_add_ps(vCorr1, _mm256_mul_ps(vTemp1, vRef));
+		vCorr2 = _mm256_add_ps(vCorr2, _mm256_mul_ps(vTemp2, vRef));
+		vCorr3 = _mm256_add_ps(vCorr3, _mm256_mul_ps(vTemp3, vRef));
+		vNorm0 = _mm256_add_ps(vNorm0, _mm256_mul_ps(vTemp0, vTemp0));
+		vNorm1 = _mm256_add_ps(vNorm1, _mm256_mul_ps(vTemp1, vTemp1));
+		vNorm2 = _mm256_add_ps(vNorm2, _mm256_mul_ps(vTemp2, vTemp2));
+		vNorm3 = _mm256_add_ps(vNorm3, _mm256_mul_ps(vTemp3, vTemp3));
+		pV1 += 4;
+		pV2 += 4;
+	}
+
+	float afCorr[4][8], afNorm[4][8];
+	_mm256_storeu_ps(afCorr[0], vCorr0);
+	_mm256_storeu_ps(afCorr[1], vCorr1);
+	_mm256_storeu_ps(afCorr[2], vCorr2);
+	_mm256_storeu_ps(afCorr[3], vCorr3);
+	_mm256_storeu_ps(afNorm[0], vNorm0);
+	_mm256_storeu_ps(afNorm[1], vNorm1);
+	_mm256_storeu_ps(afNorm[2], vNorm2);
+	_mm256_storeu_ps(afNorm[3], vNorm3);
+
+	for (unsigned int k = 0; k < 8; ++k) {
+		const float *pvNorm = &afNorm[k & 3][(k >> 2) << 2];
+		float fNorm = (pvNorm[0] + pvNorm[1] + pvNorm[2] + pvNorm[3]);
+		if (fNorm < 1e-9f) fNorm = 1.0f; // avoid div by zero
+		const float *pvCorr = &afCorr[k & 3][(k >> 2) << 2];
+		pfCorr[k] = (pvCorr[0] + pvCorr[1] + pvCorr[2] + pvCorr[3]) / ::sqrtf(fNorm);
+	}
+}
+
+#endif	// QTRACTOR_TIME_STRETCH_AVX
+
 #endif
 
 
@@ -140,6 +279,57 @@ static inline float std_cross_corr (
 }
 
 
+// Standard version, four consecutive positions at once.
+static inline void std_cross_corr4 ( const float *pV1, const float *pV2,
+	unsigned int iOverlapLength, float *pfCorr )
+{
+	for (unsigned int k = 0; k < 4; ++k)
+		pfCorr[k] = std_cross_corr(pV1 + k, pV2, iOverlapLength);
+}
+
+
+// In-place radix-2 complex FFT (forward: e^-jwt; inverse: unscaled).
+// pCos[k], pSin[k] = cos(2*pi*k/N), sin(2*pi*k/N), for k < N/2.
+static void fft_radix2 ( float *pRe, float *pIm,
+	const float *pCos, const float *pSin, unsigned int N, bool bInverse )
+{
+	unsigned int i, j, k;
+
+	// Bit-reversal permutation...
+	for (i = 1, j = 0; i < N; ++i) {
+		unsigned int iBit = (N >> 1);
+		for ( ; j & iBit; iBit >>= 1)
+			j ^= iBit;
+		j ^= iBit;
+		if (i < j) {
+			float fTemp;
+			fTemp = pRe[i]; pRe[i] = pRe[j]; pRe[j] = fTemp;
+			fTemp = pIm[i]; pIm[i] = pIm[j]; pIm[j] = fTemp;
+		}
+	}
+
+	// Butterflies...
+	for (unsigned int iLen = 2; iLen <= N; iLen <<= 1) {
+		const unsigned int iHalf = (iLen >> 1);
+		const unsigned int iStep = N / iLen;
+		for (i = 0; i < N; i += iLen) {
+			for (k = 0; k < iHalf; ++k) {
+				const float wr = pCos[k * iStep];
+				const float wi = (bInverse ? pSin[k * iStep] : -pSin[k * iStep]);
+				const unsigned int a = i + k;
+				const unsigned int b = a + iHalf;
+				const float tr = pRe[b] * wr - pIm[b] * wi;
+				const float ti = pRe[b] * wi + pIm[b] * wr;
+				pRe[b] = pRe[a] - tr;
+				pIm[b] = pIm[a] - ti;
+				pRe[a] += tr;
+				pIm[a] += ti;
+			}
+		}
+	}
+}
+
+
 //---------------------------------------------------------------------------
 // qtractorTimeStretch - Time-stretch (tempo change) effect for processed sound.
 //
@@ -162,12 +352,33 @@ qtractorTimeStretch::qtractorTimeStretch (
 
 	m_iOverlapLength = 0;
 
+	m_bFftSeek = false;
+	m_bBlockSeek = true;
+
+	m_iFftSize = 0;
+	m_pFftRe   = NULL;
+	m_pFftIm   = NULL;
+	m_pFftCos  = NULL;
+	m_pFftSin  = NULL;
+
 #if defined(__SSE__)
-	if (sse_enabled())
-		m_pfnCrossCorr = sse_cross_corr;
-	else
+	if (sse_enabled()) {
+		m_pfnCrossCorr  = sse_cross_corr;
+		m_pfnCrossCorrN = sse_cross_corr4;
+		m_iCrossCorrN   = 4;
+	#if defined(QTRACTOR_TIME_STRETCH_AVX)
+		if (avx_enabled()) {
+			m_pfnCrossCorrN = avx_cross_corr8;
+			m_iCrossCorrN   = 8;
+		}
+	#endif
+	} else
 #endif
-	m_pfnCrossCorr = std_cross_corr;
+	{
+		m_pfnCrossCorr  = std_cross_corr;
+		m_pfnCrossCorrN = std_cross_corr4;
+		m_iCrossCorrN   = 4;
+	}
 
 	setParameters(iSampleRate);
 }
@@ -176,6 +387,13 @@ qtractorTimeStretch::qtractorTimeStretch (
 // Destructor.
 qtractorTimeStretch::~qtractorTimeStretch (void)
 {
+	if (m_iFftSize > 0) {
+		delete [] m_pFftSin;
+		delete [] m_pFftCos;
+		delete [] m_pFftIm;
+		delete [] m_pFftRe;
+	}
+
 	if (m_ppFrames) {
 		for (unsigned short i = 0; i < m_iChannels; ++i) {
 			delete [] m_ppMidBuffer[i];
@@ -258,6 +476,32 @@ bool qtractorTimeStretch::isQuickSeek (void) const
 }
 
 
+// Set FFT-seek mode (long seek windows only).
+void qtractorTimeStretch::setFftSeek ( bool bFftSeek )
+{
+	m_bFftSeek = bFftSeek;
+}
+
+// Get FFT-seek mode.
+bool qtractorTimeStretch::isFftSeek (void) const
+{
+	return m_bFftSeek;
+}
+
+
+// Set block-seek mode (linear search, a block of positions at a time).
+void qtractorTimeStretch::setBlockSeek ( bool bBlockSeek )
+{
+	m_bBlockSeek = bBlockSeek;
+}
+
+// Get block-seek mode.
+bool qtractorTimeStretch::isBlockSeek (void) const
+{
+	return m_bBlockSeek;
+}
+
+
 // Sets routine control parameters.
 // These control are certain time constants defining
 // how the sound is stretched to the desired duration.
@@ -387,10 +631,41 @@ unsigned int qtractorTimeStretch::seekBestOverlapPosition (void)
 			}
 			iPrevBestOffs = iBestOffs;
 		}
+	}
+	else
+	if (m_bFftSeek && m_iSeekLength >= c_iFftSeekLength) {
+		// FFT-assisted search...
+		iBestOffs = seekBestOverlapPositionFft();
 	} else {
-		// Linear search...
+		// Linear search, a block of positions at a time...
+		float afCorr[c_iMaxCrossCorrN * c_iMaxChannels];
+		const int iCrossCorrN = int(m_iCrossCorrN);
 		iBestOffs = 0;
-		for (iOffs = 0; iOffs < (int) m_iSeekLength; ++iOffs) {
+		iOffs = 0;
+		if (m_bBlockSeek && m_iChannels <= c_iMaxChannels) {
+			for ( ; iOffs + iCrossCorrN <= (int) m_iSeekLength;
+					iOffs += iCrossCorrN) {
+				for (i = 0; i < m_iChannels; ++i) {
+					(*m_pfnCrossCorrN)(
+						m_inputBuffer.ptrBegin(i) + iOffs,
+						m_ppRefMidBuffer[i], m_iOverlapLength,
+						&afCorr[i * iCrossCorrN]);
+				}
+				// Checks for the highest correlation value,
+				// in the very same order as one at a time...
+				for (k = 0; k < iCrossCorrN; ++k) {
+					for (i = 0; i < m_iChannels; ++i) {
+						fCorr = afCorr[i * iCrossCorrN + k];
+						if (fCorr > fBestCorr) {
+							fBestCorr = fCorr;
+							iBestOffs = iOffs + k;
+						}
+					}
+				}
+			}
+		}
+		// Linear search, the remaining positions one at a time...
+		for ( ; iOffs < (int) m_iSeekLength; ++iOffs) {
 			for (i = 0; i < m_iChannels; ++i) {
 				// Calculates correlation value for the mixing
 				// position corresponding to iOffs.
@@ -410,6 +685,99 @@ unsigned int qtractorTimeStretch::seekBestOverlapPosition (void)
 }
 
 
+// Seeks for the optimal overlap-mixing position (FFT-assisted).
+//
+// Same as the linear search, but the cross-correlation numerators
+// are computed for all positions at once in the frequency domain,
+// while the normalization terms are computed as a running sum;
+// hence the results are not bit-exact to the time domain search.
+unsigned int qtractorTimeStretch::seekBestOverlapPositionFft (void)
+{
+	const unsigned int iInputLength = m_iSeekLength + m_iOverlapLength - 1;
+
+	// (Re)allocate FFT buffers and twiddle factors, if needed...
+	unsigned int N = 2;
+	while (N < iInputLength)
+		N <<= 1;
+	if (m_iFftSize != N) {
+		if (m_iFftSize > 0) {
+			delete [] m_pFftSin;
+			delete [] m_pFftCos;
+			delete [] m_pFftIm;
+			delete [] m_pFftRe;
+		}
+		m_iFftSize = N;
+		m_pFftRe  = new float [N];
+		m_pFftIm  = new float [N];
+		m_pFftCos = new float [N >> 1];
+		m_pFftSin = new float [N >> 1];
+		for (unsigned int k = 0; k < (N >> 1); ++k) {
+			const double w = 2.0 * M_PI * double(k) / double(N);
+			m_pFftCos[k] = float(::cos(w));
+			m_pFftSin[k] = float(::sin(w));
+		}
+	}
+
+	const unsigned int iMask = N - 1;
+	const float fScale = 0.25f / float(N);
+
+	float fBestCorr = -1e38f;
+	unsigned int iBestOffs = 0;
+
+	for (unsigned short i = 0; i < m_iChannels; ++i) {
+		const float *pInput = m_inputBuffer.ptrBegin(i);
+		const float *pRef = m_ppRefMidBuffer[i];
+		unsigned int n, k;
+		// Pack input (real) and reference (imaginary) together...
+		for (n = 0; n < N; ++n) {
+			m_pFftRe[n] = (n < iInputLength ? pInput[n] : 0.0f);
+			m_pFftIm[n] = (n < m_iOverlapLength ? pRef[n] : 0.0f);
+		}
+		fft_radix2(m_pFftRe, m_pFftIm, m_pFftCos, m_pFftSin, N, false);
+		// Unpack and multiply: C[k] = X[k] * conj(R[k])...
+		for (k = 0; k <= (N >> 1); ++k) {
+			const unsigned int m = (N - k) & iMask;
+			const float zr = m_pFftRe[k];
+			const float zi = m_pFftIm[k];
+			const float wr = m_pFftRe[m];
+			const float wi = m_pFftIm[m];
+			const float xr = (zr + wr);
+			const float xi = (zi - wi);
+			const float rr = (zi + wi);
+			const float ri = (wr - zr);
+			const float cr = (xr * rr + xi * ri) * fScale;
+			const float ci = (xi * rr - xr * ri) * fScale;
+			m_pFftRe[k] =  cr;
+			m_pFftIm[k] =  ci;
+			m_pFftRe[m] =  cr;
+			m_pFftIm[m] = -ci;
+		}
+		fft_radix2(m_pFftRe, m_pFftIm, m_pFftCos, m_pFftSin, N, true);
+		// Normalize by the running input energy...
+		double fSum = 0.0;
+		for (n = 0; n < m_iOverlapLength; ++n)
+			fSum += double(pInput[n]) * double(pInput[n]);
+		for (n = 0; n < m_iSeekLength; ++n) {
+			float fNorm = float(fSum);
+			if (fNorm < 1e-9f) fNorm = 1.0f; // avoid div by zero
+			const float fCorr = m_pFftRe[n] / ::sqrtf(fNorm);
+			if (fCorr > fBestCorr) {
+				fBestCorr = fCorr;
+				iBestOffs = n;
+			}
+			// Slide the window, but never past the input...
+			if (n + 1 < m_iSeekLength) {
+				const float fNext = pInput[n + m_iOverlapLength];
+				fSum += double(fNext) * double(fNext)
+					- double(pInput[n]) * double(pInput[n]);
+			}
+		}
+	}
+
+	return iBestOffs;
+}
+
+
 // Processes as many processing frames of the samples
 // from input-buffer, store the result into output-buffer.
 void qtractorTimeStretch::processFrames (void)
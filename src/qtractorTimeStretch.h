@@ -1,7 +1,7 @@
 // qtractorTimeStretch.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2014, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    Adapted and refactored from the SoundTouch library (L)GPL,
    Copyright (C) 2001-2012, Olli Parviainen.
@@ -63,6 +63,18 @@ public:
 	// Get quick-seek mode.
 	bool isQuickSeek() const;
 
+	// Set FFT-seek mode (FFT-assisted search on long seek windows).
+	void setFftSeek(bool bFftSeek);
+
+	// Get FFT-seek mode.
+	bool isFftSeek() const;
+
+	// Set block-seek mode (linear search, a block of positions at a time).
+	void setBlockSeek(bool bBlockSeek);
+
+	// Get block-seek mode.
+	bool isBlockSeek() const;
+
 	// Default values for sound processing parameters.
 	enum {
 
@@ -166,6 +178,7 @@ protected:
 
 	// Seeks for the optimal overlap-mixing position.
 	unsigned int seekBestOverlapPosition();
+	unsigned int seekBestOverlapPositionFft();
 
 	// Slopes the amplitude of the mid-buffer samples.
 	void calcCrossCorrReference();
@@ -183,6 +196,8 @@ private:
 
 	float m_fTempo;
 	bool  m_bQuickSeek;
+	bool  m_bFftSeek;
+	bool  m_bBlockSeek;
 
 	unsigned int m_iSampleRate;
 	unsigned int m_iSequenceMs;
@@ -208,6 +223,17 @@ private:
 
 	// Calculates the cross-correlation value over the overlap period.
 	float (*m_pfnCrossCorr)(const float *, const float *, unsigned int);
+
+	// Same, for a block of consecutive positions at once.
+	void (*m_pfnCrossCorrN)(const float *, const float *, unsigned int, float *);
+	unsigned int m_iCrossCorrN;
+
+	// FFT-assisted search buffers and twiddle factors.
+	unsigned int m_iFftSize;
+	float *m_pFftRe;
+	float *m_pFftIm;
+	float *m_pFftCos;
+	float *m_pFftSin;
 };
 
 
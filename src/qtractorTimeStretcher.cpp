@@ -1,7 +1,7 @@
 // qtractorTimeStretcher.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2010, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -48,6 +48,7 @@ qtractorTimeStretcher::qtractorTimeStretcher (
 			m_pTimeStretch = new qtractorTimeStretch(iChannels, iSampleRate);
 			m_pTimeStretch->setTempo(1.0f / fTimeStretch);
 			m_pTimeStretch->setQuickSeek(iFlags & WsolaQuickSeek);
+			m_pTimeStretch->setFftSeek(iFlags & WsolaFftSeek);
 			fTimeStretch = 0.0f;
 		}
 	}
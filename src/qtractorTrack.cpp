@@ -1,7 +1,7 @@
 // qtractorTrack.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -39,6 +39,7 @@
 #include "qtractorMixer.h"
 #include "qtractorMeter.h"
 #include "qtractorCurveFile.h"
+#include "qtractorXrunTrace.h"
 
 #include "qtractorTrackCommand.h"
 
@@ -49,6 +50,7 @@
 
 #include <QDomDocument>
 #include <QFileInfo>
+#include <QDir>
 
 
 //------------------------------------------------------------------------
@@ -318,10 +320,19 @@ qtractorTrack::qtractorTrack ( qtractorSession *pSession, TrackType trackType )
 
 	m_bClipRecordEx = false;
 
+	m_iClipSerial = 0;
+
 	m_clips.setAutoDelete(true);
 
 	m_pSyncThread = NULL;
 
+	m_ppGraphBuffer = NULL;
+
+	m_bAudioSilent = false;
+
+	m_iFreezeStart = 0;
+	m_pFreezeClip  = NULL;
+
 	m_pMidiVolumeObserver  = NULL;
 	m_pMidiPanningObserver = NULL;
 
@@ -401,6 +412,14 @@ void qtractorTrack::clear (void)
 	clearTakeInfo();
 	m_clips.clear();
 
+	if (m_pFreezeClip) {
+		delete m_pFreezeClip;
+		m_pFreezeClip = NULL;
+	}
+
+	m_sFreezeFilename.clear();
+	m_iFreezeStart = 0;
+
 	m_pPluginList->clear();
 	m_pCurveFile->clear();
 
@@ -504,6 +523,9 @@ bool qtractorTrack::open (void)
 		if (pAudioBus) {
 			m_pMonitor = new qtractorAudioMonitor(pAudioBus->channels(),
 				m_props.gain, m_props.panning);
+			// Frozen plugin chains are left unrealized,
+			// all but the aux-sends, which keep running...
+			m_pPluginList->setFrozen(isFrozen());
 			m_pPluginList->setChannels(pAudioBus->channels(),
 				qtractorPluginList::AudioTrack);
 		}
@@ -602,6 +624,10 @@ bool qtractorTrack::open (void)
 		delete pMonitor;
 	}
 
+	// Frozen tracks gets their own pre-rendered clip...
+	if (isFrozen())
+		updateFreeze();
+
 	// Ah, at least make new name feedback...
 	updateTrackName();
 
@@ -1089,12 +1115,16 @@ void qtractorTrack::insertClip ( qtractorClip *pClip )
 		m_clips.insertBefore(pClip, pNextClip);
 	else
 		m_clips.append(pClip);
+
+	updateClipSerial();
 }
 
 
 void qtractorTrack::unlinkClip ( qtractorClip *pClip )
 {
 	m_clips.unlink(pClip);
+
+	updateClipSerial();
 }
 
 void qtractorTrack::removeClip ( qtractorClip *pClip )
@@ -1106,6 +1136,19 @@ void qtractorTrack::removeClip ( qtractorClip *pClip )
 }
 
 
+// Clip list change serial: bumped on any clip being
+// (un)linked or having its start/length changed.
+void qtractorTrack::updateClipSerial (void)
+{
+	++m_iClipSerial;
+}
+
+unsigned int qtractorTrack::clipSerial (void) const
+{
+	return m_iClipSerial;
+}
+
+
 // Current clip on record (capture).
 void qtractorTrack::setClipRecord ( qtractorClip *pClipRecord )
 {
@@ -1262,22 +1305,21 @@ void qtractorTrack::resetProperties (void)
 void qtractorTrack::process ( qtractorClip *pClip,
 	unsigned long iFrameStart, unsigned long iFrameEnd )
 {
-	// Audio-buffers needs some preparation...
-	const unsigned int nframes = iFrameEnd - iFrameStart;
-	qtractorAudioMonitor *pAudioMonitor = NULL;
-	qtractorAudioBus *pOutputBus = NULL;
+	m_dspLoad.start();
+
 	if (m_props.trackType == qtractorTrack::Audio) {
-		pAudioMonitor = static_cast<qtractorAudioMonitor *> (m_pMonitor);
-		pOutputBus = static_cast<qtractorAudioBus *> (m_pOutputBus);
-		// Prepare this track buffer...
-		if (pOutputBus) {
-			qtractorAudioBus *pInputBus = (m_pSession->isTrackMonitor(this)
-				? static_cast<qtractorAudioBus *> (m_pInputBus) : NULL);
-			pOutputBus->buffer_prepare(nframes, pInputBus);
+		// Split in sub-blocks, at our own automation boundaries;
+		// any gain/panning changes get ramped over the period...
+		unsigned long iFrame = iFrameStart;
+		while (iFrame < iFrameEnd) {
+			const unsigned long iFrameSplit = process_split(iFrame, iFrameEnd);
+			process_curve(iFrame);
+			process_audio(pClip, iFrame, iFrameSplit,
+				iFrame - iFrameStart, iFrameEnd - iFrame, false);
+			iFrame = iFrameSplit;
 		}
 	}
-
-	// Playback...
+	else
 	if (!isMute() && (!m_pSession->soloTracks() || isSolo())) {
 		// Now, for every clip...
 		while (pClip && pClip->clipStart() < iFrameEnd) {
@@ -1287,15 +1329,154 @@ void qtractorTrack::process ( qtractorClip *pClip,
 		}
 	}
 
+	const unsigned long long iTime = m_dspLoad.stop(iFrameEnd - iFrameStart);
+
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+	if (pXrunTrace)
+		pXrunTrace->addItem(qtractorXrunTrace::Track, this, iTime);
+}
+
+
+// Audio track sub-block process executive.
+void qtractorTrack::process_audio ( qtractorClip *pClip,
+	unsigned long iFrameStart, unsigned long iFrameEnd,
+	unsigned int iOffset, unsigned int iRampFrames, bool bExport )
+{
+	qtractorAudioMonitor *pAudioMonitor
+		= static_cast<qtractorAudioMonitor *> (m_pMonitor);
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (m_pOutputBus);
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+
+	// Audio-buffers needs some preparation...
+	const unsigned int nframes = iFrameEnd - iFrameStart;
+
+	// Prepare this track buffer;
+	// no input monitoring while exporting...
+	if (pOutputBus) {
+		qtractorAudioBus *pInputBus
+			= (!bExport && m_pSession->isTrackMonitor(this)
+			? static_cast<qtractorAudioBus *> (m_pInputBus) : NULL);
+		m_bAudioSilent = pOutputBus->buffer_prepare(nframes, pInputBus, iOffset);
+		if (bExport)
+			m_bAudioSilent = false;
+	}
+
+	// Single track export (eg. freeze) ignores mute/solo state...
+	const bool bExportTrack
+		= (bExport && pAudioEngine && pAudioEngine->exportTrack() == this);
+
+	// Playback...
+	if (bExportTrack
+		|| (!isMute() && (!m_pSession->soloTracks() || isSolo()))) {
+		// Now, for every clip...
+		while (pClip && pClip->clipStart() < iFrameEnd) {
+			if (iFrameStart < pClip->clipStart() + pClip->clipLength()) {
+				if (bExport)
+					pClip->process_export(iFrameStart, iFrameEnd);
+				else
+					pClip->process(iFrameStart, iFrameEnd);
+			}
+			pClip = pClip->next();
+		}
+	}
+
 	// Audio buffers needs monitoring and commitment...
 	if (pAudioMonitor && pOutputBus) {
-		// Plugin chain post-processing...
-		m_pPluginList->process(pOutputBus->buffer(), nframes);
+		// Plugin chain post-processing (aux-sends only if frozen)...
+		pOutputBus->buffer_process(m_pPluginList,
+			nframes, m_bAudioSilent, iOffset);
+		// Single track export gets it pre-fader...
+		if (bExportTrack) {
+			pAudioEngine->process_export_add(pOutputBus->buffer(),
+				pOutputBus->channels(), nframes, iOffset);
+		}
 		// Monitor passthru...
-		pAudioMonitor->process(pOutputBus->buffer(), nframes);
+		pAudioMonitor->process(pOutputBus->buffer(), nframes, 0, iRampFrames);
 		// Actually render it...
-		pOutputBus->buffer_commit(nframes);
+		pOutputBus->buffer_commit(nframes, iOffset);
+	}
+}
+
+
+// Track parallel process cycle executive (deferred commit).
+void qtractorTrack::process_graph ( qtractorClip *pClip,
+	unsigned long iFrameStart, unsigned long iFrameEnd,
+	float **ppXBuffer, float **ppYBuffer,
+	float **ppZBuffer, float **ppWBuffer, bool bExport )
+{
+	// Audio tracks only...
+	qtractorAudioMonitor *pAudioMonitor
+		= static_cast<qtractorAudioMonitor *> (m_pMonitor);
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (m_pOutputBus);
+	if (pAudioMonitor == NULL || pOutputBus == NULL)
+		return;
+
+	m_dspLoad.start();
+
+	// Prepare this track (private) buffer;
+	// no input monitoring while exporting...
+	const unsigned int nframes = iFrameEnd - iFrameStart;
+	qtractorAudioBus *pInputBus = (!bExport && m_pSession->isTrackMonitor(this)
+		? static_cast<qtractorAudioBus *> (m_pInputBus) : NULL);
+	m_bAudioSilent = pOutputBus->buffer_prepare(
+		ppXBuffer, ppYBuffer, nframes, pInputBus);
+	if (bExport)
+		m_bAudioSilent = false;
+
+	// Clips shall render into our own buffer...
+	m_ppGraphBuffer = ppYBuffer;
+
+	// Playback...
+	if (!isMute() && (!m_pSession->soloTracks() || isSolo())) {
+		// Now, for every clip...
+		while (pClip && pClip->clipStart() < iFrameEnd) {
+			if (iFrameStart < pClip->clipStart() + pClip->clipLength()) {
+				if (bExport)
+					pClip->process_export(iFrameStart, iFrameEnd);
+				else
+					pClip->process(iFrameStart, iFrameEnd);
+			}
+			pClip = pClip->next();
+		}
 	}
+
+	m_ppGraphBuffer = NULL;
+
+	// Plugin chain post-processing (aux-sends only if frozen)...
+	pOutputBus->buffer_process(ppXBuffer, ppYBuffer,
+		ppZBuffer, ppWBuffer, m_pPluginList, nframes, m_bAudioSilent);
+	// Monitor passthru...
+	pAudioMonitor->process(ppYBuffer, nframes);
+
+	const unsigned long long iTime = m_dspLoad.stop(nframes);
+
+	qtractorXrunTrace *pXrunTrace = qtractorXrunTrace::getInstance();
+	if (pXrunTrace)
+		pXrunTrace->addItem(qtractorXrunTrace::Track, this, iTime);
+}
+
+
+// Track parallel process cycle commitment (in track order).
+void qtractorTrack::process_commit ( unsigned int nframes, float **ppXBuffer )
+{
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (m_pOutputBus);
+	if (pOutputBus)
+		pOutputBus->buffer_commit(ppXBuffer, nframes);
+}
+
+
+// Audio work buffer accessor (output bus or graph node buffer).
+float **qtractorTrack::audioBuffer (void) const
+{
+	if (m_ppGraphBuffer)
+		return m_ppGraphBuffer;
+
+	qtractorAudioBus *pOutputBus
+		= static_cast<qtractorAudioBus *> (m_pOutputBus);
+	return (pOutputBus ? pOutputBus->buffer() : NULL);
 }
 
 
@@ -1303,22 +1484,22 @@ void qtractorTrack::process ( qtractorClip *pClip,
 void qtractorTrack::process_export ( qtractorClip *pClip,
 	unsigned long iFrameStart, unsigned long iFrameEnd )
 {
-	// Track automation processing...
-	qtractorCurveList *pCurveList = curveList();
-	if (pCurveList && pCurveList->isProcess())
-		pCurveList->process(iFrameStart);
-
-	// Audio-buffers needs some preparation...
-	const unsigned int nframes = iFrameEnd - iFrameStart;
-	qtractorAudioMonitor *pAudioMonitor = NULL;
-	qtractorAudioBus *pOutputBus = NULL;
 	if (m_props.trackType == qtractorTrack::Audio) {
-		pAudioMonitor = static_cast<qtractorAudioMonitor *> (m_pMonitor);
-		pOutputBus = static_cast<qtractorAudioBus *> (m_pOutputBus);
-		if (pOutputBus)
-			pOutputBus->buffer_prepare(nframes);
+		// Split in sub-blocks, at our own automation boundaries...
+		unsigned long iFrame = iFrameStart;
+		while (iFrame < iFrameEnd) {
+			const unsigned long iFrameSplit = process_split(iFrame, iFrameEnd);
+			process_curve(iFrame);
+			process_audio(pClip, iFrame, iFrameSplit,
+				iFrame - iFrameStart, iFrameEnd - iFrame, true);
+			iFrame = iFrameSplit;
+		}
+		return;
 	}
 
+	// Track automation processing...
+	process_curve(iFrameStart);
+
 	// Playback...
 	if (!isMute() && (!m_pSession->soloTracks() || isSolo())) {
 		// Now, for every clip...
@@ -1328,16 +1509,6 @@ void qtractorTrack::process_export ( qtractorClip *pClip,
 			pClip = pClip->next();
 		}
 	}
-
-	// Audio buffers needs monitoring and commitment...
-	if (pAudioMonitor && pOutputBus) {
-		// Plugin chain post-processing...
-		m_pPluginList->process(pOutputBus->buffer(), nframes);
-		// Monitor passthru...
-		pAudioMonitor->process(pOutputBus->buffer(), nframes);
-		// Actually render it...
-		pOutputBus->buffer_commit(nframes);
-	}
 }
 
 
@@ -1393,6 +1564,30 @@ void qtractorTrack::process_curve ( unsigned long iFrame )
 }
 
 
+// Next automation split frame, for sub-block
+// processing (audio tracks only, RT-safe).
+unsigned long qtractorTrack::process_split (
+	unsigned long iFrameStart, unsigned long iFrameEnd ) const
+{
+	if (m_props.trackType != qtractorTrack::Audio)
+		return iFrameEnd;
+
+	qtractorCurveList *pCurveList = curveList();
+	if (pCurveList == NULL || !pCurveList->isProcess())
+		return iFrameEnd;
+
+	qtractorAudioEngine *pAudioEngine = m_pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return iFrameEnd;
+
+	const unsigned int iFrames = pAudioEngine->automationFrames();
+	if (iFrames < 1)
+		return iFrameEnd;
+
+	return pCurveList->nextFrame(iFrameStart, iFrameEnd, iFrames);
+}
+
+
 
 // Track paint method.
 void qtractorTrack::drawTrack ( QPainter *pPainter, const QRect& trackRect,
@@ -1533,6 +1728,113 @@ qtractorAudioBufferThread *qtractorTrack::syncThread (void)
 }
 
 
+// Track freeze (pre-rendered clips and plugin chain) methods.
+void qtractorTrack::setFreeze (
+	const QString& sFreezeFilename, unsigned long iFreezeStart )
+{
+	if (m_props.trackType != qtractorTrack::Audio)
+		return;
+
+	m_sFreezeFilename = sFreezeFilename;
+	m_iFreezeStart = iFreezeStart;
+
+	// Only if already open...
+	if (m_pOutputBus)
+		updateFreeze();
+}
+
+
+void qtractorTrack::setFreezeEx (
+	const QString& sFreezeFilename, unsigned long iFreezeStart )
+{
+	if (m_props.trackType != qtractorTrack::Audio)
+		return;
+
+	m_sFreezeFilename = sFreezeFilename;
+	m_iFreezeStart = iFreezeStart;
+
+	// Only if already open...
+	if (m_pOutputBus)
+		updateFreezeEx();
+}
+
+
+const QString& qtractorTrack::freezeFilename (void) const
+{
+	return m_sFreezeFilename;
+}
+
+
+unsigned long qtractorTrack::freezeStart (void) const
+{
+	return m_iFreezeStart;
+}
+
+
+bool qtractorTrack::isFrozen (void) const
+{
+	return !m_sFreezeFilename.isEmpty();
+}
+
+
+// Track freeze (hidden) audio clip accessor.
+qtractorClip *qtractorTrack::freezeClip (void) const
+{
+	return m_pFreezeClip;
+}
+
+
+// Track freeze clip and plugin chain (re)realization.
+void qtractorTrack::updateFreeze (void)
+{
+	// Take this track out of RT processing sight...
+	m_pSession->detachTrack(this);
+	m_pSession->updateSnapshot();
+
+	updateFreezeEx();
+
+	// Back into RT processing sight...
+	m_pSession->attachTracks();
+}
+
+
+void qtractorTrack::updateFreezeEx (void)
+{
+	if (m_props.trackType != qtractorTrack::Audio || m_pOutputBus == NULL)
+		return;
+
+	if (m_pFreezeClip) {
+		delete m_pFreezeClip;
+		m_pFreezeClip = NULL;
+	}
+
+	if (isFrozen()) {
+		// Plugin chain state must be kept while unrealized
+		// (all but the aux-sends, which are kept running)...
+		if (m_pPluginList->isFrozen()) {
+			for (qtractorPlugin *pPlugin = m_pPluginList->first();
+					pPlugin; pPlugin = pPlugin->next()) {
+				if (pPlugin->instances() < 1)
+					pPlugin->realizeValues();
+			}
+		} else {
+			m_pPluginList->setFrozen(true);
+		}
+		// The pre-rendered clip, out of the clip list...
+		qtractorAudioClip *pAudioClip = new qtractorAudioClip(this);
+		pAudioClip->setClipStart(m_iFreezeStart);
+		if (pAudioClip->openAudioFile(m_sFreezeFilename))
+			m_pFreezeClip = pAudioClip;
+		else
+			delete pAudioClip;
+	}
+	else {
+		// Back to the realized plugin chain...
+		m_pPluginList->setFrozen(false);
+	}
+}
+
+
 // Track state (monitor record, mute, solo) button setup.
 qtractorSubject *qtractorTrack::monitorSubject (void) const
 {
@@ -1683,6 +1985,29 @@ bool qtractorTrack::loadElement (
 			}
 		}
 		else
+		// Load track freeze (pre-rendered) state...
+		if (eChild.tagName() == "freeze") {
+			QString sFreezeFilename;
+			unsigned long iFreezeStart = 0;
+			for (QDomNode nFreeze = eChild.firstChild();
+					!nFreeze.isNull();
+						nFreeze = nFreeze.nextSibling()) {
+				// Convert freeze node to element...
+				QDomElement eFreeze = nFreeze.toElement();
+				if (eFreeze.isNull())
+					continue;
+				if (eFreeze.tagName() == "filename") {
+					const QDir dir(m_pSession->sessionDir());
+					sFreezeFilename = QDir::cleanPath(
+						dir.absoluteFilePath(eFreeze.text()));
+				}
+				else if (eFreeze.tagName() == "start")
+					iFreezeStart = eFreeze.text().toULong();
+			}
+			if (!sFreezeFilename.isEmpty())
+				qtractorTrack::setFreeze(sFreezeFilename, iFreezeStart);
+		}
+		else
 		if (eChild.tagName() == "view") {
 			for (QDomNode nView = eChild.firstChild();
 					!nView.isNull();
@@ -1811,6 +2136,16 @@ bool qtractorTrack::saveElement (
 		QString::number(qtractorTrack::panning()), &eState);
 	pElement->appendChild(eState);
 
+	// Save track freeze (pre-rendered) state...
+	if (m_pFreezeClip) {
+		QDomElement eFreeze = pDocument->document()->createElement("freeze");
+		pDocument->saveTextElement("filename",
+			m_pFreezeClip->relativeFilename(pDocument), &eFreeze);
+		pDocument->saveTextElement("start",
+			QString::number(m_iFreezeStart), &eFreeze);
+		pElement->appendChild(eFreeze);
+	}
+
 	// Save track view attributes...
 	QDomElement eView = pDocument->document()->createElement("view");
 	pDocument->saveTextElement("height",
@@ -1,7 +1,7 @@
 // qtractorTrack.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -26,6 +26,8 @@
 
 #include "qtractorMidiControl.h"
 
+#include "qtractorDspLoad.h"
+
 #include <QColor>
 
 
@@ -178,6 +180,11 @@ public:
 	void unlinkClip(qtractorClip *pClip);
 	void removeClip(qtractorClip *pClip);
 
+	// Clip list change serial: bumped on any clip being
+	// (un)linked or having its start/length changed.
+	void updateClipSerial();
+	unsigned int clipSerial() const;
+
 	// Current clip on record (capture).
 	void setClipRecord(qtractorClip *pClipRecord);
 	qtractorClip *clipRecord() const;
@@ -205,6 +212,26 @@ public:
 	void process(qtractorClip *pClip,
 		unsigned long iFrameStart, unsigned long iFrameEnd);
 
+	// Track parallel process cycle executive (deferred commit).
+	void process_graph(qtractorClip *pClip,
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		float **ppXBuffer, float **ppYBuffer,
+		float **ppZBuffer, float **ppWBuffer, bool bExport = false);
+	void process_commit(unsigned int nframes, float **ppXBuffer);
+
+	// Audio work buffer accessor (output bus or graph node buffer).
+	float **audioBuffer() const;
+
+	// Audio work buffer silence flag (cleared by playing clips).
+	void setAudioSilent(bool bAudioSilent)
+		{ m_bAudioSilent = bAudioSilent; }
+	bool isAudioSilent() const
+		{ return m_bAudioSilent; }
+
+	// DSP load meter accessor (process cycle only).
+	qtractorDspLoad *dspLoad()
+		{ return &m_dspLoad; }
+
 	// Track freewheeling process cycle executive (needed for export).
 	void process_export(qtractorClip *pClip,
 		unsigned long iFrameStart, unsigned long iFrameEnd);
@@ -216,6 +243,11 @@ public:
 	// Track special process automation executive.
 	void process_curve(unsigned long iFrame);
 
+	// Next automation split frame, for sub-block
+	// processing (audio tracks only, RT-safe).
+	unsigned long process_split(
+		unsigned long iFrameStart, unsigned long iFrameEnd) const;
+
 	// Track paint method.
 	void drawTrack(QPainter *pPainter, const QRect& trackRect,
 		unsigned long iTrackStart, unsigned long iTrackEnd,
@@ -233,6 +265,20 @@ public:
 	// Audio buffer ring-cache (playlist) methods.
 	qtractorAudioBufferThread *syncThread();
 
+	// Track freeze (pre-rendered clips and plugin chain) methods;
+	// an empty file name just unfreezes back (audio tracks only).
+	void setFreeze(const QString& sFreezeFilename,
+		unsigned long iFreezeStart = 0);
+	// Same, while already out of RT processing sight (detached).
+	void setFreezeEx(const QString& sFreezeFilename,
+		unsigned long iFreezeStart = 0);
+	const QString& freezeFilename() const;
+	unsigned long freezeStart() const;
+	bool isFrozen() const;
+
+	// Track freeze (hidden) audio clip accessor.
+	qtractorClip *freezeClip() const;
+
 	// Track state (monitor, record, mute, solo) button setup.
 	qtractorSubject *monitorSubject() const;
 	qtractorSubject *recordSubject() const;
@@ -340,6 +386,13 @@ public:
 	// Update tracks/list-view.
 	void updateTracks();
 
+protected:
+
+	// Audio track sub-block process executive.
+	void process_audio(qtractorClip *pClip,
+		unsigned long iFrameStart, unsigned long iFrameEnd,
+		unsigned int iOffset, unsigned int iRampFrames, bool bExport);
+
 private:
 
 	qtractorSession *m_pSession;    // Session reference.
@@ -358,6 +411,8 @@ private:
 
 	qtractorList<qtractorClip> m_clips; // List of clips.
 
+	volatile unsigned int m_iClipSerial; // Clip list change serial.
+
 	qtractorClip *m_pClipRecord;        // Current clip on record (capture).
 	unsigned long m_iClipRecordStart;   // Current clip on record start frame.
 
@@ -368,6 +423,24 @@ private:
 	// Audio buffer ring-cache (playlist).
 	qtractorAudioBufferThread *m_pSyncThread;
 
+	// Audio work buffer override (parallel graph node).
+	float **m_ppGraphBuffer;
+
+	// Audio work buffer silence flag (per-cycle).
+	bool m_bAudioSilent;
+
+	// DSP load meter (process cycle only).
+	qtractorDspLoad m_dspLoad;
+
+	// Track freeze (pre-rendered) file and clip.
+	QString       m_sFreezeFilename;
+	unsigned long m_iFreezeStart;
+	qtractorClip *m_pFreezeClip;
+
+	// Track freeze clip and plugin chain (re)realization.
+	void updateFreeze();
+	void updateFreezeEx();
+
 	// MIDI track/channel (volume, panning) observers.
 	class MidiVolumeObserver;
 	class MidiPanningObserver;
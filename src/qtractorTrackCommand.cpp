@@ -1,7 +1,7 @@
 // qtractorTrackCommand.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -28,6 +28,7 @@
 #include "qtractorTracks.h"
 #include "qtractorTrackList.h"
 #include "qtractorAudioClip.h"
+#include "qtractorAudioEngine.h"
 #include "qtractorMidiEngine.h"
 #include "qtractorMidiControl.h"
 #include "qtractorMidiManager.h"
@@ -38,6 +39,8 @@
 #include "qtractorPlugin.h"
 #include "qtractorCurve.h"
 
+#include <QFile>
+
 
 //----------------------------------------------------------------------
 // class qtractorTrackCommand - implementation
@@ -1350,4 +1353,129 @@ bool qtractorTrackInstrumentCommand::redo (void)
 }
 
 
+//----------------------------------------------------------------------
+// class qtractorTrackFreezeCommand - implementation.
+//
+
+// Constructor.
+qtractorTrackFreezeCommand::qtractorTrackFreezeCommand (
+	qtractorTrack *pTrack, bool bFreeze )
+	: qtractorTrackCommand(bFreeze
+		? QObject::tr("track freeze") : QObject::tr("track unfreeze"), pTrack),
+		m_bFreeze(bFreeze), m_iFreezeStart(0)
+{
+}
+
+
+// Track-freeze command method.
+bool qtractorTrackFreezeCommand::redo (void)
+{
+	qtractorTrack *pTrack = track();
+	if (pTrack == NULL)
+		return false;
+
+	if (pTrack->trackType() != qtractorTrack::Audio)
+		return false;
+
+	// Render it first, only once...
+	if (m_bFreeze && m_sFreezeFilename.isEmpty() && !render())
+		return false;
+
+	// Set undo values...
+	const QString sFreezeFilename = pTrack->freezeFilename();
+	const unsigned long iFreezeStart = pTrack->freezeStart();
+
+	// Freeze or unfreeze (empty file name)...
+	pTrack->setFreeze(m_sFreezeFilename, m_iFreezeStart);
+
+	// Reset undo values...
+	m_sFreezeFilename = sFreezeFilename;
+	m_iFreezeStart = iFreezeStart;
+
+	m_bFreeze = !m_bFreeze;
+
+	// Refresh to most recent things...
+	qtractorMainForm *pMainForm = qtractorMainForm::getInstance();
+	if (pMainForm) {
+		qtractorMixer *pMixer = pMainForm->mixer();
+		if (pMixer)
+			pMixer->updateTrackStrip(pTrack);
+	}
+
+	return true;
+}
+
+
+// Plugin-chain tail render time (msecs).
+int qtractorTrackFreezeCommand::g_iTailTime = 2000;
+
+void qtractorTrackFreezeCommand::setTailTime ( int iTailTime )
+{
+	g_iTailTime = (iTailTime > 0 ? iTailTime : 0);
+}
+
+int qtractorTrackFreezeCommand::tailTime (void)
+{
+	return g_iTailTime;
+}
+
+
+// Track-freeze render method (audio export).
+bool qtractorTrackFreezeCommand::render (void)
+{
+	qtractorTrack *pTrack = track();
+	if (pTrack == NULL)
+		return false;
+
+	qtractorSession *pSession = pTrack->session();
+	if (pSession == NULL)
+		return false;
+
+	qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+	if (pAudioEngine == NULL)
+		return false;
+
+	// Render range spans all track clips...
+	qtractorClip *pClip = pTrack->clips().first();
+	if (pClip == NULL)
+		return false;
+
+	const unsigned long iFreezeStart = pClip->clipStart();
+	unsigned long iFreezeEnd = iFreezeStart;
+	for ( ; pClip; pClip = pClip->next()) {
+		const unsigned long iClipEnd = pClip->clipStart() + pClip->clipLength();
+		if (iFreezeEnd < iClipEnd)
+			iFreezeEnd = iClipEnd;
+	}
+
+	// Plus some room for the plugin-chain tail,
+	// the longest declared by any plugin, if longer...
+	unsigned long iTailFrames
+		= (unsigned long) g_iTailTime * pAudioEngine->sampleRate() / 1000;
+	qtractorPluginList *pPluginList = pTrack->pluginList();
+	if (pPluginList) {
+		for (qtractorPlugin *pPlugin = pPluginList->first();
+				pPlugin; pPlugin = pPlugin->next()) {
+			if (pPlugin->isActivated() && iTailFrames < pPlugin->tailFrames())
+				iTailFrames = pPlugin->tailFrames();
+		}
+	}
+	iFreezeEnd += iTailFrames;
+
+	// Single track export, pre-fader...
+	const QString& sFreezeFilename
+		= pSession->createFilePath(pTrack->trackName() + "-freeze", "wav");
+	if (!pAudioEngine->fileExport(sFreezeFilename,
+			QList<qtractorAudioBus *> (), iFreezeStart, iFreezeEnd, pTrack)) {
+		QFile::remove(sFreezeFilename);
+		return false;
+	}
+
+	m_sFreezeFilename = sFreezeFilename;
+	m_iFreezeStart = iFreezeStart;
+
+	return true;
+}
+
+
 // end of qtractorTrackCommand.cpp
@@ -1,7 +1,7 @@
 // qtractorTrackCommand.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -423,6 +423,42 @@ private:
 };
 
 
+//----------------------------------------------------------------------
+// class qtractorTrackFreezeCommand - declaration.
+//
+
+class qtractorTrackFreezeCommand : public qtractorTrackCommand
+{
+public:
+
+	// Constructor.
+	qtractorTrackFreezeCommand(qtractorTrack *pTrack, bool bFreeze);
+
+	// Track-freeze command methods.
+	bool redo();
+	bool undo() { return redo(); }
+
+	// Plugin-chain tail render time (msecs).
+	static void setTailTime(int iTailTime);
+	static int tailTime();
+
+protected:
+
+	// Track-freeze render method (audio export).
+	bool render();
+
+private:
+
+	// Instance variables.
+	bool          m_bFreeze;
+	QString       m_sFreezeFilename;
+	unsigned long m_iFreezeStart;
+
+	// Plugin-chain tail render time (msecs).
+	static int g_iTailTime;
+};
+
+
 #endif	// __qtractorTrackCommand_h
 
 // end of qtractorTrackCommand.h
@@ -1,7 +1,7 @@
 // qtractorTrackView.cpp
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -77,6 +77,10 @@
 // Follow-playhead: maximum iterations on hold.
 #define QTRACTOR_SYNC_VIEW_HOLD 46
 
+// Track view tile width and (seamless) drawing margin (pixels).
+static const int c_iTileWidth  = 256;
+static const int c_iTileMargin = 8;
+
 
 //----------------------------------------------------------------------------
 // qtractorTrackView::ClipBoard - Local clipaboard singleton.
@@ -118,6 +122,9 @@ qtractorTrackView::qtractorTrackView ( qtractorTracks *pTracks,
 	m_pEditCurveNodeSpinBox = NULL;
 	m_iEditCurveNodeDirty = 0;
 
+	m_iTileView  = 0;
+	m_iTileStamp = 0;
+
 	clear();
 
 	// Zoom tool widgets
@@ -232,6 +239,8 @@ void qtractorTrackView::clear (void)
 		delete m_pSessionCursor;
 	m_pSessionCursor = NULL;
 
+	m_tiles.clear();
+
 	if (m_pRubberBand)
 		delete m_pRubberBand;
 	m_pRubberBand = NULL;
@@ -855,75 +864,74 @@ void qtractorTrackView::updatePixmap ( int cx, int cy )
 	// Update view session cursor location,
 	// so that we'll start drawing clips from there...
 	const unsigned long iTrackStart = pTimeScale->frameFromPixel(cx);
-	const unsigned long iTrackEnd   = iTrackStart + pTimeScale->frameFromPixel(w);
 	// Create cursor now if applicable...
-	if (m_pSessionCursor == NULL) {
+	if (m_pSessionCursor == NULL)
 		m_pSessionCursor = pSession->createSessionCursor(iTrackStart);
-	} else {
-		m_pSessionCursor->seek(iTrackStart);
+
+	// Any view (zoom) change invalidates all tiles...
+	unsigned int iTileView = pTimeScale->sampleRate();
+	iTileView = (iTileView * 31) + pTimeScale->pixelsPerBeat();
+	iTileView = (iTileView * 31) + pTimeScale->horizontalZoom();
+	iTileView = (iTileView * 31) + rgbMid.rgb();
+	iTileView = (iTileView * 31) + (m_bSnapGrid ? 2 : 0) + (m_bSnapZebra ? 1 : 0);
+	if (m_iTileView != iTileView) {
+		m_iTileView = iTileView;
+		m_tiles.clear();
 	}
 
-	const QColor& rgbLight = pal.midlight().color();
-	const QColor& rgbDark  = rgbMid.darker(120);
+	++m_iTileStamp;
 
-	// Draw vertical grid lines...
-	if (m_bSnapGrid || m_bSnapZebra) {
-		const QBrush zebra(QColor(0, 0, 0, 20));
-		qtractorTimeScale::Cursor cursor(pTimeScale);
-		qtractorTimeScale::Node *pNode = cursor.seekPixel(cx);
-		unsigned short iPixelsPerBeat = pNode->pixelsPerBeat();
-		unsigned int iBeat = pNode->beatFromPixel(cx);
-		if (iBeat > 0) pNode = cursor.seekBeat(--iBeat);
-		unsigned short iBar = pNode->barFromBeat(iBeat);
-		int x = pNode->pixelFromBeat(iBeat) - cx;
-		int x2 = x;
-		while (x < w) {
-			bool bBeatIsBar = pNode->beatIsBar(iBeat);
-			if (bBeatIsBar) {
-				if (m_bSnapGrid) {
-					painter.setPen(rgbLight);
-					painter.drawLine(x, 0, x, h);
+	// Draw tracks, column by column, only (re)drawing
+	// the tiles that are missing or have changed...
+	const int iColumn1 = cx / c_iTileWidth;
+	const int iColumn2 = (cx + w) / c_iTileWidth;
+	int iTiles = 0;
+	int y1, y2;
+	y1 = y2 = 0;
+	for (int iColumn = iColumn1; iColumn <= iColumn2; ++iColumn) {
+		const int tx = iColumn * c_iTileWidth;
+		const int tx1 = (tx > c_iTileMargin ? tx - c_iTileMargin : 0);
+		const int tx2 = tx + c_iTileWidth + c_iTileMargin;
+		const unsigned long iTileStart = pTimeScale->frameFromPixel(tx1);
+		const unsigned long iTileEnd   = pTimeScale->frameFromPixel(tx2);
+		m_pSessionCursor->seek(iTileStart);
+		y1 = y2 = 0;
+		int iTrack = 0;
+		qtractorTrack *pTrack = pSession->tracks().first();
+		while (pTrack && y2 < cy + h) {
+			y1  = y2;
+			y2 += pTrack->zoomHeight();
+			if (y2 > cy) {
+				qtractorClip *pClip = m_pSessionCursor->clip(iTrack);
+				const unsigned int sig
+					= tileSig(pTrack, pClip, iTileStart, iTileEnd);
+				Tile& tile = m_tiles[TileKey(pTrack, iColumn)];
+				if (tile.pixmap.isNull() || tile.sig != sig) {
+					drawTile(tile.pixmap, pTrack, pClip,
+						iTileStart, iTileEnd, tx, (iTrack > 0));
+					tile.sig = sig;
 				}
-				if (m_bSnapZebra && (x > x2) && (++iBar & 1))
-					painter.fillRect(QRect(x2, 0, x - x2 + 1, h), zebra);
-				x2 = x;
-				if (iBeat == pNode->beat)
-					iPixelsPerBeat = pNode->pixelsPerBeat();
-			}
-			if (m_bSnapGrid && (bBeatIsBar || iPixelsPerBeat > 16)) {
-				painter.setPen(rgbDark);
-				painter.drawLine(x - 1, 0, x - 1, h);
+				tile.stamp = m_iTileStamp;
+				painter.drawPixmap(tx - cx, y1 - cy, tile.pixmap);
+				++iTiles;
 			}
-			pNode = cursor.seekBeat(++iBeat);
-			x = pNode->pixelFromBeat(iBeat) - cx;
+			pTrack = pTrack->next();
+			++iTrack;
 		}
-		if (m_bSnapZebra && (x > x2) && (++iBar & 1))
-			painter.fillRect(QRect(x2, 0, x - x2 + 1, h), zebra);
 	}
 
-	// Draw track and horizontal lines...
-	int y1, y2;
-	y1 = y2 = 0;
-	int iTrack = 0;
-	qtractorTrack *pTrack = pSession->tracks().first();
-	while (pTrack && y2 < cy + h) {
-		y1  = y2;
-		y2 += pTrack->zoomHeight();
-		if (y2 > cy) {
-			// Dispatch to paint this track...
-			if (y1 > cy) {
-				painter.setPen(rgbLight);
-				painter.drawLine(0, y1 - cy, w, y1 - cy);
-			}
-			const QRect trackRect(0, y1 - cy + 1, w, y2 - y1 - 2);
-		//	painter.fillRect(trackRect, rgbMid);
-			pTrack->drawTrack(&painter, trackRect, iTrackStart, iTrackEnd,
-				m_pSessionCursor->clip(iTrack));
-			painter.setPen(rgbDark);
-			painter.drawLine(0, y2 - cy - 1, w, y2 - cy - 1);
+	// Back to where the view starts...
+	m_pSessionCursor->seek(iTrackStart);
+
+	// Drop the tiles out of sight, if too many...
+	if (m_tiles.count() > (iTiles << 2)) {
+		QHash<TileKey, Tile>::Iterator iter = m_tiles.begin();
+		while (iter != m_tiles.end()) {
+			if (iter.value().stamp != m_iTileStamp)
+				iter = m_tiles.erase(iter);
+			else
+				++iter;
 		}
-		pTrack = pTrack->next();
-		++iTrack;
 	}
 
 	// Fill the empty area...
@@ -990,6 +998,155 @@ void qtractorTrackView::updatePixmap ( int cx, int cy )
 }
 
 
+
+
+// Track view tile cache reset (eg. on contents change).
+void qtractorTrackView::clearTiles (void)
+{
+	m_tiles.clear();
+}
+
+
+// Track view tile signature: whatever might change its looks.
+unsigned int qtractorTrackView::tileSig ( qtractorTrack *pTrack,
+	qtractorClip *pClip, unsigned long iTileStart, unsigned long iTileEnd ) const
+{
+	qtractorSession *pSession = pTrack->session();
+
+	unsigned int sig = pTrack->zoomHeight();
+	sig = (sig * 31) + pTrack->background().rgb();
+	sig = (sig * 31) + pTrack->foreground().rgb();
+	sig = (sig * 31) + (pTrack->isMute() ? 2 : 0) + (pTrack->isSolo() ? 1 : 0);
+	sig = (sig * 31) + (pSession && pSession->soloTracks() > 0 ? 1 : 0);
+	if (pTrack->isClipRecordEx())
+		sig = (sig * 31) + qHash(pTrack->clipRecord());
+
+	if (pClip == NULL)
+		pClip = pTrack->clips().first();
+
+	while (pClip) {
+		const unsigned long iClipStart = pClip->clipStart();
+		if (iClipStart > iTileEnd)
+			break;
+		const unsigned long iClipEnd = iClipStart + pClip->clipLength();
+		if (iClipStart < iTileEnd && iClipEnd > iTileStart) {
+			sig = (sig * 31) + qHash(pClip);
+			sig = (sig * 31) + iClipStart;
+			sig = (sig * 31) + pClip->clipLength();
+			sig = (sig * 31) + pClip->clipOffset();
+			sig = (sig * 31) + pClip->fadeInLength() + int(pClip->fadeInType());
+			sig = (sig * 31) + pClip->fadeOutLength() + int(pClip->fadeOutType());
+			sig = (sig * 31) + int(1000.0f * pClip->clipGain());
+			sig = (sig * 31) + qHash(pClip->clipTitle());
+		}
+		pClip = pClip->next();
+	}
+
+	return sig;
+}
+
+
+// Track view tile (re)drawing.
+void qtractorTrackView::drawTile ( QPixmap& pixmap,
+	qtractorTrack *pTrack, qtractorClip *pClip,
+	unsigned long iTileStart, unsigned long iTileEnd, int tx, bool bTop )
+{
+	qtractorSession *pSession = pTrack->session();
+	if (pSession == NULL)
+		return;
+
+	const int w = c_iTileWidth;
+	const int h = pTrack->zoomHeight();
+
+	const QPalette& pal = qtractorScrollView::palette();
+	const QColor& rgbMid   = pal.mid().color();
+	const QColor& rgbLight = pal.midlight().color();
+	const QColor& rgbDark  = rgbMid.darker(120);
+
+	pixmap = QPixmap(w, h);
+	pixmap.fill(rgbMid);
+
+	QPainter painter(&pixmap);
+	painter.initFrom(this);
+
+	// Draw vertical grid lines...
+	drawGrid(&painter, tx, w, h);
+
+	// Draw track and horizontal lines...
+	if (bTop) {
+		painter.setPen(rgbLight);
+		painter.drawLine(0, 0, w, 0);
+	}
+
+	// Clips are drawn a little wider than the tile,
+	// then clipped, so that there are no seams in between...
+	const int x1 = pSession->pixelFromFrame(iTileStart) - tx;
+	const int x2 = pSession->pixelFromFrame(iTileEnd) - tx;
+	painter.save();
+	painter.setClipRect(0, 0, w, h);
+	painter.translate(x1, 0);
+	const QRect trackRect(0, 1, x2 - x1, h - 2);
+	pTrack->drawTrack(&painter, trackRect, iTileStart, iTileEnd, pClip);
+	painter.restore();
+
+	painter.setPen(rgbDark);
+	painter.drawLine(0, h - 1, w, h - 1);
+}
+
+
+// Draw vertical grid lines (contents range, from cx to cx + w).
+void qtractorTrackView::drawGrid (
+	QPainter *pPainter, int cx, int w, int h ) const
+{
+	if (!m_bSnapGrid && !m_bSnapZebra)
+		return;
+
+	qtractorSession *pSession = qtractorSession::getInstance();
+	if (pSession == NULL)
+		return;
+
+	qtractorTimeScale *pTimeScale = pSession->timeScale();
+	if (pTimeScale == NULL)
+		return;
+
+	const QPalette& pal = qtractorScrollView::palette();
+	const QColor& rgbLight = pal.midlight().color();
+	const QColor& rgbDark  = pal.mid().color().darker(120);
+
+	const QBrush zebra(QColor(0, 0, 0, 20));
+	qtractorTimeScale::Cursor cursor(pTimeScale);
+	qtractorTimeScale::Node *pNode = cursor.seekPixel(cx);
+	unsigned short iPixelsPerBeat = pNode->pixelsPerBeat();
+	unsigned int iBeat = pNode->beatFromPixel(cx);
+	if (iBeat > 0) pNode = cursor.seekBeat(--iBeat);
+	unsigned short iBar = pNode->barFromBeat(iBeat);
+	int x = pNode->pixelFromBeat(iBeat) - cx;
+	int x2 = x;
+	while (x < w) {
+		bool bBeatIsBar = pNode->beatIsBar(iBeat);
+		if (bBeatIsBar) {
+			if (m_bSnapGrid) {
+				pPainter->setPen(rgbLight);
+				pPainter->drawLine(x, 0, x, h);
+			}
+			if (m_bSnapZebra && (x > x2) && (++iBar & 1))
+				pPainter->fillRect(QRect(x2, 0, x - x2 + 1, h), zebra);
+			x2 = x;
+			if (iBeat == pNode->beat)
+				iPixelsPerBeat = pNode->pixelsPerBeat();
+		}
+		if (m_bSnapGrid && (bBeatIsBar || iPixelsPerBeat > 16)) {
+			pPainter->setPen(rgbDark);
+			pPainter->drawLine(x - 1, 0, x - 1, h);
+		}
+		pNode = cursor.seekBeat(++iBeat);
+		x = pNode->pixelFromBeat(iBeat) - cx;
+	}
+	if (m_bSnapZebra && (x > x2) && (++iBar & 1))
+		pPainter->fillRect(QRect(x2, 0, x - x2 + 1, h), zebra);
+}
+
+
 // To have track view in v-sync with track list.
 void qtractorTrackView::contentsYMovingSlot ( int /*cx*/, int cy )
 {
@@ -1,7 +1,7 @@
 // qtractorTrackView.h
 //
 /****************************************************************************
-   Copyright (C) 2005-2016, rncbc aka Rui Nuno Capela. All rights reserved.
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
 
    This program is free software; you can redistribute it and/or
    modify it under the terms of the GNU General Public License
@@ -29,6 +29,7 @@
 #include "qtractorCurve.h"
 
 #include <QPixmap>
+#include <QHash>
 
 
 // Forward declarations.
@@ -78,6 +79,9 @@ public:
 	// Update track view content width.
 	void updateContentsWidth(int iContentsWidth = 0);
 
+	// Track view tile cache reset (eg. on contents change).
+	void clearTiles();
+
 	// Contents update overloaded methods.
 	void updateContents(const QRect& rect);
 	void updateContents();
@@ -404,6 +408,13 @@ protected slots:
 	// (Re)create the complete track view pixmap.
 	void updatePixmap(int cx, int cy);
 
+	// Track view tile helpers.
+	unsigned int tileSig(qtractorTrack *pTrack, qtractorClip *pClip,
+		unsigned long iTileStart, unsigned long iTileEnd) const;
+	void drawTile(QPixmap& pixmap, qtractorTrack *pTrack, qtractorClip *pClip,
+		unsigned long iTileStart, unsigned long iTileEnd, int tx, bool bTop);
+	void drawGrid(QPainter *pPainter, int cx, int w, int h) const;
+
 	// Drag-reset timer slot.
 	void dragTimeout();
 
@@ -426,6 +437,22 @@ private:
 	// Local double-buffering pixmap.
 	QPixmap m_pixmap;
 
+	// Track view tile cache: one pixmap per track row and
+	// fixed width column, in contents coordinates.
+	struct Tile
+	{
+		QPixmap      pixmap;
+		unsigned int sig;
+		unsigned int stamp;
+	};
+
+	typedef QPair<qtractorTrack *, int> TileKey;
+
+	QHash<TileKey, Tile> m_tiles;
+
+	unsigned int m_iTileView;
+	unsigned int m_iTileStamp;
+
 	// To maintain the current track/clip positioning.
 	qtractorSessionCursor *m_pSessionCursor;
 
@@ -403,6 +403,9 @@ void qtractorTracks::updateContents ( bool bRefresh )
 	qDebug("qtractorTracks::updateContents(%d)\n", int(bRefresh));
 #endif
 
+	// Whatever might have changed, redraw it all...
+	m_pTrackView->clearTiles();
+
 	// Update/sync from session tracks.
 	int iRefresh = 0;
 	if (bRefresh)
@@ -104,6 +104,7 @@ const int effGetParamDisplay = 7;
 const int effGetChunk = 23;
 const int effSetChunk = 24;
 const int effFlagsProgramChunks = 32;
+const int effGetTailSize = 52;
 #endif
 
 
@@ -908,6 +909,15 @@ void qtractorVstPlugin::process (
 }
 
 
+// Declared tail length in frames (zero if unknown).
+unsigned long qtractorVstPlugin::tailFrames (void) const
+{
+	// Zero means default (unknown); one means no tail at all.
+	const int iTailSize = vst_dispatch(0, effGetTailSize, 0, 0, NULL, 0.0f);
+	return (iTailSize > 1 ? iTailSize : 0);
+}
+
+
 // Parameter update method.
 void qtractorVstPlugin::updateParam (
 	qtractorPluginParam *pParam, float fValue, bool /*bUpdate*/ )
@@ -130,6 +130,9 @@ public:
 	// The main plugin processing procedure.
 	void process(float **ppIBuffer, float **ppOBuffer, unsigned int nframes);
 
+	// Declared tail length in frames.
+	unsigned long tailFrames() const;
+
 	// Parameter update method.
 	void updateParam(qtractorPluginParam *pParam, float fValue, bool bUpdate);
 
@@ -0,0 +1,303 @@
+// qtractorXrunTrace.cpp
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "qtractorAbout.h"
+#include "qtractorXrunTrace.h"
+
+#include "qtractorRenderStats.h"
+
+#include "qtractorSession.h"
+#include "qtractorAudioEngine.h"
+#include "qtractorPlugin.h"
+#include "qtractorClip.h"
+
+#include <QHash>
+#include <QFile>
+#include <QTextStream>
+
+
+//----------------------------------------------------------------------
+// class qtractorXrunTrace -- Real-time process cycle trace (xrun forensics).
+//
+
+// Global instance and enablement.
+qtractorXrunTrace qtractorXrunTrace::g_xrunTrace;
+bool qtractorXrunTrace::g_bEnabled = false;
+
+
+// Constructor.
+qtractorXrunTrace::qtractorXrunTrace (void)
+{
+	m_iCycle  = 0;
+	m_iCycles = 0;
+	m_pCycle  = NULL;
+
+	ATOMIC_SET(&m_frozen, 0);
+}
+
+
+// Global enablement (non RT-safe).
+void qtractorXrunTrace::setEnabled ( bool bEnabled )
+{
+	// Start afresh...
+	if (bEnabled && !g_bEnabled)
+		g_xrunTrace.thaw();
+
+	g_bEnabled = bEnabled;
+}
+
+bool qtractorXrunTrace::isEnabled (void)
+{
+	return g_bEnabled;
+}
+
+
+// Global instance accessor; NULL when disabled (RT-safe).
+qtractorXrunTrace *qtractorXrunTrace::getInstance (void)
+{
+	return (g_bEnabled ? &g_xrunTrace : NULL);
+}
+
+
+// Cycle bracket (audio process thread only).
+void qtractorXrunTrace::beginCycle ( unsigned int nframes, unsigned long iFrame )
+{
+	if (ATOMIC_GET(&m_frozen))
+		return;
+
+	Cycle *pCycle = &m_ring[m_iCycle];
+	pCycle->start = qtractorRenderStats::clock();
+	pCycle->time = 0;
+	pCycle->nframes = nframes;
+	pCycle->frame = iFrame;
+	pCycle->contended = false;
+	ATOMIC_SET(&pCycle->count, 0);
+
+	m_pCycle = pCycle;
+}
+
+void qtractorXrunTrace::endCycle ( bool bContended )
+{
+	Cycle *pCycle = m_pCycle;
+	if (pCycle == NULL)
+		return;
+
+	m_pCycle = NULL;
+
+	pCycle->time = (unsigned int) (qtractorRenderStats::clock() - pCycle->start);
+	pCycle->contended = bContended;
+
+	if (++m_iCycle >= Cycles)
+		m_iCycle = 0;
+	if (m_iCycles < Cycles)
+		++m_iCycles;
+}
+
+
+// Cycle item record (any process thread).
+void qtractorXrunTrace::addItem (
+	ItemType type, const void *pObject, unsigned int iValue )
+{
+	Cycle *pCycle = m_pCycle;
+	if (pCycle == NULL)
+		return;
+
+	// Overflown items are just counted...
+	const int iItem = ATOMIC_INC(&pCycle->count) - 1;
+	if (iItem < 0 || iItem >= Items)
+		return;
+
+	Item *pItem = &pCycle->items[iItem];
+	pItem->object = pObject;
+	pItem->type = type;
+	pItem->value = iValue;
+}
+
+
+// Freeze on xrun (any thread).
+void qtractorXrunTrace::freeze (void)
+{
+	ATOMIC_SET(&m_frozen, 1);
+}
+
+bool qtractorXrunTrace::isFrozen (void) const
+{
+	return ATOMIC_GET(&m_frozen);
+}
+
+
+// Resume tracing, after dump (non RT-safe).
+void qtractorXrunTrace::thaw (void)
+{
+	m_iCycle  = 0;
+	m_iCycles = 0;
+
+	ATOMIC_SET(&m_frozen, 0);
+}
+
+
+// Recorded cycles, oldest first.
+unsigned int qtractorXrunTrace::cycles (void) const
+{
+	return m_iCycles;
+}
+
+const qtractorXrunTrace::Cycle *qtractorXrunTrace::cycle ( unsigned int i ) const
+{
+	const unsigned int iCycle = (m_iCycle + Cycles - m_iCycles + i) % Cycles;
+	return &m_ring[iCycle];
+}
+
+
+// Frozen ring dump: a short summary.
+QStringList qtractorXrunTrace::summary ( unsigned int iSampleRate ) const
+{
+	QStringList list;
+
+	const unsigned int iCycles = cycles();
+	if (iCycles < 1)
+		return list;
+
+	const Cycle *pWorst = NULL;
+	unsigned int iOverruns = 0;
+	unsigned int iContended = 0;
+	for (unsigned int i = 0; i < iCycles; ++i) {
+		const Cycle *pCycle = cycle(i);
+		if (pWorst == NULL || pCycle->time > pWorst->time)
+			pWorst = pCycle;
+		if (iSampleRate > 0 && pCycle->time
+			> (unsigned int) ((1000000000ULL * pCycle->nframes) / iSampleRate))
+			++iOverruns;
+		if (pCycle->contended)
+			++iContended;
+	}
+
+	const float fBudget = (iSampleRate > 0
+		? 1e6f * float(pWorst->nframes) / float(iSampleRate) : 0.0f);
+
+	list.append(QObject::tr("XRUN trace: %1 cycles, %2 over budget, %3 contended.")
+		.arg(iCycles).arg(iOverruns).arg(iContended));
+	list.append(QObject::tr("XRUN trace: worst cycle %1 us (budget %2 us) at frame %3.")
+		.arg(float(pWorst->time) * 1e-3f, 0, 'f', 1)
+		.arg(fBudget, 0, 'f', 1)
+		.arg(pWorst->frame));
+
+	return list;
+}
+
+
+// Frozen ring dump: the complete trace.
+void qtractorXrunTrace::dump ( QTextStream& out, qtractorSession *pSession ) const
+{
+	// Object names, as far as they're still around...
+	QHash<const void *, QString> names;
+	QList<qtractorPluginList *> lists;
+	if (pSession) {
+		for (qtractorTrack *pTrack = pSession->tracks().first();
+				pTrack; pTrack = pTrack->next()) {
+			names.insert(pTrack, pTrack->trackName());
+			for (qtractorClip *pClip = pTrack->clips().first();
+					pClip; pClip = pClip->next()) {
+				names.insert(pClip, pClip->clipName());
+			}
+			lists.append(pTrack->pluginList());
+		}
+		qtractorAudioEngine *pAudioEngine = pSession->audioEngine();
+		if (pAudioEngine) {
+			for (qtractorBus *pBus = pAudioEngine->buses().first();
+					pBus; pBus = pBus->next()) {
+				qtractorAudioBus *pAudioBus
+					= static_cast<qtractorAudioBus *> (pBus);
+				if (pAudioBus->pluginList_in())
+					lists.append(pAudioBus->pluginList_in());
+				if (pAudioBus->pluginList_out())
+					lists.append(pAudioBus->pluginList_out());
+			}
+		}
+	}
+
+	QListIterator<qtractorPluginList *> iter(lists);
+	while (iter.hasNext()) {
+		qtractorPluginList *pPluginList = iter.next();
+		for (qtractorPlugin *pPlugin = pPluginList->first();
+				pPlugin; pPlugin = pPlugin->next()) {
+			names.insert(pPlugin, pPlugin->type()->name());
+		}
+	}
+
+	const unsigned int iSampleRate = (pSession ? pSession->sampleRate() : 0);
+
+	QStringListIterator iter2(summary(iSampleRate));
+	while (iter2.hasNext())
+		out << "# " << iter2.next() << '\n';
+
+	const char *types[] = { "track", "plugin", "buffer" };
+
+	const unsigned int iCycles = cycles();
+	const unsigned long long iStart = (iCycles > 0 ? cycle(0)->start : 0);
+	for (unsigned int i = 0; i < iCycles; ++i) {
+		const Cycle *pCycle = cycle(i);
+		const float fBudget = (iSampleRate > 0
+			? 1e6f * float(pCycle->nframes) / float(iSampleRate) : 0.0f);
+		out << QString("%1: +%2 ms frame %3: %4 us / %5 us%6\n")
+			.arg(i)
+			.arg(float(pCycle->start - iStart) * 1e-6f, 0, 'f', 3)
+			.arg(pCycle->frame)
+			.arg(float(pCycle->time) * 1e-3f, 0, 'f', 1)
+			.arg(fBudget, 0, 'f', 1)
+			.arg(pCycle->contended ? " (contended)" : "");
+		const int iCount = ATOMIC_GET(&pCycle->count);
+		const int iItems = (iCount < Items ? iCount : Items);
+		for (int j = 0; j < iItems; ++j) {
+			const Item *pItem = &pCycle->items[j];
+			const QString& sName = names.value(pItem->object, "?");
+			if (pItem->type == Buffer) {
+				out << QString("  %1 \"%2\": %3 frames ahead\n")
+					.arg(types[pItem->type]).arg(sName).arg(pItem->value);
+			} else {
+				out << QString("  %1 \"%2\": %3 us\n")
+					.arg(types[pItem->type]).arg(sName)
+					.arg(float(pItem->value) * 1e-3f, 0, 'f', 1);
+			}
+		}
+		if (iCount > iItems)
+			out << QString("  (%1 more)\n").arg(iCount - iItems);
+	}
+}
+
+
+// Frozen ring dump: the complete trace, to file.
+bool qtractorXrunTrace::save (
+	const QString& sFilename, qtractorSession *pSession ) const
+{
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	dump(out, pSession);
+	file.close();
+
+	return true;
+}
+
+
+// end of qtractorXrunTrace.cpp
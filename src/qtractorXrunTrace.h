@@ -0,0 +1,135 @@
+// qtractorXrunTrace.h
+//
+/****************************************************************************
+   Copyright (C) 2005-2017, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __qtractorXrunTrace_h
+#define __qtractorXrunTrace_h
+
+#include "qtractorAtomic.h"
+
+#include <QStringList>
+
+
+// Forward declarations.
+class qtractorSession;
+class QTextStream;
+
+
+//----------------------------------------------------------------------
+// class qtractorXrunTrace -- Real-time process cycle trace (xrun forensics).
+//
+// The audio process thread keeps a (pre-allocated) ring of the last few
+// hundred cycles: when each one started, how long it took, whether the
+// session lock was contended, how long each track and plugin took and
+// how far ahead each playing audio clip buffer was. Tracks are possibly
+// processed in parallel, so item slots are claimed atomically. On xrun
+// the ring gets frozen, so that the GUI thread may dump it at leisure,
+// then thawed to carry on tracing.
+//
+
+class qtractorXrunTrace
+{
+public:
+
+	// Ring size (cycles) and maximum items per cycle.
+	enum { Cycles = 256, Items = 128 };
+
+	// Item kinds.
+	enum ItemType { Track = 0, Plugin = 1, Buffer = 2 };
+
+	// Cycle item: time taken (ns) for tracks and plugins;
+	// frames ahead (ring-buffer fill level) for audio buffers.
+	struct Item
+	{
+		const void   *object;
+		unsigned int  type;
+		unsigned int  value;
+	};
+
+	// Cycle record.
+	struct Cycle
+	{
+		unsigned long long start;
+		unsigned int       time;
+		unsigned int       nframes;
+		unsigned long      frame;
+		bool               contended;
+		qtractorAtomic     count;
+		Item               items[Items];
+	};
+
+	// Global enablement (non RT-safe).
+	static void setEnabled(bool bEnabled);
+	static bool isEnabled();
+
+	// Global instance accessor; NULL when disabled (RT-safe).
+	static qtractorXrunTrace *getInstance();
+
+	// Cycle bracket (audio process thread only).
+	void beginCycle(unsigned int nframes, unsigned long iFrame);
+	void endCycle(bool bContended = false);
+
+	// Cycle item record (any process thread).
+	void addItem(ItemType type, const void *pObject, unsigned int iValue);
+
+	// Freeze on xrun (any thread).
+	void freeze();
+	bool isFrozen() const;
+
+	// Resume tracing, after dump (non RT-safe).
+	void thaw();
+
+	// Frozen ring dump (non RT-safe): a short summary
+	// and the complete trace, one line per cycle item.
+	QStringList summary(unsigned int iSampleRate) const;
+	void dump(QTextStream& out, qtractorSession *pSession) const;
+	bool save(const QString& sFilename, qtractorSession *pSession) const;
+
+protected:
+
+	// Constructor.
+	qtractorXrunTrace();
+
+	// Recorded cycles, oldest first.
+	unsigned int cycles() const;
+	const Cycle *cycle(unsigned int i) const;
+
+private:
+
+	// Instance variables.
+	Cycle m_ring[Cycles];
+
+	unsigned int   m_iCycle;
+	unsigned int   m_iCycles;
+
+	Cycle *volatile m_pCycle;
+
+	qtractorAtomic m_frozen;
+
+	// Global instance and enablement.
+	static qtractorXrunTrace g_xrunTrace;
+	static bool g_bEnabled;
+};
+
+
+#endif  // __qtractorXrunTrace_h
+
+
+// end of qtractorXrunTrace.h
@@ -14,10 +14,14 @@ HEADERS += config.h \
 	qtractorAtomic.h \
 	qtractorActionControl.h \
 	qtractorAudioBuffer.h \
+	qtractorAudioCache.h \
 	qtractorAudioClip.h \
 	qtractorAudioConnect.h \
+	qtractorAudioDummy.h \
 	qtractorAudioEngine.h \
 	qtractorAudioFile.h \
+	qtractorAudioGraph.h \
+	qtractorAudioKernel.h \
 	qtractorAudioListView.h \
 	qtractorAudioMadFile.h \
 	qtractorAudioMeter.h \
@@ -38,6 +42,7 @@ HEADERS += config.h \
 	qtractorCurveFile.h \
 	qtractorCurveSelect.h \
 	qtractorDocument.h \
+	qtractorDspLoad.h \
 	qtractorDssiPlugin.h \
 	qtractorEngine.h \
 	qtractorEngineCommand.h \
@@ -96,12 +101,15 @@ HEADERS += config.h \
 	qtractorPluginListView.h \
 	qtractorPropertyCommand.h \
 	qtractorRingBuffer.h \
+	qtractorRenderBench.h \
+	qtractorRenderStats.h \
 	qtractorRubberBand.h \
 	qtractorScrollView.h \
 	qtractorSession.h \
 	qtractorSessionCommand.h \
 	qtractorSessionCursor.h \
 	qtractorSessionDocument.h \
+	qtractorSessionSnapshot.h \
 	qtractorSpinBox.h \
 	qtractorThumbView.h \
 	qtractorTimeScale.h \
@@ -116,6 +124,7 @@ HEADERS += config.h \
 	qtractorTrackView.h \
 	qtractorTracks.h \
 	qtractorVstPlugin.h \
+	qtractorXrunTrace.h \
 	qtractorZipFile.h \
 	qtractorBusForm.h \
 	qtractorClipForm.h \
@@ -144,10 +153,14 @@ SOURCES += \
 	qtractor.cpp \
 	qtractorActionControl.cpp \
 	qtractorAudioBuffer.cpp \
+	qtractorAudioCache.cpp \
 	qtractorAudioClip.cpp \
 	qtractorAudioConnect.cpp \
+	qtractorAudioDummy.cpp \
 	qtractorAudioEngine.cpp \
 	qtractorAudioFile.cpp \
+	qtractorAudioGraph.cpp \
+	qtractorAudioKernel.cpp \
 	qtractorAudioListView.cpp \
 	qtractorAudioMadFile.cpp \
 	qtractorAudioMeter.cpp \
@@ -167,6 +180,7 @@ SOURCES += \
 	qtractorCurveCommand.cpp \
 	qtractorCurveFile.cpp \
 	qtractorCurveSelect.cpp \
+	qtractorDspLoad.cpp \
 	qtractorDssiPlugin.cpp \
 	qtractorEngine.cpp \
 	qtractorEngineCommand.cpp \
@@ -196,6 +210,7 @@ SOURCES += \
 	qtractorMidiEditTime.cpp \
 	qtractorMidiEditView.cpp \
 	qtractorMidiEngine.cpp \
+	qtractorMidiEvent.cpp \
 	qtractorMidiEventList.cpp \
 	qtractorMidiFile.cpp \
 	qtractorMidiFileTempo.cpp \
@@ -217,12 +232,15 @@ SOURCES += \
 	qtractorPluginFactory.cpp \
 	qtractorPluginCommand.cpp \
 	qtractorPluginListView.cpp \
+	qtractorRenderBench.cpp \
+	qtractorRenderStats.cpp \
 	qtractorRubberBand.cpp \
 	qtractorScrollView.cpp \
 	qtractorSession.cpp \
 	qtractorSessionCommand.cpp \
 	qtractorSessionCursor.cpp \
 	qtractorSessionDocument.cpp \
+	qtractorSessionSnapshot.cpp \
 	qtractorSpinBox.cpp \
 	qtractorThumbView.cpp \
 	qtractorTimeScale.cpp \
@@ -237,6 +255,7 @@ SOURCES += \
 	qtractorTrackView.cpp \
 	qtractorTracks.cpp \
 	qtractorVstPlugin.cpp \
+	qtractorXrunTrace.cpp \
 	qtractorZipFile.cpp \
 	qtractorBusForm.cpp \
 	qtractorClipForm.cpp \